@@ -1,6 +1,45 @@
 #pragma once
 
 #include "protocolconnection/ProtocolSessionContainer.h"
+#include "connectionhub/TopicRouter.h"
+#include "connectionhub/MessageSpool.h"
+#include "connectionhub/MessageJournal.h"
+#include "helpers/RcuPointer.h"
+
+#include <functional>
+#include <unordered_set>
+#include <atomic>
+
+
+// returns false, if the message has no topic
+typedef std::function<bool(const IMessagePtr& message, std::string& topic)> FuncGetTopic;
+
+
+// returns false, if the message shall not be conflated
+typedef std::function<bool(const IMessagePtr& message, std::string& key)> FuncGetConflationKey;
+
+
+// How messages are forwarded to a session, which does not consume its messages fast enough.
+enum SlowConsumerPolicy
+{
+    SLOWCONSUMER_QUEUE = 0,     // queue all messages (default)
+    SLOWCONSUMER_DROP,          // drop the messages, while maxPendingMessages are queued
+    SLOWCONSUMER_DISCONNECT,    // disconnect the session, when maxPendingMessages are queued
+    SLOWCONSUMER_CONFLATE,      // a queued message is replaced by a newer message with the same key
+};
+
+
+// The topic is the beginning of the payload till the delimiter, e.g. "sensors/temperature\n..."
+class TopicFromPayloadPrefix
+{
+public:
+    TopicFromPayloadPrefix(char delimiter);
+    bool operator ()(const IMessagePtr& message, std::string& topic) const;
+
+private:
+    char m_delimiter;
+};
+
 
 
 struct IConnectionHub
@@ -21,9 +60,42 @@ struct IConnectionHub
     virtual IProtocolSessionPtr connectSsl(const std::string& endpoint, const IProtocolPtr& protocol, const CertificateData& certificateData, int reconnectInterval = 5000, int totalReconnectDuration = -1) = 0;
 #endif
 
+    // Till startMessageForwarding() the received messages are buffered. Beyond maxMemoryBytes the messages
+    // are spooled to a memory mapped file in the spoolDirectory. Call it before messages are received.
+    virtual void setPreForwardingBuffer(std::int64_t maxMemoryBytes, const std::string& spoolDirectory = "/tmp") = 0;
+    // The buffered messages are forwarded in batches by the poller thread, new messages are forwarded after them.
     virtual void startMessageForwarding() = 0;
     virtual void stopForwardingFromSession(std::int64_t sessionId) = 0;
     virtual void stopForwardingToSession(std::int64_t sessionId) = 0;
+
+    // With a topic function the messages are only forwarded to the sessions, which subscribed
+    // a matching pattern (see TopicRouter). Messages without topic are not forwarded.
+    // Without a topic function all messages are forwarded to all sessions.
+    virtual void setTopicFunction(FuncGetTopic funcGetTopic) = 0;
+    // returns false, if the pattern is invalid (see TopicRouter::isValidPattern)
+    virtual bool subscribe(std::int64_t sessionId, const std::string& pattern) = 0;
+    virtual void unsubscribe(std::int64_t sessionId, const std::string& pattern) = 0;
+
+    // The policy is applied, when messages are forwarded to the session. The pending messages are the messages,
+    // which are queued at the connection of the session. For SLOWCONSUMER_CONFLATE the funcGetConflationKey is
+    // needed, e.g. TopicFromPayloadPrefix, maxPendingMessages is not used.
+    virtual void setSlowConsumerPolicy(std::int64_t sessionId, SlowConsumerPolicy policy, int maxPendingMessages, FuncGetConflationKey funcGetConflationKey = nullptr) = 0;
+
+    // With a journal every forwarded message is appended to the journal (see MessageJournal) and
+    // the sequence number is set at the forwarded messages (see IMessage::getSequenceNumber).
+    virtual void enableJournal(const std::string& directory, std::int64_t segmentSize = 64 * 1024 * 1024, int maxSegments = 16) = 0;
+    // returns 0, if no message was journaled
+    virtual std::uint64_t getLastSequenceNumber() const = 0;
+    // The journal stores the source id of a message, it is the session id, if it is not set. A reconnected
+    // session gets a new session id, give it the source id of the former session, so that the replay
+    // does not send its own messages back.
+    virtual void setSourceId(std::int64_t sessionId, std::int64_t sourceId) = 0;
+    // Sends the journaled messages starting at sequenceNumberFrom to the session, e.g. after a reconnect.
+    // The messages are routed like forwarded messages, the messages of the session's source id are not sent.
+    // The replay runs in batches in the poller thread, new messages are sent to the session after the
+    // replay reached them. Returns false, if the session does not exist, there is no journal, the messages
+    // are not in the journal anymore or a replay for the session is running.
+    virtual bool replayFromJournal(std::int64_t sessionId, std::uint64_t sequenceNumberFrom) = 0;
 };
 
 
@@ -51,9 +123,18 @@ private:
     virtual IProtocolSessionPtr connectSsl(const std::string& endpoint, const IProtocolPtr& protocol, const CertificateData& certificateData, int reconnectInterval = 5000, int totalReconnectDuration = -1) override;
 #endif
 
+    virtual void setPreForwardingBuffer(std::int64_t maxMemoryBytes, const std::string& spoolDirectory = "/tmp") override;
     virtual void startMessageForwarding() override;
     virtual void stopForwardingFromSession(std::int64_t sessionId) override;
     virtual void stopForwardingToSession(std::int64_t sessionId) override;
+    virtual void setTopicFunction(FuncGetTopic funcGetTopic) override;
+    virtual bool subscribe(std::int64_t sessionId, const std::string& pattern) override;
+    virtual void unsubscribe(std::int64_t sessionId, const std::string& pattern) override;
+    virtual void setSlowConsumerPolicy(std::int64_t sessionId, SlowConsumerPolicy policy, int maxPendingMessages, FuncGetConflationKey funcGetConflationKey = nullptr) override;
+    virtual void enableJournal(const std::string& directory, std::int64_t segmentSize = 64 * 1024 * 1024, int maxSegments = 16) override;
+    virtual std::uint64_t getLastSequenceNumber() const override;
+    virtual void setSourceId(std::int64_t sessionId, std::int64_t sourceId) override;
+    virtual bool replayFromJournal(std::int64_t sessionId, std::uint64_t sequenceNumberFrom) override;
 
     // IProtocolSessionCallback
     virtual void connected(const IProtocolSessionPtr& session) override;
@@ -62,12 +143,60 @@ private:
     virtual void socketConnected(const IProtocolSessionPtr& session) override;
     virtual void socketDisconnected(const IProtocolSessionPtr& session) override;
 
-    std::unique_ptr<IProtocolSessionContainer>  m_protocolSessionContainer;
-    std::vector<std::int64_t>                   m_sessionIdsStopForwardingFromSession;
-    std::vector<std::int64_t>                   m_sessionIdsStopForwardingToSession;
-    bool                                        m_startMessageForwarding = false;
-    std::vector<std::pair<IProtocolSessionPtr, IMessagePtr>>    m_messagesForForwarding;
+    struct SlowConsumer
+    {
+        SlowConsumerPolicy      policy = SLOWCONSUMER_QUEUE;
+        int                     maxPendingMessages = 0;
+        FuncGetConflationKey    funcGetConflationKey;
+    };
+
+    // A running replay of the journal to a session. While it runs, the messages are not forwarded to the
+    // session, the replay sends them after it reached them. The replay stops while no message can be
+    // journaled (see MessageJournal::visitLastSequenceNumber), so a message, which is journaled before,
+    // is sent by the replay and a message, which is journaled after, sees that the replay stopped.
+    struct Replay
+    {
+        std::atomic<bool>   running{true};
+        std::uint64_t       sequenceNumberNext = 0;     // used by the poller thread
+        size_t              batchSize = 0;              // used by the poller thread
+    };
+    typedef std::shared_ptr<Replay> ReplayPtr;
+
+    // The sessions and forwarding rules, which are used by received() without a lock.
+    // A change copies the snapshot and publishes it (see RcuPointer), the readers keep their old snapshot.
+    struct ForwardingSnapshot
+    {
+        std::vector<IProtocolSessionPtr>                        sessions;
+        std::unordered_map<std::int64_t, IProtocolSessionPtr>   sessionsById;
+        std::unordered_set<std::int64_t>                        sessionIdsStopForwardingFromSession;
+        std::unordered_set<std::int64_t>                        sessionIdsStopForwardingToSession;
+        FuncGetTopic                                            funcGetTopic;
+        TopicRoutes                                             topicRoutes;
+        std::unordered_map<std::int64_t, SlowConsumer>          slowConsumers;
+        MessageJournalPtr                                       journal;
+        std::unordered_map<std::int64_t, std::int64_t>          sourceIds;
+        std::unordered_map<std::int64_t, ReplayPtr>             replays;
+    };
+    typedef RcuPointer<ForwardingSnapshot>::Reader ForwardingSnapshotReader;
+
+    void updateSnapshot(const std::function<void(ForwardingSnapshot& snapshot)>& funcUpdate);
+    void addSession(const IProtocolSessionPtr& session);
+    void forwardMessage(const ForwardingSnapshot& snapshot, std::int64_t sessionIdFrom, const IMessagePtr& message);
+    void forwardBufferedMessages();
+    void replayBatch(std::int64_t sessionId, const ReplayPtr& replay);
+    static std::int64_t getSourceId(const ForwardingSnapshot& snapshot, std::int64_t sessionId);
+    static bool isRoutedTo(const ForwardingSnapshot& snapshot, std::int64_t sourceIdFrom, const IMessagePtr& message, std::int64_t sessionIdTo);
+    static bool isHeldForReplay(const ForwardingSnapshot& snapshot, std::int64_t sessionId);
+    static void sendToSession(const ForwardingSnapshot& snapshot, const IProtocolSessionPtr& session, const IMessagePtr& message, std::vector<std::pair<int, IMessagePtr>>& preparedMessages);
 
-    std::recursive_mutex                        m_mutex;
+    std::unique_ptr<IProtocolSessionContainer>  m_protocolSessionContainer;
+    RcuPointer<ForwardingSnapshot>              m_snapshot;
+    std::mutex                                  m_mutexUpdate;      // serializes the updates of m_snapshot
+    TopicRouter                                 m_topicRouter;      // guarded by m_mutexUpdate
+
+    std::atomic<bool>                           m_startMessageForwarding{false};
+    std::unique_ptr<MessageSpool>               m_messagesForForwarding;
+    std::mutex                                  m_mutexMessagesForForwarding;
+    size_t                                      m_forwardBatchSize;     // used by the poller thread
 
 };
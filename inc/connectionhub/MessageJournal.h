@@ -0,0 +1,75 @@
+#pragma once
+
+#include "streamconnection/IMessage.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+
+
+struct JournalEntry
+{
+    std::uint64_t   sequenceNumber = 0;
+    std::int64_t    timestamp = 0;      // microseconds since epoch
+    std::int64_t    sessionId = 0;      // source session
+    BufferRef       payload;            // points into the mapped segment
+    std::shared_ptr<const void> segment;    // keeps the mapped segment alive, while the payload is used
+};
+
+
+// Append-only journal of messages in segmented, memory mapped files. The sequence numbers start at 1
+// and have no gaps. A segment file is named by the sequence number of its first entry. When more than
+// maxSegments exist, the oldest segment is deleted. An existing journal in the directory is continued,
+// the oldest segments beyond maxSegments are deleted.
+// The journal is thread safe, entries can be replayed while other entries are appended.
+class MessageJournal
+{
+public:
+    MessageJournal(const std::string& directory, std::int64_t segmentSize = 64 * 1024 * 1024, int maxSegments = 16);
+    MessageJournal(const MessageJournal&) = delete;
+    MessageJournal& operator =(const MessageJournal&) = delete;
+
+    // returns the sequence number of the entry or 0, if the entry could not be written.
+    std::uint64_t append(std::int64_t sessionId, const BufferRef& payload);
+    // Calls funcEntry for all entries starting at sequenceNumberFrom, but for not more than maxEntries.
+    // The payloads are not copied. Returns false, if entries starting at sequenceNumberFrom are not in
+    // the journal (anymore).
+    bool replay(std::uint64_t sequenceNumberFrom, const std::function<void(const JournalEntry& entry)>& funcEntry, size_t maxEntries = SIZE_MAX) const;
+    std::uint64_t getFirstSequenceNumber() const;
+    std::uint64_t getLastSequenceNumber() const;
+    // Calls funcLast with the last sequence number, no entry is appended while funcLast runs.
+    void visitLastSequenceNumber(const std::function<void(std::uint64_t sequenceNumberLast)>& funcLast) const;
+
+private:
+    struct Segment
+    {
+        ~Segment();
+        std::uint64_t   firstSequenceNumber = 0;
+        std::string     fileName;
+        int             fd = -1;
+        char*           mapped = nullptr;
+        std::int64_t    size = 0;
+        std::int64_t    writeOffset = 0;
+        std::vector<std::int64_t> offsets;  // offset of every INDEX_INTERVAL'th entry
+    };
+    typedef std::shared_ptr<Segment> SegmentPtr;
+
+    void openExistingSegments();
+    SegmentPtr openSegment(const std::string& fileName, std::uint64_t firstSequenceNumber, std::int64_t size);
+    bool addSegment(std::int64_t sizeMin);
+    void removeOldSegments();
+
+    std::string                 m_directory;
+    std::int64_t                m_segmentSize;
+    int                         m_maxSegments;
+    std::deque<SegmentPtr>      m_segments;
+    std::uint64_t               m_nextSequenceNumber = 1;
+    mutable std::mutex          m_mutex;
+};
+
+typedef std::shared_ptr<MessageJournal> MessageJournalPtr;
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "streamconnection/IMessage.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdint>
+
+
+
+// FIFO of received messages with a bounded memory usage. The messages, which do not fit into
+// the memory limit, are appended to a memory mapped spool file. The file is created in the
+// spool directory and is deleted immediately, so it disappears also after a crash.
+// If the spool file cannot be created, the messages are kept in memory. If the file cannot grow, while
+// messages are in the file, the message is dropped to keep the order. The space of the messages, which
+// were read from the file, is reused. The spool is not thread safe.
+class MessageSpool
+{
+public:
+    MessageSpool(std::int64_t maxMemoryBytes = 64 * 1024 * 1024, const std::string& spoolDirectory = "/tmp");
+    ~MessageSpool();
+    MessageSpool(const MessageSpool&) = delete;
+    MessageSpool& operator =(const MessageSpool&) = delete;
+
+    // returns false, if the message was dropped (see getDroppedMessages).
+    bool push(std::int64_t sessionId, const IMessagePtr& message);
+    // takes up to maxEntries messages, returns false if the spool was empty.
+    bool pop(size_t maxEntries, std::vector<std::pair<std::int64_t, IMessagePtr>>& entries);
+    bool empty() const;
+
+    std::int64_t getMemoryBytes() const;
+    std::int64_t getFileBytes() const;
+    std::int64_t getDroppedMessages() const;
+
+private:
+    bool appendToFile(std::int64_t sessionId, const BufferRef& payload);
+    IMessagePtr readFromFile(std::int64_t& sessionId);
+    void compactFile();
+    bool mapFile(std::int64_t size);
+    void releaseFile();
+
+    std::int64_t                                            m_maxMemoryBytes;
+    std::string                                             m_spoolDirectory;
+
+    std::deque<std::pair<std::int64_t, IMessagePtr>>        m_memory;
+    std::int64_t                                            m_memoryBytes = 0;
+
+    int                                                     m_fd = -1;
+    char*                                                   m_mapped = nullptr;
+    std::int64_t                                            m_mappedSize = 0;
+    std::int64_t                                            m_readOffset = 0;
+    std::int64_t                                            m_writeOffset = 0;
+    std::int64_t                                            m_droppedMessages = 0;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+#include "helpers/PersistentHashMap.h"
+
+
+
+// Immutable version of the routing table (see TopicRouter). It can be used by other threads, while
+// the router is changed, the nodes, which did not change, are shared with the router.
+class TopicRoutes
+{
+public:
+    // every matching session is added once.
+    void getSubscribers(const std::string& topic, std::vector<std::int64_t>& sessionIds) const;
+
+private:
+    struct Node
+    {
+        PersistentHashMap<std::string, std::shared_ptr<const Node>>     children;
+        // the value is not used
+        PersistentHashMap<std::int64_t, bool>                           subscribers;
+        PersistentHashMap<std::int64_t, bool>                           subscribersMultiLevel;
+    };
+    typedef std::shared_ptr<const Node> NodePtr;
+
+    static void match(const Node& node, const std::vector<std::string>& levels, size_t index, std::vector<std::int64_t>& sessionIds);
+
+    NodePtr     m_root;
+
+    friend class TopicRouter;
+};
+
+
+
+// Routing table of topic subscriptions. The levels of a topic are separated by '/'.
+// In a subscription pattern '+' matches exactly one level and '#' (only as last level)
+// matches any number of levels, also zero levels. The router is not thread safe.
+// The nodes are never changed, a change copies the nodes on the path of the pattern and
+// shares the other nodes (see PersistentHashMap), so a version of the routes (see getRoutes)
+// is kept without copying and a change costs O(levels * log(subscriptions)).
+class TopicRouter
+{
+public:
+    // returns false and does not subscribe, if the pattern is invalid (see isValidPattern).
+    bool subscribe(std::int64_t sessionId, const std::string& pattern);
+    void unsubscribe(std::int64_t sessionId, const std::string& pattern);
+    void unsubscribeAll(std::int64_t sessionId);
+    // every matching session is added once.
+    void getSubscribers(const std::string& topic, std::vector<std::int64_t>& sessionIds) const;
+    bool hasSubscriptions(std::int64_t sessionId) const;
+    // the current routes, it does not copy the nodes.
+    const TopicRoutes& getRoutes() const;
+    // A wildcard must be a whole level and '#' must be the last level.
+    static bool isValidPattern(const std::string& pattern);
+
+private:
+    typedef TopicRoutes::Node Node;
+    typedef TopicRoutes::NodePtr NodePtr;
+
+    static NodePtr insert(const NodePtr& node, std::int64_t sessionId, const std::vector<std::string>& levels, size_t index, bool& inserted);
+    // returns nullptr, if the node can be pruned
+    static NodePtr remove(const NodePtr& node, std::int64_t sessionId, const std::vector<std::string>& levels, size_t index);
+
+    TopicRoutes                                                     m_routes;
+    std::unordered_map<std::int64_t, std::vector<std::string>>      m_patternsOfSession;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+
+
+
+struct IExecutor
+{
+    virtual ~IExecutor() {}
+    // Actions with the same key are executed in the order they were added. addAction never blocks.
+    // It returns false, if more actions of the key are queued than the executor wants to hold. The action
+    // is queued anyway, but the caller should stop producing actions for the key till they are executed.
+    virtual bool addAction(std::int64_t key, std::function<void()> func) = 0;
+};
+
+typedef std::shared_ptr<IExecutor> IExecutorPtr;
+
+
+
+// The actions are sharded by key over the workers, each worker executes its actions in order.
+// addAction returns false, when more than maxQueueSize actions of the key are queued. The
+// protocol sessions then stop reading from their socket till their actions are executed.
+// The destructor executes the actions, which are already queued, before the workers stop.
+// Actions added during or after the destruction are dropped.
+class ExecutorWorkerPool : public IExecutor
+{
+public:
+    ExecutorWorkerPool(int numberOfWorkers = 4, int maxQueueSize = 1000);
+    ~ExecutorWorkerPool();
+
+private:
+    // IExecutor
+    virtual bool addAction(std::int64_t key, std::function<void()> func) override;
+
+    struct Worker
+    {
+        std::deque<std::pair<std::int64_t, std::function<void()>>>  actions;
+        std::unordered_map<std::int64_t, int>                       queuedPerKey;
+        std::mutex                          mutex;
+        std::condition_variable             condNotEmpty;
+        bool                                terminate = false;
+        std::thread                         thread;
+    };
+
+    void workerLoop(Worker& worker);
+
+    std::vector<std::unique_ptr<Worker>>    m_workers;
+    const int                               m_maxQueueSize;
+};
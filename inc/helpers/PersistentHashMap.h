@@ -0,0 +1,247 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <functional>
+#include <utility>
+#include <cstdint>
+#include <assert.h>
+
+
+// Hash map with structural sharing: a copy only copies the root pointer, a change copies
+// the nodes on the path of the key (at most 16 pointers and a few entries per node) and
+// shares all other nodes with the copies. A copy can be read by other threads, while the
+// map is changed. The map itself is not thread safe.
+template<class KEY, class VALUE, class HASH = std::hash<KEY>>
+class PersistentHashMap
+{
+public:
+    const VALUE* find(const KEY& key) const
+    {
+        std::size_t hash = HASH()(key);
+        const Node* node = m_root.get();
+        for (int depth = 0; node; ++depth)
+        {
+            if (node->isLeaf())
+            {
+                for (size_t i = 0; i < node->entries.size(); ++i)
+                {
+                    if (node->entries[i].first == key)
+                    {
+                        return &node->entries[i].second;
+                    }
+                }
+                return nullptr;
+            }
+            node = node->slots[slotIndex(hash, depth)].get();
+        }
+        return nullptr;
+    }
+
+    // inserts or replaces the value.
+    void set(const KEY& key, const VALUE& value)
+    {
+        bool inserted = false;
+        m_root = insert(m_root, key, value, HASH()(key), 0, true, inserted);
+        if (inserted)
+        {
+            ++m_size;
+        }
+    }
+
+    // returns false, if the key already exists, the value is not replaced.
+    bool insert(const KEY& key, const VALUE& value)
+    {
+        bool inserted = false;
+        NodePtr root = insert(m_root, key, value, HASH()(key), 0, false, inserted);
+        if (inserted)
+        {
+            m_root = root;
+            ++m_size;
+        }
+        return inserted;
+    }
+
+    // returns false, if the key does not exist.
+    bool erase(const KEY& key)
+    {
+        bool erased = false;
+        NodePtr root = erase(m_root, key, HASH()(key), 0, erased);
+        if (erased)
+        {
+            m_root = root;
+            --m_size;
+        }
+        return erased;
+    }
+
+    template<class FUNC>
+    void forEach(const FUNC& func) const
+    {
+        forEach(m_root.get(), func);
+    }
+
+    bool empty() const
+    {
+        return (m_size == 0);
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    static const int BITS_PER_LEVEL = 4;
+    static const int SLOTS = 1 << BITS_PER_LEVEL;
+    static const int MAX_DEPTH = static_cast<int>(sizeof(std::size_t) * 8 / BITS_PER_LEVEL);
+
+    struct Node;
+    typedef std::shared_ptr<const Node> NodePtr;
+
+    // An inner node has only slots, a leaf has only entries. The entries of a leaf have the same
+    // hash up to its depth, at MAX_DEPTH they have the same hash.
+    struct Node
+    {
+        NodePtr                             slots[SLOTS];
+        std::vector<std::pair<KEY, VALUE>>  entries;
+
+        bool isLeaf() const
+        {
+            return !entries.empty();
+        }
+    };
+
+    static int slotIndex(std::size_t hash, int depth)
+    {
+        return static_cast<int>((hash >> (depth * BITS_PER_LEVEL)) & (SLOTS - 1));
+    }
+
+    static NodePtr insert(const NodePtr& node, const KEY& key, const VALUE& value, std::size_t hash, int depth, bool replace, bool& inserted)
+    {
+        if (!node)
+        {
+            std::shared_ptr<Node> leaf = std::make_shared<Node>();
+            leaf->entries.emplace_back(key, value);
+            inserted = true;
+            return leaf;
+        }
+        if (node->isLeaf())
+        {
+            for (size_t i = 0; i < node->entries.size(); ++i)
+            {
+                if (node->entries[i].first == key)
+                {
+                    if (!replace)
+                    {
+                        return node;
+                    }
+                    std::shared_ptr<Node> leaf = std::make_shared<Node>(*node);
+                    leaf->entries[i].second = value;
+                    return leaf;
+                }
+            }
+            if (depth == MAX_DEPTH)
+            {
+                std::shared_ptr<Node> leaf = std::make_shared<Node>(*node);
+                leaf->entries.emplace_back(key, value);
+                inserted = true;
+                return leaf;
+            }
+            // split the leaf
+            std::shared_ptr<Node> inner = std::make_shared<Node>();
+            for (size_t i = 0; i < node->entries.size(); ++i)
+            {
+                const std::pair<KEY, VALUE>& entry = node->entries[i];
+                bool insertedEntry = false;
+                NodePtr& slot = inner->slots[slotIndex(HASH()(entry.first), depth)];
+                slot = insert(slot, entry.first, entry.second, HASH()(entry.first), depth + 1, false, insertedEntry);
+            }
+            NodePtr& slot = inner->slots[slotIndex(hash, depth)];
+            slot = insert(slot, key, value, hash, depth + 1, replace, inserted);
+            return inner;
+        }
+        const NodePtr& slot = node->slots[slotIndex(hash, depth)];
+        NodePtr slotNew = insert(slot, key, value, hash, depth + 1, replace, inserted);
+        if (slotNew == slot)
+        {
+            return node;
+        }
+        std::shared_ptr<Node> inner = std::make_shared<Node>(*node);
+        inner->slots[slotIndex(hash, depth)] = slotNew;
+        return inner;
+    }
+
+    // returns nullptr, if the node became empty
+    static NodePtr erase(const NodePtr& node, const KEY& key, std::size_t hash, int depth, bool& erased)
+    {
+        if (!node)
+        {
+            return node;
+        }
+        if (node->isLeaf())
+        {
+            for (size_t i = 0; i < node->entries.size(); ++i)
+            {
+                if (node->entries[i].first == key)
+                {
+                    erased = true;
+                    if (node->entries.size() == 1)
+                    {
+                        return nullptr;
+                    }
+                    std::shared_ptr<Node> leaf = std::make_shared<Node>(*node);
+                    leaf->entries.erase(leaf->entries.begin() + i);
+                    return leaf;
+                }
+            }
+            return node;
+        }
+        const NodePtr& slot = node->slots[slotIndex(hash, depth)];
+        NodePtr slotNew = erase(slot, key, hash, depth + 1, erased);
+        if (slotNew == slot)
+        {
+            return node;
+        }
+        std::shared_ptr<Node> inner = std::make_shared<Node>(*node);
+        inner->slots[slotIndex(hash, depth)] = slotNew;
+        // an inner node with only one leaf is replaced by the leaf, the leaf is found at any depth
+        const NodePtr* remaining = nullptr;
+        for (int i = 0; i < SLOTS; ++i)
+        {
+            if (inner->slots[i])
+            {
+                if (remaining)
+                {
+                    return inner;
+                }
+                remaining = &inner->slots[i];
+            }
+        }
+        if (remaining == nullptr)
+        {
+            return nullptr;
+        }
+        return (*remaining)->isLeaf() ? *remaining : NodePtr(inner);
+    }
+
+    template<class FUNC>
+    static void forEach(const Node* node, const FUNC& func)
+    {
+        if (!node)
+        {
+            return;
+        }
+        for (size_t i = 0; i < node->entries.size(); ++i)
+        {
+            func(node->entries[i].first, node->entries[i].second);
+        }
+        for (int i = 0; i < SLOTS; ++i)
+        {
+            forEach(node->slots[i].get(), func);
+        }
+    }
+
+    NodePtr         m_root;
+    std::size_t     m_size = 0;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <assert.h>
+
+
+// Pointer to an object, which is read by many threads without a lock and replaced by a writer (read-copy-update).
+// A reader registers at the current epoch and reads the pointer (see Reader). A replaced object is retired
+// and deleted, when no reader can use it anymore: the epoch only advances, when no reader of the previous
+// epoch is left, so the objects, which were retired two epochs ago, are not reachable anymore.
+// The writers are not thread safe, they have to be serialized by the caller.
+template<class T>
+class RcuPointer
+{
+public:
+    class Reader
+    {
+    public:
+        Reader(const RcuPointer& rcu)
+            : m_rcu(rcu)
+        {
+            std::uint64_t epoch = m_rcu.m_epoch.load();
+            while (true)
+            {
+                m_readers = &m_rcu.m_readers[epoch % EPOCHS];
+                m_readers->fetch_add(1);
+                std::uint64_t epochAfter = m_rcu.m_epoch.load();
+                if (epochAfter == epoch)
+                {
+                    break;
+                }
+                // the epoch advanced, while the reader registered
+                m_readers->fetch_sub(1);
+                epoch = epochAfter;
+            }
+            m_ptr = m_rcu.m_ptr.load();
+            assert(m_ptr);
+        }
+
+        ~Reader()
+        {
+            m_readers->fetch_sub(1, std::memory_order_release);
+        }
+
+        Reader(const Reader&) = delete;
+        Reader& operator =(const Reader&) = delete;
+
+        const T& operator *() const
+        {
+            return *m_ptr;
+        }
+
+        const T* operator ->() const
+        {
+            return m_ptr;
+        }
+
+    private:
+        const RcuPointer&       m_rcu;
+        std::atomic<int>*       m_readers = nullptr;
+        const T*                m_ptr = nullptr;
+    };
+
+    RcuPointer(std::unique_ptr<T>&& ptr)
+        : m_ptr(ptr.release())
+    {
+        assert(m_ptr.load());
+    }
+
+    ~RcuPointer()
+    {
+        delete m_ptr.load();
+    }
+
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator =(const RcuPointer&) = delete;
+
+    // for the writer
+    const T& get() const
+    {
+        return *m_ptr.load(std::memory_order_relaxed);
+    }
+
+    // for the writer, the former object is deleted, when no reader uses it anymore.
+    void publish(std::unique_ptr<T>&& ptr)
+    {
+        assert(ptr);
+        T* ptrFormer = m_ptr.exchange(ptr.release());
+        std::uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+        m_retired[epoch % EPOCHS].emplace_back(ptrFormer);
+        // up to two epochs, so that the former object is deleted at once, if there are no readers
+        for (int i = 0; i < EPOCHS - 1; ++i)
+        {
+            if (!tryAdvanceEpoch())
+            {
+                break;
+            }
+        }
+    }
+
+private:
+    static const int EPOCHS = 3;
+
+    bool tryAdvanceEpoch()
+    {
+        std::uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+        std::uint64_t epochPrevious = epoch + EPOCHS - 1;
+        if (m_readers[epochPrevious % EPOCHS].load() != 0)
+        {
+            return false;
+        }
+        // The readers of the previous epoch are gone and the readers of the epoch before it were gone, when
+        // the current epoch started. The objects, which were retired in the previous epoch, are not used anymore.
+        m_retired[epochPrevious % EPOCHS].clear();
+        m_epoch.store(epoch + 1);
+        return true;
+    }
+
+    std::atomic<T*>                     m_ptr;
+    std::atomic<std::uint64_t>          m_epoch{0};
+    mutable std::atomic<int>            m_readers[EPOCHS] = {};
+    std::vector<std::unique_ptr<T>>     m_retired[EPOCHS];      // used by the writer
+};
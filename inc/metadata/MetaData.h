@@ -2,9 +2,12 @@
 
 #include "metadata/MetaStruct.h"
 #include "metadata/MetaEnum.h"
+#include "helpers/PersistentHashMap.h"
 
 #include <mutex>
 #include <memory>
+#include <atomic>
+#include <vector>
 
 struct IMetaData
 {
@@ -20,12 +23,21 @@ struct IMetaData
     virtual void addStruct(MetaStruct&& stru) = 0;
     virtual void addEnum(const MetaEnum& en) = 0;
     virtual void addEnum(MetaEnum&& en) = 0;
+
+    // The type reference of a field is cached at the field by its first lookup. After freeze, no structs and
+    // enums can be added anymore and all type references of the fields are resolved. The lookups do not lock,
+    // also before freeze.
+    virtual void freeze() = 0;
+    virtual bool isFrozen() const = 0;
+    virtual const MetaStruct* getStructById(int typeId) const = 0;
+    virtual const MetaEnum* getEnumById(int typeId) const = 0;
 };
 
 
 class MetaData : public IMetaData
 {
 public:
+    MetaData();
 
 private:
     // IMetaData
@@ -40,10 +52,36 @@ private:
     virtual void addStruct(MetaStruct&& stru) override;
     virtual void addEnum(const MetaEnum& en) override;
     virtual void addEnum(MetaEnum&& en) override;
+    virtual void freeze() override;
+    virtual bool isFrozen() const override;
+    virtual const MetaStruct* getStructById(int typeId) const override;
+    virtual const MetaEnum* getEnumById(int typeId) const override;
+
+    // Before freeze the lookups use the latest index. A struct or enum is added by publishing a new index,
+    // which shares the unchanged entries with the former index. The former indexes are kept, because
+    // a lookup can still use them.
+    struct Index
+    {
+        PersistentHashMap<std::string, const MetaStruct*>   name2Struct;
+        PersistentHashMap<std::string, const MetaEnum*>     name2Enum;
+        PersistentHashMap<int, const MetaStruct*>           structs;    ///< by type id
+        PersistentHashMap<int, const MetaEnum*>             enums;      ///< by type id
+    };
+
+    const MetaStruct* findStruct(const std::string& typeName) const;
+    const MetaEnum* findEnum(const std::string& typeName) const;
+    static const MetaField* getArrayFieldIntern(const MetaField& field);
+    void resolveField(const MetaField& field) const;
+    void publishIndex(std::unique_ptr<Index>&& index);
 
     std::unordered_map<std::string, MetaStruct> m_name2Struct;
     std::unordered_map<std::string, MetaEnum>   m_name2Enum;
-    std::mutex                                  m_mutex;
+    std::vector<const MetaStruct*>              m_structs;      ///< by type id
+    std::vector<const MetaEnum*>                m_enums;        ///< by type id
+    std::atomic<const Index*>                   m_index{nullptr};
+    std::vector<std::unique_ptr<const Index>>   m_indexes;      ///< all published indexes
+    std::atomic<bool>                           m_frozen{false};
+    mutable std::mutex                          m_mutex;
 };
 
 
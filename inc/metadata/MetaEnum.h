@@ -22,6 +22,8 @@ class MetaEnum
 public:
     void setTypeName(const std::string& typeName);
     const std::string& getTypeName() const;
+    void setTypeId(int typeId);
+    int getTypeId() const;
 
     const MetaEnumEntry* getEntryById(int id) const;
     const MetaEnumEntry* getEntryByName(const std::string& name) const;
@@ -39,9 +41,14 @@ public:
     }
 
 private:
-    std::string                                                             m_typeName;
-    std::vector<std::shared_ptr<const MetaEnumEntry>>                       m_entries;
-    std::unordered_map<int, std::shared_ptr<const MetaEnumEntry>>           m_id2Entry;
-    std::unordered_map<std::string, std::shared_ptr<const MetaEnumEntry>>   m_name2Entry;
+    void buildDenseIds();
+
+    std::string                             m_typeName;
+    int                                     m_typeId = -1;      ///< index inside the IMetaData, -1 if not registered
+    std::vector<MetaEnumEntry>              m_entries;
+    std::unordered_map<int, int>            m_id2Index;
+    std::unordered_map<std::string, int>    m_name2Index;
+    int                                     m_denseIdMin = 0;
+    std::vector<int>                        m_denseId2Index;    ///< id - m_denseIdMin -> index or -1, empty if the ids are too sparse
 };
 
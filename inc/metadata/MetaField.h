@@ -5,6 +5,7 @@
 
 #include <string>
 #include <memory>
+#include <atomic>
 
 
 
@@ -13,6 +14,40 @@ class MetaStruct;
 class IMetaData;
 
 
+// A cached pointer, which can be written and read by several threads at the same time.
+template<class T>
+class MetaFieldCache
+{
+public:
+    MetaFieldCache() = default;
+
+    MetaFieldCache(const MetaFieldCache& rhs)
+        : m_ptr(rhs.m_ptr.load(std::memory_order_acquire))
+    {
+    }
+
+    MetaFieldCache& operator =(const MetaFieldCache& rhs)
+    {
+        m_ptr.store(rhs.m_ptr.load(std::memory_order_acquire), std::memory_order_release);
+        return *this;
+    }
+
+    MetaFieldCache& operator =(const T* ptr)
+    {
+        m_ptr.store(ptr, std::memory_order_release);
+        return *this;
+    }
+
+    operator const T*() const
+    {
+        return m_ptr.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<const T*>   m_ptr{nullptr};
+};
+
+
 enum MetaFieldFlags
 {
     METAFLAG_PROTO_VARINT = 1,
@@ -32,8 +67,8 @@ public:
 
     int             flags = 0;                              ///< flaggs of the parameter
 
-    mutable const MetaEnum*     metaEnum    = nullptr;      ///< cache to find MetaEnum of typeName faster
-    mutable const MetaStruct*   metaStruct  = nullptr;      ///< cache to find MetaStruct of typeName faster
+    mutable MetaFieldCache<MetaEnum>    metaEnum;           ///< cache to find MetaEnum of typeName faster
+    mutable MetaFieldCache<MetaStruct>  metaStruct;         ///< cache to find MetaStruct of typeName faster
     mutable std::shared_ptr<MetaField> fieldWithoutArray;   ///< in case of an array, this is the MetaField for its entries
 };
 
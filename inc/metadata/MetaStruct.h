@@ -12,6 +12,8 @@ class MetaStruct
 public:
     void setTypeName(const std::string& typeName);
     const std::string& getTypeName() const;
+    void setTypeId(int typeId);
+    int getTypeId() const;
 
     const MetaField* getFieldByIndex(int index) const;
     const MetaField* getFieldByName(const std::string& name) const;
@@ -19,13 +21,17 @@ public:
     void addField(const MetaField& field);
     void addField(MetaField&& field);
 
+    // the MetaField for the entries of an array field
+    static std::shared_ptr<MetaField> createFieldWithoutArray(const MetaField& field);
+
     int getFieldsSize() const
     {
         return m_fields.size();
     }
 
 private:
-    std::string                                                         m_typeName;
-    std::vector<std::shared_ptr<const MetaField>>                       m_fields;
-    std::unordered_map<std::string, std::shared_ptr<const MetaField>>   m_name2Field;
+    std::string                             m_typeName;
+    int                                     m_typeId = -1;      ///< index inside the IMetaData, -1 if not registered
+    std::vector<MetaField>                  m_fields;           ///< the proto id of a field is its index + 1
+    std::unordered_map<std::string, int>    m_name2Index;
 };
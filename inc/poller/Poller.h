@@ -93,6 +93,9 @@ struct IPoller
     virtual void removeSocket(const SocketDescriptorPtr& fd) = 0;
     virtual void enableWrite(const SocketDescriptorPtr& fd) = 0;
     virtual void disableWrite(const SocketDescriptorPtr& fd) = 0;
+    // A socket is polled for reading, when it is added. disableRead stops that till enableRead is called.
+    virtual void enableRead(const SocketDescriptorPtr& fd) = 0;
+    virtual void disableRead(const SocketDescriptorPtr& fd) = 0;
     virtual const PollerResult& wait(std::int32_t timeout) = 0;
     virtual void releaseWait() = 0;
 };
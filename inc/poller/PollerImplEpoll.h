@@ -26,6 +26,8 @@ private:
     virtual void removeSocket(const SocketDescriptorPtr& fd) override;
     virtual void enableWrite(const SocketDescriptorPtr& fd) override;
     virtual void disableWrite(const SocketDescriptorPtr& fd) override;
+    virtual void enableRead(const SocketDescriptorPtr& fd) override;
+    virtual void disableRead(const SocketDescriptorPtr& fd) override;
     virtual const PollerResult& wait(std::int32_t timeout) override;
     virtual void releaseWait() override;
 
@@ -34,11 +36,14 @@ private:
     void sockedDescriptorHasChanged();
     void collectSockets(int res);
     void releaseWaitInternal();
+    void modifyEvents(const SocketDescriptorPtr& fd);
 
     SocketDescriptorPtr m_controlSocketRead;
     SocketDescriptorPtr m_controlSocketWrite;
 
     std::unordered_set<SocketDescriptorPtr> m_socketDescriptors;
+    std::unordered_set<SOCKET>              m_writeEnabled;
+    std::unordered_set<SOCKET>              m_readDisabled;
 
     PollerResult    m_result;
     int             m_fdEpoll = -1;
@@ -23,6 +23,8 @@ private:
     virtual void removeSocket(const SocketDescriptorPtr& fd) override;
     virtual void enableWrite(const SocketDescriptorPtr& fd) override;
     virtual void disableWrite(const SocketDescriptorPtr& fd) override;
+    virtual void enableRead(const SocketDescriptorPtr& fd) override;
+    virtual void disableRead(const SocketDescriptorPtr& fd) override;
     virtual const PollerResult& wait(std::int32_t timeout) override;
     virtual void releaseWait() override;
 
@@ -39,6 +41,7 @@ private:
     SocketDescriptorPtr m_controlSocketWrite;
 
     std::unordered_set<SocketDescriptorPtr> m_socketDescriptors;
+    std::unordered_set<SOCKET>              m_readDisabled;
 
     PollerResult m_result;
     fd_set m_readfdsCached;
@@ -7,11 +7,25 @@ struct IProtocolSession
 {
     virtual ~IProtocolSession() {}
     virtual IMessagePtr createMessage() const = 0;
-    virtual bool sendMessage(const IMessagePtr& msg) = 0;
+    virtual bool sendMessage(const IMessagePtr& msg, MessagePriority priority = MESSAGEPRIORITY_NORMAL) = 0;
+    // see IStreamConnection::sendMessageConflated
+    virtual bool sendMessageConflated(const IMessagePtr& msg, const std::string& conflationKey, MessagePriority priority = MESSAGEPRIORITY_NORMAL) = 0;
+    virtual int getPendingMessages() const = 0;
     virtual std::int64_t getSessionId() const = 0;
+    virtual int getProtocolId() const = 0;
+    // Prepares the message for the protocol of the session. The prepared message can be sent to all sessions
+    // with the same protocol id without encoding it again. Returns nullptr, if the protocol cannot resend messages.
+    virtual IMessagePtr prepareMessage(const IMessagePtr& msg) = 0;
     virtual const ConnectionData& getConnectionData() const = 0;
     virtual SocketPtr getSocket() = 0;
     virtual void disconnect() = 0;
+    // see IStreamConnection::setCoalescing, the setting survives a reconnect.
+    virtual void setCoalescing(int maxBytes, int maxMessages, int deadlineUs) = 0;
+    virtual void flush() = 0;
+    // see IStreamConnection::disableRead, enableRead and notifyWhenSent
+    virtual void disableRead() = 0;
+    virtual void enableRead() = 0;
+    virtual void notifyWhenSent(std::function<void()> func) = 0;
 };
 
 struct IProtocolSession;
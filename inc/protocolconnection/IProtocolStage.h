@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+
+// A stage of a ProtocolPipeline. A stage transforms the whole payload of a message,
+// encode() on the send side and decode() in the reverse order on the receive side.
+struct IProtocolStage
+{
+    virtual ~IProtocolStage() {}
+    virtual int getStageId() const = 0;
+    virtual void encode(std::string& payload) = 0;
+    // returns false, if the payload is corrupt. The message will be dropped.
+    virtual bool decode(std::string& payload) = 0;
+};
+
+typedef std::shared_ptr<IProtocolStage>  IProtocolStagePtr;
+
+
+struct IProtocolStageFactory
+{
+    virtual ~IProtocolStageFactory() {}
+    virtual IProtocolStagePtr createStage() = 0;
+};
+
+typedef std::shared_ptr<IProtocolStageFactory>  IProtocolStageFactoryPtr;
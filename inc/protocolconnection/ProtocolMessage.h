@@ -20,6 +20,8 @@ private:
     virtual void addSendPayload(const char* payload, int size) override;
     virtual char* addSendPayload(int size) override;
     virtual void downsizeLastSendPayload(int newSize) override;
+    virtual void addSendPayloadReference(const char* payload, int size, const std::shared_ptr<const void>& owner) override;
+    virtual const std::shared_ptr<const void>& getSendPayloadOwner() const override;
 
     // for receive
     virtual BufferRef getReceivePayload() override;
@@ -37,6 +39,9 @@ private:
     virtual char* addSendHeader(int size) override;
     virtual void downsizeLastSendHeader(int newSize) override;
 
+    // for the protocol to send the buffers of another message instead of the own send buffers
+    virtual void setSendBufferMessage(const IMessagePtr& msg) override;
+
     // for the protocol to prepare the message for send
     virtual void prepareMessageToSend() override;
 
@@ -47,6 +52,9 @@ private:
     virtual void addMessage(const IMessagePtr& msg) override;
     virtual IMessagePtr getMessage(int protocolId) const override;
 
+    virtual void setSequenceNumber(std::uint64_t sequenceNumber) override;
+    virtual std::uint64_t getSequenceNumber() const override;
+
 private:
     // send
     std::list<std::string>      m_headerBuffers;
@@ -56,6 +64,8 @@ private:
     int                         m_sizeSendBufferTotal = 0;
     std::list<BufferRef>        m_sendPayloadRefs;
     int                         m_sizeSendPayloadTotal = 0;
+    IMessagePtr                 m_sendBufferMessage;
+    std::shared_ptr<const void> m_sendPayloadOwner;
 
     // receive
     std::string                 m_receiveBuffer;
@@ -68,5 +78,6 @@ private:
     const int                   m_protocolId;
 
     std::unordered_map<int, IMessagePtr> m_messages;
+    std::uint64_t               m_sequenceNumber = 0;
 };
 
@@ -4,6 +4,9 @@
 #include "IProtocol.h"
 #include "ProtocolSessionList.h"
 #include "IProtocolSession.h"
+#include "helpers/Executor.h"
+
+#include <atomic>
 
 
 
@@ -26,12 +29,12 @@ class ProtocolSession : public IProtocolSessionPrivate
                       , public std::enable_shared_from_this<ProtocolSession>
 {
 public:
-    ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList);
-    ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const std::shared_ptr<IStreamConnectionContainer>& streamConnectionContainer, const std::string& endpoint, int reconnectInterval, int totalReconnectDuration);
+    ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const std::weak_ptr<IExecutor>& executor, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList);
+    ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const std::weak_ptr<IExecutor>& executor, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const std::shared_ptr<IStreamConnectionContainer>& streamConnectionContainer, const std::string& endpoint, int reconnectInterval, int totalReconnectDuration);
 
 #ifdef USE_OPENSSL
-    ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const CertificateData& certificateData);
-    ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const std::shared_ptr<IStreamConnectionContainer>& streamConnectionContainer, const std::string& endpoint, const CertificateData& certificateData, int reconnectInterval, int totalReconnectDuration);
+    ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const std::weak_ptr<IExecutor>& executor, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const CertificateData& certificateData);
+    ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const std::weak_ptr<IExecutor>& executor, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const std::shared_ptr<IStreamConnectionContainer>& streamConnectionContainer, const std::string& endpoint, const CertificateData& certificateData, int reconnectInterval, int totalReconnectDuration);
 #endif
 
     virtual ~ProtocolSession();
@@ -39,11 +42,20 @@ public:
 private:
     // IProtocolSession
     virtual IMessagePtr createMessage() const override;
-    virtual bool sendMessage(const IMessagePtr& msg) override;
+    virtual bool sendMessage(const IMessagePtr& msg, MessagePriority priority = MESSAGEPRIORITY_NORMAL) override;
+    virtual bool sendMessageConflated(const IMessagePtr& msg, const std::string& conflationKey, MessagePriority priority = MESSAGEPRIORITY_NORMAL) override;
+    virtual int getPendingMessages() const override;
     virtual std::int64_t getSessionId() const;
+    virtual int getProtocolId() const override;
+    virtual IMessagePtr prepareMessage(const IMessagePtr& msg) override;
     virtual const ConnectionData& getConnectionData() const override;
     virtual SocketPtr getSocket() override;
     virtual void disconnect() override;
+    virtual void setCoalescing(int maxBytes, int maxMessages, int deadlineUs) override;
+    virtual void flush() override;
+    virtual void disableRead() override;
+    virtual void enableRead() override;
+    virtual void notifyWhenSent(std::function<void()> func) override;
 
     // IStreamConnectionCallback
     virtual bex::hybrid_ptr<IStreamConnectionCallback> connected(const IStreamConnectionPtr& connection) override;
@@ -62,8 +74,12 @@ private:
     virtual void socketDisconnected() override;
     virtual void reconnect() override;
 
+    IMessagePtr convertMessage(const IMessagePtr& msg);
+    void callCallback(const std::function<void(IProtocolSessionCallback& callback, const IProtocolSessionPtr& session)>& func);
+
     IStreamConnectionPtr                            m_connection;
     bex::hybrid_ptr<IProtocolSessionCallback>       m_callback;
+    std::weak_ptr<IExecutor>                        m_executor;
     IProtocolPtr                                    m_protocol;
     int64_t                                         m_sessionId = 0;
     std::weak_ptr<IProtocolSessionList>             m_protocolSessionList;
@@ -73,6 +89,11 @@ private:
     const int                                       m_reconnectInterval = 5000;
     const int                                       m_totalReconnectDuration = -1;
 
+    int                                             m_coalescingMaxBytes = 0;
+    int                                             m_coalescingMaxMessages = 0;
+    int                                             m_coalescingDeadlineUs = 0;
+    std::atomic<bool>                               m_readDisabled{false};
+
 #ifdef USE_OPENSSL
     bool                                            m_ssl = false;
     CertificateData                                 m_certificateData;
@@ -12,7 +12,8 @@ struct IProtocolSessionContainer
 {
     virtual ~IProtocolSessionContainer() {}
 
-    virtual void init(int cycleTime = 100, int checkReconnectInterval = 1000) = 0;
+    // with an executor the callbacks of the sessions are called by the executor instead of the poller thread.
+    virtual void init(int cycleTime = 100, int checkReconnectInterval = 1000, const IExecutorPtr& executor = nullptr) = 0;
     virtual int bind(const std::string& endpoint, bex::hybrid_ptr<IProtocolSessionCallback> callback, IProtocolFactoryPtr protocolFactory) = 0;
     virtual void unbind(const std::string& endpoint) = 0;
     virtual IProtocolSessionPtr connect(const std::string& endpoint, bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, int reconnectInterval = 5000, int totalReconnectDuration = -1) = 0;
@@ -20,6 +21,8 @@ struct IProtocolSessionContainer
     virtual IProtocolSessionPtr getSession(std::int64_t sessionId) const = 0;
     virtual void threadEntry() = 0;
     virtual bool terminatePollerLoop(int timeout) = 0;
+    // see IStreamConnectionContainer::postToPollerLoop
+    virtual void postToPollerLoop(std::function<void()> action) = 0;
 
 #ifdef USE_OPENSSL
     virtual int bindSsl(const std::string& endpoint, bex::hybrid_ptr<IProtocolSessionCallback> callback, IProtocolFactoryPtr protocolFactory, const CertificateData& certificateData) = 0;
@@ -37,7 +40,7 @@ struct IStreamConnectionContainer;
 class ProtocolBind : public IStreamConnectionCallback
 {
 public:
-    ProtocolBind(bex::hybrid_ptr<IProtocolSessionCallback> callback, IProtocolFactoryPtr protocolFactory, const std::weak_ptr<IProtocolSessionList>& protocolSessionList);
+    ProtocolBind(bex::hybrid_ptr<IProtocolSessionCallback> callback, const std::weak_ptr<IExecutor>& executor, IProtocolFactoryPtr protocolFactory, const std::weak_ptr<IProtocolSessionList>& protocolSessionList);
 
 private:
     // IStreamConnectionCallback
@@ -46,6 +49,7 @@ private:
     virtual void received(const IStreamConnectionPtr& connection, const SocketPtr& socket, int bytesToRead) override;
 
     bex::hybrid_ptr<IProtocolSessionCallback>    m_callback;
+    std::weak_ptr<IExecutor>                     m_executor;
     IProtocolFactoryPtr                          m_protocolFactory;
     std::weak_ptr<IProtocolSessionList>          m_protocolSessionList;
 };
@@ -64,7 +68,7 @@ public:
 
 private:
     // IProtocolSessionContainer
-    virtual void init(int cycleTime = 100, int checkReconnectInterval = 1000) override;
+    virtual void init(int cycleTime = 100, int checkReconnectInterval = 1000, const IExecutorPtr& executor = nullptr) override;
     virtual int bind(const std::string& endpoint, bex::hybrid_ptr<IProtocolSessionCallback> callback, IProtocolFactoryPtr protocolFactory) override;
     virtual void unbind(const std::string& endpoint) override;
     virtual IProtocolSessionPtr connect(const std::string& endpoint, bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, int reconnectInterval = 5000, int totalReconnectDuration = -1) override;
@@ -72,6 +76,7 @@ private:
     virtual IProtocolSessionPtr getSession(std::int64_t sessionId) const override;
     virtual void threadEntry() override;
     virtual bool terminatePollerLoop(int timeout) override;
+    virtual void postToPollerLoop(std::function<void()> action) override;
 
 #ifdef USE_OPENSSL
     virtual int bindSsl(const std::string& endpoint, bex::hybrid_ptr<IProtocolSessionCallback> callback, IProtocolFactoryPtr protocolFactory, const CertificateData& certificateData) override;
@@ -82,5 +87,6 @@ private:
     IProtocolSessionListPtr                                     m_protocolSessionList;
     std::unordered_map<std::string,  ProtocolBindPtr>           m_endpoint2Bind;
     std::shared_ptr<IStreamConnectionContainer>                 m_streamConnectionContainer;
+    IExecutorPtr                                                m_executor;
     mutable std::mutex                                          m_mutex;
 };
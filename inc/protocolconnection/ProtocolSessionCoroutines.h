@@ -0,0 +1,415 @@
+#pragma once
+
+// Optional coroutine layer on top of the session callbacks. It is header only and
+// available, if the code that includes it is compiled with C++20 coroutines.
+#if defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)
+
+#include "protocolconnection/ProtocolSessionContainer.h"
+
+#include <coroutine>
+#include <exception>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <assert.h>
+
+
+
+// A coroutine, which starts immediately and destroys itself, when it is finished.
+// Start one task per flow, e.g. per outstanding request.
+struct SessionTask
+{
+    struct promise_type
+    {
+        SessionTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+
+
+// Turns the callbacks of the sessions into awaitables. Pass it as callback to bind/connect of the
+// container or use connect() of this class. A coroutine is resumed by the thread that calls the
+// callback (the poller thread or the executor of the container), timers resume on the timer thread.
+// Only one coroutine at a time shall wait for the messages of a session. When maxQueuedMessages
+// messages of a session are waiting to be received, the session stops reading from its socket.
+class ProtocolSessionCoroutines : public IProtocolSessionCallback
+                                , public std::enable_shared_from_this<ProtocolSessionCoroutines>
+{
+public:
+    ProtocolSessionCoroutines(const IProtocolSessionContainerPtr& container, int maxQueuedMessages = 1000)
+        : m_container(container)
+        , m_maxQueuedMessages(maxQueuedMessages)
+        , m_timerThread([this] () { timerLoop(); })
+    {
+        assert(m_maxQueuedMessages > 0);
+    }
+
+    ~ProtocolSessionCoroutines()
+    {
+        std::unique_lock<std::mutex> lock(m_mutexTimer);
+        m_terminateTimer = true;
+        lock.unlock();
+        m_condTimer.notify_one();
+        m_timerThread.join();
+    }
+
+    // co_await returns the session, when it is connected, or nullptr if the connect failed.
+    auto connect(const std::string& endpoint, const IProtocolPtr& protocol, int reconnectInterval = 5000, int totalReconnectDuration = -1)
+    {
+        struct Awaiter
+        {
+            ProtocolSessionCoroutines& coroutines;
+            std::string endpoint;
+            IProtocolPtr protocol;
+            int reconnectInterval;
+            int totalReconnectDuration;
+            IProtocolSessionPtr session;
+
+            bool await_ready() { return false; }
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                // connect without the lock, the callbacks of the poller thread must not wait for the name resolution.
+                // The session id is known after connect, so a connected or disconnected callback, which came
+                // first, is detected by the state it left.
+                session = coroutines.m_container->connect(endpoint, coroutines.shared_from_this(), protocol, reconnectInterval, totalReconnectDuration);
+                if (!session)
+                {
+                    return false;
+                }
+                std::unique_lock<std::mutex> lock(coroutines.m_mutex);
+                SessionState* state = coroutines.findState(session);
+                if (!state || state->connected || state->disconnected)
+                {
+                    return false;
+                }
+                state->waitingConnect = handle;
+                return true;
+            }
+            IProtocolSessionPtr await_resume()
+            {
+                std::unique_lock<std::mutex> lock(coroutines.m_mutex);
+                if (session)
+                {
+                    auto it = coroutines.m_sessions.find(session->getSessionId());
+                    if (it == coroutines.m_sessions.end() || !it->second.connected)
+                    {
+                        return nullptr;
+                    }
+                }
+                return session;
+            }
+        };
+        return Awaiter{*this, endpoint, protocol, reconnectInterval, totalReconnectDuration, nullptr};
+    }
+
+    // co_await returns the next incoming session of the binds, which use this object as callback.
+    auto accept()
+    {
+        struct Awaiter
+        {
+            ProtocolSessionCoroutines& coroutines;
+            IProtocolSessionPtr session;
+
+            bool await_ready() { return false; }
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                std::unique_lock<std::mutex> lock(coroutines.m_mutex);
+                if (!coroutines.m_accepted.empty())
+                {
+                    session = coroutines.m_accepted.front();
+                    coroutines.m_accepted.pop_front();
+                    return false;
+                }
+                coroutines.m_waitingAccept.push_back({handle, &session});
+                return true;
+            }
+            IProtocolSessionPtr await_resume() { return session; }
+        };
+        return Awaiter{*this, nullptr};
+    }
+
+    // co_await returns the next message of the session, or nullptr if the session is disconnected.
+    auto receive(const IProtocolSessionPtr& session)
+    {
+        struct Awaiter
+        {
+            ProtocolSessionCoroutines& coroutines;
+            IProtocolSessionPtr session;
+            IMessagePtr message;
+
+            bool await_ready() { return false; }
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                std::unique_lock<std::mutex> lock(coroutines.m_mutex);
+                SessionState* state = coroutines.findState(session);
+                if (!state)
+                {
+                    return false;
+                }
+                if (!state->messages.empty())
+                {
+                    message = state->messages.front();
+                    state->messages.pop_front();
+                    bool enableRead = (state->readDisabled && static_cast<int>(state->messages.size()) <= coroutines.m_maxQueuedMessages / 2);
+                    if (enableRead)
+                    {
+                        state->readDisabled = false;
+                    }
+                    lock.unlock();
+                    if (enableRead)
+                    {
+                        session->enableRead();
+                    }
+                    return false;
+                }
+                if (state->disconnected)
+                {
+                    coroutines.m_sessions.erase(session->getSessionId());
+                    return false;
+                }
+                assert(!state->waitingReceive);
+                state->waitingReceive = handle;
+                state->message = &message;
+                return true;
+            }
+            IMessagePtr await_resume() { return message; }
+        };
+        assert(session);
+        return Awaiter{*this, session, nullptr};
+    }
+
+    // Sends the message, co_await resumes, when all pending messages of the session are written to the socket.
+    // Returns false, if the session is disconnected. The coroutine is resumed by the poller thread.
+    auto sendMessage(const IProtocolSessionPtr& session, const IMessagePtr& message, MessagePriority priority = MESSAGEPRIORITY_NORMAL)
+    {
+        struct Awaiter
+        {
+            IProtocolSessionPtr session;
+            IMessagePtr message;
+            MessagePriority priority;
+            bool sent = false;
+
+            bool await_ready() { return false; }
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                sent = session->sendMessage(message, priority);
+                if (!sent)
+                {
+                    return false;
+                }
+                // 1: notified, 2: suspended. The one who comes second knows whether to resume.
+                std::shared_ptr<std::atomic<int>> state = std::make_shared<std::atomic<int>>(0);
+                session->notifyWhenSent([state, handle] () {
+                    if (state->exchange(1) == 2)
+                    {
+                        handle.resume();
+                    }
+                });
+                int expected = 0;
+                return state->compare_exchange_strong(expected, 2);
+            }
+            bool await_resume()
+            {
+                return (sent && session->getConnectionData().connectionState == CONNECTIONSTATE_CONNECTED);
+            }
+        };
+        assert(session);
+        return Awaiter{session, message, priority};
+    }
+
+    // co_await resumes after the duration on the timer thread.
+    auto sleepFor(std::chrono::milliseconds duration)
+    {
+        struct Awaiter
+        {
+            ProtocolSessionCoroutines& coroutines;
+            std::chrono::steady_clock::time_point deadline;
+
+            bool await_ready() { return (deadline <= std::chrono::steady_clock::now()); }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                // notify under the lock, the timer thread could resume and destroy this awaiter after the unlock.
+                std::unique_lock<std::mutex> lock(coroutines.m_mutexTimer);
+                bool earliest = (coroutines.m_timers.empty() || deadline < coroutines.m_timers.begin()->first);
+                coroutines.m_timers.emplace(deadline, handle);
+                if (earliest)
+                {
+                    coroutines.m_condTimer.notify_one();
+                }
+            }
+            void await_resume() {}
+        };
+        return Awaiter{*this, std::chrono::steady_clock::now() + duration};
+    }
+
+private:
+    // IProtocolSessionCallback
+    virtual void connected(const IProtocolSessionPtr& session) override
+    {
+        std::coroutine_handle<> handle;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (session->getConnectionData().incomingConnection)
+        {
+            if (!m_waitingAccept.empty())
+            {
+                handle = m_waitingAccept.front().first;
+                *m_waitingAccept.front().second = session;
+                m_waitingAccept.pop_front();
+            }
+            else
+            {
+                m_accepted.push_back(session);
+            }
+        }
+        else
+        {
+            SessionState& state = m_sessions[session->getSessionId()];
+            state.connected = true;
+            std::swap(handle, state.waitingConnect);
+        }
+        lock.unlock();
+        if (handle)
+        {
+            handle.resume();
+        }
+    }
+
+    virtual void disconnected(const IProtocolSessionPtr& session) override
+    {
+        std::coroutine_handle<> handleReceive;
+        std::coroutine_handle<> handleConnect;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        SessionState& state = m_sessions[session->getSessionId()];
+        state.disconnected = true;
+        std::swap(handleConnect, state.waitingConnect);
+        std::swap(handleReceive, state.waitingReceive);
+        // keep the state only for the messages, which were not received yet
+        if (handleReceive || state.messages.empty())
+        {
+            m_sessions.erase(session->getSessionId());
+        }
+        lock.unlock();
+        if (handleConnect)
+        {
+            handleConnect.resume();
+        }
+        if (handleReceive)
+        {
+            handleReceive.resume();
+        }
+    }
+
+    virtual void received(const IProtocolSessionPtr& session, const IMessagePtr& message) override
+    {
+        std::coroutine_handle<> handle;
+        bool disableRead = false;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        SessionState& state = m_sessions[session->getSessionId()];
+        if (state.waitingReceive)
+        {
+            *state.message = message;
+            std::swap(handle, state.waitingReceive);
+        }
+        else
+        {
+            state.messages.push_back(message);
+            // disable again, also if someone else has enabled the reading meanwhile
+            if (static_cast<int>(state.messages.size()) >= m_maxQueuedMessages)
+            {
+                state.readDisabled = true;
+                disableRead = true;
+            }
+        }
+        lock.unlock();
+        if (disableRead)
+        {
+            session->disableRead();
+        }
+        if (handle)
+        {
+            handle.resume();
+        }
+    }
+
+    virtual void socketConnected(const IProtocolSessionPtr& session) override
+    {
+    }
+
+    virtual void socketDisconnected(const IProtocolSessionPtr& session) override
+    {
+    }
+
+    void timerLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutexTimer);
+        while (!m_terminateTimer)
+        {
+            if (m_timers.empty())
+            {
+                m_condTimer.wait(lock);
+            }
+            else if (m_timers.begin()->first > std::chrono::steady_clock::now())
+            {
+                m_condTimer.wait_until(lock, m_timers.begin()->first);
+            }
+            else
+            {
+                std::coroutine_handle<> handle = m_timers.begin()->second;
+                m_timers.erase(m_timers.begin());
+                lock.unlock();
+                handle.resume();
+                lock.lock();
+            }
+        }
+    }
+
+    struct SessionState
+    {
+        std::deque<IMessagePtr>     messages;
+        std::coroutine_handle<>     waitingReceive;
+        IMessagePtr*                message = nullptr;
+        std::coroutine_handle<>     waitingConnect;
+        bool                        connected = false;
+        bool                        disconnected = false;
+        bool                        readDisabled = false;
+    };
+
+    // the state of a disconnected session is removed, when all its messages are received.
+    SessionState* findState(const IProtocolSessionPtr& session)
+    {
+        auto it = m_sessions.find(session->getSessionId());
+        if (it == m_sessions.end())
+        {
+            if (session->getConnectionData().connectionState == CONNECTIONSTATE_DISCONNECTED)
+            {
+                return nullptr;
+            }
+            it = m_sessions.emplace(session->getSessionId(), SessionState()).first;
+        }
+        return &it->second;
+    }
+
+    IProtocolSessionContainerPtr                                                m_container;
+    const int                                                                   m_maxQueuedMessages;
+    std::unordered_map<std::int64_t, SessionState>                              m_sessions;
+    std::deque<IProtocolSessionPtr>                                             m_accepted;
+    std::deque<std::pair<std::coroutine_handle<>, IProtocolSessionPtr*>>        m_waitingAccept;
+    std::mutex                                                                  m_mutex;
+
+    std::multimap<std::chrono::steady_clock::time_point, std::coroutine_handle<>> m_timers;
+    bool                                                                        m_terminateTimer = false;
+    std::condition_variable                                                     m_condTimer;
+    std::mutex                                                                  m_mutexTimer;
+    std::thread                                                                 m_timerThread;
+};
+
+#endif
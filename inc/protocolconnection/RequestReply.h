@@ -0,0 +1,123 @@
+#pragma once
+
+#include "protocolconnection/IProtocolSession.h"
+#include "helpers/hybrid_ptr.h"
+
+#include <functional>
+#include <future>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+
+enum ReplyStatus
+{
+    REPLYSTATUS_OK = 0,
+    REPLYSTATUS_TIMEOUT = 1,
+    REPLYSTATUS_DISCONNECTED = 2,
+};
+
+struct Reply
+{
+    ReplyStatus     status = REPLYSTATUS_OK;
+    // the received message holds the memory of the payload
+    IMessagePtr     message;
+    BufferRef       payload{nullptr, 0};
+};
+
+typedef std::function<void(const Reply& reply)> FuncReply;
+
+
+
+struct IRequestReplyCallback
+{
+    virtual ~IRequestReplyCallback() {}
+    virtual void connected(const IProtocolSessionPtr& session) = 0;
+    virtual void disconnected(const IProtocolSessionPtr& session) = 0;
+    // answer the request with sendReply and the correlationId, also later from another thread.
+    virtual void receivedRequest(const IProtocolSessionPtr& session, std::uint64_t correlationId, const IMessagePtr& message, const BufferRef& payload) = 0;
+};
+
+
+
+struct IRequestReply
+{
+    virtual ~IRequestReply() {}
+    // timeout in [ms], -1 = no timeout. Returns false, if the request could not be sent, then funcReply is not called.
+    virtual bool sendRequest(const IProtocolSessionPtr& session, const char* payload, int size, int timeout, FuncReply funcReply) = 0;
+    virtual std::future<Reply> sendRequest(const IProtocolSessionPtr& session, const char* payload, int size, int timeout) = 0;
+    virtual bool sendReply(const IProtocolSessionPtr& session, std::uint64_t correlationId, const char* payload, int size) = 0;
+    virtual int getNumberOfPendingRequests() const = 0;
+};
+
+typedef std::shared_ptr<IRequestReply> IRequestReplyPtr;
+
+
+
+// Request/reply correlation on top of the sessions. Use it as the session callback for bind and connect.
+// Every message gets an envelope with the message type and the correlation id. The outstanding
+// requests are kept in a hash table per session, the timeouts in a timer wheel, which is driven
+// by an own thread with the resolution of tickInterval.
+class RequestReply : public IRequestReply
+                   , public IProtocolSessionCallback
+{
+public:
+    RequestReply(bex::hybrid_ptr<IRequestReplyCallback> callback, int tickInterval = 10, int wheelSize = 256);
+    ~RequestReply();
+
+    static const int ENVELOPE_SIZE = 9;
+
+private:
+    // IRequestReply
+    virtual bool sendRequest(const IProtocolSessionPtr& session, const char* payload, int size, int timeout, FuncReply funcReply) override;
+    virtual std::future<Reply> sendRequest(const IProtocolSessionPtr& session, const char* payload, int size, int timeout) override;
+    virtual bool sendReply(const IProtocolSessionPtr& session, std::uint64_t correlationId, const char* payload, int size) override;
+    virtual int getNumberOfPendingRequests() const override;
+
+    // IProtocolSessionCallback
+    virtual void connected(const IProtocolSessionPtr& session) override;
+    virtual void disconnected(const IProtocolSessionPtr& session) override;
+    virtual void received(const IProtocolSessionPtr& session, const IMessagePtr& message) override;
+    virtual void socketConnected(const IProtocolSessionPtr& session) override;
+    virtual void socketDisconnected(const IProtocolSessionPtr& session) override;
+
+    enum EnvelopeType
+    {
+        ENVELOPE_REQUEST = 1,
+        ENVELOPE_REPLY = 2,
+    };
+
+    struct SessionRequests
+    {
+        std::uint64_t                               nextCorrelationId = 1;
+        std::unordered_map<std::uint64_t, FuncReply> pending;
+    };
+
+    struct TimerEntry
+    {
+        std::int64_t    sessionId;
+        std::uint64_t   correlationId;
+        int             rounds;
+    };
+
+    bool sendEnvelope(const IProtocolSessionPtr& session, EnvelopeType type, std::uint64_t correlationId, const char* payload, int size);
+    void addTimer(std::int64_t sessionId, std::uint64_t correlationId, int timeout);
+    void timerLoop();
+    void tick();
+
+    bex::hybrid_ptr<IRequestReplyCallback>                  m_callback;
+    std::unordered_map<std::int64_t, SessionRequests>       m_sessionRequests;
+    int                                                     m_numberOfPendingRequests = 0;
+
+    const int                                               m_tickInterval;
+    std::vector<std::vector<TimerEntry>>                    m_wheel;
+    size_t                                                  m_wheelPosition = 0;
+
+    bool                                                    m_terminate = false;
+    std::condition_variable                                 m_condTerminate;
+    mutable std::mutex                                      m_mutex;
+    std::thread                                             m_thread;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "streamconnection/IMessage.h"
+#include "protocolconnection/IProtocol.h"
+#include "protocolconnection/IProtocolStage.h"
+
+#include <vector>
+
+
+
+
+// The pipeline uses a framing protocol (e.g. ProtocolHeaderBinarySize) for the socket
+// and passes the payload of every message through a chain of stages (e.g. compression, checksum).
+class ProtocolPipeline : public IProtocol
+{
+public:
+    ProtocolPipeline(const IProtocolPtr& protocolFraming, const std::vector<IProtocolStagePtr>& stages);
+
+private:
+    // IProtocol
+    virtual void setCallback(const std::weak_ptr<IProtocolCallback>& callback) override;
+    virtual int getProtocolId() const override;
+    virtual bool areMessagesResendable() const override;
+    virtual IMessagePtr createMessage() const override;
+    virtual void receive(const SocketPtr& socket, int bytesToRead) override;
+    virtual void prepareMessageToSend(IMessagePtr message) override;
+    virtual void socketConnected() override;
+    virtual void socketDisconnected() override;
+
+    void receivedFraming(const IMessagePtr& message);
+
+    // callback of the framing protocol
+    class FramingCallback : public IProtocolCallback
+    {
+    public:
+        FramingCallback(ProtocolPipeline& pipeline);
+    private:
+        virtual void connected() override;
+        virtual void disconnected() override;
+        virtual void received(const IMessagePtr& message) override;
+        virtual void socketConnected() override;
+        virtual void socketDisconnected() override;
+        virtual void reconnect() override;
+
+        ProtocolPipeline& m_pipeline;
+    };
+
+    std::weak_ptr<IProtocolCallback>    m_callback;
+    IProtocolPtr                        m_protocolFraming;
+    std::vector<IProtocolStagePtr>      m_stages;
+    std::shared_ptr<FramingCallback>    m_framingCallback;
+
+    int                                 m_protocolId = 0;
+};
+
+
+class ProtocolPipelineFactory : public IProtocolFactory
+{
+public:
+    ProtocolPipelineFactory(const IProtocolFactoryPtr& protocolFactoryFraming, const std::vector<IProtocolStageFactoryPtr>& stageFactories);
+
+private:
+    // IProtocolFactory
+    virtual IProtocolPtr createProtocol() override;
+
+    IProtocolFactoryPtr                     m_protocolFactoryFraming;
+    std::vector<IProtocolStageFactoryPtr>   m_stageFactories;
+};
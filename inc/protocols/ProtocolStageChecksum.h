@@ -0,0 +1,36 @@
+#pragma once
+
+#include "protocolconnection/IProtocolStage.h"
+
+#include <cstdint>
+
+
+
+
+// Integrity stage for the ProtocolPipeline: appends a CRC32 of the payload (4 bytes, little endian)
+// and drops received messages with a wrong checksum.
+class ProtocolStageChecksum : public IProtocolStage
+{
+public:
+    ProtocolStageChecksum();
+
+    static std::uint32_t crc32(const char* buffer, int size);
+
+private:
+    // IProtocolStage
+    virtual int getStageId() const override;
+    virtual void encode(std::string& payload) override;
+    virtual bool decode(std::string& payload) override;
+
+    const int                           m_stageId = 0x2c8f6a41;
+};
+
+
+class ProtocolStageChecksumFactory : public IProtocolStageFactory
+{
+public:
+
+private:
+    // IProtocolStageFactory
+    virtual IProtocolStagePtr createStage() override;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "protocolconnection/IProtocolStage.h"
+
+#include <cstdint>
+
+typedef struct z_stream_s z_stream;
+typedef struct ZSTD_CCtx_s ZSTD_CCtx;
+typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+typedef struct ZSTD_CDict_s ZSTD_CDict;
+typedef struct ZSTD_DDict_s ZSTD_DDict;
+typedef union LZ4_stream_u LZ4_stream_t;
+
+
+enum CompressionAlgorithm
+{
+    COMPRESSION_NONE = 0,
+    COMPRESSION_ZLIB = 1,
+    COMPRESSION_ZSTD = 2,
+    COMPRESSION_LZ4 = 3,
+};
+
+
+// Compression stage for the ProtocolPipeline. Every frame starts with a flag byte
+// (algorithm in the low nibble, 0x10 if a dictionary was used). Payloads smaller than
+// the threshold, or payloads that do not shrink, are sent uncompressed behind the flag byte.
+// Compressed frames carry the uncompressed size (4 bytes) and, if a dictionary was used,
+// the CRC32 of the dictionary (4 bytes), so that both sides must have loaded the same dictionary.
+// The receiver decodes every algorithm that was available at build time. Frames that announce more than
+// maxDecodedSize bytes, or more than maxRatio times their compressed size, are rejected before any allocation.
+class ProtocolStageCompression : public IProtocolStage
+{
+public:
+    static const int DEFAULT_MAX_DECODED_SIZE = 64 * 1024 * 1024;
+    static const int DEFAULT_MAX_RATIO = 4096;
+
+    // level -1: default level of the algorithm, maxRatio 0: no ratio check
+    ProtocolStageCompression(CompressionAlgorithm algorithm = COMPRESSION_ZLIB, int threshold = 256, const std::shared_ptr<const std::string>& dictionary = nullptr, int level = -1,
+                             int maxDecodedSize = DEFAULT_MAX_DECODED_SIZE, int maxRatio = DEFAULT_MAX_RATIO);
+    virtual ~ProtocolStageCompression();
+
+    static bool isAlgorithmAvailable(CompressionAlgorithm algorithm);
+    static std::shared_ptr<const std::string> loadDictionary(const std::string& filename);
+
+private:
+    // IProtocolStage
+    virtual int getStageId() const override;
+    virtual void encode(std::string& payload) override;
+    virtual bool decode(std::string& payload) override;
+
+    int compress(const std::string& payload, char* dest, int sizeDest);
+    bool decompress(CompressionAlgorithm algorithm, bool withDictionary, const char* src, int sizeSrc, char* dest, int sizeDest);
+    int compressBound(int size) const;
+
+    CompressionAlgorithm                m_algorithm = COMPRESSION_ZLIB;
+    int                                 m_threshold = 256;
+    std::shared_ptr<const std::string>  m_dictionary;
+    std::uint32_t                       m_dictionaryId = 0;
+    int                                 m_level = -1;
+    int                                 m_maxDecodedSize = DEFAULT_MAX_DECODED_SIZE;
+    int                                 m_maxRatio = DEFAULT_MAX_RATIO;
+
+    std::unique_ptr<z_stream>           m_deflate;
+    std::unique_ptr<z_stream>           m_inflate;
+
+    ZSTD_CCtx*                          m_zstdCCtx = nullptr;
+    ZSTD_DCtx*                          m_zstdDCtx = nullptr;
+    ZSTD_CDict*                         m_zstdCDict = nullptr;
+    ZSTD_DDict*                         m_zstdDDict = nullptr;
+
+    LZ4_stream_t*                       m_lz4Stream = nullptr;
+    LZ4_stream_t*                       m_lz4DictStream = nullptr;  ///< the dictionary is loaded only once
+
+    const int                           m_stageId = 0x71c3d58e;
+};
+
+
+class ProtocolStageCompressionFactory : public IProtocolStageFactory
+{
+public:
+    ProtocolStageCompressionFactory(CompressionAlgorithm algorithm = COMPRESSION_ZLIB, int threshold = 256, const std::shared_ptr<const std::string>& dictionary = nullptr, int level = -1,
+                                    int maxDecodedSize = ProtocolStageCompression::DEFAULT_MAX_DECODED_SIZE, int maxRatio = ProtocolStageCompression::DEFAULT_MAX_RATIO);
+
+private:
+    // IProtocolStageFactory
+    virtual IProtocolStagePtr createStage() override;
+
+    CompressionAlgorithm                m_algorithm = COMPRESSION_ZLIB;
+    int                                 m_threshold = 256;
+    std::shared_ptr<const std::string>  m_dictionary;
+    int                                 m_level = -1;
+    int                                 m_maxDecodedSize = ProtocolStageCompression::DEFAULT_MAX_DECODED_SIZE;
+    int                                 m_maxRatio = ProtocolStageCompression::DEFAULT_MAX_RATIO;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "streamconnection/IMessage.h"
+#include "protocolconnection/IProtocol.h"
+
+#include <vector>
+
+
+
+
+// Frames every message with the varint of its size + 1 (1 byte for payloads below 127 bytes).
+// The varint 0 marks a batch frame: it is followed by the varint size of the batch and the batch
+// contains the messages, each with the varint of its size. The receiver delivers every message of
+// a batch separately. Frames larger than maxFrameSize are rejected before any allocation.
+class ProtocolVarintSize : public IProtocol
+{
+public:
+    static const int DEFAULT_MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+    ProtocolVarintSize(int maxFrameSize = DEFAULT_MAX_FRAME_SIZE);
+
+    static const int PROTOCOL_ID = 0x1e4c7b52;
+
+    // packs several messages into one batch frame.
+    static IMessagePtr createBatchMessage(const std::vector<IMessagePtr>& messages);
+
+private:
+    // IProtocol
+    virtual void setCallback(const std::weak_ptr<IProtocolCallback>& callback) override;
+    virtual int getProtocolId() const override;
+    virtual bool areMessagesResendable() const override;
+    virtual IMessagePtr createMessage() const override;
+    virtual void receive(const SocketPtr& socket, int bytesToRead) override;
+    virtual void prepareMessageToSend(IMessagePtr message) override;
+    virtual void socketConnected() override;
+    virtual void socketDisconnected() override;
+
+    static void addHeader(const IMessagePtr& message, bool batch);
+    void parseReceiveBuffer(std::vector<IMessagePtr>& messages);
+    void frameReceived(const char* payload, int size, bool batch, std::vector<IMessagePtr>& messages);
+
+    std::weak_ptr<IProtocolCallback>    m_callback;
+    int                                 m_maxFrameSize = DEFAULT_MAX_FRAME_SIZE;
+
+    std::string                         m_receiveBuffer;
+    bool                                m_corrupt = false;
+
+    // frame, which is received directly into the message
+    IMessagePtr                         m_message;
+    char*                               m_payload = nullptr;
+    int                                 m_sizePayload = 0;
+    int                                 m_sizeCurrent = 0;
+    bool                                m_batch = false;
+};
+
+
+class ProtocolVarintSizeFactory : public IProtocolFactory
+{
+public:
+    ProtocolVarintSizeFactory(int maxFrameSize = ProtocolVarintSize::DEFAULT_MAX_FRAME_SIZE);
+
+private:
+    // IProtocolFactory
+    virtual IProtocolPtr createProtocol() override;
+
+    int                                 m_maxFrameSize = ProtocolVarintSize::DEFAULT_MAX_FRAME_SIZE;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "metadata/MetaStruct.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+
+// A compiled set of field paths, like "struct_string.value", that a parser keeps. All other fields are skipped
+// by the parsers without calling the visitor. A path that ends at a struct or an array of structs keeps all
+// fields below it, a path through an array of structs applies to all of its entries.
+class FieldMask
+{
+public:
+    struct Node
+    {
+        bool                                all = false;    ///< keep all fields of this struct and below
+        std::vector<std::unique_ptr<Node>>  fields;         ///< by field index, nullptr: field is skipped
+    };
+
+    FieldMask(const std::string& typeName, const std::vector<std::string>& paths);
+
+    // false, if the type or a path does not exist in the meta data
+    bool isValid() const;
+    const Node* getRoot() const;
+
+    // Returns false, if the field with index is skipped. Otherwise, child is the node for the fields below,
+    // nullptr means that all fields below are kept.
+    static bool select(const Node* node, int index, const Node*& child)
+    {
+        if (node == nullptr)
+        {
+            child = nullptr;
+            return true;
+        }
+        if (index < 0 || index >= static_cast<int>(node->fields.size()) || !node->fields[index])
+        {
+            return false;
+        }
+        const Node* c = node->fields[index].get();
+        child = c->all ? nullptr : c;
+        return true;
+    }
+
+private:
+    bool addPath(const MetaStruct& stru, const std::string& path);
+
+    bool    m_valid = true;
+    Node    m_root;
+};
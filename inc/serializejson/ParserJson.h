@@ -2,6 +2,7 @@
 
 #include "metadata/MetaStruct.h"
 #include "serialize/IParserVisitor.h"
+#include "serialize/FieldMask.h"
 #include "json/JsonParser.h"
 
 
@@ -15,7 +16,8 @@ class ParserJson : public IJsonParserVisitor
 public:
     ParserJson(IParserVisitor& visitor, const char* ptr, int size = CHECK_ON_ZEROTERM);
 
-    bool parseStruct(const std::string& typeName);
+    // fieldMask: only the fields of the mask are passed to the visitor, nullptr: all fields
+    bool parseStruct(const std::string& typeName, const FieldMask* fieldMask = nullptr);
 
 private:
     // IJsonParserVisitor
@@ -43,11 +45,13 @@ private:
 
     struct State
     {
-        explicit State(const MetaField* f)
+        State(const MetaField* f, const FieldMask::Node* m)
             : field(f)
+            , mask(m)
         {
         }
         const MetaField* field;
+        const FieldMask::Node* mask;
     };
 
     const char*         m_ptr = nullptr;
@@ -58,6 +62,8 @@ private:
     std::deque<State>   m_stack;
     const MetaStruct*   m_structCurrent = nullptr;
     const MetaField*    m_fieldCurrent = nullptr;
+    const FieldMask::Node* m_maskCurrent = nullptr;    ///< mask of the fields of m_structCurrent
+    const FieldMask::Node* m_maskField = nullptr;      ///< mask below m_fieldCurrent
 
     std::vector<bool>           m_arrayBool;
     std::vector<std::int32_t>   m_arrayInt32;
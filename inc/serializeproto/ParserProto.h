@@ -2,6 +2,7 @@
 
 #include "metadata/MetaStruct.h"
 #include "serialize/IParserVisitor.h"
+#include "serialize/FieldMask.h"
 
 
 #include <string>
@@ -25,13 +26,14 @@ class ParserProto
 public:
     ParserProto(IParserVisitor& visitor, const char* ptr, int size);
 
-    bool parseStruct(const std::string& typeName);
+    // fieldMask: only the fields of the mask are passed to the visitor, nullptr: all fields
+    bool parseStruct(const std::string& typeName, const FieldMask* fieldMask = nullptr);
 
 private:
     bool parseString(const char*& buffer, int& size);
-    void parseStructWire(const MetaField& field);
+    void parseStructWire(const MetaField& field, const FieldMask::Node* mask);
     bool parseStructIntern(const MetaStruct& stru);
-    void parseArrayStruct(const MetaField& field);
+    void parseArrayStruct(const MetaField& field, const FieldMask::Node* mask);
 
     template<class T>
     bool parseArrayString(std::vector<T>& array);
@@ -51,6 +53,9 @@ private:
     template<class T, bool ZIGZAG = false>
     bool parseArrayVarint(std::vector<T>& array);
 
+    template<class T, bool ZIGZAG>
+    bool parsePackedVarint(const char* buffer, int size, std::vector<T>& array);
+
     std::uint64_t parseVarint();
 
     template<class T>
@@ -66,4 +71,5 @@ private:
     IParserVisitor&     m_visitor;
 
     std::uint32_t       m_tag = 0;
+    const FieldMask::Node* m_mask = nullptr;
 };
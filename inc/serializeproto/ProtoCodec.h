@@ -0,0 +1,720 @@
+#pragma once
+
+#include "serializeproto/ParserProto.h"
+#include "metadata/MetaType.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string.h>
+#include <assert.h>
+
+
+// Runtime of the schema compiled proto codecs. The code generator (tools/protocodecgen) creates plain
+// structs of a .proto file and specializes ProtoCodec<T> for them. The generated codecs encode and
+// decode the structs directly, without IParserVisitor calls and without MetaStruct lookups.
+template<class T>
+struct ProtoCodec;
+
+
+enum ProtoKind
+{
+    PROTOKIND_BOOL,
+    PROTOKIND_INT32,
+    PROTOKIND_SINT32,
+    PROTOKIND_UINT32,
+    PROTOKIND_FIXED32,
+    PROTOKIND_SFIXED32,
+    PROTOKIND_INT64,
+    PROTOKIND_SINT64,
+    PROTOKIND_UINT64,
+    PROTOKIND_FIXED64,
+    PROTOKIND_SFIXED64,
+    PROTOKIND_FLOAT,
+    PROTOKIND_DOUBLE,
+    PROTOKIND_STRING,
+    PROTOKIND_BYTES,
+    PROTOKIND_ENUM,
+};
+
+
+
+// The sizes of the sub messages in the order of the size pass (pre-order). The write pass takes them
+// in the same order, so that the size of a sub message is computed only once, at any nesting depth.
+class ProtoSizes
+{
+public:
+    size_t add()
+    {
+        m_sizes.push_back(0);
+        return m_sizes.size() - 1;
+    }
+
+    void set(size_t index, size_t size)
+    {
+        m_sizes[index] = size;
+    }
+
+    // removes the sizes behind index, e.g. of the sub messages of a message, which is not written
+    void truncate(size_t index)
+    {
+        m_sizes.resize(index + 1);
+    }
+
+    size_t next()
+    {
+        assert(m_next < m_sizes.size());
+        return m_sizes[m_next++];
+    }
+
+private:
+    std::vector<size_t>     m_sizes;
+    size_t                  m_next = 0;
+};
+
+
+
+class ProtoWriter
+{
+public:
+    // without sizes the size of every sub message is computed while it is written
+    ProtoWriter(char* buffer, ProtoSizes* sizes = nullptr)
+        : m_buffer(buffer)
+        , m_sizes(sizes)
+    {
+    }
+
+    static size_t sizeVarint(std::uint64_t value)
+    {
+        size_t size = 1;
+        while (value >= 0x80)
+        {
+            value >>= 7;
+            ++size;
+        }
+        return size;
+    }
+
+    static size_t sizeTag(int id)
+    {
+        return sizeVarint(static_cast<std::uint32_t>(id) << 3);
+    }
+
+    void writeVarint(std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            *m_buffer++ = static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        *m_buffer++ = static_cast<char>(value);
+    }
+
+    void writeTag(int id, int wireType)
+    {
+        writeVarint((static_cast<std::uint32_t>(id) << 3) | wireType);
+    }
+
+    void writeFixed32(std::uint32_t value)
+    {
+        memcpy(m_buffer, &value, 4);   // little endian hosts only, like SerializerProto
+        m_buffer += 4;
+    }
+
+    void writeFixed64(std::uint64_t value)
+    {
+        memcpy(m_buffer, &value, 8);
+        m_buffer += 8;
+    }
+
+    void writeBytes(const char* data, size_t size)
+    {
+        memcpy(m_buffer, data, size);
+        m_buffer += size;
+    }
+
+    char* getPosition() const
+    {
+        return m_buffer;
+    }
+
+    ProtoSizes* getSizes() const
+    {
+        return m_sizes;
+    }
+
+private:
+    char*           m_buffer;
+    ProtoSizes*     m_sizes;
+};
+
+
+
+class ProtoReader
+{
+public:
+    ProtoReader(const char* buffer, size_t size)
+        : m_buffer(buffer)
+        , m_end(buffer + size)
+    {
+    }
+
+    // returns false at the end of the buffer or on error, see isValid()
+    bool readTag(int& id, int& wireType)
+    {
+        if (m_buffer == m_end || !m_valid)
+        {
+            return false;
+        }
+        std::uint64_t tag = 0;
+        if (!readVarint(tag))
+        {
+            return false;
+        }
+        id = static_cast<int>(tag >> 3);
+        wireType = static_cast<int>(tag & 0x7);
+        if (id <= 0)
+        {
+            m_valid = false;
+            return false;
+        }
+        return true;
+    }
+
+    bool readVarint(std::uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && m_buffer < m_end; shift += 7)
+        {
+            std::uint8_t c = static_cast<std::uint8_t>(*m_buffer++);
+            value |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+            if ((c & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        m_valid = false;
+        return false;
+    }
+
+    bool readFixed32(std::uint32_t& value)
+    {
+        if (m_end - m_buffer < 4)
+        {
+            m_valid = false;
+            return false;
+        }
+        memcpy(&value, m_buffer, 4);
+        m_buffer += 4;
+        return true;
+    }
+
+    bool readFixed64(std::uint64_t& value)
+    {
+        if (m_end - m_buffer < 8)
+        {
+            m_valid = false;
+            return false;
+        }
+        memcpy(&value, m_buffer, 8);
+        m_buffer += 8;
+        return true;
+    }
+
+    bool readLengthDelimited(const char*& data, size_t& size)
+    {
+        std::uint64_t length = 0;
+        if (!readVarint(length))
+        {
+            return false;
+        }
+        if (length > static_cast<std::uint64_t>(m_end - m_buffer))
+        {
+            m_valid = false;
+            return false;
+        }
+        data = m_buffer;
+        size = static_cast<size_t>(length);
+        m_buffer += size;
+        return true;
+    }
+
+    bool skip(int wireType)
+    {
+        std::uint64_t value64 = 0;
+        std::uint32_t value32 = 0;
+        const char* data = nullptr;
+        size_t size = 0;
+        switch (wireType)
+        {
+        case WIRETYPE_VARINT:
+            return readVarint(value64);
+        case WIRETYPE_FIXED64:
+            return readFixed64(value64);
+        case WIRETYPE_LENGTH_DELIMITED:
+            return readLengthDelimited(data, size);
+        case WIRETYPE_FIXED32:
+            return readFixed32(value32);
+        default:
+            m_valid = false;
+            return false;
+        }
+    }
+
+    bool isValid() const
+    {
+        return m_valid;
+    }
+
+    bool atEnd() const
+    {
+        return (m_buffer == m_end);
+    }
+
+private:
+    const char*     m_buffer;
+    const char*     m_end;
+    bool            m_valid = true;
+};
+
+
+
+template<int KIND>
+struct ProtoScalar;
+
+template<>
+struct ProtoScalar<PROTOKIND_BOOL>
+{
+    typedef bool Type;
+    static const int WIRETYPE = WIRETYPE_VARINT;
+    static size_t size(bool value) { return 1; }
+    static void write(ProtoWriter& writer, bool value) { writer.writeVarint(value ? 1 : 0); }
+    static bool read(ProtoReader& reader, bool& value) { std::uint64_t v; bool ok = reader.readVarint(v); value = (v != 0); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_INT32>
+{
+    typedef std::int32_t Type;
+    static const int WIRETYPE = WIRETYPE_VARINT;
+    // negative values are sign extended to 64 bits
+    static size_t size(std::int32_t value) { return ProtoWriter::sizeVarint(static_cast<std::int64_t>(value)); }
+    static void write(ProtoWriter& writer, std::int32_t value) { writer.writeVarint(static_cast<std::int64_t>(value)); }
+    static bool read(ProtoReader& reader, std::int32_t& value) { std::uint64_t v; bool ok = reader.readVarint(v); value = static_cast<std::int32_t>(v); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_ENUM> : public ProtoScalar<PROTOKIND_INT32>
+{
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_SINT32>
+{
+    typedef std::int32_t Type;
+    static const int WIRETYPE = WIRETYPE_VARINT;
+    static std::uint32_t encode(std::int32_t value) { return (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31); }
+    static size_t size(std::int32_t value) { return ProtoWriter::sizeVarint(encode(value)); }
+    static void write(ProtoWriter& writer, std::int32_t value) { writer.writeVarint(encode(value)); }
+    static bool read(ProtoReader& reader, std::int32_t& value) { std::uint64_t v; bool ok = reader.readVarint(v); std::uint32_t u = static_cast<std::uint32_t>(v); value = static_cast<std::int32_t>((u >> 1) ^ (~(u & 1) + 1)); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_UINT32>
+{
+    typedef std::uint32_t Type;
+    static const int WIRETYPE = WIRETYPE_VARINT;
+    static size_t size(std::uint32_t value) { return ProtoWriter::sizeVarint(value); }
+    static void write(ProtoWriter& writer, std::uint32_t value) { writer.writeVarint(value); }
+    static bool read(ProtoReader& reader, std::uint32_t& value) { std::uint64_t v; bool ok = reader.readVarint(v); value = static_cast<std::uint32_t>(v); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_FIXED32>
+{
+    typedef std::uint32_t Type;
+    static const int WIRETYPE = WIRETYPE_FIXED32;
+    static size_t size(std::uint32_t value) { return 4; }
+    static void write(ProtoWriter& writer, std::uint32_t value) { writer.writeFixed32(value); }
+    static bool read(ProtoReader& reader, std::uint32_t& value) { return reader.readFixed32(value); }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_SFIXED32>
+{
+    typedef std::int32_t Type;
+    static const int WIRETYPE = WIRETYPE_FIXED32;
+    static size_t size(std::int32_t value) { return 4; }
+    static void write(ProtoWriter& writer, std::int32_t value) { writer.writeFixed32(static_cast<std::uint32_t>(value)); }
+    static bool read(ProtoReader& reader, std::int32_t& value) { std::uint32_t v; bool ok = reader.readFixed32(v); value = static_cast<std::int32_t>(v); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_INT64>
+{
+    typedef std::int64_t Type;
+    static const int WIRETYPE = WIRETYPE_VARINT;
+    static size_t size(std::int64_t value) { return ProtoWriter::sizeVarint(value); }
+    static void write(ProtoWriter& writer, std::int64_t value) { writer.writeVarint(value); }
+    static bool read(ProtoReader& reader, std::int64_t& value) { std::uint64_t v; bool ok = reader.readVarint(v); value = static_cast<std::int64_t>(v); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_SINT64>
+{
+    typedef std::int64_t Type;
+    static const int WIRETYPE = WIRETYPE_VARINT;
+    static std::uint64_t encode(std::int64_t value) { return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63); }
+    static size_t size(std::int64_t value) { return ProtoWriter::sizeVarint(encode(value)); }
+    static void write(ProtoWriter& writer, std::int64_t value) { writer.writeVarint(encode(value)); }
+    static bool read(ProtoReader& reader, std::int64_t& value) { std::uint64_t v; bool ok = reader.readVarint(v); value = static_cast<std::int64_t>((v >> 1) ^ (~(v & 1) + 1)); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_UINT64>
+{
+    typedef std::uint64_t Type;
+    static const int WIRETYPE = WIRETYPE_VARINT;
+    static size_t size(std::uint64_t value) { return ProtoWriter::sizeVarint(value); }
+    static void write(ProtoWriter& writer, std::uint64_t value) { writer.writeVarint(value); }
+    static bool read(ProtoReader& reader, std::uint64_t& value) { return reader.readVarint(value); }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_FIXED64>
+{
+    typedef std::uint64_t Type;
+    static const int WIRETYPE = WIRETYPE_FIXED64;
+    static size_t size(std::uint64_t value) { return 8; }
+    static void write(ProtoWriter& writer, std::uint64_t value) { writer.writeFixed64(value); }
+    static bool read(ProtoReader& reader, std::uint64_t& value) { return reader.readFixed64(value); }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_SFIXED64>
+{
+    typedef std::int64_t Type;
+    static const int WIRETYPE = WIRETYPE_FIXED64;
+    static size_t size(std::int64_t value) { return 8; }
+    static void write(ProtoWriter& writer, std::int64_t value) { writer.writeFixed64(static_cast<std::uint64_t>(value)); }
+    static bool read(ProtoReader& reader, std::int64_t& value) { std::uint64_t v; bool ok = reader.readFixed64(v); value = static_cast<std::int64_t>(v); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_FLOAT>
+{
+    typedef float Type;
+    static const int WIRETYPE = WIRETYPE_FIXED32;
+    static size_t size(float value) { return 4; }
+    static void write(ProtoWriter& writer, float value) { std::uint32_t v; memcpy(&v, &value, 4); writer.writeFixed32(v); }
+    static bool read(ProtoReader& reader, float& value) { std::uint32_t v; bool ok = reader.readFixed32(v); memcpy(&value, &v, 4); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_DOUBLE>
+{
+    typedef double Type;
+    static const int WIRETYPE = WIRETYPE_FIXED64;
+    static size_t size(double value) { return 8; }
+    static void write(ProtoWriter& writer, double value) { std::uint64_t v; memcpy(&v, &value, 8); writer.writeFixed64(v); }
+    static bool read(ProtoReader& reader, double& value) { std::uint64_t v; bool ok = reader.readFixed64(v); memcpy(&value, &v, 8); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_STRING>
+{
+    typedef std::string Type;
+    static const int WIRETYPE = WIRETYPE_LENGTH_DELIMITED;
+    static size_t size(const std::string& value) { return ProtoWriter::sizeVarint(value.size()) + value.size(); }
+    static void write(ProtoWriter& writer, const std::string& value) { writer.writeVarint(value.size()); writer.writeBytes(value.data(), value.size()); }
+    static bool read(ProtoReader& reader, std::string& value) { const char* data; size_t size; bool ok = reader.readLengthDelimited(data, size); if (ok) value.assign(data, size); return ok; }
+};
+
+template<>
+struct ProtoScalar<PROTOKIND_BYTES>
+{
+    typedef Bytes Type;
+    static const int WIRETYPE = WIRETYPE_LENGTH_DELIMITED;
+    static size_t size(const Bytes& value) { return ProtoWriter::sizeVarint(value.size()) + value.size(); }
+    static void write(ProtoWriter& writer, const Bytes& value) { writer.writeVarint(value.size()); writer.writeBytes(value.data(), value.size()); }
+    static bool read(ProtoReader& reader, Bytes& value) { const char* data; size_t size; bool ok = reader.readLengthDelimited(data, size); if (ok) value.assign(data, data + size); return ok; }
+};
+
+
+template<class T>
+inline bool protoIsDefault(const T& value)
+{
+    return (value == T());
+}
+
+inline bool protoIsDefault(const std::string& value)
+{
+    return value.empty();
+}
+
+inline bool protoIsDefault(const Bytes& value)
+{
+    return value.empty();
+}
+
+
+
+// Fields with the default value are not serialized (proto3). Repeated scalar numbers are packed.
+// Messages are only serialized, if their size is not 0.
+
+template<int KIND, class T>
+inline void protoSizeField(size_t& size, int id, const T& value)
+{
+    if (!protoIsDefault(value))
+    {
+        size += ProtoWriter::sizeTag(id) + ProtoScalar<KIND>::size(value);
+    }
+}
+
+template<int KIND, class T>
+inline void protoWriteField(ProtoWriter& writer, int id, const T& value)
+{
+    if (!protoIsDefault(value))
+    {
+        writer.writeTag(id, ProtoScalar<KIND>::WIRETYPE);
+        ProtoScalar<KIND>::write(writer, value);
+    }
+}
+
+template<int KIND, class T>
+inline bool protoReadField(ProtoReader& reader, int wireType, T& value)
+{
+    typedef typename ProtoScalar<KIND>::Type Type;
+    if (wireType != ProtoScalar<KIND>::WIRETYPE)
+    {
+        return reader.skip(wireType);
+    }
+    Type v;
+    bool ok = ProtoScalar<KIND>::read(reader, v);
+    value = static_cast<T>(std::move(v));
+    return ok;
+}
+
+
+template<int KIND, class T>
+inline size_t protoSizePackedData(const std::vector<T>& values)
+{
+    if (ProtoScalar<KIND>::WIRETYPE == WIRETYPE_FIXED32)
+    {
+        return values.size() * 4;
+    }
+    if (ProtoScalar<KIND>::WIRETYPE == WIRETYPE_FIXED64)
+    {
+        return values.size() * 8;
+    }
+    size_t size = 0;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        size += ProtoScalar<KIND>::size(values[i]);
+    }
+    return size;
+}
+
+template<int KIND, class T>
+inline void protoSizeRepeated(size_t& size, int id, const std::vector<T>& values)
+{
+    if (values.empty())
+    {
+        return;
+    }
+    if (ProtoScalar<KIND>::WIRETYPE == WIRETYPE_LENGTH_DELIMITED)
+    {
+        size_t sizeTag = ProtoWriter::sizeTag(id);
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            size += sizeTag + ProtoScalar<KIND>::size(values[i]);
+        }
+    }
+    else
+    {
+        size_t sizeData = protoSizePackedData<KIND>(values);
+        size += ProtoWriter::sizeTag(id) + ProtoWriter::sizeVarint(sizeData) + sizeData;
+    }
+}
+
+template<int KIND, class T>
+inline void protoWriteRepeated(ProtoWriter& writer, int id, const std::vector<T>& values)
+{
+    if (values.empty())
+    {
+        return;
+    }
+    if (ProtoScalar<KIND>::WIRETYPE == WIRETYPE_LENGTH_DELIMITED)
+    {
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            writer.writeTag(id, WIRETYPE_LENGTH_DELIMITED);
+            ProtoScalar<KIND>::write(writer, values[i]);
+        }
+    }
+    else
+    {
+        writer.writeTag(id, WIRETYPE_LENGTH_DELIMITED);
+        writer.writeVarint(protoSizePackedData<KIND>(values));
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            ProtoScalar<KIND>::write(writer, values[i]);
+        }
+    }
+}
+
+// accepts packed and not packed arrays
+template<int KIND, class T>
+inline bool protoReadRepeated(ProtoReader& reader, int wireType, std::vector<T>& values)
+{
+    typedef typename ProtoScalar<KIND>::Type Type;
+    if (wireType == ProtoScalar<KIND>::WIRETYPE)
+    {
+        Type v;
+        bool ok = ProtoScalar<KIND>::read(reader, v);
+        values.push_back(static_cast<T>(std::move(v)));
+        return ok;
+    }
+    if (wireType != WIRETYPE_LENGTH_DELIMITED)
+    {
+        return reader.skip(wireType);
+    }
+    const char* data = nullptr;
+    size_t size = 0;
+    if (!reader.readLengthDelimited(data, size))
+    {
+        return false;
+    }
+    ProtoReader readerPacked(data, size);
+    while (!readerPacked.atEnd())
+    {
+        Type v;
+        if (!ProtoScalar<KIND>::read(readerPacked, v))
+        {
+            return false;
+        }
+        values.push_back(static_cast<T>(v));
+    }
+    return true;
+}
+
+
+template<class T>
+inline size_t protoSizeSubMessage(const T& value, ProtoSizes* sizes, bool truncateIfEmpty)
+{
+    if (!sizes)
+    {
+        return ProtoCodec<T>::size(value);
+    }
+    size_t index = sizes->add();
+    size_t sizeMessage = ProtoCodec<T>::size(value, sizes);
+    sizes->set(index, sizeMessage);
+    if (sizeMessage == 0 && truncateIfEmpty)
+    {
+        sizes->truncate(index);
+    }
+    return sizeMessage;
+}
+
+template<class T>
+inline size_t protoWriteSizeSubMessage(ProtoWriter& writer, const T& value)
+{
+    ProtoSizes* sizes = writer.getSizes();
+    return sizes ? sizes->next() : ProtoCodec<T>::size(value);
+}
+
+template<class T>
+inline void protoSizeMessage(size_t& size, int id, const T& value, ProtoSizes* sizes)
+{
+    // an empty message is not written, so the sizes of its sub messages are not needed
+    size_t sizeMessage = protoSizeSubMessage(value, sizes, true);
+    if (sizeMessage > 0)
+    {
+        size += ProtoWriter::sizeTag(id) + ProtoWriter::sizeVarint(sizeMessage) + sizeMessage;
+    }
+}
+
+template<class T>
+inline void protoWriteMessage(ProtoWriter& writer, int id, const T& value)
+{
+    size_t sizeMessage = protoWriteSizeSubMessage(writer, value);
+    if (sizeMessage > 0)
+    {
+        writer.writeTag(id, WIRETYPE_LENGTH_DELIMITED);
+        writer.writeVarint(sizeMessage);
+        ProtoCodec<T>::write(writer, value);
+    }
+}
+
+template<class T>
+inline bool protoReadMessage(ProtoReader& reader, int wireType, T& value)
+{
+    if (wireType != WIRETYPE_LENGTH_DELIMITED)
+    {
+        return reader.skip(wireType);
+    }
+    const char* data = nullptr;
+    size_t size = 0;
+    if (!reader.readLengthDelimited(data, size))
+    {
+        return false;
+    }
+    ProtoReader readerMessage(data, size);
+    return ProtoCodec<T>::read(readerMessage, value);
+}
+
+template<class T>
+inline void protoSizeRepeatedMessage(size_t& size, int id, const std::vector<T>& values, ProtoSizes* sizes)
+{
+    size_t sizeTag = ProtoWriter::sizeTag(id);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        // every element is written, also an empty one
+        size_t sizeMessage = protoSizeSubMessage(values[i], sizes, false);
+        size += sizeTag + ProtoWriter::sizeVarint(sizeMessage) + sizeMessage;
+    }
+}
+
+template<class T>
+inline void protoWriteRepeatedMessage(ProtoWriter& writer, int id, const std::vector<T>& values)
+{
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        writer.writeTag(id, WIRETYPE_LENGTH_DELIMITED);
+        writer.writeVarint(protoWriteSizeSubMessage(writer, values[i]));
+        ProtoCodec<T>::write(writer, values[i]);
+    }
+}
+
+template<class T>
+inline bool protoReadRepeatedMessage(ProtoReader& reader, int wireType, std::vector<T>& values)
+{
+    if (wireType != WIRETYPE_LENGTH_DELIMITED)
+    {
+        return reader.skip(wireType);
+    }
+    values.emplace_back();
+    return protoReadMessage(reader, wireType, values.back());
+}
+
+
+
+// Serializes the struct with its exact size into buffer.
+template<class T>
+inline void protoEncode(const T& value, std::string& buffer)
+{
+    ProtoSizes sizes;
+    size_t size = ProtoCodec<T>::size(value, &sizes);
+    buffer.resize(size);
+    ProtoWriter writer(&buffer[0], &sizes);
+    ProtoCodec<T>::write(writer, value);
+    assert(writer.getPosition() == buffer.data() + size);
+}
+
+// The fields of value are merged with the buffer, pass a default constructed struct for a plain decode.
+template<class T>
+inline bool protoDecode(const char* buffer, size_t size, T& value)
+{
+    ProtoReader reader(buffer, size);
+    return ProtoCodec<T>::read(reader, value);
+}
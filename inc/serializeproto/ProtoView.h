@@ -0,0 +1,64 @@
+#pragma once
+
+#include "metadata/MetaStruct.h"
+#include "serializeproto/ParserProto.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+// Read-only view of a serialized proto message. On the first access, the view scans its struct level once and
+// remembers where each field is, nested structs are not decoded until a sub view accesses them.
+// The buffer must stay valid as long as the view and its sub views are used. A view is not thread safe.
+// For fields that occur several times, the scalar getters return the last occurrence, like protobuf does.
+class ProtoView
+{
+public:
+    ProtoView();
+    ProtoView(const std::string& typeName, const char* buffer, int size);
+    ProtoView(const MetaStruct& stru, const char* buffer, int size);
+
+    bool isValid() const;
+    const MetaStruct* getStruct() const;
+    int getFieldIndex(const std::string& name) const;
+    bool hasField(int index) const;
+
+    bool getBool(int index) const;
+    std::int32_t getInt32(int index) const;
+    std::uint32_t getUInt32(int index) const;
+    std::int64_t getInt64(int index) const;
+    std::uint64_t getUInt64(int index) const;
+    float getFloat(int index) const;
+    double getDouble(int index) const;
+    std::int32_t getEnum(int index) const;
+    bool getString(int index, const char*& buffer, int& size) const;
+    std::string getString(int index) const;
+    ProtoView getStruct(int index) const;
+
+    std::vector<ProtoView> getArrayStruct(int index) const;
+    std::vector<std::pair<const char*, int>> getArrayString(int index) const;
+
+private:
+    struct FieldLocation
+    {
+        int             index = -1;
+        WireType        wireType = WIRETYPE_VARINT;
+        const char*     value = nullptr;     ///< position after the tag
+    };
+
+    bool buildIndex() const;
+    const FieldLocation* getLocation(int index) const;
+    const MetaField* getMetaField(int index, MetaTypeId typeId) const;
+    template<class T>
+    T getInteger(int index, MetaTypeId typeId) const;
+
+    const MetaStruct*                   m_struct = nullptr;
+    const char*                         m_buffer = nullptr;
+    int                                 m_size = 0;
+
+    mutable bool                        m_indexed = false;
+    mutable bool                        m_valid = false;
+    mutable std::vector<FieldLocation>  m_locations;        ///< in the order of the buffer
+    mutable std::vector<int>            m_lastLocation;     ///< field index -> index into m_locations or -1
+};
@@ -5,18 +5,22 @@
 #include "serialize/ParserConverter.h"
 
 #include <deque>
+#include <vector>
 
 
 class SerializerProto : public ParserConverter
 {
 public:
-    SerializerProto(IZeroCopyBuffer& buffer, int maxBlockSize = 1024);
+    // exactSize: the data is serialized into a scratch buffer first, then it is copied with the exact
+    // struct lengths into one buffer of the exact size. Without exactSize, the serializer reserves space
+    // for the struct lengths and fills unused space with a dummy field.
+    SerializerProto(IZeroCopyBuffer& buffer, int maxBlockSize = 1024, bool exactSize = false);
 
 private:
     class Internal : public IParserVisitor
     {
     public:
-        Internal(IZeroCopyBuffer& buffer, int maxBlockSize);
+        Internal(IZeroCopyBuffer& buffer, int maxBlockSize, bool exactSize);
     private:
         // IParserVisitor
         virtual void notifyError(const char* str, const char* message) override;
@@ -104,6 +108,11 @@ private:
         int calculateStructSize(int& structSize);
         void fillRemainingStruct(int remainingSize);
 
+        void reserveSpaceExact(int space);
+        void enterStructExact(const MetaField& field);
+        void exitStructExact();
+        void writeExact();
+
         struct StructData
         {
             StructData(char* bstart, char* bsize, char* b, bool ae)
@@ -122,8 +131,23 @@ private:
             bool    arrayEntry = false;
         };
 
+        // exactSize: a struct whose length is inserted at offsetLength of the scratch buffer
+        struct StructNode
+        {
+            int     offsetTag = 0;
+            int     offsetLength = 0;
+            int     size = 0;
+            int     lengthBytesBefore = 0;
+            bool    arrayEntry = false;
+        };
+
         IZeroCopyBuffer&        m_zeroCopybuffer;
         int                     m_maxBlockSize = 1024;
+        bool                    m_exactSize = false;
+        std::vector<char>       m_scratch;
+        std::vector<StructNode> m_structNodes;          ///< in the order of their offsets
+        std::vector<int>        m_stackStructNodes;     ///< indexes into m_structNodes
+        int                     m_lengthBytes = 0;      ///< sum of the varint sizes of all struct lengths
         char*                   m_bufferStart = nullptr;
         char*                   m_buffer = nullptr;
         char*                   m_bufferEnd = nullptr;
@@ -10,14 +10,19 @@
 class SerializerVariant : public ParserConverter
 {
 public:
-    SerializerVariant(Variant& root, bool enumAsString = true, bool skipDefaultValues = true);
+    // bufferOwner: if set, strings and bytes inside [buffer, buffer + size) are stored as views into the parsed buffer,
+    // which is kept alive by bufferOwner (e.g. the received message). Strings and bytes outside of it are copied.
+    SerializerVariant(Variant& root, bool enumAsString = true, bool skipDefaultValues = true,
+                      const std::shared_ptr<const void>& bufferOwner = nullptr, const char* buffer = nullptr, int size = 0);
 
 private:
     class Internal : public IParserVisitor
     {
     public:
-        Internal(Variant& root, bool enumAsString);
+        Internal(Variant& root, bool enumAsString, const std::shared_ptr<const void>& bufferOwner, const char* buffer, int size);
     private:
+        bool isInBuffer(const char* value, int size) const;
+
         // IParserVisitor
         virtual void notifyError(const char* str, const char* message) override;
         virtual void finished() override;
@@ -73,6 +78,9 @@ private:
         Variant*                        m_current = nullptr;
         std::deque<Variant*>            m_stack;
         bool                            m_enumAsString = true;
+        std::shared_ptr<const void>     m_bufferOwner;
+        const char*                     m_bufferBegin = nullptr;
+        const char*                     m_bufferEnd = nullptr;
     };
 
     IParserVisitor& getIParserVisitorForParserConverter(bool skipDefaultValues);
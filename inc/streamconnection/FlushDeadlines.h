@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+
+
+// Deadlines of the connections, which have coalesced messages waiting to be flushed.
+// The connections add their deadlines, the poller loop of the container flushes the expired ones.
+class FlushDeadlines
+{
+public:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    // returns true, if the deadline is the earliest one, so that the poller loop has to be woken up.
+    bool addDeadline(std::int64_t connectionId, const TimePoint& deadline);
+    void takeExpired(const TimePoint& now, std::vector<std::int64_t>& connectionIds);
+    // returns the timeout in milliseconds for the poller wait, at most timeoutMax.
+    int getTimeout(const TimePoint& now, int timeoutMax) const;
+
+private:
+    std::multimap<TimePoint, std::int64_t>  m_deadlines;
+    mutable std::mutex                      m_mutex;
+};
+
+typedef std::shared_ptr<FlushDeadlines> FlushDeadlinesPtr;
@@ -7,6 +7,7 @@
 #include <memory.h>
 #include <assert.h>
 #include <list>
+#include <cstdint>
 
 
 struct IProtocol;
@@ -22,6 +23,11 @@ struct IMessage : public IZeroCopyBuffer
     virtual void addSendPayload(const char* payload, int size) = 0;
     virtual char* addSendPayload(int size) = 0;
     virtual void downsizeLastSendPayload(int newSize) = 0;
+    // The payload is not copied, the owner keeps it alive (e.g. a mapped file). It is the only payload of the
+    // message and it is also the receive payload, so that the message can be forwarded like a received message.
+    virtual void addSendPayloadReference(const char* payload, int size, const std::shared_ptr<const void>& owner) = 0;
+    // the owner of a payload reference, nullptr if the message owns its payloads
+    virtual const std::shared_ptr<const void>& getSendPayloadOwner() const = 0;
 
     // for receive
     virtual BufferRef getReceivePayload() = 0;
@@ -39,6 +45,9 @@ struct IMessage : public IZeroCopyBuffer
     virtual char* addSendHeader(int size) = 0;
     virtual void downsizeLastSendHeader(int newSize) = 0;
 
+    // for the protocol to send the buffers of another message instead of the own send buffers (e.g. transformed payload)
+    virtual void setSendBufferMessage(const std::shared_ptr<IMessage>& msg) = 0;
+
     // for the protocol to prepare the message for send
     virtual void prepareMessageToSend() = 0;
 
@@ -48,6 +57,10 @@ struct IMessage : public IZeroCopyBuffer
 
     virtual void addMessage(const std::shared_ptr<IMessage>& msg) = 0;
     virtual std::shared_ptr<IMessage> getMessage(int protocolId) const = 0;
+
+    // metadata, the sequence number of a journaled message (see ConnectionHub), 0 if not journaled
+    virtual void setSequenceNumber(std::uint64_t sequenceNumber) = 0;
+    virtual std::uint64_t getSequenceNumber() const = 0;
 };
 
 
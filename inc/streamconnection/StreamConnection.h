@@ -6,16 +6,32 @@
 #include "poller/Poller.h"
 #include "helpers/hybrid_ptr.h"
 #include "streamconnection/IMessage.h"
+#include "streamconnection/FlushDeadlines.h"
 
 #include <memory>
 #include <vector>
 #include <list>
+#include <unordered_map>
 #include <mutex>
+#include <functional>
 #include <assert.h>
 
 
 
 
+// Pending messages with a higher priority are sent first. A message is never interrupted
+// by another message, so the priority takes effect at message boundaries.
+enum MessagePriority
+{
+    MESSAGEPRIORITY_CONTROL = 0,
+    MESSAGEPRIORITY_NORMAL = 1,
+    MESSAGEPRIORITY_BULK = 2,
+};
+
+static const int MESSAGEPRIORITY_COUNT = MESSAGEPRIORITY_BULK + 1;
+
+
+
 struct IStreamConnection;
 typedef std::shared_ptr<IStreamConnection> IStreamConnectionPtr;
 
@@ -34,10 +50,24 @@ struct IStreamConnection
 {
     virtual ~IStreamConnection() {}
     virtual bool connect() = 0;
-    virtual bool sendMessage(const IMessagePtr& msg) = 0;
+    virtual bool sendMessage(const IMessagePtr& msg, MessagePriority priority = MESSAGEPRIORITY_NORMAL) = 0;
+    // A pending message with the same conflation key, which was not started to be sent, is replaced by msg.
+    virtual bool sendMessageConflated(const IMessagePtr& msg, const std::string& conflationKey, MessagePriority priority = MESSAGEPRIORITY_NORMAL) = 0;
+    virtual int getPendingMessages() const = 0;
     virtual const ConnectionData& getConnectionData() const = 0;
     virtual SocketPtr getSocket() = 0;
     virtual void disconnect() = 0;
+    // Messages of normal priority are copied into one batch, which is sent, when maxBytes or maxMessages
+    // is reached, when the deadline (in microseconds, 0 = no deadline) expires or when flush() is called.
+    // maxBytes = 0 disables the coalescing. The deadline is checked by the poller loop with millisecond resolution.
+    virtual void setCoalescing(int maxBytes, int maxMessages, int deadlineUs) = 0;
+    virtual void flush() = 0;
+    // Stops and restarts reading from the socket, e.g. as long as the receiver cannot keep up.
+    virtual void disableRead() = 0;
+    virtual void enableRead() = 0;
+    // func is called once, when all pending messages are written to the socket or when the connection
+    // is disconnected. It is called immediately, if no message is pending.
+    virtual void notifyWhenSent(std::function<void()> func) = 0;
 };
 
 
@@ -49,6 +79,7 @@ struct IStreamConnectionPrivate : public IStreamConnection
     virtual bool doReconnect() = 0;
     virtual bool changeStateForDisconnect() = 0;
     virtual bool getDisconnectFlag() const = 0;
+    virtual void flushOnDeadline(const FlushDeadlines::TimePoint& now) = 0;
 
     virtual void connected(const IStreamConnectionPtr& connection) = 0;
     virtual void disconnected(const IStreamConnectionPtr& connection) = 0;
@@ -63,15 +94,22 @@ typedef std::shared_ptr<IStreamConnectionPrivate> IStreamConnectionPrivatePtr;
 class StreamConnection : public IStreamConnectionPrivate
 {
 public:
-    StreamConnection(const ConnectionData& connectionData, std::shared_ptr<Socket> socket, const IPollerPtr& poller, bex::hybrid_ptr<IStreamConnectionCallback> callback);
+    StreamConnection(const ConnectionData& connectionData, std::shared_ptr<Socket> socket, const IPollerPtr& poller, const FlushDeadlinesPtr& flushDeadlines, bex::hybrid_ptr<IStreamConnectionCallback> callback);
 
 private:
     // IStreamConnection
     virtual bool connect() override;
-    virtual bool sendMessage(const IMessagePtr& msg) override;
+    virtual bool sendMessage(const IMessagePtr& msg, MessagePriority priority = MESSAGEPRIORITY_NORMAL) override;
+    virtual bool sendMessageConflated(const IMessagePtr& msg, const std::string& conflationKey, MessagePriority priority = MESSAGEPRIORITY_NORMAL) override;
+    virtual int getPendingMessages() const override;
     virtual const ConnectionData& getConnectionData() const override;
     virtual SocketPtr getSocket() override;
     virtual void disconnect() override;
+    virtual void setCoalescing(int maxBytes, int maxMessages, int deadlineUs) override;
+    virtual void flush() override;
+    virtual void disableRead() override;
+    virtual void enableRead() override;
+    virtual void notifyWhenSent(std::function<void()> func) override;
 
     // IStreamConnectionPrivate
     virtual SocketPtr getSocketPrivate() override;
@@ -80,6 +118,7 @@ private:
     virtual bool doReconnect() override;
     virtual bool changeStateForDisconnect() override;
     virtual bool getDisconnectFlag() const override;
+    virtual void flushOnDeadline(const FlushDeadlines::TimePoint& now) override;
 
     virtual void connected(const IStreamConnectionPtr& connection) override;
     virtual void disconnected(const IStreamConnectionPtr& connection) override;
@@ -90,14 +129,40 @@ private:
         IMessagePtr msg;
         std::list<BufferRef>::const_iterator it;
         int offset = 0;
+        // only set as long as the message can be replaced by a conflated message
+        std::string conflationKey;
     };
 
     ConnectionData              m_connectionData;
     SocketPtr                   m_socketPrivate;
     SocketPtr                   m_socket;
     IPollerPtr                  m_poller;
-    std::list<MessageSendState> m_pendingMessages;
+    FlushDeadlinesPtr           m_flushDeadlines;
+    std::list<MessageSendState>* getNextPendingMessages();
+    bool sendMessageIntern(const IMessagePtr& msg, MessagePriority priority, const std::string* conflationKey = nullptr);
+    bool coalesceMessage(const IMessagePtr& msg);
+    bool flushIntern();
+
+    std::list<MessageSendState> m_pendingMessages[MESSAGEPRIORITY_COUNT];
+    int                         m_pendingMessagesCount = 0;
+    std::unordered_map<std::string, std::list<MessageSendState>::iterator> m_conflatedMessages;
+    // priority of the message, which was sent partially. It has to be finished first.
+    int                         m_priorityInProgress = -1;
+    std::vector<std::function<void()>> m_sentNotifications;
     bool                        m_disconnectFlag = false;
+
+    int                         m_coalescingMaxBytes = 0;
+    int                         m_coalescingMaxMessages = 0;
+    int                         m_coalescingDeadlineUs = 0;
+    IMessagePtr                 m_coalescingBatch;
+    // the batch grows by buffers of doubling size, so that small batches do not allocate maxBytes
+    char*                       m_coalescingBuffer = nullptr;
+    int                         m_coalescingBufferSize = 0;
+    int                         m_coalescingBufferUsed = 0;
+    int                         m_coalescingSize = 0;
+    int                         m_coalescingMessages = 0;
+    FlushDeadlines::TimePoint   m_coalescingDeadline;
+
     bex::hybrid_ptr<IStreamConnectionCallback> m_callback;
 
     std::chrono::time_point<std::chrono::system_clock> m_lastReconnectTime;
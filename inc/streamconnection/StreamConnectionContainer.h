@@ -5,6 +5,7 @@
 #include <vector>
 #include <mutex>
 #include <unordered_map>
+#include <functional>
 
 #include "helpers/hybrid_ptr.h"
 #include "ConnectionData.h"
@@ -28,6 +29,8 @@ struct IStreamConnectionContainer
     virtual IStreamConnectionPtr getConnection(std::int64_t connectionId) const = 0;
     virtual void threadEntry() = 0;
     virtual bool terminatePollerLoop(int timeout) = 0;
+    // the action is called by the poller thread after the current poller cycle.
+    virtual void postToPollerLoop(std::function<void()> action) = 0;
 
 #ifdef USE_OPENSSL
     virtual int bindSsl(const std::string& endpoint, bex::hybrid_ptr<IStreamConnectionCallback> callback, const CertificateData& certificateData) = 0;
@@ -53,6 +56,7 @@ private:
     virtual IStreamConnectionPtr getConnection(std::int64_t connectionId) const override;
     virtual void threadEntry() override;
     virtual bool terminatePollerLoop(int timeout) override;
+    virtual void postToPollerLoop(std::function<void()> action) override;
 
 #ifdef USE_OPENSSL
     virtual int bindSsl(const std::string& endpoint, bex::hybrid_ptr<IStreamConnectionCallback> callback, const CertificateData& certificateData) override;
@@ -81,8 +85,11 @@ private:
     void handleBindEvents(const DescriptorInfo& info);
     bool isReconnectTimerExpired();
     void doReconnect();
+    void flushExpiredDeadlines();
+    void runPostedActions();
 
     std::shared_ptr<IPoller>                                        m_poller;
+    FlushDeadlinesPtr                                               m_flushDeadlines;
     std::unordered_map<SOCKET, BindData>                            m_sd2binds;
     std::unordered_map<std::int64_t, IStreamConnectionPrivatePtr>   m_connectionId2Connection;
     std::unordered_map<SOCKET, IStreamConnectionPrivatePtr>         m_sd2Connection;
@@ -91,6 +98,7 @@ private:
     CondVar                                                         m_pollerLoopTerminated;
     int                                                             m_cycleTime = 100;
     double                                                          m_checkReconnectInterval = 1000;
+    std::vector<std::function<void()>>                              m_postedActions;
     mutable std::mutex                                              m_mutex;
 
     std::chrono::time_point<std::chrono::system_clock>              m_lastReconnectTime;
@@ -4,6 +4,7 @@
 #include <memory>
 
 class Variant;
+struct VariantPathEntry;
 
 
 
@@ -27,6 +28,8 @@ struct IVariantValue
     virtual const void* getData() const = 0;
     virtual Variant* getVariant(const std::string& name) = 0;
     virtual const Variant* getVariant(const std::string& name) const = 0;
+    virtual Variant* getVariant(const VariantPathEntry& entry) = 0;
+    virtual const Variant* getVariant(const VariantPathEntry& entry) const = 0;
     virtual std::shared_ptr<IVariantValue> clone() const = 0;
     virtual bool operator ==(const IVariantValue& rhs) const = 0;
     virtual bool add(const std::string& name, const Variant& variant) = 0;
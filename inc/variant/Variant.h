@@ -6,6 +6,8 @@
 #include <assert.h>
 
 #include "IVariantValue.h"
+#include "VariantPath.h"
+#include "metadata/MetaType.h"
 
 
 
@@ -24,19 +26,17 @@ public:
 
     template<class T>
     Variant(T data)
-        : m_value(std::make_shared<typename VariantValueTypeInfo<T>::VariantValueType>(std::move(data)))
     {
+        initValue(std::move(data));
     }
 
     template<class T>
     operator T*()
     {
-        if (m_value)
+        if (getType() == VariantValueTypeInfo<T>::VARTYPE)
         {
-            if (m_value->getType() == VariantValueTypeInfo<T>::VARTYPE)
-            {
-                return static_cast<T*>(m_value->getData());
-            }
+            detach();
+            return static_cast<T*>(getDataIntern());
         }
         return nullptr;
     }
@@ -44,12 +44,9 @@ public:
     template<class T>
     operator const T*() const
     {
-        if (m_value)
+        if (getType() == VariantValueTypeInfo<T>::VARTYPE)
         {
-            if (m_value->getType() == VariantValueTypeInfo<T>::VARTYPE)
-            {
-                return static_cast<const T*>(m_value->getData());
-            }
+            return static_cast<const T*>(getDataIntern());
         }
         return nullptr;
     }
@@ -72,14 +69,8 @@ public:
         Variant* variant = getVariant(name);
         if (variant)
         {
-            std::shared_ptr<IVariantValue>& value = variant->m_value;
-            if (value)
-            {
-                if (m_value->getType() == VariantValueTypeInfo<T>::VARTYPE)
-                {
-                    return static_cast<T*>(m_value->getData());
-                }
-            }
+            T* data = *variant;
+            return data;
         }
         return nullptr;
     }
@@ -87,7 +78,13 @@ public:
     template<class T>
     const T* getData(const std::string& name) const
     {
-        return const_cast<Variant*>(this)->getData<T>(name);
+        const Variant* variant = getVariant(name);
+        if (variant)
+        {
+            const T* data = *variant;
+            return data;
+        }
+        return nullptr;
     }
 
     template<class T>
@@ -101,6 +98,41 @@ public:
         return T();
     }
 
+    template<class T>
+    T* getData(const VariantPath& path)
+    {
+        Variant* variant = getVariant(path);
+        if (variant)
+        {
+            T* data = *variant;
+            return data;
+        }
+        return nullptr;
+    }
+
+    template<class T>
+    const T* getData(const VariantPath& path) const
+    {
+        const Variant* variant = getVariant(path);
+        if (variant)
+        {
+            const T* data = *variant;
+            return data;
+        }
+        return nullptr;
+    }
+
+    template<class T>
+    T getDataValue(const VariantPath& path) const
+    {
+        const Variant* variant = getVariant(path);
+        if (variant)
+        {
+            return VariantValueTypeInfo<T>::ConvertType::convert(*variant);
+        }
+        return T();
+    }
+
 
     Variant(const Variant& rhs);
     const Variant& operator =(const Variant& rhs);
@@ -112,6 +144,8 @@ public:
     int getType() const;
     Variant* getVariant(const std::string& name);
     const Variant* getVariant(const std::string& name) const;
+    Variant* getVariant(const VariantPath& path);
+    const Variant* getVariant(const VariantPath& path) const;
 
     bool operator ==(const Variant& rhs) const;
 
@@ -121,9 +155,45 @@ public:
     bool add(Variant&& variant);
     int size() const;
 
+    // replaces all string and bytes views in the tree by owned copies, so that the buffer can be released
+    void materialize();
+
 private:
+    // copy on write: copies of a variant share the value, it is cloned before it is modified,
+    // if it is shared. Data pointers, that were taken before a copy was made, shall not be used to modify.
+    void detach();
+
+    // scalars are stored inline, without a heap allocation
+    template<class T>
+    void initValue(T data)
+    {
+        m_value = std::make_shared<typename VariantValueTypeInfo<T>::VariantValueType>(std::move(data));
+    }
+    void initValue(bool data)           { m_type = TYPE_BOOL; m_inline.valBool = data; }
+    void initValue(std::int32_t data)   { m_type = TYPE_INT32; m_inline.valInt32 = data; }
+    void initValue(std::uint32_t data)  { m_type = TYPE_UINT32; m_inline.valUInt32 = data; }
+    void initValue(std::int64_t data)   { m_type = TYPE_INT64; m_inline.valInt64 = data; }
+    void initValue(std::uint64_t data)  { m_type = TYPE_UINT64; m_inline.valUInt64 = data; }
+    void initValue(float data)          { m_type = TYPE_FLOAT; m_inline.valFloat = data; }
+    void initValue(double data)         { m_type = TYPE_DOUBLE; m_inline.valDouble = data; }
+
+    void* getDataIntern();
+    const void* getDataIntern() const;
+
+    union InlineValue
+    {
+        bool            valBool;
+        std::int32_t    valInt32;
+        std::uint32_t   valUInt32;
+        std::int64_t    valInt64;
+        std::uint64_t   valUInt64;
+        float           valFloat;
+        double          valDouble;
+    };
 
     std::shared_ptr<IVariantValue> m_value;
+    int                            m_type = VARTYPE_NONE;   ///< type of the inline value, if m_value is nullptr
+    InlineValue                    m_inline = {};
 };
 
 
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "metadata/MetaStruct.h"
+
+#include <string>
+#include <vector>
+
+
+// One level of a VariantPath.
+struct VariantPathEntry
+{
+    std::string         name;
+    int                 listIndex = -1;         ///< the name as index into a list, -1 if it is not a number
+    const MetaStruct*   metaStruct = nullptr;   ///< the struct of fieldIndex, if the path was resolved against meta data
+    int                 fieldIndex = -1;
+};
+
+
+// A path like "a.b.c", split once into its entries. If the path is created with the MetaStruct of the root,
+// the names are resolved to field indices, so that a lookup in structs that are bound to the same MetaStruct
+// is done by index. A lookup with a path does not allocate.
+class VariantPath
+{
+public:
+    explicit VariantPath(const std::string& path, const MetaStruct* stru = nullptr);
+
+    const std::vector<VariantPathEntry>& getEntries() const;
+
+private:
+    std::vector<VariantPathEntry>   m_entries;
+};
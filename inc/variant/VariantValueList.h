@@ -26,6 +26,8 @@ private:
     virtual const void* getData() const override;
     virtual Variant* getVariant(const std::string& name) override;
     virtual const Variant* getVariant(const std::string& name) const override;
+    virtual Variant* getVariant(const VariantPathEntry& entry) override;
+    virtual const Variant* getVariant(const VariantPathEntry& entry) const override;
     virtual std::shared_ptr<IVariantValue> clone() const override;
     virtual bool operator ==(const IVariantValue& rhs) const override;
     virtual bool add(const std::string& name, const Variant& variant) override;
@@ -37,6 +39,7 @@ private:
 
 
     VariantList::iterator find(const std::string& name);
+    Variant* getSubVariant(const std::string& name, std::string& restname) const;
 
     std::unique_ptr<VariantList>     m_value;
 };
@@ -3,6 +3,7 @@
 #include "IVariantValue.h"
 #include "metadata/MetaType.h"
 #include "VariantValueConvert.h"
+#include "metadata/MetaStruct.h"
 
 #include <deque>
 
@@ -15,6 +16,8 @@ class VariantValueStruct : public IVariantValue
 {
 public:
     VariantValueStruct();
+    // A struct that is bound to a MetaStruct finds its fields by field index. The fields shall be added with add().
+    explicit VariantValueStruct(const MetaStruct& metaStruct);
     VariantValueStruct(const VariantValueStruct& rhs);
     VariantValueStruct(VariantValueStruct&& rhs);
     VariantValueStruct(const VariantStruct& value);
@@ -26,6 +29,8 @@ private:
     virtual const void* getData() const override;
     virtual Variant* getVariant(const std::string& name) override;
     virtual const Variant* getVariant(const std::string& name) const override;
+    virtual Variant* getVariant(const VariantPathEntry& entry) override;
+    virtual const Variant* getVariant(const VariantPathEntry& entry) const override;
     virtual std::shared_ptr<IVariantValue> clone() const override;
     virtual bool operator ==(const IVariantValue& rhs) const override;
     virtual bool add(const std::string& name, const Variant& variant) override;
@@ -36,9 +41,19 @@ private:
     virtual void visit(IVariantVisitor& visitor, Variant& variant, int index, int level, int size, const std::string& name) override;
 
 
-    VariantStruct::iterator find(const std::string& name);
+    void updatePositions();
+    VariantStruct::const_iterator find(const std::string& name) const;
+    VariantStruct::const_iterator findByIndex(int fieldIndex, const std::string& name) const;
+    VariantStruct::const_iterator findLinear(const std::string& name) const;
+    VariantStruct::const_iterator findEntry(const VariantPathEntry& entry) const;
+    Variant* getEntry(VariantStruct::const_iterator it) const;
+    void addPosition(const std::string& name);
+    Variant* getSubVariant(const std::string& name, std::string& restname) const;
 
     std::unique_ptr<VariantStruct>     m_value;
+    const MetaStruct*                  m_metaStruct = nullptr;
+    std::vector<int>                   m_positions;        ///< field index -> position in m_value, -1 if not added
+    bool                               m_positionsDirty = false;   ///< the entries were accessed by getData()
 };
 
 
@@ -53,6 +53,16 @@ private:
         return nullptr;
     }
 
+    virtual Variant* getVariant(const VariantPathEntry& entry) override
+    {
+        return nullptr;
+    }
+
+    virtual const Variant* getVariant(const VariantPathEntry& entry) const override
+    {
+        return nullptr;
+    }
+
     virtual std::shared_ptr<IVariantValue> clone() const override
     {
         return std::make_shared<VariantValueTemplate>(*this);
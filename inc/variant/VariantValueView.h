@@ -0,0 +1,168 @@
+#pragma once
+
+#include "IVariantValue.h"
+#include "Variant.h"
+#include "VariantValueConvert.h"
+#include "metadata/MetaType.h"
+#include "assert.h"
+
+#include <string.h>
+
+
+// A view references a string or bytes in a buffer without copying it. The buffer (e.g. the received message)
+// is kept alive by the owner of the view. Variant::materialize() replaces all views by owned values.
+
+const static int VARTYPE_VIEW_FLAG = 2048;
+const static int VARTYPE_STRING_VIEW = VARTYPE_VIEW_FLAG + TYPE_STRING;
+const static int VARTYPE_BYTES_VIEW = VARTYPE_VIEW_FLAG + TYPE_BYTES;
+
+
+struct StringView
+{
+    const char*     data = nullptr;
+    int             size = 0;
+};
+
+struct BytesView
+{
+    const BytesElement* data = nullptr;
+    int                 size = 0;
+};
+
+
+template<int VARTYPE, class VIEW>
+class VariantValueView : public IVariantValue
+{
+public:
+    VariantValueView(const VIEW& value, const std::shared_ptr<const void>& owner = nullptr)
+        : m_value(value)
+        , m_owner(owner)
+    {
+    }
+
+private:
+    virtual int getType() const override
+    {
+        return VARTYPE;
+    }
+
+    virtual void* getData() override
+    {
+        return &m_value;
+    }
+
+    virtual const void* getData() const override
+    {
+        return &m_value;
+    }
+
+    virtual Variant* getVariant(const std::string& name) override
+    {
+        return nullptr;
+    }
+
+    virtual const Variant* getVariant(const std::string& name) const override
+    {
+        return nullptr;
+    }
+
+    virtual Variant* getVariant(const VariantPathEntry& entry) override
+    {
+        return nullptr;
+    }
+
+    virtual const Variant* getVariant(const VariantPathEntry& entry) const override
+    {
+        return nullptr;
+    }
+
+    virtual std::shared_ptr<IVariantValue> clone() const override
+    {
+        // the clone references the same buffer
+        return std::make_shared<VariantValueView>(*this);
+    }
+
+    virtual bool operator ==(const IVariantValue& rhs) const override
+    {
+        if (this == &rhs)
+        {
+            return true;
+        }
+
+        if (getType() != rhs.getType())
+        {
+            return false;
+        }
+
+        const VIEW* rhsData = static_cast<const VIEW*>(rhs.getData());
+        assert(rhsData);
+
+        return (m_value.size == rhsData->size && (m_value.size == 0 || memcmp(m_value.data, rhsData->data, m_value.size) == 0));
+    }
+
+    virtual bool add(const std::string& name, const Variant& variant) override
+    {
+        return false;
+    }
+    virtual bool add(const std::string& name, Variant&& variant) override
+    {
+        return false;
+    }
+    virtual bool add(const Variant& variant) override
+    {
+        return false;
+    }
+    virtual bool add(Variant&& variant) override
+    {
+        return false;
+    }
+
+    virtual int size() const override
+    {
+        return 1;
+    }
+    virtual void visit(IVariantVisitor& visitor, Variant& variant, int index, int level, int size, const std::string& name) override
+    {
+        visitor.enterLeaf(variant, VARTYPE, index, level, size, name);
+    }
+
+    VIEW                        m_value;
+    std::shared_ptr<const void> m_owner;
+};
+
+
+
+/////////////////////////////////////////
+template <>
+class MetaTypeInfo<StringView>
+{
+public:
+    static const int TypeId = VARTYPE_STRING_VIEW;
+};
+typedef VariantValueView<VARTYPE_STRING_VIEW, StringView>  VariantValueStringView;
+template<>
+class VariantValueTypeInfo<StringView>
+{
+public:
+    typedef StringView T;
+    typedef VariantValueStringView VariantValueType;
+    const static int VARTYPE = VARTYPE_STRING_VIEW;
+    typedef Convert<T> ConvertType;
+};
+/////////////////////////////////////////
+template <>
+class MetaTypeInfo<BytesView>
+{
+public:
+    static const int TypeId = VARTYPE_BYTES_VIEW;
+};
+typedef VariantValueView<VARTYPE_BYTES_VIEW, BytesView>  VariantValueBytesView;
+template<>
+class VariantValueTypeInfo<BytesView>
+{
+public:
+    typedef BytesView T;
+    typedef VariantValueBytesView VariantValueType;
+    const static int VARTYPE = VARTYPE_BYTES_VIEW;
+    typedef Convert<T> ConvertType;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+
+#include "poller/Poller.h"
+
+
+#include "gmock/gmock.h"
+
+class MockIPoller : public IPoller
+{
+public:
+    MOCK_METHOD(void, init, (), (override));
+    MOCK_METHOD(void, addSocket, (const SocketDescriptorPtr& fd), (override));
+    MOCK_METHOD(void, removeSocket, (const SocketDescriptorPtr& fd), (override));
+    MOCK_METHOD(void, enableWrite, (const SocketDescriptorPtr& fd), (override));
+    MOCK_METHOD(void, disableWrite, (const SocketDescriptorPtr& fd), (override));
+    MOCK_METHOD(void, enableRead, (const SocketDescriptorPtr& fd), (override));
+    MOCK_METHOD(void, disableRead, (const SocketDescriptorPtr& fd), (override));
+    MOCK_METHOD(const PollerResult&, wait, (std::int32_t timeout), (override));
+    MOCK_METHOD(void, releaseWait, (), (override));
+};
+
@@ -0,0 +1,15 @@
+#pragma once
+
+
+#include "protocolconnection/RequestReply.h"
+
+
+#include "gmock/gmock.h"
+
+class MockIRequestReplyCallback : public IRequestReplyCallback
+{
+public:
+    MOCK_METHOD(void, connected, (const IProtocolSessionPtr& session), (override));
+    MOCK_METHOD(void, disconnected, (const IProtocolSessionPtr& session), (override));
+    MOCK_METHOD(void, receivedRequest, (const IProtocolSessionPtr& session, std::uint64_t correlationId, const IMessagePtr& message, const BufferRef& payload), (override));
+};
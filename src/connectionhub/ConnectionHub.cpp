@@ -1,11 +1,42 @@
 
 #include "connectionhub/ConnectionHub.h"
+#include "protocolconnection/ProtocolMessage.h"
+#include <string.h>
 #include <algorithm>
+#include <iostream>
+
+
+// number of buffered messages, which are forwarded per poller cycle. The batch doubles as long as
+// the spool is not drained by a batch, so that the forwarding catches up with the received messages.
+static const size_t FORWARD_BATCH_SIZE = 256;
+static const size_t FORWARD_BATCH_SIZE_MAX = 16384;
+
+
+
+TopicFromPayloadPrefix::TopicFromPayloadPrefix(char delimiter)
+    : m_delimiter(delimiter)
+{
+}
+
+bool TopicFromPayloadPrefix::operator ()(const IMessagePtr& message, std::string& topic) const
+{
+    BufferRef payload = message->getReceivePayload();
+    const char* end = static_cast<const char*>(memchr(payload.first, m_delimiter, payload.second));
+    if (end == nullptr)
+    {
+        return false;
+    }
+    topic.assign(payload.first, end - payload.first);
+    return true;
+}
 
 
 
 ConnectionHub::ConnectionHub()
     : m_protocolSessionContainer(std::make_unique<ProtocolSessionContainer>())
+    , m_snapshot(std::make_unique<ForwardingSnapshot>())
+    , m_messagesForForwarding(std::make_unique<MessageSpool>())
+    , m_forwardBatchSize(FORWARD_BATCH_SIZE)
 {
     assert(m_protocolSessionContainer);
 }
@@ -30,6 +61,8 @@ void ConnectionHub::unbind(const std::string& endpoint)
 IProtocolSessionPtr ConnectionHub::connect(const std::string& endpoint, const IProtocolPtr& protocol, int reconnectInterval, int totalReconnectDuration)
 {
     IProtocolSessionPtr session = m_protocolSessionContainer->connect(endpoint, this, protocol, reconnectInterval, totalReconnectDuration);
+    // messages can be forwarded to the session, before it is connected.
+    addSession(session);
     return session;
 }
 
@@ -63,102 +96,499 @@ int ConnectionHub::bindSsl(const std::string& endpoint, IProtocolFactoryPtr prot
 
 IProtocolSessionPtr ConnectionHub::connectSsl(const std::string& endpoint, const IProtocolPtr& protocol, const CertificateData& certificateData, int reconnectInterval, int totalReconnectDuration)
 {
-    return m_protocolSessionContainer->connectSsl(endpoint, this, protocol, certificateData, reconnectInterval, totalReconnectDuration);
+    IProtocolSessionPtr session = m_protocolSessionContainer->connectSsl(endpoint, this, protocol, certificateData, reconnectInterval, totalReconnectDuration);
+    addSession(session);
+    return session;
 }
 
 #endif
 
 
+void ConnectionHub::updateSnapshot(const std::function<void(ForwardingSnapshot& snapshot)>& funcUpdate)
+{
+    std::unique_lock<std::mutex> lock(m_mutexUpdate);
+    std::unique_ptr<ForwardingSnapshot> snapshot = std::make_unique<ForwardingSnapshot>(m_snapshot.get());
+    funcUpdate(*snapshot);
+    m_snapshot.publish(std::move(snapshot));
+}
+
+
+void ConnectionHub::addSession(const IProtocolSessionPtr& session)
+{
+    if (!session)
+    {
+        return;
+    }
+    {
+        ForwardingSnapshotReader snapshot(m_snapshot);
+        if (snapshot->sessionsById.find(session->getSessionId()) != snapshot->sessionsById.end())
+        {
+            return;
+        }
+    }
+    updateSnapshot([&session] (ForwardingSnapshot& snapshot) {
+        if (snapshot.sessionsById.emplace(session->getSessionId(), session).second)
+        {
+            snapshot.sessions.push_back(session);
+        }
+    });
+}
+
+
+void ConnectionHub::setPreForwardingBuffer(std::int64_t maxMemoryBytes, const std::string& spoolDirectory)
+{
+    std::unique_lock<std::mutex> lock(m_mutexMessagesForForwarding);
+    assert(m_messagesForForwarding->empty());
+    m_messagesForForwarding = std::make_unique<MessageSpool>(maxMemoryBytes, spoolDirectory);
+}
+
+
 void ConnectionHub::startMessageForwarding()
 {
-    std::unique_lock<std::recursive_mutex> lock(m_mutex);
-    m_startMessageForwarding = true;
-    for (size_t i = 0; i < m_messagesForForwarding.size(); ++i)
+    std::unique_lock<std::mutex> lock(m_mutexMessagesForForwarding);
+    if (m_messagesForForwarding->empty())
     {
-        auto& entry = m_messagesForForwarding[i];
-        assert(entry.first);
-        assert(entry.second);
-        received(entry.first, entry.second);
+        m_startMessageForwarding = true;
     }
-    m_messagesForForwarding.clear();
+    else
+    {
+        lock.unlock();
+        m_protocolSessionContainer->postToPollerLoop([this] () {
+            forwardBufferedMessages();
+        });
+    }
+}
+
+
+void ConnectionHub::forwardBufferedMessages()
+{
+    std::vector<std::pair<std::int64_t, IMessagePtr>> entries;
+    entries.reserve(m_forwardBatchSize);
+    std::unique_lock<std::mutex> lock(m_mutexMessagesForForwarding);
+    if (!m_messagesForForwarding->pop(m_forwardBatchSize, entries))
+    {
+        // set after the buffered messages were forwarded, so that new messages keep their order
+        m_startMessageForwarding = true;
+        m_forwardBatchSize = FORWARD_BATCH_SIZE;
+        return;
+    }
+    bool behind = !m_messagesForForwarding->empty();
     lock.unlock();
+
+    m_forwardBatchSize = behind ? std::min(m_forwardBatchSize * 2, FORWARD_BATCH_SIZE_MAX) : FORWARD_BATCH_SIZE;
+
+    {
+        ForwardingSnapshotReader snapshot(m_snapshot);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            const auto& entry = entries[i];
+            assert(entry.second);
+            forwardMessage(*snapshot, entry.first, entry.second);
+        }
+    }
+
+    // the next batch in the next poller cycle, so that the poller thread is not blocked
+    m_protocolSessionContainer->postToPollerLoop([this] () {
+        forwardBufferedMessages();
+    });
 }
 
 
 void ConnectionHub::stopForwardingFromSession(std::int64_t sessionId)
 {
-    std::unique_lock<std::recursive_mutex> lock(m_mutex);
-    m_sessionIdsStopForwardingFromSession.push_back(sessionId);
+    updateSnapshot([sessionId] (ForwardingSnapshot& snapshot) {
+        snapshot.sessionIdsStopForwardingFromSession.insert(sessionId);
+    });
 }
 
 void ConnectionHub::stopForwardingToSession(std::int64_t sessionId)
 {
-    std::unique_lock<std::recursive_mutex> lock(m_mutex);
-    m_sessionIdsStopForwardingToSession.push_back(sessionId);
+    updateSnapshot([sessionId] (ForwardingSnapshot& snapshot) {
+        snapshot.sessionIdsStopForwardingToSession.insert(sessionId);
+    });
+}
+
+void ConnectionHub::setTopicFunction(FuncGetTopic funcGetTopic)
+{
+    updateSnapshot([&funcGetTopic] (ForwardingSnapshot& snapshot) {
+        snapshot.funcGetTopic = std::move(funcGetTopic);
+    });
+}
+
+bool ConnectionHub::subscribe(std::int64_t sessionId, const std::string& pattern)
+{
+    if (!TopicRouter::isValidPattern(pattern))
+    {
+        return false;
+    }
+    updateSnapshot([this, sessionId, &pattern] (ForwardingSnapshot& snapshot) {
+        m_topicRouter.subscribe(sessionId, pattern);
+        snapshot.topicRoutes = m_topicRouter.getRoutes();
+    });
+    return true;
+}
+
+void ConnectionHub::unsubscribe(std::int64_t sessionId, const std::string& pattern)
+{
+    updateSnapshot([this, sessionId, &pattern] (ForwardingSnapshot& snapshot) {
+        m_topicRouter.unsubscribe(sessionId, pattern);
+        snapshot.topicRoutes = m_topicRouter.getRoutes();
+    });
+}
+
+
+void ConnectionHub::setSlowConsumerPolicy(std::int64_t sessionId, SlowConsumerPolicy policy, int maxPendingMessages, FuncGetConflationKey funcGetConflationKey)
+{
+    assert(policy != SLOWCONSUMER_CONFLATE || funcGetConflationKey);
+    updateSnapshot([sessionId, policy, maxPendingMessages, &funcGetConflationKey] (ForwardingSnapshot& snapshot) {
+        if (policy == SLOWCONSUMER_QUEUE)
+        {
+            snapshot.slowConsumers.erase(sessionId);
+        }
+        else
+        {
+            SlowConsumer& slowConsumer = snapshot.slowConsumers[sessionId];
+            slowConsumer.policy = policy;
+            slowConsumer.maxPendingMessages = maxPendingMessages;
+            slowConsumer.funcGetConflationKey = std::move(funcGetConflationKey);
+        }
+    });
+}
+
+void ConnectionHub::enableJournal(const std::string& directory, std::int64_t segmentSize, int maxSegments)
+{
+    MessageJournalPtr journal = std::make_shared<MessageJournal>(directory, segmentSize, maxSegments);
+    updateSnapshot([&journal] (ForwardingSnapshot& snapshot) {
+        snapshot.journal = journal;
+    });
+}
+
+std::uint64_t ConnectionHub::getLastSequenceNumber() const
+{
+    ForwardingSnapshotReader snapshot(m_snapshot);
+    if (!snapshot->journal)
+    {
+        return 0;
+    }
+    return snapshot->journal->getLastSequenceNumber();
+}
+
+void ConnectionHub::setSourceId(std::int64_t sessionId, std::int64_t sourceId)
+{
+    updateSnapshot([sessionId, sourceId] (ForwardingSnapshot& snapshot) {
+        snapshot.sourceIds[sessionId] = sourceId;
+    });
 }
 
+bool ConnectionHub::replayFromJournal(std::int64_t sessionId, std::uint64_t sequenceNumberFrom)
+{
+    ReplayPtr replay = std::make_shared<Replay>();
+    replay->sequenceNumberNext = sequenceNumberFrom;
+    replay->batchSize = FORWARD_BATCH_SIZE;
+    bool started = false;
+    updateSnapshot([sessionId, sequenceNumberFrom, &replay, &started] (ForwardingSnapshot& snapshot) {
+        if (snapshot.journal &&
+            snapshot.sessionsById.find(sessionId) != snapshot.sessionsById.end() &&
+            snapshot.replays.find(sessionId) == snapshot.replays.end() &&
+            sequenceNumberFrom >= snapshot.journal->getFirstSequenceNumber() &&
+            sequenceNumberFrom <= snapshot.journal->getLastSequenceNumber() + 1)
+        {
+            snapshot.replays[sessionId] = replay;
+            started = true;
+        }
+    });
+    if (!started)
+    {
+        return false;
+    }
+    m_protocolSessionContainer->postToPollerLoop([this, sessionId, replay] () {
+        replayBatch(sessionId, replay);
+    });
+    return true;
+}
+
+
+void ConnectionHub::replayBatch(std::int64_t sessionId, const ReplayPtr& replay)
+{
+    {
+        ForwardingSnapshotReader snapshot(m_snapshot);
+        auto it = snapshot->sessionsById.find(sessionId);
+        bool sessionExists = (it != snapshot->sessionsById.end());
+        bool inJournal = false;
+        size_t count = 0;
+        if (sessionExists && snapshot->journal)
+        {
+            const IProtocolSessionPtr& session = it->second;
+            inJournal = snapshot->journal->replay(replay->sequenceNumberNext, [&snapshot, &session, &replay, &count, sessionId] (const JournalEntry& entry) {
+                replay->sequenceNumberNext = entry.sequenceNumber + 1;
+                ++count;
+                // the payload is sent from the mapped segment, the messages keep the segment alive till they are sent
+                IMessagePtr message = std::make_shared<ProtocolMessage>(0);
+                message->addSendPayloadReference(entry.payload.first, entry.payload.second, entry.segment);
+                message->setSequenceNumber(entry.sequenceNumber);
+                if (isRoutedTo(*snapshot, entry.sessionId, message, sessionId))
+                {
+                    std::vector<std::pair<int, IMessagePtr>> preparedMessages;
+                    sendToSession(*snapshot, session, message, preparedMessages);
+                }
+            }, replay->batchSize);
+        }
+
+        if (inJournal)
+        {
+            bool caughtUp = false;
+            if (count < replay->batchSize)
+            {
+                // The held messages were journaled before they were held, so the replay has sent
+                // all of them, if it reached the end of the journal.
+                snapshot->journal->visitLastSequenceNumber([&replay, &caughtUp] (std::uint64_t sequenceNumberLast) {
+                    if (replay->sequenceNumberNext > sequenceNumberLast)
+                    {
+                        replay->running.store(false, std::memory_order_release);
+                        caughtUp = true;
+                    }
+                });
+            }
+            if (!caughtUp)
+            {
+                replay->batchSize = (count == replay->batchSize) ? std::min(replay->batchSize * 2, FORWARD_BATCH_SIZE_MAX) : FORWARD_BATCH_SIZE;
+                m_protocolSessionContainer->postToPollerLoop([this, sessionId, replay] () {
+                    replayBatch(sessionId, replay);
+                });
+                return;
+            }
+        }
+        else
+        {
+            replay->running.store(false, std::memory_order_release);
+            if (sessionExists)
+            {
+                std::cout << "replay stopped, the messages are not in the journal anymore, session: " << sessionId << std::endl;
+            }
+        }
+    }
+
+    updateSnapshot([sessionId, &replay] (ForwardingSnapshot& snapshot) {
+        auto it = snapshot.replays.find(sessionId);
+        if (it != snapshot.replays.end() && it->second == replay)
+        {
+            snapshot.replays.erase(it);
+        }
+    });
+}
 
 
 // IProtocolSessionCallback
 void ConnectionHub::connected(const IProtocolSessionPtr& session)
 {
+    addSession(session);
 }
 
 void ConnectionHub::disconnected(const IProtocolSessionPtr& session)
 {
+    std::int64_t sessionId = session->getSessionId();
+    updateSnapshot([this, sessionId] (ForwardingSnapshot& snapshot) {
+        auto it = snapshot.sessionsById.find(sessionId);
+        if (it != snapshot.sessionsById.end())
+        {
+            IProtocolSessionPtr session = it->second;
+            snapshot.sessionsById.erase(it);
+            snapshot.sessions.erase(std::find(snapshot.sessions.begin(), snapshot.sessions.end(), session));
+        }
+        if (m_topicRouter.hasSubscriptions(sessionId))
+        {
+            m_topicRouter.unsubscribeAll(sessionId);
+            snapshot.topicRoutes = m_topicRouter.getRoutes();
+        }
+        snapshot.slowConsumers.erase(sessionId);
+        snapshot.sourceIds.erase(sessionId);
+    });
+}
+
+
+void ConnectionHub::received(const IProtocolSessionPtr& session, const IMessagePtr& message)
+{
+    if (!m_startMessageForwarding)
+    {
+        std::unique_lock<std::mutex> lock(m_mutexMessagesForForwarding);
+        if (!m_startMessageForwarding)
+        {
+            if (!m_messagesForForwarding->push(session->getSessionId(), message))
+            {
+                std::cout << "message dropped, the spool file cannot grow" << std::endl;
+            }
+            return;
+        }
+    }
+
+    ForwardingSnapshotReader snapshot(m_snapshot);
+    forwardMessage(*snapshot, session->getSessionId(), message);
+}
+
+
+// The message is prepared once per protocol id and the same prepared message is queued at all sessions of this protocol.
+void ConnectionHub::sendToSession(const ForwardingSnapshot& snapshot, const IProtocolSessionPtr& session, const IMessagePtr& message, std::vector<std::pair<int, IMessagePtr>>& preparedMessages)
+{
+    const SlowConsumer* slowConsumer = nullptr;
+    if (!snapshot.slowConsumers.empty())
+    {
+        auto itSlowConsumer = snapshot.slowConsumers.find(session->getSessionId());
+        if (itSlowConsumer != snapshot.slowConsumers.end())
+        {
+            slowConsumer = &itSlowConsumer->second;
+            if (slowConsumer->policy == SLOWCONSUMER_DROP || slowConsumer->policy == SLOWCONSUMER_DISCONNECT)
+            {
+                if (session->getPendingMessages() >= slowConsumer->maxPendingMessages)
+                {
+                    if (slowConsumer->policy == SLOWCONSUMER_DISCONNECT)
+                    {
+                        session->disconnect();
+                    }
+                    return;
+                }
+            }
+        }
+    }
+
+    int protocolId = session->getProtocolId();
+    IMessagePtr messagePrepared;
+    auto it = std::find_if(preparedMessages.begin(), preparedMessages.end(), [protocolId] (const std::pair<int, IMessagePtr>& entry) {
+        return (entry.first == protocolId);
+    });
+    if (it != preparedMessages.end())
+    {
+        messagePrepared = it->second;
+    }
+    else
+    {
+        messagePrepared = session->prepareMessage(message);
+        preparedMessages.emplace_back(protocolId, messagePrepared);
+    }
+    // not resendable protocols get the original message, they encode it per session.
+    const IMessagePtr& messageToSend = messagePrepared ? messagePrepared : message;
 
+    std::string key;
+    if (slowConsumer && slowConsumer->policy == SLOWCONSUMER_CONFLATE && slowConsumer->funcGetConflationKey(message, key))
+    {
+        session->sendMessageConflated(messageToSend, key);
+    }
+    else
+    {
+        session->sendMessage(messageToSend);
+    }
 }
 
 
-static bool contains(const std::vector<std::int64_t>& array, std::int64_t sessionId)
+std::int64_t ConnectionHub::getSourceId(const ForwardingSnapshot& snapshot, std::int64_t sessionId)
 {
-    if (std::find(array.begin(), array.end(), sessionId) != array.end())
+    auto it = snapshot.sourceIds.find(sessionId);
+    return (it != snapshot.sourceIds.end()) ? it->second : sessionId;
+}
+
+
+// the rules of forwardMessage() for one session
+bool ConnectionHub::isRoutedTo(const ForwardingSnapshot& snapshot, std::int64_t sourceIdFrom, const IMessagePtr& message, std::int64_t sessionIdTo)
+{
+    if (sourceIdFrom == getSourceId(snapshot, sessionIdTo) ||
+        snapshot.sessionIdsStopForwardingFromSession.find(sourceIdFrom) != snapshot.sessionIdsStopForwardingFromSession.end() ||
+        snapshot.sessionIdsStopForwardingToSession.find(sessionIdTo) != snapshot.sessionIdsStopForwardingToSession.end())
     {
-        return true;
+        return false;
     }
-    return false;
+    if (snapshot.funcGetTopic)
+    {
+        std::string topic;
+        if (!snapshot.funcGetTopic(message, topic))
+        {
+            return false;
+        }
+        std::vector<std::int64_t> sessionIds;
+        snapshot.topicRoutes.getSubscribers(topic, sessionIds);
+        return std::binary_search(sessionIds.begin(), sessionIds.end(), sessionIdTo);
+    }
+    return true;
 }
 
 
-void ConnectionHub::received(const IProtocolSessionPtr& session, const IMessagePtr& message)
+bool ConnectionHub::isHeldForReplay(const ForwardingSnapshot& snapshot, std::int64_t sessionId)
 {
-    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+    if (snapshot.replays.empty())
+    {
+        return false;
+    }
+    auto it = snapshot.replays.find(sessionId);
+    if (it == snapshot.replays.end())
+    {
+        return false;
+    }
+    return it->second->running.load(std::memory_order_acquire);
+}
 
-    if (contains(m_sessionIdsStopForwardingFromSession, session->getSessionId()))
+
+void ConnectionHub::forwardMessage(const ForwardingSnapshot& snapshot, std::int64_t sessionIdFrom, const IMessagePtr& message)
+{
+    if (snapshot.sessionIdsStopForwardingFromSession.find(sessionIdFrom) != snapshot.sessionIdsStopForwardingFromSession.end())
     {
         return;
     }
-    std::vector<std::int64_t> sessionIdsStopForwardingToSession = m_sessionIdsStopForwardingToSession;
 
-    if (m_startMessageForwarding)
+    // only journaled messages can be held for a replay
+    bool journaled = false;
+    if (snapshot.journal)
+    {
+        std::uint64_t sequenceNumber = snapshot.journal->append(getSourceId(snapshot, sessionIdFrom), message->getReceivePayload());
+        message->setSequenceNumber(sequenceNumber);
+        journaled = (sequenceNumber != 0);
+    }
+
+    std::vector<std::pair<int, IMessagePtr>> preparedMessages;
+    if (snapshot.funcGetTopic)
     {
-        std::vector< IProtocolSessionPtr > sessions = m_protocolSessionContainer->getAllSessions();
-        for (size_t i = 0; i < sessions.size(); ++i)
+        std::string topic;
+        if (snapshot.funcGetTopic(message, topic))
         {
-            IProtocolSessionPtr s = sessions[i];
-            assert(s);
-            // if not from-session
-            if (s != session)
+            std::vector<std::int64_t> sessionIds;
+            snapshot.topicRoutes.getSubscribers(topic, sessionIds);
+            for (size_t i = 0; i < sessionIds.size(); ++i)
             {
-                // if not in sessionIdsStopForwardingToSession
-                if (!contains(sessionIdsStopForwardingToSession, s->getSessionId()))
+                std::int64_t sessionId = sessionIds[i];
+                if (sessionId != sessionIdFrom &&
+                    snapshot.sessionIdsStopForwardingToSession.find(sessionId) == snapshot.sessionIdsStopForwardingToSession.end() &&
+                    !(journaled && isHeldForReplay(snapshot, sessionId)))
                 {
-                    s->sendMessage(message);
+                    auto it = snapshot.sessionsById.find(sessionId);
+                    if (it != snapshot.sessionsById.end())
+                    {
+                        sendToSession(snapshot, it->second, message, preparedMessages);
+                    }
                 }
             }
         }
     }
     else
     {
-        m_messagesForForwarding.emplace_back(std::make_pair(session, message));
+        for (size_t i = 0; i < snapshot.sessions.size(); ++i)
+        {
+            const IProtocolSessionPtr& s = snapshot.sessions[i];
+            assert(s);
+            // if not from-session
+            if (s->getSessionId() != sessionIdFrom)
+            {
+                // if not in sessionIdsStopForwardingToSession
+                if (snapshot.sessionIdsStopForwardingToSession.find(s->getSessionId()) == snapshot.sessionIdsStopForwardingToSession.end() &&
+                    !(journaled && isHeldForReplay(snapshot, s->getSessionId())))
+                {
+                    sendToSession(snapshot, s, message, preparedMessages);
+                }
+            }
+        }
     }
-
-    lock.unlock();
 }
 
 void ConnectionHub::socketConnected(const IProtocolSessionPtr& session)
 {
-
+    // the incoming sessions are known from here
+    addSession(session);
 }
 
 void ConnectionHub::socketDisconnected(const IProtocolSessionPtr& session)
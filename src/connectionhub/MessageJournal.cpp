@@ -0,0 +1,290 @@
+#include "connectionhub/MessageJournal.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+#include <tuple>
+#include <assert.h>
+
+
+// record: sequence number (8 bytes), timestamp (8 bytes), session id (8 bytes), size of payload (4 bytes), payload
+// The segments are zero filled, a sequence number of 0 marks the end of a segment.
+static const int RECORD_HEADER_SIZE = 28;
+static const std::string SEGMENT_PREFIX = "journal_";
+static const std::string SEGMENT_SUFFIX = ".seg";
+// every INDEX_INTERVAL'th entry of a segment is indexed, so that a replay finds its first entry fast
+static const std::uint64_t INDEX_INTERVAL = 256;
+
+
+
+static bool readEntry(const char* mapped, std::int64_t offset, std::int64_t writeOffset, JournalEntry& entry)
+{
+    if (offset + RECORD_HEADER_SIZE > writeOffset)
+    {
+        return false;
+    }
+    const char* record = mapped + offset;
+    std::int32_t size = 0;
+    memcpy(&entry.sequenceNumber, record, 8);
+    memcpy(&entry.timestamp, record + 8, 8);
+    memcpy(&entry.sessionId, record + 16, 8);
+    memcpy(&size, record + 24, 4);
+    if (entry.sequenceNumber == 0 || size < 0 || offset + RECORD_HEADER_SIZE + size > writeOffset)
+    {
+        return false;
+    }
+    entry.payload = {const_cast<char*>(record + RECORD_HEADER_SIZE), size};
+    return true;
+}
+
+
+
+MessageJournal::Segment::~Segment()
+{
+    if (mapped)
+    {
+        munmap(mapped, size);
+    }
+    if (fd != -1)
+    {
+        close(fd);
+    }
+}
+
+
+
+MessageJournal::MessageJournal(const std::string& directory, std::int64_t segmentSize, int maxSegments)
+    : m_directory(directory)
+    , m_segmentSize(segmentSize)
+    , m_maxSegments(std::max(maxSegments, 1))
+{
+    openExistingSegments();
+}
+
+
+void MessageJournal::openExistingSegments()
+{
+    DIR* dir = opendir(m_directory.c_str());
+    if (dir == nullptr)
+    {
+        return;
+    }
+    std::vector<std::pair<std::uint64_t, std::string>> files;
+    struct dirent* dirEntry = nullptr;
+    while ((dirEntry = readdir(dir)) != nullptr)
+    {
+        std::string name = dirEntry->d_name;
+        if (name.size() > SEGMENT_PREFIX.size() + SEGMENT_SUFFIX.size() &&
+            name.compare(0, SEGMENT_PREFIX.size(), SEGMENT_PREFIX) == 0 &&
+            name.compare(name.size() - SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX) == 0)
+        {
+            std::uint64_t firstSequenceNumber = strtoull(name.c_str() + SEGMENT_PREFIX.size(), nullptr, 10);
+            files.emplace_back(firstSequenceNumber, m_directory + "/" + name);
+        }
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        SegmentPtr segment = openSegment(files[i].second, files[i].first, 0);
+        if (!segment)
+        {
+            continue;
+        }
+        // find the end of the segment
+        JournalEntry entry;
+        std::uint64_t sequenceNumber = segment->firstSequenceNumber;
+        while (readEntry(segment->mapped, segment->writeOffset, segment->size, entry) && entry.sequenceNumber == sequenceNumber)
+        {
+            if ((sequenceNumber - segment->firstSequenceNumber) % INDEX_INTERVAL == 0)
+            {
+                segment->offsets.push_back(segment->writeOffset);
+            }
+            segment->writeOffset += RECORD_HEADER_SIZE + entry.payload.second;
+            ++sequenceNumber;
+        }
+        m_segments.push_back(segment);
+        m_nextSequenceNumber = sequenceNumber;
+    }
+    removeOldSegments();
+}
+
+
+MessageJournal::SegmentPtr MessageJournal::openSegment(const std::string& fileName, std::uint64_t firstSequenceNumber, std::int64_t size)
+{
+    SegmentPtr segment = std::make_shared<Segment>();
+    segment->firstSequenceNumber = firstSequenceNumber;
+    segment->fileName = fileName;
+    segment->fd = open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (segment->fd == -1)
+    {
+        return nullptr;
+    }
+    if (size > 0)
+    {
+        if (ftruncate(segment->fd, size) == -1)
+        {
+            return nullptr;
+        }
+    }
+    else
+    {
+        struct stat st;
+        if (fstat(segment->fd, &st) == -1 || st.st_size == 0)
+        {
+            return nullptr;
+        }
+        size = st.st_size;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    segment->mapped = static_cast<char*>(mapped);
+    segment->size = size;
+    return segment;
+}
+
+
+bool MessageJournal::addSegment(std::int64_t sizeMin)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%020llu", static_cast<unsigned long long>(m_nextSequenceNumber));
+    std::string fileName = m_directory + "/" + SEGMENT_PREFIX + name + SEGMENT_SUFFIX;
+    SegmentPtr segment = openSegment(fileName, m_nextSequenceNumber, std::max(m_segmentSize, sizeMin));
+    if (!segment)
+    {
+        return false;
+    }
+    m_segments.push_back(segment);
+    removeOldSegments();
+    return true;
+}
+
+
+void MessageJournal::removeOldSegments()
+{
+    while (static_cast<int>(m_segments.size()) > m_maxSegments)
+    {
+        // a running replay keeps the mapping of the segment
+        unlink(m_segments.front()->fileName.c_str());
+        m_segments.pop_front();
+    }
+}
+
+
+std::uint64_t MessageJournal::append(std::int64_t sessionId, const BufferRef& payload)
+{
+    std::int64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::int64_t sizeRecord = RECORD_HEADER_SIZE + payload.second;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_segments.empty() || m_segments.back()->writeOffset + sizeRecord > m_segments.back()->size)
+    {
+        if (!addSegment(sizeRecord))
+        {
+            return 0;
+        }
+    }
+    Segment& segment = *m_segments.back();
+    std::uint64_t sequenceNumber = m_nextSequenceNumber;
+    std::int32_t size = payload.second;
+    char* record = segment.mapped + segment.writeOffset;
+    memcpy(record, &sequenceNumber, 8);
+    memcpy(record + 8, &timestamp, 8);
+    memcpy(record + 16, &sessionId, 8);
+    memcpy(record + 24, &size, 4);
+    memcpy(record + RECORD_HEADER_SIZE, payload.first, payload.second);
+    if ((sequenceNumber - segment.firstSequenceNumber) % INDEX_INTERVAL == 0)
+    {
+        segment.offsets.push_back(segment.writeOffset);
+    }
+    segment.writeOffset += sizeRecord;
+    ++m_nextSequenceNumber;
+    return sequenceNumber;
+}
+
+
+bool MessageJournal::replay(std::uint64_t sequenceNumberFrom, const std::function<void(const JournalEntry& entry)>& funcEntry, size_t maxEntries) const
+{
+    // segment, offset to start, write offset
+    std::vector<std::tuple<SegmentPtr, std::int64_t, std::int64_t>> segments;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (sequenceNumberFrom == 0 || sequenceNumberFrom > m_nextSequenceNumber)
+    {
+        return false;
+    }
+    if (sequenceNumberFrom == m_nextSequenceNumber)
+    {
+        return true;
+    }
+    if (m_segments.empty() || sequenceNumberFrom < m_segments.front()->firstSequenceNumber)
+    {
+        return false;
+    }
+    auto it = std::upper_bound(m_segments.begin(), m_segments.end(), sequenceNumberFrom, [] (std::uint64_t sequenceNumber, const SegmentPtr& segment) {
+        return (sequenceNumber < segment->firstSequenceNumber);
+    });
+    assert(it != m_segments.begin());
+    --it;
+    size_t indexOffset = static_cast<size_t>((sequenceNumberFrom - (*it)->firstSequenceNumber) / INDEX_INTERVAL);
+    std::int64_t offset = (indexOffset < (*it)->offsets.size()) ? (*it)->offsets[indexOffset] : 0;
+    segments.emplace_back(*it, offset, (*it)->writeOffset);
+    for (++it; it != m_segments.end(); ++it)
+    {
+        segments.emplace_back(*it, 0, (*it)->writeOffset);
+    }
+    lock.unlock();
+
+    // the entries till the captured write offsets are complete, they are read without lock.
+    for (size_t i = 0; i < segments.size() && maxEntries > 0; ++i)
+    {
+        const Segment& segment = *std::get<0>(segments[i]);
+        std::int64_t offset = std::get<1>(segments[i]);
+        std::int64_t writeOffset = std::get<2>(segments[i]);
+        JournalEntry entry;
+        entry.segment = std::get<0>(segments[i]);
+        while (maxEntries > 0 && readEntry(segment.mapped, offset, writeOffset, entry))
+        {
+            offset += RECORD_HEADER_SIZE + entry.payload.second;
+            if (entry.sequenceNumber >= sequenceNumberFrom)
+            {
+                funcEntry(entry);
+                --maxEntries;
+            }
+        }
+    }
+    return true;
+}
+
+
+std::uint64_t MessageJournal::getFirstSequenceNumber() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_segments.empty())
+    {
+        return m_nextSequenceNumber;
+    }
+    return m_segments.front()->firstSequenceNumber;
+}
+
+
+std::uint64_t MessageJournal::getLastSequenceNumber() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_nextSequenceNumber - 1;
+}
+
+
+void MessageJournal::visitLastSequenceNumber(const std::function<void(std::uint64_t sequenceNumberLast)>& funcLast) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    funcLast(m_nextSequenceNumber - 1);
+}
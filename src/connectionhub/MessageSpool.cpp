@@ -0,0 +1,207 @@
+#include "connectionhub/MessageSpool.h"
+#include "protocolconnection/ProtocolMessage.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include <assert.h>
+
+
+// record: sessionId (8 bytes), size of payload (4 bytes), payload
+static const int RECORD_HEADER_SIZE = 12;
+static const std::int64_t FILE_SIZE_MIN = 1024 * 1024;
+
+
+
+MessageSpool::MessageSpool(std::int64_t maxMemoryBytes, const std::string& spoolDirectory)
+    : m_maxMemoryBytes(maxMemoryBytes)
+    , m_spoolDirectory(spoolDirectory)
+{
+}
+
+MessageSpool::~MessageSpool()
+{
+    releaseFile();
+}
+
+
+bool MessageSpool::push(std::int64_t sessionId, const IMessagePtr& message)
+{
+    assert(message);
+    BufferRef payload = message->getReceivePayload();
+    // as soon as messages are in the file, all following messages go to the file to keep the order.
+    if (m_writeOffset > 0 || m_memoryBytes + payload.second > m_maxMemoryBytes)
+    {
+        if (appendToFile(sessionId, payload))
+        {
+            return true;
+        }
+        if (m_writeOffset > 0)
+        {
+            // in memory the message would overtake the messages in the file
+            ++m_droppedMessages;
+            return false;
+        }
+    }
+    m_memory.emplace_back(sessionId, message);
+    m_memoryBytes += payload.second;
+    return true;
+}
+
+
+bool MessageSpool::pop(size_t maxEntries, std::vector<std::pair<std::int64_t, IMessagePtr>>& entries)
+{
+    if (empty())
+    {
+        return false;
+    }
+    while (maxEntries > 0 && !m_memory.empty())
+    {
+        m_memoryBytes -= m_memory.front().second->getReceivePayload().second;
+        entries.push_back(std::move(m_memory.front()));
+        m_memory.pop_front();
+        --maxEntries;
+    }
+    while (maxEntries > 0 && m_readOffset < m_writeOffset)
+    {
+        std::int64_t sessionId = 0;
+        IMessagePtr message = readFromFile(sessionId);
+        entries.emplace_back(sessionId, message);
+        --maxEntries;
+    }
+    if (m_writeOffset > 0 && m_readOffset == m_writeOffset)
+    {
+        // the file is drained, new messages go into memory again.
+        releaseFile();
+    }
+    return true;
+}
+
+
+bool MessageSpool::empty() const
+{
+    return (m_memory.empty() && m_readOffset == m_writeOffset);
+}
+
+
+std::int64_t MessageSpool::getMemoryBytes() const
+{
+    return m_memoryBytes;
+}
+
+std::int64_t MessageSpool::getFileBytes() const
+{
+    return m_writeOffset - m_readOffset;
+}
+
+std::int64_t MessageSpool::getDroppedMessages() const
+{
+    return m_droppedMessages;
+}
+
+
+bool MessageSpool::appendToFile(std::int64_t sessionId, const BufferRef& payload)
+{
+    std::int64_t sizeNeeded = m_writeOffset + RECORD_HEADER_SIZE + payload.second;
+    // the messages, which were read, are overwritten, if they use at least the half of the file,
+    // so that every byte is moved at most once before it is read.
+    if (sizeNeeded > m_mappedSize && m_readOffset >= m_writeOffset - m_readOffset)
+    {
+        compactFile();
+        sizeNeeded = m_writeOffset + RECORD_HEADER_SIZE + payload.second;
+    }
+    if (sizeNeeded > m_mappedSize)
+    {
+        std::int64_t size = std::max(m_mappedSize, FILE_SIZE_MIN);
+        while (size < sizeNeeded)
+        {
+            size *= 2;
+        }
+        if (!mapFile(size))
+        {
+            return false;
+        }
+    }
+    std::int32_t size = payload.second;
+    char* record = m_mapped + m_writeOffset;
+    memcpy(record, &sessionId, sizeof(sessionId));
+    memcpy(record + sizeof(sessionId), &size, sizeof(size));
+    memcpy(record + RECORD_HEADER_SIZE, payload.first, payload.second);
+    m_writeOffset = sizeNeeded;
+    return true;
+}
+
+
+IMessagePtr MessageSpool::readFromFile(std::int64_t& sessionId)
+{
+    assert(m_readOffset + RECORD_HEADER_SIZE <= m_writeOffset);
+    std::int32_t size = 0;
+    const char* record = m_mapped + m_readOffset;
+    memcpy(&sessionId, record, sizeof(sessionId));
+    memcpy(&size, record + sizeof(sessionId), sizeof(size));
+    assert(m_readOffset + RECORD_HEADER_SIZE + size <= m_writeOffset);
+    IMessagePtr message = std::make_shared<ProtocolMessage>(0);
+    char* payload = message->resizeReceivePayload(size);
+    memcpy(payload, record + RECORD_HEADER_SIZE, size);
+    m_readOffset += RECORD_HEADER_SIZE + size;
+    return message;
+}
+
+
+void MessageSpool::compactFile()
+{
+    std::int64_t unread = m_writeOffset - m_readOffset;
+    memmove(m_mapped, m_mapped + m_readOffset, unread);
+    m_readOffset = 0;
+    m_writeOffset = unread;
+}
+
+
+bool MessageSpool::mapFile(std::int64_t size)
+{
+    if (m_fd == -1)
+    {
+        std::string fileName = m_spoolDirectory + "/finalmq_spool_XXXXXX";
+        m_fd = mkstemp(&fileName[0]);
+        if (m_fd == -1)
+        {
+            return false;
+        }
+        unlink(fileName.c_str());
+    }
+    if (ftruncate(m_fd, size) == -1)
+    {
+        return false;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        return false;
+    }
+    if (m_mapped)
+    {
+        munmap(m_mapped, m_mappedSize);
+    }
+    m_mapped = static_cast<char*>(mapped);
+    m_mappedSize = size;
+    return true;
+}
+
+
+void MessageSpool::releaseFile()
+{
+    if (m_mapped)
+    {
+        munmap(m_mapped, m_mappedSize);
+        m_mapped = nullptr;
+    }
+    if (m_fd != -1)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_mappedSize = 0;
+    m_readOffset = 0;
+    m_writeOffset = 0;
+}
@@ -0,0 +1,222 @@
+#include "connectionhub/TopicRouter.h"
+
+#include <algorithm>
+
+
+static const std::string LEVEL_SINGLE = "+";
+static const std::string LEVEL_MULTI = "#";
+
+
+
+static void splitLevels(const std::string& topic, std::vector<std::string>& levels)
+{
+    size_t begin = 0;
+    while (true)
+    {
+        size_t end = topic.find('/', begin);
+        if (end == std::string::npos)
+        {
+            levels.emplace_back(topic, begin);
+            break;
+        }
+        levels.emplace_back(topic, begin, end - begin);
+        begin = end + 1;
+    }
+}
+
+
+
+void TopicRoutes::match(const Node& node, const std::vector<std::string>& levels, size_t index, std::vector<std::int64_t>& sessionIds)
+{
+    auto addSessionId = [&sessionIds] (std::int64_t sessionId, bool) {
+        sessionIds.push_back(sessionId);
+    };
+    node.subscribersMultiLevel.forEach(addSessionId);
+    if (index == levels.size())
+    {
+        node.subscribers.forEach(addSessionId);
+        return;
+    }
+    const NodePtr* child = node.children.find(levels[index]);
+    if (child)
+    {
+        match(**child, levels, index + 1, sessionIds);
+    }
+    child = node.children.find(LEVEL_SINGLE);
+    if (child)
+    {
+        match(**child, levels, index + 1, sessionIds);
+    }
+}
+
+
+void TopicRoutes::getSubscribers(const std::string& topic, std::vector<std::int64_t>& sessionIds) const
+{
+    if (!m_root)
+    {
+        return;
+    }
+    std::vector<std::string> levels;
+    splitLevels(topic, levels);
+    size_t sizeBefore = sessionIds.size();
+    match(*m_root, levels, 0, sessionIds);
+    std::sort(sessionIds.begin() + sizeBefore, sessionIds.end());
+    sessionIds.erase(std::unique(sessionIds.begin() + sizeBefore, sessionIds.end()), sessionIds.end());
+}
+
+
+
+bool TopicRouter::isValidPattern(const std::string& pattern)
+{
+    std::vector<std::string> levels;
+    splitLevels(pattern, levels);
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        const std::string& level = levels[i];
+        if ((level.find_first_of("+#") != std::string::npos && level.size() != 1) ||
+            (level == LEVEL_MULTI && i != levels.size() - 1))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+TopicRouter::NodePtr TopicRouter::insert(const NodePtr& node, std::int64_t sessionId, const std::vector<std::string>& levels, size_t index, bool& inserted)
+{
+    std::shared_ptr<Node> nodeNew = node ? std::make_shared<Node>(*node) : std::make_shared<Node>();
+    if (index == levels.size())
+    {
+        inserted = nodeNew->subscribers.insert(sessionId, true);
+    }
+    else if (levels[index] == LEVEL_MULTI)
+    {
+        inserted = nodeNew->subscribersMultiLevel.insert(sessionId, true);
+    }
+    else
+    {
+        const NodePtr* child = nodeNew->children.find(levels[index]);
+        nodeNew->children.set(levels[index], insert(child ? *child : nullptr, sessionId, levels, index + 1, inserted));
+    }
+    return nodeNew;
+}
+
+
+bool TopicRouter::subscribe(std::int64_t sessionId, const std::string& pattern)
+{
+    if (!isValidPattern(pattern))
+    {
+        return false;
+    }
+    std::vector<std::string> levels;
+    splitLevels(pattern, levels);
+    bool inserted = false;
+    NodePtr root = insert(m_routes.m_root, sessionId, levels, 0, inserted);
+    if (inserted)
+    {
+        m_routes.m_root = root;
+        m_patternsOfSession[sessionId].push_back(pattern);
+    }
+    return true;
+}
+
+
+TopicRouter::NodePtr TopicRouter::remove(const NodePtr& node, std::int64_t sessionId, const std::vector<std::string>& levels, size_t index)
+{
+    if (!node)
+    {
+        return nullptr;
+    }
+    std::shared_ptr<Node> nodeNew = std::make_shared<Node>(*node);
+    if (index == levels.size())
+    {
+        nodeNew->subscribers.erase(sessionId);
+    }
+    else if (levels[index] == LEVEL_MULTI)
+    {
+        nodeNew->subscribersMultiLevel.erase(sessionId);
+    }
+    else
+    {
+        const NodePtr* child = nodeNew->children.find(levels[index]);
+        if (child)
+        {
+            NodePtr childNew = remove(*child, sessionId, levels, index + 1);
+            if (childNew)
+            {
+                nodeNew->children.set(levels[index], childNew);
+            }
+            else
+            {
+                nodeNew->children.erase(levels[index]);
+            }
+        }
+    }
+    if (nodeNew->children.empty() && nodeNew->subscribers.empty() && nodeNew->subscribersMultiLevel.empty())
+    {
+        return nullptr;
+    }
+    return nodeNew;
+}
+
+
+void TopicRouter::unsubscribe(std::int64_t sessionId, const std::string& pattern)
+{
+    auto it = m_patternsOfSession.find(sessionId);
+    if (it == m_patternsOfSession.end())
+    {
+        return;
+    }
+    std::vector<std::string>& patterns = it->second;
+    auto itPattern = std::find(patterns.begin(), patterns.end(), pattern);
+    if (itPattern == patterns.end())
+    {
+        return;
+    }
+    patterns.erase(itPattern);
+    if (patterns.empty())
+    {
+        m_patternsOfSession.erase(it);
+    }
+
+    std::vector<std::string> levels;
+    splitLevels(pattern, levels);
+    m_routes.m_root = remove(m_routes.m_root, sessionId, levels, 0);
+}
+
+
+void TopicRouter::unsubscribeAll(std::int64_t sessionId)
+{
+    auto it = m_patternsOfSession.find(sessionId);
+    if (it == m_patternsOfSession.end())
+    {
+        return;
+    }
+    std::vector<std::string> patterns = std::move(it->second);
+    m_patternsOfSession.erase(it);
+    for (size_t i = 0; i < patterns.size(); ++i)
+    {
+        std::vector<std::string> levels;
+        splitLevels(patterns[i], levels);
+        m_routes.m_root = remove(m_routes.m_root, sessionId, levels, 0);
+    }
+}
+
+
+void TopicRouter::getSubscribers(const std::string& topic, std::vector<std::int64_t>& sessionIds) const
+{
+    m_routes.getSubscribers(topic, sessionIds);
+}
+
+
+bool TopicRouter::hasSubscriptions(std::int64_t sessionId) const
+{
+    return (m_patternsOfSession.find(sessionId) != m_patternsOfSession.end());
+}
+
+
+const TopicRoutes& TopicRouter::getRoutes() const
+{
+    return m_routes;
+}
@@ -0,0 +1,88 @@
+#include "helpers/Executor.h"
+
+#include <assert.h>
+
+
+
+ExecutorWorkerPool::ExecutorWorkerPool(int numberOfWorkers, int maxQueueSize)
+    : m_maxQueueSize(maxQueueSize)
+{
+    assert(numberOfWorkers > 0);
+    assert(maxQueueSize > 0);
+    m_workers.reserve(numberOfWorkers);
+    for (int i = 0; i < numberOfWorkers; ++i)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < m_workers.size(); ++i)
+    {
+        Worker& worker = *m_workers[i];
+        worker.thread = std::thread([this, &worker] () {
+            workerLoop(worker);
+        });
+    }
+}
+
+
+ExecutorWorkerPool::~ExecutorWorkerPool()
+{
+    for (size_t i = 0; i < m_workers.size(); ++i)
+    {
+        Worker& worker = *m_workers[i];
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.terminate = true;
+        lock.unlock();
+        worker.condNotEmpty.notify_one();
+    }
+    for (size_t i = 0; i < m_workers.size(); ++i)
+    {
+        m_workers[i]->thread.join();
+    }
+}
+
+
+bool ExecutorWorkerPool::addAction(std::int64_t key, std::function<void()> func)
+{
+    Worker& worker = *m_workers[static_cast<std::uint64_t>(key) % m_workers.size()];
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    if (worker.terminate)
+    {
+        return true;
+    }
+    worker.actions.emplace_back(key, std::move(func));
+    int queued = ++worker.queuedPerKey[key];
+    lock.unlock();
+    worker.condNotEmpty.notify_one();
+    return (queued <= m_maxQueueSize);
+}
+
+
+void ExecutorWorkerPool::workerLoop(Worker& worker)
+{
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    while (true)
+    {
+        worker.condNotEmpty.wait(lock, [&worker] () {
+            return (!worker.actions.empty() || worker.terminate);
+        });
+        if (worker.actions.empty())
+        {
+            assert(worker.terminate);
+            break;
+        }
+        std::int64_t key = worker.actions.front().first;
+        std::function<void()> func = std::move(worker.actions.front().second);
+        worker.actions.pop_front();
+        lock.unlock();
+        func();
+        // release the captures of the action outside of the lock
+        func = nullptr;
+        lock.lock();
+        auto it = worker.queuedPerKey.find(key);
+        assert(it != worker.queuedPerKey.end());
+        if (--it->second == 0)
+        {
+            worker.queuedPerKey.erase(it);
+        }
+    }
+}
@@ -1,80 +1,78 @@
-
 #include "metadata/MetaData.h"
 
 #include <assert.h>
 #include <iostream>
 
 
+
+MetaData::MetaData()
+{
+    publishIndex(std::make_unique<Index>());
+}
+
+
 // IMetaData
 
 const MetaStruct* MetaData::getStruct(const std::string& typeName) const
 {
-    auto it = m_name2Struct.find(typeName);
-    if (it != m_name2Struct.end())
-    {
-        return &it->second;
-    }
-    return nullptr;
+    return findStruct(typeName);
 }
 
 
 const MetaEnum* MetaData::getEnum(const std::string& typeName) const
 {
-    auto it = m_name2Enum.find(typeName);
-    if (it != m_name2Enum.end())
-    {
-        return &it->second;
-    }
-    return nullptr;
+    return findEnum(typeName);
 }
 
 
 const MetaStruct* MetaData::getStruct(const MetaField& field) const
 {
     assert(field.typeId == MetaTypeId::TYPE_STRUCT || field.typeId == MetaTypeId::TYPE_ARRAY_STRUCT);
-    if (!field.metaStruct)
+    const MetaStruct* stru = field.metaStruct;
+    if (stru)
     {
-        const MetaStruct* stru = getStruct(field.typeName);
+        return stru;
+    }
+    stru = findStruct(field.typeName);
+    if (stru)
+    {
+        // a registered struct is never removed or moved
         field.metaStruct = stru;
-        if (!field.metaStruct)
-        {
-            // struct not found
-            std::cout << "struct not found: " << field.typeName << std::endl;
-        }
     }
-    return field.metaStruct;
+    else
+    {
+        // struct not found
+        std::cout << "struct not found: " << field.typeName << std::endl;
+    }
+    return stru;
 }
 
 
 const MetaEnum* MetaData::getEnum(const MetaField& field) const
 {
     assert(field.typeId == MetaTypeId::TYPE_ENUM || field.typeId == MetaTypeId::TYPE_ARRAY_ENUM);
-    if (!field.metaEnum)
+    const MetaEnum* en = field.metaEnum;
+    if (en)
+    {
+        return en;
+    }
+    en = findEnum(field.typeName);
+    if (en)
     {
-        const MetaEnum* en = getEnum(field.typeName);
         field.metaEnum = en;
-        if (!field.metaEnum)
-        {
-            // enum not found
-            std::cout << "enum not found: " << field.typeName << std::endl;
-        }
     }
-    return field.metaEnum;
+    else
+    {
+        // enum not found
+        std::cout << "enum not found: " << field.typeName << std::endl;
+    }
+    return en;
 }
 
 
-
 const MetaField* MetaData::getArrayField(const MetaField& field) const
 {
-
-    assert((int)field.typeId & (int)MetaTypeId::TYPE_ARRAY_FLAG);
-    if (!field.fieldWithoutArray)
-    {
-        field.fieldWithoutArray = std::make_shared<MetaField>(field);
-        field.fieldWithoutArray->typeId = (MetaTypeId)((int)field.typeId & ~(int)MetaTypeId::TYPE_ARRAY_FLAG);
-        field.fieldWithoutArray->name.clear();
-    }
-    return field.fieldWithoutArray.get();
+    return getArrayFieldIntern(field);
 }
 
 
@@ -111,6 +109,12 @@ void MetaData::addStruct(MetaStruct&& stru)
 {
     std::unique_lock<std::mutex> lock(m_mutex);
 
+    if (m_frozen)
+    {
+        std::cout << "metadata is frozen, struct not added: " << stru.getTypeName() << std::endl;
+        return;
+    }
+
     if (m_name2Struct.find(stru.getTypeName()) != m_name2Struct.end())
     {
         // struct already added
@@ -118,7 +122,15 @@ void MetaData::addStruct(MetaStruct&& stru)
     }
 
     std::string typeName = stru.getTypeName();
-    m_name2Struct.emplace(typeName, std::move(stru));
+    int typeId = m_structs.size();
+    stru.setTypeId(typeId);
+    auto it = m_name2Struct.emplace(typeName, std::move(stru)).first;
+    m_structs.push_back(&it->second);
+
+    std::unique_ptr<Index> index = std::make_unique<Index>(*m_index.load(std::memory_order_relaxed));
+    index->name2Struct.set(typeName, &it->second);
+    index->structs.set(typeId, &it->second);
+    publishIndex(std::move(index));
 
     lock.unlock();
 }
@@ -134,18 +146,147 @@ void MetaData::addEnum(MetaEnum&& en)
 {
     std::unique_lock<std::mutex> lock(m_mutex);
 
+    if (m_frozen)
+    {
+        std::cout << "metadata is frozen, enum not added: " << en.getTypeName() << std::endl;
+        return;
+    }
+
     if (m_name2Enum.find(en.getTypeName()) != m_name2Enum.end())
     {
         // enum already added
         return;
     }
 
-    m_name2Enum.emplace(en.getTypeName(), std::move(en));
+    std::string typeName = en.getTypeName();
+    int typeId = m_enums.size();
+    en.setTypeId(typeId);
+    auto it = m_name2Enum.emplace(typeName, std::move(en)).first;
+    m_enums.push_back(&it->second);
+
+    std::unique_ptr<Index> index = std::make_unique<Index>(*m_index.load(std::memory_order_relaxed));
+    index->name2Enum.set(typeName, &it->second);
+    index->enums.set(typeId, &it->second);
+    publishIndex(std::move(index));
 
     lock.unlock();
 }
 
 
+void MetaData::publishIndex(std::unique_ptr<Index>&& index)
+{
+    m_index.store(index.get(), std::memory_order_release);
+    m_indexes.push_back(std::move(index));
+}
+
+
+void MetaData::freeze()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_frozen)
+    {
+        return;
+    }
+
+    // fill all caches of the fields, after freeze the fields of the registered structs are not modified anymore.
+    for (size_t i = 0; i < m_structs.size(); ++i)
+    {
+        const MetaStruct& stru = *m_structs[i];
+        for (int n = 0; n < stru.getFieldsSize(); ++n)
+        {
+            resolveField(*stru.getFieldByIndex(n));
+        }
+    }
+
+    m_frozen.store(true, std::memory_order_release);
+}
+
+
+bool MetaData::isFrozen() const
+{
+    return m_frozen.load(std::memory_order_acquire);
+}
+
+
+const MetaStruct* MetaData::getStructById(int typeId) const
+{
+    if (m_frozen.load(std::memory_order_acquire))
+    {
+        return (typeId >= 0 && typeId < static_cast<int>(m_structs.size())) ? m_structs[typeId] : nullptr;
+    }
+    const MetaStruct* const* stru = m_index.load(std::memory_order_acquire)->structs.find(typeId);
+    return stru ? *stru : nullptr;
+}
+
+
+const MetaEnum* MetaData::getEnumById(int typeId) const
+{
+    if (m_frozen.load(std::memory_order_acquire))
+    {
+        return (typeId >= 0 && typeId < static_cast<int>(m_enums.size())) ? m_enums[typeId] : nullptr;
+    }
+    const MetaEnum* const* en = m_index.load(std::memory_order_acquire)->enums.find(typeId);
+    return en ? *en : nullptr;
+}
+
+
+
+const MetaStruct* MetaData::findStruct(const std::string& typeName) const
+{
+    if (m_frozen.load(std::memory_order_acquire))
+    {
+        auto it = m_name2Struct.find(typeName);
+        return (it != m_name2Struct.end()) ? &it->second : nullptr;
+    }
+    const MetaStruct* const* stru = m_index.load(std::memory_order_acquire)->name2Struct.find(typeName);
+    return stru ? *stru : nullptr;
+}
+
+
+const MetaEnum* MetaData::findEnum(const std::string& typeName) const
+{
+    if (m_frozen.load(std::memory_order_acquire))
+    {
+        auto it = m_name2Enum.find(typeName);
+        return (it != m_name2Enum.end()) ? &it->second : nullptr;
+    }
+    const MetaEnum* const* en = m_index.load(std::memory_order_acquire)->name2Enum.find(typeName);
+    return en ? *en : nullptr;
+}
+
+
+const MetaField* MetaData::getArrayFieldIntern(const MetaField& field)
+{
+    assert((int)field.typeId & (int)MetaTypeId::TYPE_ARRAY_FLAG);
+    if (!field.fieldWithoutArray)
+    {
+        // the fields of a MetaStruct have it already (see MetaStruct::addField), so it is only
+        // written here for fields, which do not belong to a struct.
+        field.fieldWithoutArray = MetaStruct::createFieldWithoutArray(field);
+    }
+    return field.fieldWithoutArray.get();
+}
+
+
+void MetaData::resolveField(const MetaField& field) const
+{
+    // getStruct() and getEnum() fill the caches
+    if (field.typeId == MetaTypeId::TYPE_STRUCT || field.typeId == MetaTypeId::TYPE_ARRAY_STRUCT)
+    {
+        getStruct(field);
+    }
+    else if (field.typeId == MetaTypeId::TYPE_ENUM || field.typeId == MetaTypeId::TYPE_ARRAY_ENUM)
+    {
+        getEnum(field);
+    }
+    if ((int)field.typeId & (int)MetaTypeId::TYPE_ARRAY_FLAG)
+    {
+        resolveField(*getArrayFieldIntern(field));
+    }
+}
+
+
 ////////////////////////////////
 
 std::unique_ptr<IMetaData> MetaDataGlobal::m_instance;
@@ -1,6 +1,11 @@
 
 #include "metadata/MetaEnum.h"
 
+#include <algorithm>
+
+
+// ids are looked up in a table instead of the hash map, if the table is not bigger than this factor times the number of entries
+static const int DENSE_IDS_FACTOR = 4;
 
 
 void MetaEnum::setTypeName(const std::string& typeName)
@@ -13,13 +18,36 @@ const std::string& MetaEnum::getTypeName() const
     return m_typeName;
 }
 
+void MetaEnum::setTypeId(int typeId)
+{
+    m_typeId = typeId;
+}
+
+int MetaEnum::getTypeId() const
+{
+    return m_typeId;
+}
+
 
 const MetaEnumEntry* MetaEnum::getEntryById(int id) const
 {
-    auto it = m_id2Entry.find(id);
-    if (it != m_id2Entry.end())
+    if (!m_denseId2Index.empty())
+    {
+        std::int64_t offset = static_cast<std::int64_t>(id) - m_denseIdMin;
+        if (offset >= 0 && offset < static_cast<std::int64_t>(m_denseId2Index.size()))
+        {
+            int index = m_denseId2Index[offset];
+            if (index >= 0)
+            {
+                return &m_entries[index];
+            }
+        }
+        return nullptr;
+    }
+    auto it = m_id2Index.find(id);
+    if (it != m_id2Index.end())
     {
-        return it->second.get();
+        return &m_entries[it->second];
     }
     return nullptr;
 }
@@ -27,10 +55,10 @@ const MetaEnumEntry* MetaEnum::getEntryById(int id) const
 
 const MetaEnumEntry* MetaEnum::getEntryByName(const std::string& name) const
 {
-    auto it = m_name2Entry.find(name);
-    if (it != m_name2Entry.end())
+    auto it = m_name2Index.find(name);
+    if (it != m_name2Index.end())
     {
-        return it->second.get();
+        return &m_entries[it->second];
     }
     return nullptr;
 }
@@ -39,9 +67,9 @@ const MetaEnumEntry* MetaEnum::getEntryByName(const std::string& name) const
 
 const MetaEnumEntry* MetaEnum::getEntryByIndex(int index) const
 {
-    if (index < static_cast<int>(m_entries.size()))
+    if (index >= 0 && index < static_cast<int>(m_entries.size()))
     {
-        return m_entries[index].get();
+        return &m_entries[index];
     }
     return nullptr;
 }
@@ -49,8 +77,7 @@ const MetaEnumEntry* MetaEnum::getEntryByIndex(int index) const
 
 bool MetaEnum::isId(int id) const
 {
-    auto it = m_id2Entry.find(id);
-    return (it != m_id2Entry.end());
+    return (getEntryById(id) != nullptr);
 }
 
 
@@ -96,15 +123,37 @@ void MetaEnum::addEntry(const MetaEnumEntry& entry)
 
 void MetaEnum::addEntry(MetaEnumEntry&& entry)
 {
-    if (m_id2Entry.find(entry.id) != m_id2Entry.end())
+    if (m_id2Index.find(entry.id) != m_id2Index.end())
     {
         // entry already added
         return;
     }
 
-    std::shared_ptr<MetaEnumEntry> e = std::make_shared<MetaEnumEntry>(std::move(entry));
-    m_entries.emplace_back(e);
-    m_id2Entry.emplace(e->id, e);
-    m_name2Entry.emplace(e->name, e);
+    int index = m_entries.size();
+    m_id2Index.emplace(entry.id, index);
+    m_name2Index.emplace(entry.name, index);
+    m_entries.emplace_back(std::move(entry));
+
+    buildDenseIds();
+}
+
+
+void MetaEnum::buildDenseIds()
+{
+    m_denseId2Index.clear();
+    auto minmax = std::minmax_element(m_entries.begin(), m_entries.end(), [] (const MetaEnumEntry& a, const MetaEnumEntry& b) {
+        return (a.id < b.id);
+    });
+    std::int64_t range = static_cast<std::int64_t>(minmax.second->id) - minmax.first->id + 1;
+    if (range > static_cast<std::int64_t>(m_entries.size()) * DENSE_IDS_FACTOR)
+    {
+        return;
+    }
+    m_denseIdMin = minmax.first->id;
+    m_denseId2Index.resize(range, -1);
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        m_denseId2Index[m_entries[i].id - m_denseIdMin] = i;
+    }
 }
 
@@ -13,13 +13,23 @@ const std::string& MetaStruct::getTypeName() const
     return m_typeName;
 }
 
+void MetaStruct::setTypeId(int typeId)
+{
+    m_typeId = typeId;
+}
+
+int MetaStruct::getTypeId() const
+{
+    return m_typeId;
+}
+
 
 
 const MetaField* MetaStruct::getFieldByIndex(int index) const
 {
     if (index >= 0 && index < static_cast<int>(m_fields.size()))
     {
-        return m_fields[index].get();
+        return &m_fields[index];
     }
     return nullptr;
 }
@@ -27,10 +37,10 @@ const MetaField* MetaStruct::getFieldByIndex(int index) const
 
 const MetaField* MetaStruct::getFieldByName(const std::string& name) const
 {
-    auto it = m_name2Field.find(name);
-    if (it != m_name2Field.end())
+    auto it = m_name2Index.find(name);
+    if (it != m_name2Index.end())
     {
-        return it->second.get();
+        return &m_fields[it->second];
     }
     return nullptr;
 }
@@ -44,15 +54,28 @@ void MetaStruct::addField(const MetaField& field)
 
 void MetaStruct::addField(MetaField&& field)
 {
-    if (m_name2Field.find(field.name) != m_name2Field.end())
+    if (m_name2Index.find(field.name) != m_name2Index.end())
     {
         // field already added
         return;
     }
 
     field.index = m_fields.size();
+    if (((int)field.typeId & (int)MetaTypeId::TYPE_ARRAY_FLAG) && !field.fieldWithoutArray)
+    {
+        field.fieldWithoutArray = createFieldWithoutArray(field);
+    }
+
+    m_name2Index.emplace(field.name, field.index);
+    m_fields.emplace_back(std::move(field));
+}
+
 
-    std::shared_ptr<MetaField> f = std::make_shared<MetaField>(std::move(field));
-    m_fields.emplace_back(f);
-    m_name2Field.emplace(f->name, f);
+std::shared_ptr<MetaField> MetaStruct::createFieldWithoutArray(const MetaField& field)
+{
+    std::shared_ptr<MetaField> fieldWithoutArray = std::make_shared<MetaField>(field);
+    fieldWithoutArray->typeId = (MetaTypeId)((int)field.typeId & ~(int)MetaTypeId::TYPE_ARRAY_FLAG);
+    fieldWithoutArray->name.clear();
+    fieldWithoutArray->fieldWithoutArray = nullptr;
+    return fieldWithoutArray;
 }
@@ -72,6 +72,8 @@ void PollerImplEpoll::removeSocket(const SocketDescriptorPtr& fd)
         int res = OperatingSystem::instance().epoll_ctl(m_fdEpoll, EPOLL_CTL_DEL, fd->getDescriptor(), &ev);
         assert(res != -1);
         m_socketDescriptors.erase(fd);
+        m_writeEnabled.erase(fd->getDescriptor());
+        m_readDisabled.erase(fd->getDescriptor());
         sockedDescriptorHasChanged();
     }
     else
@@ -88,11 +90,8 @@ void PollerImplEpoll::enableWrite(const SocketDescriptorPtr& fd)
     std::unique_lock<std::mutex> locker(m_mutex);
     if (m_socketDescriptors.find(fd) != m_socketDescriptors.end())
     {
-        epoll_event ev;
-        ev.events = EPOLLIN | EPOLLOUT;
-        ev.data.fd = fd->getDescriptor();
-        int res = OperatingSystem::instance().epoll_ctl(m_fdEpoll, EPOLL_CTL_MOD, fd->getDescriptor(), &ev);
-        assert(res != -1);
+        m_writeEnabled.insert(fd->getDescriptor());
+        modifyEvents(fd);
     }
     else
     {
@@ -107,11 +106,44 @@ void PollerImplEpoll::disableWrite(const SocketDescriptorPtr& fd)
     std::unique_lock<std::mutex> locker(m_mutex);
     if (m_socketDescriptors.find(fd) != m_socketDescriptors.end())
     {
-        epoll_event ev;
-        ev.events = EPOLLIN;
-        ev.data.fd = fd->getDescriptor();
-        int res = OperatingSystem::instance().epoll_ctl(m_fdEpoll, EPOLL_CTL_MOD, fd->getDescriptor(), &ev);
-        assert(res != -1);
+        m_writeEnabled.erase(fd->getDescriptor());
+        modifyEvents(fd);
+    }
+    else
+    {
+        // error: socket not added
+    }
+    locker.unlock();
+}
+
+
+void PollerImplEpoll::enableRead(const SocketDescriptorPtr& fd)
+{
+    std::unique_lock<std::mutex> locker(m_mutex);
+    if (m_socketDescriptors.find(fd) != m_socketDescriptors.end())
+    {
+        if (m_readDisabled.erase(fd->getDescriptor()) > 0)
+        {
+            modifyEvents(fd);
+        }
+    }
+    else
+    {
+        // socket not added (anymore)
+    }
+    locker.unlock();
+}
+
+
+void PollerImplEpoll::disableRead(const SocketDescriptorPtr& fd)
+{
+    std::unique_lock<std::mutex> locker(m_mutex);
+    if (m_socketDescriptors.find(fd) != m_socketDescriptors.end())
+    {
+        if (m_readDisabled.insert(fd->getDescriptor()).second)
+        {
+            modifyEvents(fd);
+        }
     }
     else
     {
@@ -121,6 +153,26 @@ void PollerImplEpoll::disableWrite(const SocketDescriptorPtr& fd)
 }
 
 
+void PollerImplEpoll::modifyEvents(const SocketDescriptorPtr& fd)
+{
+    SOCKET sd = fd->getDescriptor();
+    epoll_event ev;
+    // EPOLLERR and EPOLLHUP are always reported, also when reading is disabled
+    ev.events = 0;
+    if (m_readDisabled.find(sd) == m_readDisabled.end())
+    {
+        ev.events |= EPOLLIN;
+    }
+    if (m_writeEnabled.find(sd) != m_writeEnabled.end())
+    {
+        ev.events |= EPOLLOUT;
+    }
+    ev.data.fd = sd;
+    int res = OperatingSystem::instance().epoll_ctl(m_fdEpoll, EPOLL_CTL_MOD, sd, &ev);
+    assert(res != -1);
+}
+
+
 
 void PollerImplEpoll::sockedDescriptorHasChanged()
 {
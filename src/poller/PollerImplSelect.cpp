@@ -55,6 +55,7 @@ void PollerImplSelect::removeSocket(const SocketDescriptorPtr& fd)
         FD_CLR(fd->getDescriptor(), &m_readfdsCached);
         FD_CLR(fd->getDescriptor(), &m_writefdsCached);
         m_socketDescriptors.erase(fd);
+        m_readDisabled.erase(fd->getDescriptor());
         sockedDescriptorHasChanged();
     }
     else
@@ -104,6 +105,35 @@ void PollerImplSelect::disableWrite(const SocketDescriptorPtr& fd)
 }
 
 
+void PollerImplSelect::enableRead(const SocketDescriptorPtr& fd)
+{
+    std::unique_lock<std::mutex> locker(m_mutex);
+    if (m_readDisabled.erase(fd->getDescriptor()) > 0)
+    {
+        writeSockedDescriptorHasChanged();
+    }
+    locker.unlock();
+}
+
+
+void PollerImplSelect::disableRead(const SocketDescriptorPtr& fd)
+{
+    std::unique_lock<std::mutex> locker(m_mutex);
+    if (FD_ISSET(fd->getDescriptor(), &m_readfdsCached))
+    {
+        if (m_readDisabled.insert(fd->getDescriptor()).second)
+        {
+            writeSockedDescriptorHasChanged();
+        }
+    }
+    else
+    {
+        // error: socket not added
+    }
+    locker.unlock();
+}
+
+
 void PollerImplSelect::copyFds(fd_set& dest, fd_set& source)
 {
     memcpy(&dest, &source, sizeof(fd_set));
@@ -254,6 +284,10 @@ const PollerResult& PollerImplSelect::wait(std::int32_t timeout)
             // copy fds
             copyFds(m_readfds, m_readfdsCached);
             copyFds(m_writefds, m_writefdsCached);
+            for (auto it = m_readDisabled.begin(); it != m_readDisabled.end(); ++it)
+            {
+                FD_CLR(*it, &m_readfds);
+            }
 
             locker.unlock();
 
@@ -18,6 +18,7 @@ ProtocolMessage::ProtocolMessage(int protocolId, int sizeHeader, int sizeTrailer
 char* ProtocolMessage::addBuffer(int size)
 {
     assert(!m_preparedToSend);
+    assert(!m_sendPayloadOwner);
     int sizeHeader = 0;
     if (m_payloadBuffers.empty())
     {
@@ -49,6 +50,7 @@ void ProtocolMessage::downsizeLastBuffer(int newSize)
     }
 
     assert(!m_payloadBuffers.empty());
+    assert(!m_sendPayloadOwner);
     assert(m_sendBufferRefs.size() == m_payloadBuffers.size() + m_headerBuffers.size());
 
     int sizeHeader = 0;
@@ -91,9 +93,40 @@ void ProtocolMessage::downsizeLastSendPayload(int newSize)
     return downsizeLastBuffer(newSize);
 }
 
+void ProtocolMessage::addSendPayloadReference(const char* payload, int size, const std::shared_ptr<const void>& owner)
+{
+    assert(!m_preparedToSend);
+    assert(m_payloadBuffers.empty() && owner);
+    // the header and the trailer of the protocol get own buffers around the payload
+    if (m_sizeHeader > 0)
+    {
+        m_payloadBuffers.emplace_back(m_sizeHeader, '\0');
+        m_sendBufferRefs.push_back({const_cast<char*>(m_payloadBuffers.back().data()), m_sizeHeader});
+    }
+    m_sendBufferRefs.push_back({const_cast<char*>(payload), size});
+    if (m_sizeTrailer > 0)
+    {
+        m_payloadBuffers.emplace_back(m_sizeTrailer, '\0');
+        m_sendBufferRefs.push_back({const_cast<char*>(m_payloadBuffers.back().data()), m_sizeTrailer});
+    }
+    m_sendPayloadRefs.push_back({const_cast<char*>(payload), size});
+    m_sizeSendBufferTotal += m_sizeHeader + size + m_sizeTrailer;
+    m_sizeSendPayloadTotal += size;
+    m_sendPayloadOwner = owner;
+}
+
+const std::shared_ptr<const void>& ProtocolMessage::getSendPayloadOwner() const
+{
+    return m_sendPayloadOwner;
+}
+
 // for receive
 BufferRef ProtocolMessage::getReceivePayload()
 {
+    if (m_sendPayloadOwner && m_sizeReceiveBuffer == 0)
+    {
+        return m_sendPayloadRefs.front();
+    }
     return {const_cast<char*>(m_receiveBuffer.data() + m_sizeHeader), m_sizeReceiveBuffer - m_sizeHeader};
 }
 
@@ -113,10 +146,18 @@ char* ProtocolMessage::resizeReceivePayload(int size)
 // for the framework
 const std::list<BufferRef>& ProtocolMessage::getAllSendBuffers() const
 {
+    if (m_sendBufferMessage)
+    {
+        return m_sendBufferMessage->getAllSendBuffers();
+    }
     return m_sendBufferRefs;
 }
 int ProtocolMessage::getTotalSendBufferSize() const
 {
+    if (m_sendBufferMessage)
+    {
+        return m_sendBufferMessage->getTotalSendBufferSize();
+    }
     return m_sizeSendBufferTotal;
 }
 
@@ -158,7 +199,7 @@ void ProtocolMessage::downsizeLastSendHeader(int newSize)
 {
     assert(!m_preparedToSend);
     assert(!m_headerBuffers.empty());
-    assert(m_sendBufferRefs.size() == m_payloadBuffers.size() + m_headerBuffers.size());
+    assert(m_sendBufferRefs.size() == m_payloadBuffers.size() + m_headerBuffers.size() + (m_sendPayloadOwner ? 1 : 0));
     auto itSendBufferRefs = m_itSendBufferRefsPayloadBegin;
     --itSendBufferRefs;
     int& sizeCurrent = itSendBufferRefs->second;
@@ -166,6 +207,14 @@ void ProtocolMessage::downsizeLastSendHeader(int newSize)
     sizeCurrent = newSize;
 }
 
+// for the protocol to send the buffers of another message instead of the own send buffers
+void ProtocolMessage::setSendBufferMessage(const IMessagePtr& msg)
+{
+    assert(!m_preparedToSend);
+    assert(msg.get() != this);
+    m_sendBufferMessage = msg;
+}
+
 // for the protocol to prepare the message for send
 void ProtocolMessage::prepareMessageToSend()
 {
@@ -197,3 +246,13 @@ IMessagePtr ProtocolMessage::getMessage(int protocolId) const
     }
     return nullptr;
 }
+
+void ProtocolMessage::setSequenceNumber(std::uint64_t sequenceNumber)
+{
+    m_sequenceNumber = sequenceNumber;
+}
+
+std::uint64_t ProtocolMessage::getSequenceNumber() const
+{
+    return m_sequenceNumber;
+}
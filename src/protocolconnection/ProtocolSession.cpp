@@ -2,19 +2,23 @@
 #include "protocolconnection/ProtocolSession.h"
 #include "streamconnection/StreamConnectionContainer.h"
 
+#include <algorithm>
 
 
 
 
-ProtocolSession::ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList)
+
+ProtocolSession::ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const std::weak_ptr<IExecutor>& executor, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList)
     : m_callback(callback)
+    , m_executor(executor)
     , m_protocol(protocol)
     , m_protocolSessionList(protocolSessionList)
 {
 }
 
-ProtocolSession::ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const std::shared_ptr<IStreamConnectionContainer>& streamConnectionContainer, const std::string& endpoint, int reconnectInterval, int totalReconnectDuration)
+ProtocolSession::ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const std::weak_ptr<IExecutor>& executor, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const std::shared_ptr<IStreamConnectionContainer>& streamConnectionContainer, const std::string& endpoint, int reconnectInterval, int totalReconnectDuration)
     : m_callback(callback)
+    , m_executor(executor)
     , m_protocol(protocol)
     , m_protocolSessionList(protocolSessionList)
     , m_streamConnectionContainer(streamConnectionContainer)
@@ -26,8 +30,9 @@ ProtocolSession::ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callb
 
 
 #ifdef USE_OPENSSL
-ProtocolSession::ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const CertificateData& certificateData)
+ProtocolSession::ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const std::weak_ptr<IExecutor>& executor, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const CertificateData& certificateData)
     : m_callback(callback)
+    , m_executor(executor)
     , m_protocol(protocol)
     , m_protocolSessionList(protocolSessionList)
     , m_ssl(true)
@@ -36,8 +41,9 @@ ProtocolSession::ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callb
 
 }
 
-ProtocolSession::ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const std::shared_ptr<IStreamConnectionContainer>& streamConnectionContainer, const std::string& endpoint, const CertificateData& certificateData, int reconnectInterval, int totalReconnectDuration)
+ProtocolSession::ProtocolSession(bex::hybrid_ptr<IProtocolSessionCallback> callback, const std::weak_ptr<IExecutor>& executor, const IProtocolPtr& protocol, const std::weak_ptr<IProtocolSessionList>& protocolSessionList, const std::shared_ptr<IStreamConnectionContainer>& streamConnectionContainer, const std::string& endpoint, const CertificateData& certificateData, int reconnectInterval, int totalReconnectDuration)
     : m_callback(callback)
+    , m_executor(executor)
     , m_protocol(protocol)
     , m_protocolSessionList(protocolSessionList)
     , m_streamConnectionContainer(streamConnectionContainer)
@@ -87,6 +93,10 @@ int64_t ProtocolSession::setConnection(const IStreamConnectionPtr& connection)
     {
         std::unique_lock<std::mutex> lock(m_mutex);
         m_connection = connection;
+        if (connection && m_coalescingMaxBytes > 0)
+        {
+            connection->setCoalescing(m_coalescingMaxBytes, m_coalescingMaxMessages, m_coalescingDeadlineUs);
+        }
         lock.unlock();
         if (m_sessionId == 0)
         {
@@ -106,7 +116,7 @@ IMessagePtr ProtocolSession::createMessage() const
     return m_protocol->createMessage();
 }
 
-bool ProtocolSession::sendMessage(const IMessagePtr& msg)
+IMessagePtr ProtocolSession::convertMessage(const IMessagePtr& msg)
 {
     IMessagePtr message = msg;
     if (message->getProtocolId() != m_protocol->getProtocolId() ||
@@ -121,7 +131,13 @@ bool ProtocolSession::sendMessage(const IMessagePtr& msg)
         if (message == nullptr)
         {
             message = m_protocol->createMessage();
-            if (msg->getTotalSendPayloadSize() > 0)
+            if (msg->getSendPayloadOwner())
+            {
+                // the referenced payload is not copied
+                const BufferRef& payload = msg->getAllSendPayloads().front();
+                message->addSendPayloadReference(payload.first, payload.second, msg->getSendPayloadOwner());
+            }
+            else if (msg->getTotalSendPayloadSize() > 0)
             {
                 int sizePayload = msg->getTotalSendPayloadSize();
                 char* payload = message->addSendPayload(sizePayload);
@@ -137,10 +153,13 @@ bool ProtocolSession::sendMessage(const IMessagePtr& msg)
             }
             else
             {
+                // an empty message gets an empty payload, so that the protocol has a buffer for its header
                 BufferRef receivePayload = msg->getReceivePayload();
-                char* payload = message->addSendPayload(receivePayload.second);
-                memcpy(payload, receivePayload.first, receivePayload.second);
+                int sizePayload = std::max(receivePayload.second, 0);
+                char* payload = message->addSendPayload(sizePayload);
+                memcpy(payload, receivePayload.first, sizePayload);
             }
+            message->setSequenceNumber(msg->getSequenceNumber());
             if (m_protocol->areMessagesResendable())
             {
                 msg->addMessage(message);
@@ -148,23 +167,72 @@ bool ProtocolSession::sendMessage(const IMessagePtr& msg)
         }
     }
 
-    assert(message->getTotalSendPayloadSize() > 0);
+    assert(!message->getAllSendBuffers().empty());
+    return message;
+}
+
+bool ProtocolSession::sendMessage(const IMessagePtr& msg, MessagePriority priority)
+{
+    IMessagePtr message = convertMessage(msg);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_protocol->prepareMessageToSend(message);
+    IStreamConnectionPtr connection = m_connection;
+    if (connection)
+    {
+        return connection->sendMessage(message, priority);
+    }
+    return false;
+}
+
+bool ProtocolSession::sendMessageConflated(const IMessagePtr& msg, const std::string& conflationKey, MessagePriority priority)
+{
+    IMessagePtr message = convertMessage(msg);
 
     std::unique_lock<std::mutex> lock(m_mutex);
     m_protocol->prepareMessageToSend(message);
     IStreamConnectionPtr connection = m_connection;
     if (connection)
     {
-        return connection->sendMessage(message);
+        return connection->sendMessageConflated(message, conflationKey, priority);
     }
     return false;
 }
 
+int ProtocolSession::getPendingMessages() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    IStreamConnectionPtr connection = m_connection;
+    lock.unlock();
+    if (connection)
+    {
+        return connection->getPendingMessages();
+    }
+    return 0;
+}
+
+IMessagePtr ProtocolSession::prepareMessage(const IMessagePtr& msg)
+{
+    if (!m_protocol->areMessagesResendable())
+    {
+        return nullptr;
+    }
+    IMessagePtr message = convertMessage(msg);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_protocol->prepareMessageToSend(message);
+    return message;
+}
+
 std::int64_t ProtocolSession::getSessionId() const
 {
     return m_sessionId;
 }
 
+int ProtocolSession::getProtocolId() const
+{
+    return m_protocol->getProtocolId();
+}
+
 const ConnectionData& ProtocolSession::getConnectionData() const
 {
     std::unique_lock<std::mutex> lock(m_mutex);
@@ -198,6 +266,73 @@ void ProtocolSession::disconnect()
 }
 
 
+void ProtocolSession::setCoalescing(int maxBytes, int maxMessages, int deadlineUs)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_coalescingMaxBytes = maxBytes;
+    m_coalescingMaxMessages = maxMessages;
+    m_coalescingDeadlineUs = deadlineUs;
+    IStreamConnectionPtr connection = m_connection;
+    lock.unlock();
+    if (connection)
+    {
+        connection->setCoalescing(maxBytes, maxMessages, deadlineUs);
+    }
+}
+
+
+void ProtocolSession::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    IStreamConnectionPtr connection = m_connection;
+    lock.unlock();
+    if (connection)
+    {
+        connection->flush();
+    }
+}
+
+
+void ProtocolSession::disableRead()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    IStreamConnectionPtr connection = m_connection;
+    lock.unlock();
+    if (connection)
+    {
+        connection->disableRead();
+    }
+}
+
+
+void ProtocolSession::enableRead()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    IStreamConnectionPtr connection = m_connection;
+    lock.unlock();
+    if (connection)
+    {
+        connection->enableRead();
+    }
+}
+
+
+void ProtocolSession::notifyWhenSent(std::function<void()> func)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    IStreamConnectionPtr connection = m_connection;
+    lock.unlock();
+    if (connection)
+    {
+        connection->notifyWhenSent(std::move(func));
+    }
+    else
+    {
+        func();
+    }
+}
+
+
 // IStreamConnectionCallback
 bex::hybrid_ptr<IStreamConnectionCallback> ProtocolSession::connected(const IStreamConnectionPtr& connection)
 {
@@ -220,20 +355,16 @@ void ProtocolSession::received(const IStreamConnectionPtr& connection, const Soc
 // IProtocolCallback
 void ProtocolSession::connected()
 {
-    auto callback = m_callback.lock();
-    if (callback)
-    {
-        callback->connected(shared_from_this());
-    }
+    callCallback([] (IProtocolSessionCallback& callback, const IProtocolSessionPtr& session) {
+        callback.connected(session);
+    });
 }
 
 void ProtocolSession::disconnected()
 {
-    auto callback = m_callback.lock();
-    if (callback)
-    {
-        callback->disconnected(shared_from_this());
-    }
+    callCallback([] (IProtocolSessionCallback& callback, const IProtocolSessionPtr& session) {
+        callback.disconnected(session);
+    });
     IProtocolSessionListPtr protocolSessionList = m_protocolSessionList.lock();
     if (protocolSessionList)
     {
@@ -243,29 +374,23 @@ void ProtocolSession::disconnected()
 
 void ProtocolSession::received(const IMessagePtr& message)
 {
-    auto callback = m_callback.lock();
-    if (callback)
-    {
-        callback->received(shared_from_this(), message);
-    }
+    callCallback([message] (IProtocolSessionCallback& callback, const IProtocolSessionPtr& session) {
+        callback.received(session, message);
+    });
 }
 
 void ProtocolSession::socketConnected()
 {
-    auto callback = m_callback.lock();
-    if (callback)
-    {
-        callback->socketConnected(shared_from_this());
-    }
+    callCallback([] (IProtocolSessionCallback& callback, const IProtocolSessionPtr& session) {
+        callback.socketConnected(session);
+    });
 }
 
 void ProtocolSession::socketDisconnected()
 {
-    auto callback = m_callback.lock();
-    if (callback)
-    {
-        callback->socketDisconnected(shared_from_this());
-    }
+    callCallback([] (IProtocolSessionCallback& callback, const IProtocolSessionPtr& session) {
+        callback.socketDisconnected(session);
+    });
 }
 
 void ProtocolSession::reconnect()
@@ -273,3 +398,43 @@ void ProtocolSession::reconnect()
     connect();
 }
 
+
+void ProtocolSession::callCallback(const std::function<void(IProtocolSessionCallback& callback, const IProtocolSessionPtr& session)>& func)
+{
+    IProtocolSessionPtr session = shared_from_this();
+    IExecutorPtr executor = m_executor.lock();
+    if (executor)
+    {
+        // the session id is the key, so that the callbacks of a session keep their order.
+        bex::hybrid_ptr<IProtocolSessionCallback> callbackHybrid = m_callback;
+        bool accepted = executor->addAction(m_sessionId, [callbackHybrid, session, func] () mutable {
+            auto callback = callbackHybrid.lock();
+            if (callback)
+            {
+                func(*callback, session);
+            }
+        });
+        // never block the poller thread: stop reading from the socket, till the queue of the session is drained.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        IStreamConnectionPtr connection = m_connection;
+        lock.unlock();
+        if (!accepted && connection && !m_readDisabled.exchange(true))
+        {
+            connection->disableRead();
+            // the actions of a session are executed in order, so this action runs after all queued callbacks
+            std::shared_ptr<ProtocolSession> thisSession = shared_from_this();
+            executor->addAction(m_sessionId, [thisSession, connection] () {
+                thisSession->m_readDisabled = false;
+                connection->enableRead();
+            });
+        }
+    }
+    else
+    {
+        auto callback = m_callback.lock();
+        if (callback)
+        {
+            func(*callback, session);
+        }
+    }
+}
@@ -5,8 +5,9 @@
 
 
 
-ProtocolBind::ProtocolBind(bex::hybrid_ptr<IProtocolSessionCallback> callback, IProtocolFactoryPtr protocolFactory, const std::weak_ptr<IProtocolSessionList>& protocolSessionList)
+ProtocolBind::ProtocolBind(bex::hybrid_ptr<IProtocolSessionCallback> callback, const std::weak_ptr<IExecutor>& executor, IProtocolFactoryPtr protocolFactory, const std::weak_ptr<IProtocolSessionList>& protocolSessionList)
     : m_callback(callback)
+    , m_executor(executor)
     , m_protocolFactory(protocolFactory)
     , m_protocolSessionList(protocolSessionList)
 {
@@ -18,7 +19,7 @@ bex::hybrid_ptr<IStreamConnectionCallback> ProtocolBind::connected(const IStream
 {
     IProtocolPtr protocol = m_protocolFactory->createProtocol();
     assert(protocol);
-    IProtocolSessionPrivatePtr protocolSession = std::make_shared<ProtocolSession>(m_callback, protocol, m_protocolSessionList);
+    IProtocolSessionPrivatePtr protocolSession = std::make_shared<ProtocolSession>(m_callback, m_executor, protocol, m_protocolSessionList);
     protocolSession->setConnection(connection);
     return std::weak_ptr<IStreamConnectionCallback>(protocolSession);
 }
@@ -52,8 +53,9 @@ ProtocolSessionContainer::~ProtocolSessionContainer()
 }
 
 // IProtocolSessionContainer
-void ProtocolSessionContainer::init(int cycleTime, int checkReconnectInterval)
+void ProtocolSessionContainer::init(int cycleTime, int checkReconnectInterval, const IExecutorPtr& executor)
 {
+    m_executor = executor;
     m_streamConnectionContainer->init(cycleTime, checkReconnectInterval);
 }
 
@@ -64,7 +66,7 @@ int ProtocolSessionContainer::bind(const std::string& endpoint, bex::hybrid_ptr<
     auto it = m_endpoint2Bind.find(endpoint);
     if (it == m_endpoint2Bind.end())
     {
-        ProtocolBindPtr bind = std::make_shared<ProtocolBind>(callback, protocolFactory, m_protocolSessionList);
+        ProtocolBindPtr bind = std::make_shared<ProtocolBind>(callback, m_executor, protocolFactory, m_protocolSessionList);
         m_endpoint2Bind[endpoint] = bind;
         lock.unlock();
 
@@ -87,7 +89,7 @@ void ProtocolSessionContainer::unbind(const std::string& endpoint)
 IProtocolSessionPtr ProtocolSessionContainer::connect(const std::string& endpoint, bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, int reconnectInterval, int totalReconnectDuration)
 {
     assert(protocol);
-    IProtocolSessionPrivatePtr protocolSession = std::make_shared<ProtocolSession>(callback, protocol, m_protocolSessionList, m_streamConnectionContainer, endpoint, reconnectInterval, totalReconnectDuration);
+    IProtocolSessionPrivatePtr protocolSession = std::make_shared<ProtocolSession>(callback, m_executor, protocol, m_protocolSessionList, m_streamConnectionContainer, endpoint, reconnectInterval, totalReconnectDuration);
     protocolSession->connect();
     return protocolSession;
 }
@@ -117,6 +119,12 @@ bool ProtocolSessionContainer::terminatePollerLoop(int timeout)
 }
 
 
+void ProtocolSessionContainer::postToPollerLoop(std::function<void()> action)
+{
+    m_streamConnectionContainer->postToPollerLoop(std::move(action));
+}
+
+
 #ifdef USE_OPENSSL
 int ProtocolSessionContainer::bindSsl(const std::string& endpoint, bex::hybrid_ptr<IProtocolSessionCallback> callback, IProtocolFactoryPtr protocolFactory, const CertificateData& certificateData)
 {
@@ -125,7 +133,7 @@ int ProtocolSessionContainer::bindSsl(const std::string& endpoint, bex::hybrid_p
     auto it = m_endpoint2Bind.find(endpoint);
     if (it == m_endpoint2Bind.end())
     {
-        ProtocolBindPtr bind = std::make_shared<ProtocolBind>(callback, protocolFactory, m_protocolSessionList);
+        ProtocolBindPtr bind = std::make_shared<ProtocolBind>(callback, m_executor, protocolFactory, m_protocolSessionList);
         m_endpoint2Bind[endpoint] = bind;
         lock.unlock();
 
@@ -137,7 +145,7 @@ int ProtocolSessionContainer::bindSsl(const std::string& endpoint, bex::hybrid_p
 IProtocolSessionPtr ProtocolSessionContainer::connectSsl(const std::string& endpoint, bex::hybrid_ptr<IProtocolSessionCallback> callback, const IProtocolPtr& protocol, const CertificateData& certificateData, int reconnectInterval, int totalReconnectDuration)
 {
     assert(protocol);
-    IProtocolSessionPrivatePtr protocolSession = std::make_shared<ProtocolSession>(callback, protocol, m_protocolSessionList, m_streamConnectionContainer, endpoint, certificateData, reconnectInterval, totalReconnectDuration);
+    IProtocolSessionPrivatePtr protocolSession = std::make_shared<ProtocolSession>(callback, m_executor, protocol, m_protocolSessionList, m_streamConnectionContainer, endpoint, certificateData, reconnectInterval, totalReconnectDuration);
     protocolSession->connect();
     return protocolSession;
 }
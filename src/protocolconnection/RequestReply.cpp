@@ -0,0 +1,293 @@
+#include "protocolconnection/RequestReply.h"
+
+#include <chrono>
+#include <string.h>
+#include <assert.h>
+
+
+
+const int RequestReply::ENVELOPE_SIZE;
+
+
+RequestReply::RequestReply(bex::hybrid_ptr<IRequestReplyCallback> callback, int tickInterval, int wheelSize)
+    : m_callback(callback)
+    , m_tickInterval(tickInterval)
+    , m_wheel(wheelSize)
+{
+    assert(tickInterval > 0);
+    assert(wheelSize > 0);
+    m_thread = std::thread([this] () {
+        timerLoop();
+    });
+}
+
+RequestReply::~RequestReply()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_terminate = true;
+    lock.unlock();
+    m_condTerminate.notify_one();
+    m_thread.join();
+}
+
+
+
+// IRequestReply
+bool RequestReply::sendRequest(const IProtocolSessionPtr& session, const char* payload, int size, int timeout, FuncReply funcReply)
+{
+    assert(session);
+    std::int64_t sessionId = session->getSessionId();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    SessionRequests& sessionRequests = m_sessionRequests[sessionId];
+    std::uint64_t correlationId = sessionRequests.nextCorrelationId++;
+    // register before the send, the reply could be received before sendMessage returns.
+    sessionRequests.pending[correlationId] = std::move(funcReply);
+    ++m_numberOfPendingRequests;
+    if (timeout >= 0)
+    {
+        addTimer(sessionId, correlationId, timeout);
+    }
+    lock.unlock();
+
+    bool ok = sendEnvelope(session, ENVELOPE_REQUEST, correlationId, payload, size);
+    if (!ok)
+    {
+        lock.lock();
+        auto it = m_sessionRequests.find(sessionId);
+        if (it != m_sessionRequests.end() && it->second.pending.erase(correlationId) > 0)
+        {
+            --m_numberOfPendingRequests;
+        }
+        lock.unlock();
+    }
+    return ok;
+}
+
+
+std::future<Reply> RequestReply::sendRequest(const IProtocolSessionPtr& session, const char* payload, int size, int timeout)
+{
+    std::shared_ptr<std::promise<Reply>> promise = std::make_shared<std::promise<Reply>>();
+    std::future<Reply> future = promise->get_future();
+    bool ok = sendRequest(session, payload, size, timeout, [promise] (const Reply& reply) {
+        promise->set_value(reply);
+    });
+    if (!ok)
+    {
+        Reply reply;
+        reply.status = REPLYSTATUS_DISCONNECTED;
+        promise->set_value(reply);
+    }
+    return future;
+}
+
+
+bool RequestReply::sendReply(const IProtocolSessionPtr& session, std::uint64_t correlationId, const char* payload, int size)
+{
+    assert(session);
+    return sendEnvelope(session, ENVELOPE_REPLY, correlationId, payload, size);
+}
+
+
+int RequestReply::getNumberOfPendingRequests() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_numberOfPendingRequests;
+}
+
+
+bool RequestReply::sendEnvelope(const IProtocolSessionPtr& session, EnvelopeType type, std::uint64_t correlationId, const char* payload, int size)
+{
+    IMessagePtr message = session->createMessage();
+    assert(message);
+    char* buffer = message->addSendPayload(ENVELOPE_SIZE + size);
+    buffer[0] = static_cast<char>(type);
+    for (int i = 0; i < 8; ++i)
+    {
+        buffer[1 + i] = static_cast<char>((correlationId >> (i * 8)) & 0xff);
+    }
+    if (size > 0)
+    {
+        memcpy(buffer + ENVELOPE_SIZE, payload, size);
+    }
+    return session->sendMessage(message);
+}
+
+
+
+// IProtocolSessionCallback
+void RequestReply::connected(const IProtocolSessionPtr& session)
+{
+    auto callback = m_callback.lock();
+    if (callback)
+    {
+        callback->connected(session);
+    }
+}
+
+void RequestReply::disconnected(const IProtocolSessionPtr& session)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    SessionRequests sessionRequests;
+    auto it = m_sessionRequests.find(session->getSessionId());
+    if (it != m_sessionRequests.end())
+    {
+        sessionRequests = std::move(it->second);
+        m_sessionRequests.erase(it);
+        m_numberOfPendingRequests -= static_cast<int>(sessionRequests.pending.size());
+    }
+    lock.unlock();
+
+    Reply reply;
+    reply.status = REPLYSTATUS_DISCONNECTED;
+    for (auto itPending = sessionRequests.pending.begin(); itPending != sessionRequests.pending.end(); ++itPending)
+    {
+        itPending->second(reply);
+    }
+
+    auto callback = m_callback.lock();
+    if (callback)
+    {
+        callback->disconnected(session);
+    }
+}
+
+void RequestReply::received(const IProtocolSessionPtr& session, const IMessagePtr& message)
+{
+    BufferRef payload = message->getReceivePayload();
+    if (payload.second < ENVELOPE_SIZE)
+    {
+        return;
+    }
+    const unsigned char* envelope = reinterpret_cast<const unsigned char*>(payload.first);
+    std::uint64_t correlationId = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        correlationId |= static_cast<std::uint64_t>(envelope[1 + i]) << (i * 8);
+    }
+    BufferRef payloadData = {payload.first + ENVELOPE_SIZE, payload.second - ENVELOPE_SIZE};
+
+    if (envelope[0] == ENVELOPE_REQUEST)
+    {
+        auto callback = m_callback.lock();
+        if (callback)
+        {
+            callback->receivedRequest(session, correlationId, message, payloadData);
+        }
+    }
+    else if (envelope[0] == ENVELOPE_REPLY)
+    {
+        FuncReply funcReply;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto it = m_sessionRequests.find(session->getSessionId());
+        if (it != m_sessionRequests.end())
+        {
+            auto itPending = it->second.pending.find(correlationId);
+            if (itPending != it->second.pending.end())
+            {
+                funcReply = std::move(itPending->second);
+                it->second.pending.erase(itPending);
+                --m_numberOfPendingRequests;
+            }
+        }
+        lock.unlock();
+
+        // a reply after the timeout is dropped
+        if (funcReply)
+        {
+            Reply reply;
+            reply.status = REPLYSTATUS_OK;
+            reply.message = message;
+            reply.payload = payloadData;
+            funcReply(reply);
+        }
+    }
+}
+
+void RequestReply::socketConnected(const IProtocolSessionPtr& session)
+{
+}
+
+void RequestReply::socketDisconnected(const IProtocolSessionPtr& session)
+{
+}
+
+
+
+// timer wheel
+
+void RequestReply::addTimer(std::int64_t sessionId, std::uint64_t correlationId, int timeout)
+{
+    // the entry expires, when the wheel position arrives at its slot the (rounds + 1)th time
+    int ticks = (timeout + m_tickInterval - 1) / m_tickInterval;
+    if (ticks < 1)
+    {
+        ticks = 1;
+    }
+    size_t slot = (m_wheelPosition + ticks) % m_wheel.size();
+    int rounds = (ticks - 1) / static_cast<int>(m_wheel.size());
+    m_wheel[slot].push_back({sessionId, correlationId, rounds});
+}
+
+
+void RequestReply::tick()
+{
+    std::vector<FuncReply> expired;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wheelPosition = (m_wheelPosition + 1) % m_wheel.size();
+    std::vector<TimerEntry>& entries = m_wheel[m_wheelPosition];
+    size_t remaining = 0;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        TimerEntry& entry = entries[i];
+        if (entry.rounds > 0)
+        {
+            --entry.rounds;
+            entries[remaining] = entry;
+            ++remaining;
+        }
+        else
+        {
+            // the entries of completed requests are not removed from the wheel, they are ignored here.
+            auto it = m_sessionRequests.find(entry.sessionId);
+            if (it != m_sessionRequests.end())
+            {
+                auto itPending = it->second.pending.find(entry.correlationId);
+                if (itPending != it->second.pending.end())
+                {
+                    expired.push_back(std::move(itPending->second));
+                    it->second.pending.erase(itPending);
+                    --m_numberOfPendingRequests;
+                }
+            }
+        }
+    }
+    entries.resize(remaining);
+    lock.unlock();
+
+    Reply reply;
+    reply.status = REPLYSTATUS_TIMEOUT;
+    for (size_t i = 0; i < expired.size(); ++i)
+    {
+        expired[i](reply);
+    }
+}
+
+
+void RequestReply::timerLoop()
+{
+    std::chrono::steady_clock::time_point nextTick = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_terminate)
+    {
+        nextTick += std::chrono::milliseconds(m_tickInterval);
+        m_condTerminate.wait_until(lock, nextTick, [this] () {
+            return m_terminate;
+        });
+        if (!m_terminate)
+        {
+            lock.unlock();
+            tick();
+            lock.lock();
+        }
+    }
+}
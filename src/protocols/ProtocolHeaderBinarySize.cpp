@@ -21,7 +21,7 @@ ProtocolHeaderBinarySize::ProtocolHeaderBinarySize()
             int sizePayload = 0;
             for (int i = 0; i < 4; ++i)
             {
-                sizePayload += (int)header[i] << (8 * i);
+                sizePayload += static_cast<int>(static_cast<unsigned char>(header[i])) << (8 * i);
             }
             return sizePayload;
       })
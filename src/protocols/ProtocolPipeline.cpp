@@ -0,0 +1,217 @@
+
+#include "protocols/ProtocolPipeline.h"
+#include "protocolconnection/ProtocolMessage.h"
+#include "streamconnection/Socket.h"
+
+#include <cstdint>
+
+
+
+//---------------------------------------
+// ProtocolPipeline
+//---------------------------------------
+
+
+ProtocolPipeline::ProtocolPipeline(const IProtocolPtr& protocolFraming, const std::vector<IProtocolStagePtr>& stages)
+    : m_protocolFraming(protocolFraming)
+    , m_stages(stages)
+    , m_framingCallback(std::make_shared<FramingCallback>(*this))
+{
+    assert(m_protocolFraming);
+    // the protocol ID depends on the framing and on the stages, so that messages
+    // are only reused by sessions with exactly the same pipeline.
+    std::uint32_t protocolId = static_cast<std::uint32_t>(m_protocolFraming->getProtocolId());
+    for (size_t i = 0; i < m_stages.size(); ++i)
+    {
+        assert(m_stages[i]);
+        protocolId = (protocolId * 0x01000193) ^ static_cast<std::uint32_t>(m_stages[i]->getStageId());
+    }
+    m_protocolId = static_cast<int>(protocolId);
+    m_protocolFraming->setCallback(m_framingCallback);
+}
+
+
+// IProtocol
+void ProtocolPipeline::setCallback(const std::weak_ptr<IProtocolCallback>& callback)
+{
+    m_callback = callback;
+}
+
+int ProtocolPipeline::getProtocolId() const
+{
+    return m_protocolId;
+}
+
+bool ProtocolPipeline::areMessagesResendable() const
+{
+    return m_protocolFraming->areMessagesResendable();
+}
+
+IMessagePtr ProtocolPipeline::createMessage() const
+{
+    return std::make_shared<ProtocolMessage>(m_protocolId);
+}
+
+void ProtocolPipeline::receive(const SocketPtr& socket, int bytesToRead)
+{
+    m_protocolFraming->receive(socket, bytesToRead);
+}
+
+void ProtocolPipeline::prepareMessageToSend(IMessagePtr message)
+{
+    if (!message->wasSent())
+    {
+        std::string payload;
+        payload.resize(message->getTotalSendPayloadSize());
+        const std::list<BufferRef>& payloads = message->getAllSendPayloads();
+        int offset = 0;
+        for (auto it = payloads.begin(); it != payloads.end(); ++it)
+        {
+            const BufferRef& p = *it;
+            memcpy(const_cast<char*>(payload.data()) + offset, p.first, p.second);
+            offset += p.second;
+        }
+
+        for (size_t i = 0; i < m_stages.size(); ++i)
+        {
+            m_stages[i]->encode(payload);
+        }
+
+        IMessagePtr messageFraming = m_protocolFraming->createMessage();
+        messageFraming->addSendPayload(payload);
+        m_protocolFraming->prepareMessageToSend(messageFraming);
+        message->setSendBufferMessage(messageFraming);
+        message->prepareMessageToSend();
+    }
+}
+
+void ProtocolPipeline::socketConnected()
+{
+    m_protocolFraming->socketConnected();
+}
+
+void ProtocolPipeline::socketDisconnected()
+{
+    m_protocolFraming->socketDisconnected();
+}
+
+
+void ProtocolPipeline::receivedFraming(const IMessagePtr& message)
+{
+    auto callback = m_callback.lock();
+    if (!callback)
+    {
+        return;
+    }
+
+    if (m_stages.empty())
+    {
+        callback->received(message);
+        return;
+    }
+
+    BufferRef payloadFraming = message->getReceivePayload();
+    std::string payload(payloadFraming.first, payloadFraming.second);
+    bool ok = true;
+    for (auto it = m_stages.rbegin(); it != m_stages.rend() && ok; ++it)
+    {
+        ok = (*it)->decode(payload);
+    }
+
+    if (ok)
+    {
+        IMessagePtr messageDecoded = std::make_shared<ProtocolMessage>(0);
+        char* payloadDecoded = messageDecoded->resizeReceivePayload(payload.size());
+        memcpy(payloadDecoded, payload.data(), payload.size());
+        callback->received(messageDecoded);
+    }
+}
+
+
+
+//---------------------------------------
+// ProtocolPipeline::FramingCallback
+//---------------------------------------
+
+ProtocolPipeline::FramingCallback::FramingCallback(ProtocolPipeline& pipeline)
+    : m_pipeline(pipeline)
+{
+}
+
+void ProtocolPipeline::FramingCallback::connected()
+{
+    auto callback = m_pipeline.m_callback.lock();
+    if (callback)
+    {
+        callback->connected();
+    }
+}
+
+void ProtocolPipeline::FramingCallback::disconnected()
+{
+    auto callback = m_pipeline.m_callback.lock();
+    if (callback)
+    {
+        callback->disconnected();
+    }
+}
+
+void ProtocolPipeline::FramingCallback::received(const IMessagePtr& message)
+{
+    m_pipeline.receivedFraming(message);
+}
+
+void ProtocolPipeline::FramingCallback::socketConnected()
+{
+    auto callback = m_pipeline.m_callback.lock();
+    if (callback)
+    {
+        callback->socketConnected();
+    }
+}
+
+void ProtocolPipeline::FramingCallback::socketDisconnected()
+{
+    auto callback = m_pipeline.m_callback.lock();
+    if (callback)
+    {
+        callback->socketDisconnected();
+    }
+}
+
+void ProtocolPipeline::FramingCallback::reconnect()
+{
+    auto callback = m_pipeline.m_callback.lock();
+    if (callback)
+    {
+        callback->reconnect();
+    }
+}
+
+
+
+//---------------------------------------
+// ProtocolPipelineFactory
+//---------------------------------------
+
+
+ProtocolPipelineFactory::ProtocolPipelineFactory(const IProtocolFactoryPtr& protocolFactoryFraming, const std::vector<IProtocolStageFactoryPtr>& stageFactories)
+    : m_protocolFactoryFraming(protocolFactoryFraming)
+    , m_stageFactories(stageFactories)
+{
+    assert(m_protocolFactoryFraming);
+}
+
+
+// IProtocolFactory
+IProtocolPtr ProtocolPipelineFactory::createProtocol()
+{
+    std::vector<IProtocolStagePtr> stages;
+    stages.reserve(m_stageFactories.size());
+    for (size_t i = 0; i < m_stageFactories.size(); ++i)
+    {
+        assert(m_stageFactories[i]);
+        stages.push_back(m_stageFactories[i]->createStage());
+    }
+    return std::make_shared<ProtocolPipeline>(m_protocolFactoryFraming->createProtocol(), stages);
+}
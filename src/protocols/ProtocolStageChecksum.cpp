@@ -0,0 +1,96 @@
+
+#include "protocols/ProtocolStageChecksum.h"
+
+#include <assert.h>
+
+static const int CHECKSUMSIZE = 4;
+
+
+static std::uint32_t g_crcTable[256];
+
+static bool initCrcTable()
+{
+    for (std::uint32_t i = 0; i < 256; ++i)
+    {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; ++k)
+        {
+            c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+        }
+        g_crcTable[i] = c;
+    }
+    return true;
+}
+
+static bool g_crcTableInitialized = initCrcTable();
+
+
+
+//---------------------------------------
+// ProtocolStageChecksum
+//---------------------------------------
+
+
+ProtocolStageChecksum::ProtocolStageChecksum()
+{
+}
+
+
+std::uint32_t ProtocolStageChecksum::crc32(const char* buffer, int size)
+{
+    std::uint32_t crc = 0xffffffff;
+    for (int i = 0; i < size; ++i)
+    {
+        crc = g_crcTable[(crc ^ static_cast<std::uint8_t>(buffer[i])) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffff;
+}
+
+
+// IProtocolStage
+int ProtocolStageChecksum::getStageId() const
+{
+    return m_stageId;
+}
+
+void ProtocolStageChecksum::encode(std::string& payload)
+{
+    std::uint32_t crc = crc32(payload.data(), payload.size());
+    for (int i = 0; i < CHECKSUMSIZE; ++i)
+    {
+        payload += static_cast<char>((crc >> (i * 8)) & 0xff);
+    }
+}
+
+bool ProtocolStageChecksum::decode(std::string& payload)
+{
+    if (static_cast<int>(payload.size()) < CHECKSUMSIZE)
+    {
+        return false;
+    }
+    int sizePayload = payload.size() - CHECKSUMSIZE;
+    std::uint32_t crc = 0;
+    for (int i = 0; i < CHECKSUMSIZE; ++i)
+    {
+        crc |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(payload[sizePayload + i])) << (i * 8);
+    }
+    if (crc != crc32(payload.data(), sizePayload))
+    {
+        return false;
+    }
+    payload.resize(sizePayload);
+    return true;
+}
+
+
+
+//---------------------------------------
+// ProtocolStageChecksumFactory
+//---------------------------------------
+
+
+// IProtocolStageFactory
+IProtocolStagePtr ProtocolStageChecksumFactory::createStage()
+{
+    return std::make_shared<ProtocolStageChecksum>();
+}
@@ -0,0 +1,434 @@
+
+#include "protocols/ProtocolStageCompression.h"
+#include "protocols/ProtocolStageChecksum.h"
+
+#include <zlib.h>
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+#include <fstream>
+#include <sstream>
+#include <assert.h>
+#include <string.h>
+
+
+static const std::uint8_t FLAG_DICTIONARY = 0x10;
+static const std::uint8_t ALGORITHM_MASK = 0x0f;
+static const int SIZE_FLAGS = 1;
+static const int SIZE_UNCOMPRESSED = 4;
+static const int SIZE_DICTIONARYID = 4;
+
+
+static void writeUint32(char* buffer, std::uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        buffer[i] = static_cast<char>((value >> (i * 8)) & 0xff);
+    }
+}
+
+static std::uint32_t readUint32(const char* buffer)
+{
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        value |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(buffer[i])) << (i * 8);
+    }
+    return value;
+}
+
+
+
+//---------------------------------------
+// ProtocolStageCompression
+//---------------------------------------
+
+
+const int ProtocolStageCompression::DEFAULT_MAX_DECODED_SIZE;
+const int ProtocolStageCompression::DEFAULT_MAX_RATIO;
+
+
+ProtocolStageCompression::ProtocolStageCompression(CompressionAlgorithm algorithm, int threshold, const std::shared_ptr<const std::string>& dictionary, int level,
+                                                   int maxDecodedSize, int maxRatio)
+    : m_algorithm(isAlgorithmAvailable(algorithm) ? algorithm : COMPRESSION_ZLIB)
+    , m_threshold(threshold)
+    , m_dictionary((dictionary && !dictionary->empty()) ? dictionary : nullptr)
+    , m_level(level)
+    , m_maxDecodedSize(maxDecodedSize)
+    , m_maxRatio(maxRatio)
+{
+    if (m_dictionary)
+    {
+        m_dictionaryId = ProtocolStageChecksum::crc32(m_dictionary->data(), m_dictionary->size());
+    }
+}
+
+ProtocolStageCompression::~ProtocolStageCompression()
+{
+    if (m_deflate)
+    {
+        deflateEnd(m_deflate.get());
+    }
+    if (m_inflate)
+    {
+        inflateEnd(m_inflate.get());
+    }
+#ifdef USE_ZSTD
+    ZSTD_freeCCtx(m_zstdCCtx);
+    ZSTD_freeDCtx(m_zstdDCtx);
+    ZSTD_freeCDict(m_zstdCDict);
+    ZSTD_freeDDict(m_zstdDDict);
+#endif
+#ifdef USE_LZ4
+    if (m_lz4Stream)
+    {
+        LZ4_freeStream(m_lz4Stream);
+    }
+    if (m_lz4DictStream)
+    {
+        LZ4_freeStream(m_lz4DictStream);
+    }
+#endif
+}
+
+
+bool ProtocolStageCompression::isAlgorithmAvailable(CompressionAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case COMPRESSION_NONE:
+    case COMPRESSION_ZLIB:
+        return true;
+#ifdef USE_ZSTD
+    case COMPRESSION_ZSTD:
+        return true;
+#endif
+#ifdef USE_LZ4
+    case COMPRESSION_LZ4:
+        return true;
+#endif
+    default:
+        break;
+    }
+    return false;
+}
+
+
+std::shared_ptr<const std::string> ProtocolStageCompression::loadDictionary(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        return nullptr;
+    }
+    std::ostringstream data;
+    data << file.rdbuf();
+    return std::make_shared<const std::string>(data.str());
+}
+
+
+int ProtocolStageCompression::compressBound(int size) const
+{
+    switch (m_algorithm)
+    {
+#ifdef USE_ZSTD
+    case COMPRESSION_ZSTD:
+        return ZSTD_compressBound(size);
+#endif
+#ifdef USE_LZ4
+    case COMPRESSION_LZ4:
+        return LZ4_compressBound(size);
+#endif
+    default:
+        break;
+    }
+    return ::compressBound(size);
+}
+
+
+int ProtocolStageCompression::compress(const std::string& payload, char* dest, int sizeDest)
+{
+    switch (m_algorithm)
+    {
+#ifdef USE_ZSTD
+    case COMPRESSION_ZSTD:
+        {
+            if (!m_zstdCCtx)
+            {
+                m_zstdCCtx = ZSTD_createCCtx();
+            }
+            int level = (m_level < 0) ? ZSTD_CLEVEL_DEFAULT : m_level;
+            size_t res = 0;
+            if (m_dictionary)
+            {
+                if (!m_zstdCDict)
+                {
+                    m_zstdCDict = ZSTD_createCDict(m_dictionary->data(), m_dictionary->size(), level);
+                }
+                res = ZSTD_compress_usingCDict(m_zstdCCtx, dest, sizeDest, payload.data(), payload.size(), m_zstdCDict);
+            }
+            else
+            {
+                res = ZSTD_compressCCtx(m_zstdCCtx, dest, sizeDest, payload.data(), payload.size(), level);
+            }
+            return ZSTD_isError(res) ? -1 : static_cast<int>(res);
+        }
+#endif
+#ifdef USE_LZ4
+    case COMPRESSION_LZ4:
+        {
+            int res = 0;
+            if (m_dictionary)
+            {
+                if (!m_lz4DictStream)
+                {
+                    m_lz4DictStream = LZ4_createStream();
+                    m_lz4Stream = LZ4_createStream();
+                    LZ4_loadDict(m_lz4DictStream, m_dictionary->data(), m_dictionary->size());
+                }
+                // start every message from the loaded dictionary, so every message is compressed independently.
+                // Copying the loaded stream is much cheaper than hashing the dictionary again.
+                memcpy(m_lz4Stream, m_lz4DictStream, sizeof(LZ4_stream_t));
+                res = LZ4_compress_fast_continue(m_lz4Stream, payload.data(), dest, payload.size(), sizeDest, 1);
+            }
+            else
+            {
+                res = LZ4_compress_default(payload.data(), dest, payload.size(), sizeDest);
+            }
+            return (res > 0) ? res : -1;
+        }
+#endif
+    default:
+        break;
+    }
+
+    assert(m_algorithm == COMPRESSION_ZLIB);
+    if (!m_deflate)
+    {
+        m_deflate = std::make_unique<z_stream>();
+        memset(m_deflate.get(), 0, sizeof(z_stream));
+        int level = (m_level < 0) ? Z_DEFAULT_COMPRESSION : m_level;
+        if (deflateInit(m_deflate.get(), level) != Z_OK)
+        {
+            m_deflate = nullptr;
+            return -1;
+        }
+    }
+    else
+    {
+        deflateReset(m_deflate.get());
+    }
+    z_stream* stream = m_deflate.get();
+    if (m_dictionary)
+    {
+        deflateSetDictionary(stream, reinterpret_cast<const Bytef*>(m_dictionary->data()), m_dictionary->size());
+    }
+    stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(payload.data()));
+    stream->avail_in = payload.size();
+    stream->next_out = reinterpret_cast<Bytef*>(dest);
+    stream->avail_out = sizeDest;
+    int res = deflate(stream, Z_FINISH);
+    if (res != Z_STREAM_END)
+    {
+        return -1;
+    }
+    return sizeDest - stream->avail_out;
+}
+
+
+bool ProtocolStageCompression::decompress(CompressionAlgorithm algorithm, bool withDictionary, const char* src, int sizeSrc, char* dest, int sizeDest)
+{
+    switch (algorithm)
+    {
+    case COMPRESSION_ZLIB:
+        {
+            if (!m_inflate)
+            {
+                m_inflate = std::make_unique<z_stream>();
+                memset(m_inflate.get(), 0, sizeof(z_stream));
+                if (inflateInit(m_inflate.get()) != Z_OK)
+                {
+                    m_inflate = nullptr;
+                    return false;
+                }
+            }
+            else
+            {
+                inflateReset(m_inflate.get());
+            }
+            z_stream* stream = m_inflate.get();
+            stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src));
+            stream->avail_in = sizeSrc;
+            stream->next_out = reinterpret_cast<Bytef*>(dest);
+            stream->avail_out = sizeDest;
+            int res = inflate(stream, Z_FINISH);
+            if (res == Z_NEED_DICT && withDictionary)
+            {
+                assert(m_dictionary);
+                res = inflateSetDictionary(stream, reinterpret_cast<const Bytef*>(m_dictionary->data()), m_dictionary->size());
+                if (res == Z_OK)
+                {
+                    res = inflate(stream, Z_FINISH);
+                }
+            }
+            return (res == Z_STREAM_END && stream->avail_out == 0);
+        }
+#ifdef USE_ZSTD
+    case COMPRESSION_ZSTD:
+        {
+            if (!m_zstdDCtx)
+            {
+                m_zstdDCtx = ZSTD_createDCtx();
+            }
+            size_t res = 0;
+            if (withDictionary)
+            {
+                assert(m_dictionary);
+                if (!m_zstdDDict)
+                {
+                    m_zstdDDict = ZSTD_createDDict(m_dictionary->data(), m_dictionary->size());
+                }
+                res = ZSTD_decompress_usingDDict(m_zstdDCtx, dest, sizeDest, src, sizeSrc, m_zstdDDict);
+            }
+            else
+            {
+                res = ZSTD_decompressDCtx(m_zstdDCtx, dest, sizeDest, src, sizeSrc);
+            }
+            return (!ZSTD_isError(res) && res == static_cast<size_t>(sizeDest));
+        }
+#endif
+#ifdef USE_LZ4
+    case COMPRESSION_LZ4:
+        {
+            int res = 0;
+            if (withDictionary)
+            {
+                assert(m_dictionary);
+                res = LZ4_decompress_safe_usingDict(src, dest, sizeSrc, sizeDest, m_dictionary->data(), m_dictionary->size());
+            }
+            else
+            {
+                res = LZ4_decompress_safe(src, dest, sizeSrc, sizeDest);
+            }
+            return (res == sizeDest);
+        }
+#endif
+    default:
+        break;
+    }
+    return false;
+}
+
+
+
+// IProtocolStage
+int ProtocolStageCompression::getStageId() const
+{
+    return m_stageId ^ (m_algorithm << 8) ^ static_cast<int>(m_dictionaryId);
+}
+
+void ProtocolStageCompression::encode(std::string& payload)
+{
+    int sizePayload = payload.size();
+    if (m_algorithm != COMPRESSION_NONE && sizePayload >= m_threshold)
+    {
+        int sizeHeader = SIZE_FLAGS + SIZE_UNCOMPRESSED + (m_dictionary ? SIZE_DICTIONARYID : 0);
+        std::string compressed;
+        compressed.resize(sizeHeader + compressBound(sizePayload));
+        int sizeCompressed = compress(payload, &compressed[sizeHeader], compressed.size() - sizeHeader);
+        // only send it compressed, if it is smaller than the uncompressed frame
+        if (sizeCompressed >= 0 && sizeHeader + sizeCompressed < SIZE_FLAGS + sizePayload)
+        {
+            char* header = &compressed[0];
+            header[0] = static_cast<char>(m_algorithm | (m_dictionary ? FLAG_DICTIONARY : 0));
+            writeUint32(header + SIZE_FLAGS, sizePayload);
+            if (m_dictionary)
+            {
+                writeUint32(header + SIZE_FLAGS + SIZE_UNCOMPRESSED, m_dictionaryId);
+            }
+            compressed.resize(sizeHeader + sizeCompressed);
+            payload.swap(compressed);
+            return;
+        }
+    }
+    payload.insert(payload.begin(), static_cast<char>(COMPRESSION_NONE));
+}
+
+bool ProtocolStageCompression::decode(std::string& payload)
+{
+    if (payload.empty())
+    {
+        return false;
+    }
+    std::uint8_t flags = static_cast<std::uint8_t>(payload[0]);
+    CompressionAlgorithm algorithm = static_cast<CompressionAlgorithm>(flags & ALGORITHM_MASK);
+    if (algorithm == COMPRESSION_NONE)
+    {
+        payload.erase(0, SIZE_FLAGS);
+        return true;
+    }
+
+    bool withDictionary = ((flags & FLAG_DICTIONARY) != 0);
+    int sizeHeader = SIZE_FLAGS + SIZE_UNCOMPRESSED + (withDictionary ? SIZE_DICTIONARYID : 0);
+    if (static_cast<int>(payload.size()) < sizeHeader)
+    {
+        return false;
+    }
+    // the size comes from the peer, check it before allocating
+    std::uint32_t sizeUncompressed = readUint32(&payload[SIZE_FLAGS]);
+    std::uint64_t sizeCompressed = payload.size() - sizeHeader;
+    if (sizeUncompressed > static_cast<std::uint32_t>(m_maxDecodedSize))
+    {
+        return false;
+    }
+    if (m_maxRatio > 0 && sizeUncompressed > sizeCompressed * m_maxRatio)
+    {
+        return false;
+    }
+    if (withDictionary)
+    {
+        // both sides must have loaded the same dictionary
+        if (!m_dictionary || readUint32(&payload[SIZE_FLAGS + SIZE_UNCOMPRESSED]) != m_dictionaryId)
+        {
+            return false;
+        }
+    }
+
+    std::string uncompressed;
+    uncompressed.resize(sizeUncompressed);
+    bool ok = decompress(algorithm, withDictionary, payload.data() + sizeHeader, payload.size() - sizeHeader, &uncompressed[0], sizeUncompressed);
+    if (ok)
+    {
+        payload.swap(uncompressed);
+    }
+    return ok;
+}
+
+
+
+//---------------------------------------
+// ProtocolStageCompressionFactory
+//---------------------------------------
+
+
+ProtocolStageCompressionFactory::ProtocolStageCompressionFactory(CompressionAlgorithm algorithm, int threshold, const std::shared_ptr<const std::string>& dictionary, int level,
+                                                                 int maxDecodedSize, int maxRatio)
+    : m_algorithm(algorithm)
+    , m_threshold(threshold)
+    , m_dictionary(dictionary)
+    , m_level(level)
+    , m_maxDecodedSize(maxDecodedSize)
+    , m_maxRatio(maxRatio)
+{
+}
+
+
+// IProtocolStageFactory
+IProtocolStagePtr ProtocolStageCompressionFactory::createStage()
+{
+    return std::make_shared<ProtocolStageCompression>(m_algorithm, m_threshold, m_dictionary, m_level, m_maxDecodedSize, m_maxRatio);
+}
@@ -0,0 +1,395 @@
+
+#include "protocols/ProtocolVarintSize.h"
+#include "protocolconnection/ProtocolMessage.h"
+#include "streamconnection/Socket.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+
+// the size of a message is an int, so the varint has at most 5 bytes
+static const int MAX_VARINT_SIZE = 5;
+static const int MAX_HEADER_SIZE = 1 + MAX_VARINT_SIZE;
+
+
+static int serializeVarint(char* buffer, std::uint32_t value)
+{
+    int size = 0;
+    while (value >= 0x80)
+    {
+        buffer[size++] = static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    buffer[size++] = static_cast<char>(value);
+    return size;
+}
+
+// returns the size of the varint, 0 if it is not complete, -1 if it is invalid
+static int parseVarint(const char* buffer, int size, std::uint32_t& value)
+{
+    value = 0;
+    for (int i = 0; i < MAX_VARINT_SIZE; ++i)
+    {
+        if (i >= size)
+        {
+            return 0;
+        }
+        std::uint8_t c = static_cast<std::uint8_t>(buffer[i]);
+        value |= static_cast<std::uint32_t>(c & 0x7f) << (7 * i);
+        if ((c & 0x80) == 0)
+        {
+            return (value <= 0x7fffffff) ? (i + 1) : -1;
+        }
+    }
+    return -1;
+}
+
+// returns the size of the header, 0 if it is not complete, -1 if it is invalid or the frame is too large
+static int parseHeader(const char* buffer, int size, int maxFrameSize, int& sizeFrame, bool& batch)
+{
+    std::uint32_t value = 0;
+    int sizeVarint = parseVarint(buffer, size, value);
+    if (sizeVarint <= 0)
+    {
+        return sizeVarint;
+    }
+    if (value != 0)
+    {
+        // a message frame carries the payload size + 1, so that 0 is only the batch marker
+        sizeFrame = value - 1;
+        batch = false;
+        return (sizeFrame <= maxFrameSize) ? sizeVarint : -1;
+    }
+    // batch frame
+    int sizeVarintBatch = parseVarint(buffer + sizeVarint, size - sizeVarint, value);
+    if (sizeVarintBatch <= 0)
+    {
+        return sizeVarintBatch;
+    }
+    if (value == 0 || value > static_cast<std::uint32_t>(maxFrameSize))
+    {
+        return -1;
+    }
+    sizeFrame = value;
+    batch = true;
+    return sizeVarint + sizeVarintBatch;
+}
+
+static BufferRef getPayload(const IMessagePtr& message, int& size)
+{
+    size = message->getTotalSendPayloadSize();
+    if (size == 0)
+    {
+        BufferRef receivePayload = message->getReceivePayload();
+        if (receivePayload.second > 0)
+        {
+            size = receivePayload.second;
+            return receivePayload;
+        }
+    }
+    return {nullptr, size};
+}
+
+
+
+//---------------------------------------
+// ProtocolVarintSize
+//---------------------------------------
+
+
+const int ProtocolVarintSize::PROTOCOL_ID;
+
+
+ProtocolVarintSize::ProtocolVarintSize(int maxFrameSize)
+    : m_maxFrameSize(maxFrameSize)
+{
+}
+
+
+IMessagePtr ProtocolVarintSize::createBatchMessage(const std::vector<IMessagePtr>& messages)
+{
+    if (messages.empty())
+    {
+        return nullptr;
+    }
+    // inside of a batch the sizes are not shifted, an empty message has the size 0
+    int sizeBatch = 0;
+    char header[MAX_VARINT_SIZE];
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        int size = 0;
+        getPayload(messages[i], size);
+        sizeBatch += serializeVarint(header, size) + size;
+    }
+
+    IMessagePtr batch = std::make_shared<ProtocolMessage>(PROTOCOL_ID, 1);
+    char* payloadBatch = batch->addSendPayload(sizeBatch);
+    int offset = 0;
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        const IMessagePtr& message = messages[i];
+        int size = 0;
+        BufferRef payload = getPayload(message, size);
+        offset += serializeVarint(payloadBatch + offset, size);
+        if (size > 0)
+        {
+            if (payload.first)
+            {
+                memcpy(payloadBatch + offset, payload.first, size);
+                offset += size;
+            }
+            else
+            {
+                const std::list<BufferRef>& payloads = message->getAllSendPayloads();
+                for (auto it = payloads.begin(); it != payloads.end(); ++it)
+                {
+                    memcpy(payloadBatch + offset, it->first, it->second);
+                    offset += it->second;
+                }
+            }
+        }
+    }
+    assert(offset == sizeBatch);
+    addHeader(batch, true);
+    batch->prepareMessageToSend();
+    return batch;
+}
+
+
+void ProtocolVarintSize::addHeader(const IMessagePtr& message, bool batch)
+{
+    char header[MAX_HEADER_SIZE];
+    int sizeHeader = 0;
+    if (batch)
+    {
+        header[sizeHeader++] = 0;
+        sizeHeader += serializeVarint(header + sizeHeader, message->getTotalSendPayloadSize());
+    }
+    else
+    {
+        sizeHeader += serializeVarint(header + sizeHeader, static_cast<std::uint32_t>(message->getTotalSendPayloadSize()) + 1);
+    }
+
+    // the last byte of the header goes into the byte, which is reserved in front of the payload,
+    // so that small messages are sent with one buffer.
+    const std::list<BufferRef>& buffers = message->getAllSendBuffers();
+    assert(!buffers.empty());
+    assert(buffers.begin()->second >= 1);
+    buffers.begin()->first[0] = header[sizeHeader - 1];
+    if (sizeHeader > 1)
+    {
+        message->addSendHeader(header, sizeHeader - 1);
+    }
+}
+
+
+// IProtocol
+void ProtocolVarintSize::setCallback(const std::weak_ptr<IProtocolCallback>& callback)
+{
+    m_callback = callback;
+}
+
+int ProtocolVarintSize::getProtocolId() const
+{
+    return PROTOCOL_ID;
+}
+
+bool ProtocolVarintSize::areMessagesResendable() const
+{
+    return true;
+}
+
+IMessagePtr ProtocolVarintSize::createMessage() const
+{
+    return std::make_shared<ProtocolMessage>(PROTOCOL_ID, 1);
+}
+
+
+void ProtocolVarintSize::frameReceived(const char* payload, int size, bool batch, std::vector<IMessagePtr>& messages)
+{
+    if (!batch)
+    {
+        IMessagePtr message = std::make_shared<ProtocolMessage>(0);
+        char* payloadMessage = message->resizeReceivePayload(size);
+        memcpy(payloadMessage, payload, size);
+        messages.push_back(message);
+        return;
+    }
+
+    int offset = 0;
+    while (offset < size)
+    {
+        std::uint32_t sizeMessage = 0;
+        int sizeVarint = parseVarint(payload + offset, size - offset, sizeMessage);
+        if (sizeVarint <= 0 || static_cast<int>(sizeMessage) > size - offset - sizeVarint)
+        {
+            // corrupt batch
+            break;
+        }
+        offset += sizeVarint;
+        IMessagePtr message = std::make_shared<ProtocolMessage>(0);
+        char* payloadMessage = message->resizeReceivePayload(sizeMessage);
+        memcpy(payloadMessage, payload + offset, sizeMessage);
+        offset += sizeMessage;
+        messages.push_back(message);
+    }
+}
+
+
+void ProtocolVarintSize::parseReceiveBuffer(std::vector<IMessagePtr>& messages)
+{
+    if (m_corrupt)
+    {
+        m_receiveBuffer.clear();
+        return;
+    }
+    const char* buffer = m_receiveBuffer.data();
+    int size = m_receiveBuffer.size();
+    int offset = 0;
+    while (offset < size)
+    {
+        int sizeFrame = 0;
+        bool batch = false;
+        int sizeHeader = parseHeader(buffer + offset, size - offset, m_maxFrameSize, sizeFrame, batch);
+        if (sizeHeader == 0)
+        {
+            // header is not complete, keep the rest for the next receive
+            break;
+        }
+        if (sizeHeader < 0)
+        {
+            // corrupt stream, there is no way to find the next frame, all further data is dropped
+            std::cout << "ProtocolVarintSize: invalid frame header or frame larger than " << m_maxFrameSize << " bytes" << std::endl;
+            m_corrupt = true;
+            offset = size;
+            break;
+        }
+        offset += sizeHeader;
+        int sizeAvailable = size - offset;
+        if (sizeAvailable >= sizeFrame)
+        {
+            frameReceived(buffer + offset, sizeFrame, batch, messages);
+            offset += sizeFrame;
+        }
+        else
+        {
+            // the rest of the frame will be received directly into the message
+            m_message = std::make_shared<ProtocolMessage>(0);
+            m_payload = m_message->resizeReceivePayload(sizeFrame);
+            memcpy(m_payload, buffer + offset, sizeAvailable);
+            m_sizePayload = sizeFrame;
+            m_sizeCurrent = sizeAvailable;
+            m_batch = batch;
+            offset = size;
+        }
+    }
+    m_receiveBuffer.erase(0, offset);
+}
+
+
+void ProtocolVarintSize::receive(const SocketPtr& socket, int bytesToRead)
+{
+    std::vector<IMessagePtr> messages;
+
+    while (bytesToRead > 0)
+    {
+        if (m_message)
+        {
+            int sizeRead = std::min(bytesToRead, m_sizePayload - m_sizeCurrent);
+            int res = socket->receive(m_payload + m_sizeCurrent, sizeRead);
+            if (res <= 0)
+            {
+                break;
+            }
+            assert(res <= sizeRead);
+            bytesToRead -= res;
+            m_sizeCurrent += res;
+            if (m_sizeCurrent == m_sizePayload)
+            {
+                if (m_batch)
+                {
+                    frameReceived(m_payload, m_sizePayload, true, messages);
+                }
+                else
+                {
+                    messages.push_back(m_message);
+                }
+                m_message = nullptr;
+                m_payload = nullptr;
+                m_sizePayload = 0;
+                m_sizeCurrent = 0;
+                m_batch = false;
+            }
+        }
+        else
+        {
+            int sizeOld = m_receiveBuffer.size();
+            m_receiveBuffer.resize(sizeOld + bytesToRead);
+            int res = socket->receive(const_cast<char*>(m_receiveBuffer.data() + sizeOld), bytesToRead);
+            if (res <= 0)
+            {
+                m_receiveBuffer.resize(sizeOld);
+                break;
+            }
+            assert(res <= bytesToRead);
+            bytesToRead -= res;
+            m_receiveBuffer.resize(sizeOld + res);
+            parseReceiveBuffer(messages);
+        }
+    }
+
+    auto callback = m_callback.lock();
+    if (callback)
+    {
+        for (size_t i = 0; i < messages.size(); ++i)
+        {
+            callback->received(messages[i]);
+        }
+    }
+}
+
+void ProtocolVarintSize::prepareMessageToSend(IMessagePtr message)
+{
+    if (!message->wasSent())
+    {
+        addHeader(message, false);
+        message->prepareMessageToSend();
+    }
+}
+
+void ProtocolVarintSize::socketConnected()
+{
+    auto callback = m_callback.lock();
+    if (callback)
+    {
+        callback->connected();
+    }
+}
+
+void ProtocolVarintSize::socketDisconnected()
+{
+    auto callback = m_callback.lock();
+    if (callback)
+    {
+        callback->disconnected();
+    }
+}
+
+
+
+//---------------------------------------
+// ProtocolVarintSizeFactory
+//---------------------------------------
+
+
+
+ProtocolVarintSizeFactory::ProtocolVarintSizeFactory(int maxFrameSize)
+    : m_maxFrameSize(maxFrameSize)
+{
+}
+
+// IProtocolFactory
+IProtocolPtr ProtocolVarintSizeFactory::createProtocol()
+{
+    return std::make_shared<ProtocolVarintSize>(m_maxFrameSize);
+}
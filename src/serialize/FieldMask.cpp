@@ -0,0 +1,80 @@
+
+#include "serialize/FieldMask.h"
+#include "metadata/MetaData.h"
+
+
+
+FieldMask::FieldMask(const std::string& typeName, const std::vector<std::string>& paths)
+{
+    const MetaStruct* stru = MetaDataGlobal::instance().getStruct(typeName);
+    if (!stru)
+    {
+        m_valid = false;
+        return;
+    }
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        if (!addPath(*stru, paths[i]))
+        {
+            m_valid = false;
+        }
+    }
+}
+
+
+bool FieldMask::isValid() const
+{
+    return m_valid;
+}
+
+
+const FieldMask::Node* FieldMask::getRoot() const
+{
+    return &m_root;
+}
+
+
+bool FieldMask::addPath(const MetaStruct& stru, const std::string& path)
+{
+    const MetaStruct* struCurrent = &stru;
+    Node* node = &m_root;
+    size_t pos = 0;
+    while (pos <= path.size())
+    {
+        size_t posEnd = path.find('.', pos);
+        if (posEnd == std::string::npos)
+        {
+            posEnd = path.size();
+        }
+        const MetaField* field = struCurrent ? struCurrent->getFieldByName(path.substr(pos, posEnd - pos)) : nullptr;
+        if (!field)
+        {
+            return false;
+        }
+        if (node->fields.empty())
+        {
+            node->fields.resize(struCurrent->getFieldsSize());
+        }
+        std::unique_ptr<Node>& child = node->fields[field->index];
+        if (!child)
+        {
+            child = std::make_unique<Node>();
+        }
+        node = child.get();
+        if (node->all)
+        {
+            // a shorter path keeps already everything
+            return true;
+        }
+
+        struCurrent = nullptr;
+        if (field->typeId == MetaTypeId::TYPE_STRUCT || field->typeId == MetaTypeId::TYPE_ARRAY_STRUCT)
+        {
+            struCurrent = MetaDataGlobal::instance().getStruct(*field);
+        }
+        pos = posEnd + 1;
+    }
+    node->all = true;
+    node->fields.clear();
+    return true;
+}
@@ -25,7 +25,7 @@ ParserJson::ParserJson(IParserVisitor& visitor, const char* ptr, int size)
 
 
 
-bool ParserJson::parseStruct(const std::string& typeName)
+bool ParserJson::parseStruct(const std::string& typeName, const FieldMask* fieldMask)
 {
     assert(m_ptr);
     assert(m_size >= 0);
@@ -41,6 +41,7 @@ bool ParserJson::parseStruct(const std::string& typeName)
     MetaField field = {MetaTypeId::TYPE_STRUCT, typeName};
     field.metaStruct = stru;
     m_fieldCurrent = &field;
+    m_maskField = fieldMask ? fieldMask->getRoot() : nullptr;
 
     const char* str = m_parser.parse(m_ptr, m_size);
     m_visitor.finished();
@@ -472,9 +473,9 @@ void ParserJson::enterArray()
             break;
         case MetaTypeId::TYPE_ARRAY_STRUCT:
             m_visitor.enterArrayStruct(*m_fieldCurrent);
-            m_stack.emplace_back(m_fieldCurrent);
+            m_stack.emplace_back(m_fieldCurrent, m_maskField);
             m_fieldCurrent = MetaDataGlobal::instance().getArrayField(*m_fieldCurrent);
-            m_stack.emplace_back(m_fieldCurrent);
+            m_stack.emplace_back(m_fieldCurrent, m_maskField);
             m_structCurrent = nullptr;
             break;
         default:
@@ -568,7 +569,7 @@ void ParserJson::exitArray()
 
 void ParserJson::enterObject()
 {
-    m_stack.emplace_back(m_fieldCurrent);
+    m_stack.emplace_back(m_fieldCurrent, m_maskField);
     m_structCurrent = nullptr;
     if (m_fieldCurrent && m_fieldCurrent->typeId == MetaTypeId::TYPE_STRUCT)
     {
@@ -576,6 +577,7 @@ void ParserJson::enterObject()
         if (stru)
         {
             m_structCurrent = stru;
+            m_maskCurrent = m_maskField;
             m_visitor.enterStruct(*m_fieldCurrent);
             m_fieldCurrent = nullptr;
         }
@@ -607,6 +609,8 @@ void ParserJson::exitObject()
     if (!m_stack.empty())
     {
         m_fieldCurrent = m_stack.back().field;
+        m_maskCurrent = m_stack.back().mask;
+        m_maskField = m_maskCurrent;
         if (m_fieldCurrent)
         {
             m_structCurrent = MetaDataGlobal::instance().getStruct(*m_fieldCurrent);
@@ -625,6 +629,11 @@ void ParserJson::enterKey(std::string&& key)
     if (m_structCurrent)
     {
         m_fieldCurrent = m_structCurrent->getFieldByName(key);
+        if (m_fieldCurrent && !FieldMask::select(m_maskCurrent, m_fieldCurrent->index, m_maskField))
+        {
+            // not in the field mask, the value is ignored like an unknown key
+            m_fieldCurrent = nullptr;
+        }
     }
 }
 
@@ -6,9 +6,54 @@
 #include <assert.h>
 #include <memory.h>
 #include <iostream>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 
 static const int INDEX2ID = 1;
+static const int MAX_VARINT_SIZE = 10;
+
+
+// Decodes a varint without a bounds check per byte, at least MAX_VARINT_SIZE bytes must be readable.
+// Varints up to 8 bytes (56 bits) are decoded from one 64 bit load without a loop.
+// Returns the position after the varint or nullptr, if the varint is longer than MAX_VARINT_SIZE.
+static inline const char* decodeVarintFast(const char* buffer, std::uint64_t& value)
+{
+    const std::uint8_t* ptr = reinterpret_cast<const std::uint8_t*>(buffer);
+#ifdef BEXMQ_LITTLE_ENDIAN
+    std::uint64_t data;
+    memcpy(&data, ptr, sizeof(data));
+    std::uint64_t stopBits = ~data & 0x8080808080808080ULL;
+    if (stopBits != 0)
+    {
+        int bits = __builtin_ctzll(stopBits) + 1;   // bits till the end of the last byte of the varint
+        data &= (bits == 64) ? ~0ULL : ((1ULL << bits) - 1);
+#if defined(__BMI2__)
+        value = _pext_u64(data, 0x7f7f7f7f7f7f7f7fULL);
+#else
+        data &= 0x7f7f7f7f7f7f7f7fULL;
+        data = ((data & 0x7f007f007f007f00ULL) >> 1) | (data & 0x007f007f007f007fULL);
+        data = ((data & 0x3fff00003fff0000ULL) >> 2) | (data & 0x00003fff00003fffULL);
+        data = ((data & 0x0fffffff00000000ULL) >> 4) | (data & 0x000000000fffffffULL);
+        value = data;
+#endif
+        return buffer + bits / 8;
+    }
+#endif
+    std::uint64_t res = 0;
+    for (int i = 0; i < MAX_VARINT_SIZE; ++i)
+    {
+        std::uint64_t c = ptr[i];
+        res |= (c & 0x7f) << (7 * i);
+        if (c < 0x80)
+        {
+            value = res;
+            return buffer + i + 1;
+        }
+    }
+    return nullptr;
+}
 
 
 ParserProto::ParserProto(IParserVisitor& visitor, const char* ptr, int size)
@@ -99,7 +144,7 @@ bool ParserProto::parseString(const char*& buffer, int& size)
 
 
 
-void ParserProto::parseStructWire(const MetaField& field)
+void ParserProto::parseStructWire(const MetaField& field, const FieldMask::Node* mask)
 {
     WireType wireType = static_cast<WireType>(m_tag & 0x7);
 
@@ -121,6 +166,7 @@ void ParserProto::parseStructWire(const MetaField& field)
             {
                 m_visitor.enterStruct(field);
                 ParserProto parser(m_visitor, m_ptr, sizeBuffer);
+                parser.m_mask = mask;
                 bool res = parser.parseStructIntern(*stru);
                 m_visitor.exitStruct(field);
                 if (res)
@@ -233,7 +279,7 @@ bool ParserProto::parseArrayFixed(std::vector<T>& array)
 }
 
 
-template<class T, bool ZIGZAG = false>
+template<class T, bool ZIGZAG>
 bool ParserProto::parseArrayVarint(std::vector<T>& array)
 {
     bool ok = true;
@@ -269,11 +315,13 @@ bool ParserProto::parseArrayVarint(std::vector<T>& array)
             {
                 if (sizeBuffer >= 0 && sizeBuffer <= m_size)
                 {
-                    while (m_size > 0)
+                    ok = parsePackedVarint<T, ZIGZAG>(m_ptr, sizeBuffer, array);
+                    m_ptr += sizeBuffer;
+                    m_size -= sizeBuffer;
+                    if (!ok)
                     {
-                        std::uint64_t value = parseVarint();
-                        T v = (ZIGZAG) ? zigzag(value) : static_cast<T>(value);
-                        array.push_back(v);
+                        m_ptr = nullptr;
+                        m_size = 0;
                     }
                 }
                 else
@@ -294,6 +342,78 @@ bool ParserProto::parseArrayVarint(std::vector<T>& array)
 }
 
 
+template<class T, bool ZIGZAG>
+bool ParserProto::parsePackedVarint(const char* buffer, int size, std::vector<T>& array)
+{
+    const std::uint8_t* ptr = reinterpret_cast<const std::uint8_t*>(buffer);
+    const std::uint8_t* end = ptr + size;
+
+    // every varint ends with a byte without the continuation bit, the compiler vectorizes this loop.
+    int count = 0;
+    for (int i = 0; i < size; ++i)
+    {
+        count += (ptr[i] < 0x80) ? 1 : 0;
+    }
+    if (size > 0 && end[-1] >= 0x80)
+    {
+        // the last varint is not complete
+        return false;
+    }
+
+    size_t offset = array.size();
+    array.resize(offset + count);
+
+    if (count == size)
+    {
+        // all values fit in one byte
+        for (int i = 0; i < count; ++i)
+        {
+            std::uint64_t value = ptr[i];
+            array[offset + i] = (ZIGZAG) ? zigzag(value) : static_cast<T>(value);
+        }
+        return true;
+    }
+
+    int i = 0;
+    for ( ; i < count && end - ptr >= MAX_VARINT_SIZE; ++i)
+    {
+        std::uint64_t value = 0;
+        const char* next = decodeVarintFast(reinterpret_cast<const char*>(ptr), value);
+        if (!next)
+        {
+            return false;
+        }
+        ptr = reinterpret_cast<const std::uint8_t*>(next);
+        array[offset + i] = (ZIGZAG) ? zigzag(value) : static_cast<T>(value);
+    }
+    for ( ; i < count; ++i)
+    {
+        std::uint64_t value = *ptr;
+        ++ptr;
+        if (value >= 0x80)
+        {
+            value -= 0x80;
+            int shift = 7;
+            std::uint64_t c;
+            do
+            {
+                if (shift >= 70)
+                {
+                    return false;
+                }
+                c = *ptr;
+                ++ptr;
+                value += (c & 0x7f) << shift;
+                shift += 7;
+            } while (c >= 0x80);
+        }
+        array[offset + i] = (ZIGZAG) ? zigzag(value) : static_cast<T>(value);
+    }
+    assert(ptr == end);
+    return true;
+}
+
+
 
 template<class T>
 bool ParserProto::parseArrayString(std::vector<T>& array)
@@ -344,7 +464,7 @@ bool ParserProto::parseArrayString(std::vector<T>& array)
 
 
 
-void ParserProto::parseArrayStruct(const MetaField& field)
+void ParserProto::parseArrayStruct(const MetaField& field, const FieldMask::Node* mask)
 {
     WireType wireType = static_cast<WireType>(m_tag & 0x7);
 
@@ -371,6 +491,7 @@ void ParserProto::parseArrayStruct(const MetaField& field)
             {
                 m_visitor.enterStruct(*fieldWithoutArray);
                 ParserProto parser(m_visitor, m_ptr, sizeBuffer);
+                parser.m_mask = mask;
                 bool res = parser.parseStructIntern(*stru);
                 m_visitor.exitStruct(*fieldWithoutArray);
                 if (res)
@@ -409,7 +530,7 @@ void ParserProto::parseArrayStruct(const MetaField& field)
 }
 
 
-bool ParserProto::parseStruct(const std::string& typeName)
+bool ParserProto::parseStruct(const std::string& typeName, const FieldMask* fieldMask)
 {
     assert(m_ptr);
     assert(m_size >= 0);
@@ -424,6 +545,7 @@ bool ParserProto::parseStruct(const std::string& typeName)
 
     MetaField field = {MetaTypeId::TYPE_STRUCT, typeName};
     field.metaStruct = stru;
+    m_mask = fieldMask ? fieldMask->getRoot() : nullptr;
     m_visitor.enterStruct(field);
     bool res = parseStructIntern(*stru);
     m_visitor.exitStruct(field);
@@ -454,6 +576,12 @@ bool ParserProto::parseStructIntern(const MetaStruct& stru)
             int id = m_tag >> 3;
             int index = id - INDEX2ID;
             const MetaField* field = stru.getFieldByIndex(index);
+            const FieldMask::Node* mask = nullptr;
+            if (field && !FieldMask::select(m_mask, index, mask))
+            {
+                // not in the field mask
+                field = nullptr;
+            }
             if (field)
             {
                 switch (field->typeId)
@@ -593,7 +721,7 @@ bool ParserProto::parseStructIntern(const MetaStruct& stru)
                     }
                     break;
                 case MetaTypeId::TYPE_STRUCT:
-                    parseStructWire(*field);
+                    parseStructWire(*field, mask);
                     break;
                 case MetaTypeId::TYPE_ENUM:
                     {
@@ -744,7 +872,7 @@ bool ParserProto::parseStructIntern(const MetaStruct& stru)
                     }
                     break;
                 case MetaTypeId::TYPE_ARRAY_STRUCT:
-                    parseArrayStruct(*field);
+                    parseArrayStruct(*field, mask);
                     break;
                 case MetaTypeId::TYPE_ARRAY_ENUM:
                     {
@@ -778,6 +906,7 @@ bool ParserProto::parseStructIntern(const MetaStruct& stru)
             else
             {
                 WireType wireType = static_cast<WireType>(m_tag & 0x7);
+                m_tag = 0;
                 skip(wireType);
             }
         }
@@ -799,13 +928,28 @@ std::uint64_t ParserProto::parseVarint()
         return 0;
     }
     std::uint64_t c = static_cast<std::uint8_t>(*m_ptr);
-    res = c;
-    ++m_ptr;
-    --m_size;
     if (c < 128)
     {
-        return res;
+        ++m_ptr;
+        --m_size;
+        return c;
+    }
+    if (m_size >= MAX_VARINT_SIZE)
+    {
+        const char* ptr = decodeVarintFast(m_ptr, res);
+        if (ptr)
+        {
+            m_size -= ptr - m_ptr;
+            m_ptr = ptr;
+            return res;
+        }
+        m_ptr = nullptr;
+        m_size = 0;
+        return 0;
     }
+    res = c;
+    ++m_ptr;
+    --m_size;
     for (int i = 1; i < 10; ++i)
     {
         if (m_size <= 0)
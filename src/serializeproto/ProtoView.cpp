@@ -0,0 +1,369 @@
+
+#include "serializeproto/ProtoView.h"
+#include "metadata/MetaData.h"
+#include "helpers/BexDefines.h"
+
+#include <assert.h>
+
+
+
+static const int INDEX2ID = 1;
+
+
+static bool readVarint(const char*& ptr, const char* end, std::uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 70 && ptr < end; shift += 7)
+    {
+        std::uint64_t c = static_cast<std::uint8_t>(*ptr);
+        ++ptr;
+        value |= (c & 0x7f) << shift;
+        if (c < 0x80)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static bool skipValue(WireType wireType, const char*& ptr, const char* end)
+{
+    std::uint64_t value = 0;
+    switch (wireType)
+    {
+    case WIRETYPE_VARINT:
+        return readVarint(ptr, end, value);
+    case WIRETYPE_FIXED64:
+        ptr += sizeof(std::uint64_t);
+        return (ptr <= end);
+    case WIRETYPE_LENGTH_DELIMITED:
+        if (!readVarint(ptr, end, value) || value > static_cast<std::uint64_t>(end - ptr))
+        {
+            return false;
+        }
+        ptr += value;
+        return true;
+    case WIRETYPE_FIXED32:
+        ptr += sizeof(std::uint32_t);
+        return (ptr <= end);
+    default:
+        return false;
+    }
+}
+
+
+static std::int64_t zigzag(std::uint64_t value)
+{
+    return static_cast<std::int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+
+
+ProtoView::ProtoView()
+{
+}
+
+
+ProtoView::ProtoView(const std::string& typeName, const char* buffer, int size)
+    : m_struct(MetaDataGlobal::instance().getStruct(typeName))
+    , m_buffer(buffer)
+    , m_size(size)
+{
+}
+
+
+ProtoView::ProtoView(const MetaStruct& stru, const char* buffer, int size)
+    : m_struct(&stru)
+    , m_buffer(buffer)
+    , m_size(size)
+{
+}
+
+
+bool ProtoView::buildIndex() const
+{
+    if (m_indexed)
+    {
+        return m_valid;
+    }
+    m_indexed = true;
+    m_valid = false;
+    if (!m_struct || !m_buffer || m_size < 0)
+    {
+        return false;
+    }
+
+    m_lastLocation.resize(m_struct->getFieldsSize(), -1);
+    const char* ptr = m_buffer;
+    const char* end = m_buffer + m_size;
+    while (ptr < end)
+    {
+        std::uint64_t tag = 0;
+        if (!readVarint(ptr, end, tag))
+        {
+            return false;
+        }
+        WireType wireType = static_cast<WireType>(tag & 0x7);
+        std::int64_t index = static_cast<std::int64_t>(tag >> 3) - INDEX2ID;
+        const char* value = ptr;
+        if (!skipValue(wireType, ptr, end))
+        {
+            return false;
+        }
+        if (index >= 0 && index < static_cast<std::int64_t>(m_lastLocation.size()))
+        {
+            m_lastLocation[index] = m_locations.size();
+            m_locations.push_back({static_cast<int>(index), wireType, value});
+        }
+    }
+    m_valid = true;
+    return true;
+}
+
+
+const ProtoView::FieldLocation* ProtoView::getLocation(int index) const
+{
+    if (!buildIndex() || index < 0 || index >= static_cast<int>(m_lastLocation.size()))
+    {
+        return nullptr;
+    }
+    int location = m_lastLocation[index];
+    return (location >= 0) ? &m_locations[location] : nullptr;
+}
+
+
+const MetaField* ProtoView::getMetaField(int index, MetaTypeId typeId) const
+{
+    if (!m_struct)
+    {
+        return nullptr;
+    }
+    const MetaField* field = m_struct->getFieldByIndex(index);
+    if (!field || field->typeId != typeId)
+    {
+        return nullptr;
+    }
+    return field;
+}
+
+
+template<class T>
+T ProtoView::getInteger(int index, MetaTypeId typeId) const
+{
+    const MetaField* field = getMetaField(index, typeId);
+    const FieldLocation* location = getLocation(index);
+    if (!field || !location)
+    {
+        return 0;
+    }
+    const char* ptr = location->value;
+    const char* end = m_buffer + m_size;
+    bool varint = (typeId == MetaTypeId::TYPE_BOOL || typeId == MetaTypeId::TYPE_ENUM || (field->flags & (METAFLAG_PROTO_VARINT | METAFLAG_PROTO_ZIGZAG)));
+    if (varint)
+    {
+        std::uint64_t value = 0;
+        if (location->wireType != WIRETYPE_VARINT || !readVarint(ptr, end, value))
+        {
+            return 0;
+        }
+        if (field->flags & METAFLAG_PROTO_ZIGZAG)
+        {
+            return static_cast<T>(zigzag(value));
+        }
+        return static_cast<T>(value);
+    }
+    WireType wireTypeFixed = (sizeof(T) == sizeof(std::uint32_t)) ? WIRETYPE_FIXED32 : WIRETYPE_FIXED64;
+    T value = 0;
+    if (location->wireType == wireTypeFixed)
+    {
+        EndianHelper<sizeof(T)>::read(ptr, value);
+    }
+    return value;
+}
+
+
+
+bool ProtoView::isValid() const
+{
+    return buildIndex();
+}
+
+
+const MetaStruct* ProtoView::getStruct() const
+{
+    return m_struct;
+}
+
+
+int ProtoView::getFieldIndex(const std::string& name) const
+{
+    if (!m_struct)
+    {
+        return -1;
+    }
+    const MetaField* field = m_struct->getFieldByName(name);
+    return field ? field->index : -1;
+}
+
+
+bool ProtoView::hasField(int index) const
+{
+    return (getLocation(index) != nullptr);
+}
+
+
+bool ProtoView::getBool(int index) const
+{
+    return (getInteger<std::uint64_t>(index, MetaTypeId::TYPE_BOOL) != 0);
+}
+
+std::int32_t ProtoView::getInt32(int index) const
+{
+    return getInteger<std::int32_t>(index, MetaTypeId::TYPE_INT32);
+}
+
+std::uint32_t ProtoView::getUInt32(int index) const
+{
+    return getInteger<std::uint32_t>(index, MetaTypeId::TYPE_UINT32);
+}
+
+std::int64_t ProtoView::getInt64(int index) const
+{
+    return getInteger<std::int64_t>(index, MetaTypeId::TYPE_INT64);
+}
+
+std::uint64_t ProtoView::getUInt64(int index) const
+{
+    return getInteger<std::uint64_t>(index, MetaTypeId::TYPE_UINT64);
+}
+
+std::int32_t ProtoView::getEnum(int index) const
+{
+    return getInteger<std::int32_t>(index, MetaTypeId::TYPE_ENUM);
+}
+
+float ProtoView::getFloat(int index) const
+{
+    const FieldLocation* location = getLocation(index);
+    float value = 0;
+    if (getMetaField(index, MetaTypeId::TYPE_FLOAT) && location && location->wireType == WIRETYPE_FIXED32)
+    {
+        EndianHelper<sizeof(float)>::read(location->value, value);
+    }
+    return value;
+}
+
+double ProtoView::getDouble(int index) const
+{
+    const FieldLocation* location = getLocation(index);
+    double value = 0;
+    if (getMetaField(index, MetaTypeId::TYPE_DOUBLE) && location && location->wireType == WIRETYPE_FIXED64)
+    {
+        EndianHelper<sizeof(double)>::read(location->value, value);
+    }
+    return value;
+}
+
+
+bool ProtoView::getString(int index, const char*& buffer, int& size) const
+{
+    buffer = nullptr;
+    size = 0;
+    const MetaField* field = m_struct ? m_struct->getFieldByIndex(index) : nullptr;
+    if (!field || (field->typeId != MetaTypeId::TYPE_STRING && field->typeId != MetaTypeId::TYPE_BYTES))
+    {
+        return false;
+    }
+    const FieldLocation* location = getLocation(index);
+    if (!location || location->wireType != WIRETYPE_LENGTH_DELIMITED)
+    {
+        return false;
+    }
+    const char* ptr = location->value;
+    std::uint64_t sizeValue = 0;
+    readVarint(ptr, m_buffer + m_size, sizeValue);
+    buffer = ptr;
+    size = static_cast<int>(sizeValue);
+    return true;
+}
+
+
+std::string ProtoView::getString(int index) const
+{
+    const char* buffer = nullptr;
+    int size = 0;
+    getString(index, buffer, size);
+    return std::string(buffer ? buffer : "", size);
+}
+
+
+ProtoView ProtoView::getStruct(int index) const
+{
+    const MetaField* field = getMetaField(index, MetaTypeId::TYPE_STRUCT);
+    const FieldLocation* location = getLocation(index);
+    if (!field || !location || location->wireType != WIRETYPE_LENGTH_DELIMITED)
+    {
+        return ProtoView();
+    }
+    const MetaStruct* stru = MetaDataGlobal::instance().getStruct(*field);
+    if (!stru)
+    {
+        return ProtoView();
+    }
+    const char* ptr = location->value;
+    std::uint64_t size = 0;
+    readVarint(ptr, m_buffer + m_size, size);
+    return ProtoView(*stru, ptr, static_cast<int>(size));
+}
+
+
+std::vector<ProtoView> ProtoView::getArrayStruct(int index) const
+{
+    std::vector<ProtoView> views;
+    const MetaField* field = getMetaField(index, MetaTypeId::TYPE_ARRAY_STRUCT);
+    if (!field || !getLocation(index))
+    {
+        return views;
+    }
+    const MetaStruct* stru = MetaDataGlobal::instance().getStruct(*field);
+    if (!stru)
+    {
+        return views;
+    }
+    for (size_t i = 0; i < m_locations.size(); ++i)
+    {
+        const FieldLocation& location = m_locations[i];
+        if (location.index == index && location.wireType == WIRETYPE_LENGTH_DELIMITED)
+        {
+            const char* ptr = location.value;
+            std::uint64_t size = 0;
+            readVarint(ptr, m_buffer + m_size, size);
+            views.emplace_back(*stru, ptr, static_cast<int>(size));
+        }
+    }
+    return views;
+}
+
+
+std::vector<std::pair<const char*, int>> ProtoView::getArrayString(int index) const
+{
+    std::vector<std::pair<const char*, int>> strings;
+    const MetaField* field = m_struct ? m_struct->getFieldByIndex(index) : nullptr;
+    if (!field || (field->typeId != MetaTypeId::TYPE_ARRAY_STRING && field->typeId != MetaTypeId::TYPE_ARRAY_BYTES) || !getLocation(index))
+    {
+        return strings;
+    }
+    for (size_t i = 0; i < m_locations.size(); ++i)
+    {
+        const FieldLocation& location = m_locations[i];
+        if (location.index == index && location.wireType == WIRETYPE_LENGTH_DELIMITED)
+        {
+            const char* ptr = location.value;
+            std::uint64_t size = 0;
+            readVarint(ptr, m_buffer + m_size, size);
+            strings.emplace_back(ptr, static_cast<int>(size));
+        }
+    }
+    return strings;
+}
@@ -23,17 +23,31 @@ enum WireType
 };
 
 
-SerializerProto::SerializerProto(IZeroCopyBuffer& buffer, int maxBlockSize)
+static inline int sizeVarint(std::uint64_t value)
+{
+    int size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+
+
+SerializerProto::SerializerProto(IZeroCopyBuffer& buffer, int maxBlockSize, bool exactSize)
     : ParserConverter(&m_internal)
-    , m_internal(buffer, maxBlockSize)
+    , m_internal(buffer, maxBlockSize, exactSize)
 {
 }
 
 
 
-SerializerProto::Internal::Internal(IZeroCopyBuffer& buffer, int maxBlockSize)
+SerializerProto::Internal::Internal(IZeroCopyBuffer& buffer, int maxBlockSize, bool exactSize)
     : m_zeroCopybuffer(buffer)
     , m_maxBlockSize(maxBlockSize)
+    , m_exactSize(exactSize)
 {
 }
 
@@ -226,13 +240,20 @@ void SerializerProto::Internal::serializeArrayVarint(int id, const T* value, int
         return;
     }
 
-    reserveSpace(size * 2 * MAX_VARINT_SIZE);
+    int sizeByte = 0;
+    for (int i = 0; i < size; i++)
+    {
+        sizeByte += sizeVarint(static_cast<std::uint64_t>(value[i]));
+    }
+
+    reserveSpace(MAX_VARINT_SIZE + MAX_VARINT_SIZE + sizeByte);
 
-    std::uint32_t tag = (id << 3) | WIRETYPE_VARINT;
+    std::uint32_t tag = (id << 3) | WIRETYPE_LENGTH_DELIMITED;
+    serializeVarint(tag);
+    serializeVarint(sizeByte);
 
     for (int i = 0; i < size; i++)
     {
-        serializeVarint(tag);
         serializeVarint(value[i]);
     }
 }
@@ -246,13 +267,20 @@ void SerializerProto::Internal::serializeArrayZigZag(int id, const T* value, int
         return;
     }
 
-    reserveSpace(size * 2 * MAX_VARINT_SIZE);
+    int sizeByte = 0;
+    for (int i = 0; i < size; i++)
+    {
+        sizeByte += sizeVarint(zigzag(value[i]));
+    }
 
-    std::uint32_t tag = (id << 3) | WIRETYPE_VARINT;
+    reserveSpace(MAX_VARINT_SIZE + MAX_VARINT_SIZE + sizeByte);
+
+    std::uint32_t tag = (id << 3) | WIRETYPE_LENGTH_DELIMITED;
+    serializeVarint(tag);
+    serializeVarint(sizeByte);
 
     for (int i = 0; i < size; i++)
     {
-        serializeVarint(tag);
         auto v = zigzag(value[i]);
         serializeVarint(v);
     }
@@ -280,6 +308,12 @@ char* SerializerProto::Internal::serializeStruct(int id)
 
 void SerializerProto::Internal::reserveSpace(int space)
 {
+    if (m_exactSize)
+    {
+        reserveSpaceExact(space);
+        return;
+    }
+
     int sizeRemaining = m_bufferEnd - m_buffer;
     if (sizeRemaining < space)
     {
@@ -310,6 +344,110 @@ void SerializerProto::Internal::reserveSpace(int space)
     }
 }
 
+void SerializerProto::Internal::reserveSpaceExact(int space)
+{
+    int sizeRemaining = m_bufferEnd - m_buffer;
+    if (sizeRemaining < space)
+    {
+        int size = m_buffer - m_bufferStart;
+        m_scratch.resize(std::max(static_cast<int>(m_scratch.size()) * 2, size + std::max(m_maxBlockSize, space)));
+        m_bufferStart = m_scratch.data();
+        m_bufferEnd = m_bufferStart + m_scratch.size();
+        m_buffer = m_bufferStart + size;
+    }
+}
+
+
+void SerializerProto::Internal::enterStructExact(const MetaField& field)
+{
+    if (m_stackStruct.empty())
+    {
+        m_stackStruct.emplace_back(nullptr, nullptr, nullptr, false);
+        m_structNodes.clear();
+        m_stackStructNodes.clear();
+        m_lengthBytes = 0;
+        m_bufferStart = m_scratch.data();
+        m_bufferEnd = m_bufferStart + m_scratch.size();
+        m_buffer = m_bufferStart;
+        return;
+    }
+
+    int id = field.index + INDEX2ID;
+    bool arrayEntry = m_stackStruct.back().arrayParent;
+    m_stackStruct.emplace_back(nullptr, nullptr, nullptr, arrayEntry);
+
+    reserveSpace(MAX_VARINT_SIZE);
+    int offsetTag = m_buffer - m_bufferStart;
+    std::uint32_t tag = (id << 3) | WIRETYPE_LENGTH_DELIMITED;
+    serializeVarint(tag);
+
+    m_stackStructNodes.push_back(m_structNodes.size());
+    m_structNodes.emplace_back();
+    StructNode& node = m_structNodes.back();
+    node.offsetTag = offsetTag;
+    node.offsetLength = m_buffer - m_bufferStart;
+    node.lengthBytesBefore = m_lengthBytes;
+    node.arrayEntry = arrayEntry;
+}
+
+
+void SerializerProto::Internal::exitStructExact()
+{
+    if (m_stackStruct.size() == 1)
+    {
+        writeExact();
+        return;
+    }
+
+    assert(!m_stackStructNodes.empty());
+    int indexNode = m_stackStructNodes.back();
+    m_stackStructNodes.pop_back();
+    StructNode& node = m_structNodes[indexNode];
+    int offset = m_buffer - m_bufferStart;
+    // the lengths of the nested structs are not in the scratch buffer, yet.
+    int structSize = (offset - node.offsetLength) + (m_lengthBytes - node.lengthBytesBefore);
+    if (structSize == 0 && !node.arrayEntry)
+    {
+        // an empty struct is not serialized, it is the last node, because it has no nested structs.
+        assert(indexNode == static_cast<int>(m_structNodes.size()) - 1);
+        m_buffer = m_bufferStart + node.offsetTag;
+        m_structNodes.pop_back();
+        return;
+    }
+    node.size = structSize;
+    m_lengthBytes += sizeVarint(structSize);
+}
+
+
+void SerializerProto::Internal::writeExact()
+{
+    int sizeScratch = m_buffer - m_bufferStart;
+    int sizeTotal = sizeScratch + m_lengthBytes;
+    char* buffer = m_zeroCopybuffer.addBuffer(sizeTotal);
+
+    m_buffer = buffer;
+    int offset = 0;
+    for (size_t i = 0; i < m_structNodes.size(); ++i)
+    {
+        const StructNode& node = m_structNodes[i];
+        int size = node.offsetLength - offset;
+        memcpy(m_buffer, m_bufferStart + offset, size);
+        m_buffer += size;
+        serializeVarint(node.size);
+        offset = node.offsetLength;
+    }
+    memcpy(m_buffer, m_bufferStart + offset, sizeScratch - offset);
+    m_buffer += sizeScratch - offset;
+    assert(m_buffer - buffer == sizeTotal);
+    m_zeroCopybuffer.downsizeLastBuffer(sizeTotal);
+
+    m_structNodes.clear();
+    m_bufferStart = nullptr;
+    m_bufferEnd = nullptr;
+    m_buffer = nullptr;
+}
+
+
 void SerializerProto::Internal::resizeBuffer()
 {
     if (m_buffer != nullptr)
@@ -342,6 +480,12 @@ void SerializerProto::Internal::finished()
 
 void SerializerProto::Internal::enterStruct(const MetaField& field)
 {
+    if (m_exactSize)
+    {
+        enterStructExact(field);
+        return;
+    }
+
     int id = field.index + INDEX2ID;
 
     if (!m_stackStruct.empty())
@@ -447,6 +591,13 @@ void SerializerProto::Internal::fillRemainingStruct(int remainingSize)
 void SerializerProto::Internal::exitStruct(const MetaField& field)
 {
     assert(!m_stackStruct.empty());
+    if (m_exactSize)
+    {
+        exitStructExact();
+        m_stackStruct.pop_back();
+        return;
+    }
+
     StructData& structData = m_stackStruct.back();
     if (m_stackStruct.size() == 1)
     {
@@ -762,11 +913,8 @@ void SerializerProto::Internal::enterArrayEnum(const MetaField& field, const std
             return;
         }
 
-        reserveSpace(value.size() * 2 * MAX_VARINT_SIZE);
-
-        int id = field.index + INDEX2ID;
-        std::uint32_t tag = (id << 3) | WIRETYPE_VARINT;
-
+        std::vector<std::int32_t> intValues;
+        intValues.reserve(value.size());
         for (size_t i = 0; i < value.size(); i++)
         {
             int intValue = 0;
@@ -775,8 +923,10 @@ void SerializerProto::Internal::enterArrayEnum(const MetaField& field, const std
             {
                 intValue = entry->id;
             }
-            serializeVarint(tag);
-            serializeVarint(intValue);
+            intValues.push_back(intValue);
         }
+
+        int id = field.index + INDEX2ID;
+        serializeArrayVarint(id, intValues.data(), intValues.size());
     }
 }
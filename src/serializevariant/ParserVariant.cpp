@@ -3,6 +3,7 @@
 #include "metadata/MetaData.h"
 #include "variant/VariantValues.h"
 #include "variant/VariantValueList.h"
+#include "variant/VariantValueView.h"
 
 #include <assert.h>
 
@@ -72,10 +73,15 @@ void ParserVariant::processField(const Variant* sub, const MetaField* field)
     case TYPE_STRING:
         {
             const std::string* str = *sub;
+            const StringView* view = *sub;
             if (str)
             {
                 m_visitor.enterString(*field, str->c_str(), str->size());
             }
+            else if (view)
+            {
+                m_visitor.enterString(*field, view->data, view->size);
+            }
             else
             {
                 m_visitor.enterString(*field, *sub);
@@ -85,10 +91,15 @@ void ParserVariant::processField(const Variant* sub, const MetaField* field)
     case TYPE_BYTES:
     {
         const Bytes* bytes = *sub;
+        const BytesView* view = *sub;
         if (bytes)
         {
             m_visitor.enterBytes(*field, bytes->data(), bytes->size());
         }
+        else if (view)
+        {
+            m_visitor.enterBytes(*field, view->data, view->size);
+        }
         else
         {
             m_visitor.enterBytes(*field, *sub);
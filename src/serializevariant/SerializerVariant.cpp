@@ -5,6 +5,7 @@
 #include "variant/VariantValueStruct.h"
 #include "variant/VariantValueList.h"
 #include "variant/VariantValues.h"
+#include "variant/VariantValueView.h"
 
 #include <assert.h>
 #include <algorithm>
@@ -12,9 +13,9 @@
 
 
 
-SerializerVariant::SerializerVariant(Variant& root, bool enumAsString, bool skipDefaultValues)
+SerializerVariant::SerializerVariant(Variant& root, bool enumAsString, bool skipDefaultValues, const std::shared_ptr<const void>& bufferOwner, const char* buffer, int size)
     : ParserConverter()
-    , m_internal(root, enumAsString)
+    , m_internal(root, enumAsString, bufferOwner, buffer, size)
     , m_parserProcessDefaultValues()
 {
     m_parserProcessDefaultValues = std::make_unique<ParserProcessDefaultValues>(skipDefaultValues, &m_internal);
@@ -23,14 +24,37 @@ SerializerVariant::SerializerVariant(Variant& root, bool enumAsString, bool skip
 
 
 
-SerializerVariant::Internal::Internal(Variant& root, bool enumAsString)
+SerializerVariant::Internal::Internal(Variant& root, bool enumAsString, const std::shared_ptr<const void>& bufferOwner, const char* buffer, int size)
     : m_root(root)
     , m_enumAsString(enumAsString)
+    , m_bufferOwner(bufferOwner)
+    , m_bufferBegin(buffer)
+    , m_bufferEnd(buffer ? buffer + size : nullptr)
 {
     m_root = Variant();
 }
 
 
+bool SerializerVariant::Internal::isInBuffer(const char* value, int size) const
+{
+    // a parser may pass data of its own (e.g. an unescaped string), this data must be copied
+    return (m_bufferOwner && m_bufferBegin && value >= m_bufferBegin && value + size <= m_bufferEnd);
+}
+
+
+static Variant createStruct(const MetaField& field)
+{
+    // bind the struct to its meta data, so that the fields can be accessed by field index
+    const MetaStruct* stru = MetaDataGlobal::instance().getStruct(field);
+    if (stru)
+    {
+        std::shared_ptr<IVariantValue> value = std::make_shared<VariantValueStruct>(*stru);
+        return Variant(value);
+    }
+    return VariantStruct();
+}
+
+
 // IParserVisitor
 void SerializerVariant::Internal::notifyError(const char* str, const char* message)
 {
@@ -45,7 +69,7 @@ void SerializerVariant::Internal::enterStruct(const MetaField& field)
 {
     if (m_stack.empty())
     {
-        m_root = VariantStruct();
+        m_root = createStruct(field);
         m_stack.push_back(&m_root);
         m_current = m_stack.back();
     }
@@ -54,15 +78,16 @@ void SerializerVariant::Internal::enterStruct(const MetaField& field)
         assert(m_current);
         if (m_current->getType() == TYPE_STRUCT)
         {
-            m_current->add(field.name, VariantStruct());
-            VariantStruct* stru = *m_current;
+            m_current->add(field.name, createStruct(field));
+            // the const access keeps the field positions of the struct, only the new entry is changed
+            const VariantStruct* stru = *static_cast<const Variant*>(m_current);
             assert(stru);
-            m_stack.push_back(&stru->back().second);
+            m_stack.push_back(const_cast<Variant*>(&stru->back().second));
         }
         else
         {
             assert(m_current->getType() == TYPE_ARRAY_STRUCT);
-            m_current->add(VariantStruct());
+            m_current->add(createStruct(field));
             VariantList* list = *m_current;
             assert(list);
             m_stack.push_back(&list->back());
@@ -96,9 +121,10 @@ void SerializerVariant::Internal::enterArrayStruct(const MetaField& field)
         if (m_current->getType() == TYPE_STRUCT)
         {
             m_current->add(field.name, VariantList());
-            VariantStruct* stru = *m_current;
+            // the const access keeps the field positions of the struct, only the new entry is changed
+            const VariantStruct* stru = *static_cast<const Variant*>(m_current);
             assert(stru);
-            m_stack.push_back(&stru->back().second);
+            m_stack.push_back(const_cast<Variant*>(&stru->back().second));
         }
         else
         {
@@ -190,7 +216,15 @@ void SerializerVariant::Internal::enterString(const MetaField& field, std::strin
 
 void SerializerVariant::Internal::enterString(const MetaField& field, const char* value, int size)
 {
-    add(field, std::string(value, size));
+    if (isInBuffer(value, size))
+    {
+        std::shared_ptr<IVariantValue> view = std::make_shared<VariantValueStringView>(StringView{value, size}, m_bufferOwner);
+        add(field, Variant(view));
+    }
+    else
+    {
+        add(field, std::string(value, size));
+    }
 }
 
 void SerializerVariant::Internal::enterBytes(const MetaField& field, Bytes&& value)
@@ -200,7 +234,15 @@ void SerializerVariant::Internal::enterBytes(const MetaField& field, Bytes&& val
 
 void SerializerVariant::Internal::enterBytes(const MetaField& field, const BytesElement* value, int size)
 {
-    add(field, Bytes(value, value + size));
+    if (isInBuffer(value, size))
+    {
+        std::shared_ptr<IVariantValue> view = std::make_shared<VariantValueBytesView>(BytesView{value, size}, m_bufferOwner);
+        add(field, Variant(view));
+    }
+    else
+    {
+        add(field, Bytes(value, value + size));
+    }
 }
 
 void SerializerVariant::Internal::enterEnum(const MetaField& field, std::int32_t value)
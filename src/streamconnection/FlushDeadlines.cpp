@@ -0,0 +1,52 @@
+#include "streamconnection/FlushDeadlines.h"
+
+
+
+bool FlushDeadlines::addDeadline(std::int64_t connectionId, const TimePoint& deadline)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    bool earliest = (m_deadlines.empty() || deadline < m_deadlines.begin()->first);
+    m_deadlines.emplace(deadline, connectionId);
+    lock.unlock();
+    return earliest;
+}
+
+
+void FlushDeadlines::takeExpired(const TimePoint& now, std::vector<std::int64_t>& connectionIds)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto itEnd = m_deadlines.upper_bound(now);
+    for (auto it = m_deadlines.begin(); it != itEnd; ++it)
+    {
+        connectionIds.push_back(it->second);
+    }
+    m_deadlines.erase(m_deadlines.begin(), itEnd);
+    lock.unlock();
+}
+
+
+int FlushDeadlines::getTimeout(const TimePoint& now, int timeoutMax) const
+{
+    int timeout = timeoutMax;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_deadlines.empty())
+    {
+        const TimePoint& deadline = m_deadlines.begin()->first;
+        if (deadline <= now)
+        {
+            timeout = 0;
+        }
+        else
+        {
+            // round up, the poller would wake up too early otherwise
+            std::int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count();
+            std::int64_t ms = (us + 999) / 1000;
+            if (timeoutMax < 0 || ms < timeoutMax)
+            {
+                timeout = static_cast<int>(ms);
+            }
+        }
+    }
+    lock.unlock();
+    return timeout;
+}
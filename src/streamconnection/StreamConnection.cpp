@@ -1,15 +1,22 @@
 
 
 #include "streamconnection/StreamConnection.h"
+#include "protocolconnection/ProtocolMessage.h"
 #include <thread>
+#include <string.h>
+#include <algorithm>
 
 
+static const int COALESCING_BUFFER_SIZE_MIN = 4096;
 
-StreamConnection::StreamConnection(const ConnectionData& connectionData, std::shared_ptr<Socket> socket, const IPollerPtr& poller, bex::hybrid_ptr<IStreamConnectionCallback> callback)
+
+
+StreamConnection::StreamConnection(const ConnectionData& connectionData, std::shared_ptr<Socket> socket, const IPollerPtr& poller, const FlushDeadlinesPtr& flushDeadlines, bex::hybrid_ptr<IStreamConnectionCallback> callback)
     : m_connectionData(connectionData)
     , m_socketPrivate(socket)
     , m_socket(socket)
     , m_poller(poller)
+    , m_flushDeadlines(flushDeadlines)
     , m_callback(callback)
 {
 
@@ -17,11 +24,201 @@ StreamConnection::StreamConnection(const ConnectionData& connectionData, std::sh
 }
 
 // IStreamConnection
-bool StreamConnection::sendMessage(const IMessagePtr& msg)
+bool StreamConnection::sendMessage(const IMessagePtr& msg, MessagePriority priority)
 {
     assert(msg);
-    int ret = false;
+    assert(priority >= 0 && priority < MESSAGEPRIORITY_COUNT);
+    bool ret = false;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_coalescingMaxBytes > 0 && priority == MESSAGEPRIORITY_NORMAL)
+    {
+        ret = coalesceMessage(msg);
+    }
+    else
+    {
+        ret = sendMessageIntern(msg, priority);
+    }
+    lock.unlock();
+    return ret;
+}
+
+
+bool StreamConnection::sendMessageConflated(const IMessagePtr& msg, const std::string& conflationKey, MessagePriority priority)
+{
+    assert(msg);
+    assert(priority >= 0 && priority < MESSAGEPRIORITY_COUNT);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // keep the order to the coalesced messages
+    flushIntern();
+    auto it = m_conflatedMessages.find(conflationKey);
+    if (it != m_conflatedMessages.end() && msg->getTotalSendBufferSize() > 0)
+    {
+        MessageSendState& messageSendState = *it->second;
+        messageSendState.msg = msg;
+        messageSendState.it = msg->getAllSendBuffers().begin();
+        messageSendState.offset = 0;
+        return (m_socketPrivate != nullptr);
+    }
+    bool ret = sendMessageIntern(msg, priority, conflationKey.empty() ? nullptr : &conflationKey);
+    lock.unlock();
+    return ret;
+}
+
+
+int StreamConnection::getPendingMessages() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_pendingMessagesCount;
+}
+
+
+void StreamConnection::setCoalescing(int maxBytes, int maxMessages, int deadlineUs)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    flushIntern();
+    m_coalescingMaxBytes = maxBytes;
+    m_coalescingMaxMessages = maxMessages;
+    m_coalescingDeadlineUs = deadlineUs;
+    lock.unlock();
+}
+
+
+void StreamConnection::flush()
+{
     std::unique_lock<std::mutex> lock(m_mutex);
+    flushIntern();
+    lock.unlock();
+}
+
+
+void StreamConnection::disableRead()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_socketPrivate)
+    {
+        m_poller->disableRead(m_socketPrivate->getSocketDescriptor());
+    }
+    lock.unlock();
+}
+
+
+void StreamConnection::enableRead()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_socketPrivate)
+    {
+        m_poller->enableRead(m_socketPrivate->getSocketDescriptor());
+    }
+    lock.unlock();
+}
+
+
+void StreamConnection::notifyWhenSent(std::function<void()> func)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    flushIntern();
+    if (m_socket && m_pendingMessagesCount > 0)
+    {
+        m_sentNotifications.push_back(std::move(func));
+        return;
+    }
+    lock.unlock();
+    func();
+}
+
+
+bool StreamConnection::coalesceMessage(const IMessagePtr& msg)
+{
+    if (!m_socketPrivate)
+    {
+        return false;
+    }
+    int size = msg->getTotalSendBufferSize();
+    if (size == 0)
+    {
+        return true;
+    }
+    if (m_coalescingSize + size > m_coalescingMaxBytes)
+    {
+        flushIntern();
+    }
+    if (size >= m_coalescingMaxBytes)
+    {
+        return sendMessageIntern(msg, MESSAGEPRIORITY_NORMAL);
+    }
+
+    bool wakeupPoller = false;
+    if (!m_coalescingBatch)
+    {
+        m_coalescingBatch = std::make_shared<ProtocolMessage>(0);
+        if (m_coalescingDeadlineUs > 0)
+        {
+            m_coalescingDeadline = std::chrono::steady_clock::now() + std::chrono::microseconds(m_coalescingDeadlineUs);
+            wakeupPoller = m_flushDeadlines->addDeadline(m_connectionData.connectionId, m_coalescingDeadline);
+        }
+    }
+
+    if (m_coalescingBufferUsed + size > m_coalescingBufferSize)
+    {
+        if (m_coalescingBuffer)
+        {
+            m_coalescingBatch->downsizeLastSendPayload(m_coalescingBufferUsed);
+        }
+        // m_coalescingSize + size <= m_coalescingMaxBytes, so the message fits into the new buffer
+        int sizeBuffer = std::max(std::max(2 * m_coalescingBufferSize, COALESCING_BUFFER_SIZE_MIN), size);
+        sizeBuffer = std::min(sizeBuffer, m_coalescingMaxBytes - m_coalescingSize);
+        m_coalescingBuffer = m_coalescingBatch->addSendPayload(sizeBuffer);
+        m_coalescingBufferSize = sizeBuffer;
+        m_coalescingBufferUsed = 0;
+    }
+
+    const std::list<BufferRef>& buffers = msg->getAllSendBuffers();
+    for (auto it = buffers.begin(); it != buffers.end(); ++it)
+    {
+        const BufferRef& buffer = *it;
+        memcpy(m_coalescingBuffer + m_coalescingBufferUsed, buffer.first, buffer.second);
+        m_coalescingBufferUsed += buffer.second;
+        m_coalescingSize += buffer.second;
+    }
+    ++m_coalescingMessages;
+
+    if (m_coalescingSize == m_coalescingMaxBytes ||
+        (m_coalescingMaxMessages > 0 && m_coalescingMessages >= m_coalescingMaxMessages))
+    {
+        flushIntern();
+    }
+    else if (wakeupPoller)
+    {
+        // the poller has to recalculate its timeout
+        m_poller->releaseWait();
+    }
+    return true;
+}
+
+
+bool StreamConnection::flushIntern()
+{
+    bool ret = true;
+    if (m_coalescingBatch)
+    {
+        IMessagePtr batch = m_coalescingBatch;
+        m_coalescingBatch = nullptr;
+        m_coalescingBuffer = nullptr;
+        batch->downsizeLastSendPayload(m_coalescingBufferUsed);
+        m_coalescingBufferSize = 0;
+        m_coalescingBufferUsed = 0;
+        batch->prepareMessageToSend();
+        m_coalescingSize = 0;
+        m_coalescingMessages = 0;
+        ret = sendMessageIntern(batch, MESSAGEPRIORITY_NORMAL);
+    }
+    return ret;
+}
+
+
+bool StreamConnection::sendMessageIntern(const IMessagePtr& msg, MessagePriority priority, const std::string* conflationKey)
+{
+    bool ret = false;
     if (m_socketPrivate)
     {
         ret = true;
@@ -29,10 +226,18 @@ bool StreamConnection::sendMessage(const IMessagePtr& msg)
         if (size > 0)
         {
             const auto& payloads = msg->getAllSendBuffers();
-            if (!m_pendingMessages.empty() ||
+            if (m_pendingMessagesCount > 0 ||
                 m_connectionData.connectionState != CONNECTIONSTATE_CONNECTED)
             {
-                m_pendingMessages.push_back({msg, payloads.begin(), 0});
+                m_pendingMessages[priority].push_back({msg, payloads.begin(), 0});
+                ++m_pendingMessagesCount;
+                if (conflationKey)
+                {
+                    auto itLast = m_pendingMessages[priority].end();
+                    --itLast;
+                    itLast->conflationKey = *conflationKey;
+                    m_conflatedMessages[*conflationKey] = itLast;
+                }
             }
             else
             {
@@ -49,7 +254,13 @@ bool StreamConnection::sendMessage(const IMessagePtr& msg)
                     {
                         assert(err < payload.second);
                         --it;
-                        m_pendingMessages.push_back({msg, it, err});
+                        int offset = (err > 0) ? err : 0;
+                        m_pendingMessages[priority].push_back({msg, it, offset});
+                        ++m_pendingMessagesCount;
+                        if (it != payloads.begin() || offset > 0)
+                        {
+                            m_priorityInProgress = priority;
+                        }
                         m_poller->enableWrite(m_socketPrivate->getSocketDescriptor());
                         ex = true;
                     }
@@ -57,7 +268,6 @@ bool StreamConnection::sendMessage(const IMessagePtr& msg)
             }
         }
     }
-    lock.unlock();
     return ret;
 }
 
@@ -115,17 +325,43 @@ bool StreamConnection::connect()
 
 
 
+std::list<StreamConnection::MessageSendState>* StreamConnection::getNextPendingMessages()
+{
+    if (m_priorityInProgress != -1)
+    {
+        assert(!m_pendingMessages[m_priorityInProgress].empty());
+        return &m_pendingMessages[m_priorityInProgress];
+    }
+    for (int priority = 0; priority < MESSAGEPRIORITY_COUNT; ++priority)
+    {
+        if (!m_pendingMessages[priority].empty())
+        {
+            return &m_pendingMessages[priority];
+        }
+    }
+    return nullptr;
+}
+
+
 bool StreamConnection::sendPendingMessages()
 {
     bool pending = false;
+    std::vector<std::function<void()>> sentNotifications;
     std::unique_lock<std::mutex> lock(m_mutex);
     if (m_socketPrivate)
     {
         if (m_connectionData.connectionState == CONNECTIONSTATE_CONNECTED)
         {
-            while (!m_pendingMessages.empty() && !pending)
+            std::list<MessageSendState>* pendingMessages = nullptr;
+            while (!pending && (pendingMessages = getNextPendingMessages()) != nullptr)
             {
-                MessageSendState& messageSendState = m_pendingMessages.front();
+                MessageSendState& messageSendState = pendingMessages->front();
+                if (!messageSendState.conflationKey.empty())
+                {
+                    // the message is started to be sent, it cannot be replaced anymore
+                    m_conflatedMessages.erase(messageSendState.conflationKey);
+                    messageSendState.conflationKey.clear();
+                }
                 IMessagePtr& msg = messageSendState.msg;
                 assert(msg);
                 const auto& payloads = msg->getAllSendBuffers();
@@ -133,7 +369,7 @@ bool StreamConnection::sendPendingMessages()
                 {
                     const BufferRef& payload = *it;
                     ++it;
-                    bool last = ((it == payloads.end()) && (m_pendingMessages.size() == 1));
+                    bool last = ((it == payloads.end()) && (m_pendingMessagesCount == 1));
                     int flags = last ? 0 : MSG_MORE;    // win32: MSG_PARTIAL
                     int size = payload.second - messageSendState.offset;
                     assert(size > 0);
@@ -141,6 +377,7 @@ bool StreamConnection::sendPendingMessages()
                     if (err == size)
                     {
                         ++messageSendState.it;
+                        messageSendState.offset = 0;
                     }
                     else if (err > 0)
                     {
@@ -155,17 +392,29 @@ bool StreamConnection::sendPendingMessages()
                 }
                 if (!pending)
                 {
-                    m_pendingMessages.pop_front();
+                    pendingMessages->pop_front();
+                    --m_pendingMessagesCount;
+                    m_priorityInProgress = -1;
+                }
+                else if (messageSendState.it != payloads.begin() || messageSendState.offset > 0)
+                {
+                    m_priorityInProgress = static_cast<int>(pendingMessages - m_pendingMessages);
                 }
             }
             if (!pending)
             {
                 m_poller->disableWrite(m_socketPrivate->getSocketDescriptor());
+                sentNotifications.swap(m_sentNotifications);
             }
         }
     }
     lock.unlock();
 
+    for (size_t i = 0; i < sentNotifications.size(); ++i)
+    {
+        sentNotifications[i]();
+    }
+
     return pending;
 }
 
@@ -235,6 +484,13 @@ bool StreamConnection::changeStateForDisconnect()
         m_socketPrivate = nullptr;
         std::unique_lock<std::mutex> lock(m_mutex);
         m_socket = nullptr;
+        std::vector<std::function<void()>> sentNotifications;
+        sentNotifications.swap(m_sentNotifications);
+        lock.unlock();
+        for (size_t i = 0; i < sentNotifications.size(); ++i)
+        {
+            sentNotifications[i]();
+        }
     }
     return removeConnection;
 }
@@ -246,6 +502,18 @@ bool StreamConnection::getDisconnectFlag() const
 }
 
 
+void StreamConnection::flushOnDeadline(const FlushDeadlines::TimePoint& now)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // the batch of the deadline could already be flushed by a threshold, then the current batch has its own deadline.
+    if (m_coalescingBatch && m_coalescingDeadlineUs > 0 && m_coalescingDeadline <= now)
+    {
+        flushIntern();
+    }
+    lock.unlock();
+}
+
+
 
 void StreamConnection::connected(const IStreamConnectionPtr& connection)
 {
@@ -26,6 +26,7 @@
 
 StreamConnectionContainer::StreamConnectionContainer()
     : m_poller(std::make_shared<PollerImplEpoll>())
+    , m_flushDeadlines(std::make_shared<FlushDeadlines>())
     , m_pollerLoopTerminated(CondVar::CONDVAR_MANUAL)
 {
 }
@@ -276,6 +277,34 @@ IStreamConnectionPtr StreamConnectionContainer::createConnectionSsl(const std::s
 
 
 
+void StreamConnectionContainer::postToPollerLoop(std::function<void()> action)
+{
+    assert(action);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_postedActions.push_back(std::move(action));
+    lock.unlock();
+    m_poller->releaseWait();
+}
+
+
+void StreamConnectionContainer::runPostedActions()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_postedActions.empty())
+    {
+        return;
+    }
+    std::vector<std::function<void()>> actions;
+    actions.swap(m_postedActions);
+    lock.unlock();
+    for (size_t i = 0; i < actions.size(); ++i)
+    {
+        actions[i]();
+    }
+}
+
+
+
 void StreamConnectionContainer::terminatePollerLoop()
 {
     m_terminatePollerLoop = true;
@@ -294,7 +323,7 @@ IStreamConnectionPrivatePtr StreamConnectionContainer::addConnection(const Socke
     std::unique_lock<std::mutex> lock(m_mutex);
     int connectionId = m_nextConnectionId++;
     connectionData.connectionId = connectionId;
-    IStreamConnectionPrivatePtr connection = std::make_shared<StreamConnection>(connectionData, socket, m_poller, callback);
+    IStreamConnectionPrivatePtr connection = std::make_shared<StreamConnection>(connectionData, socket, m_poller, m_flushDeadlines, callback);
     m_connectionId2Connection[connectionId] = connection;
     m_sd2Connection[connectionData.sd] = connection;
     lock.unlock();
@@ -509,6 +538,30 @@ void StreamConnectionContainer::doReconnect()
 
 
 
+void StreamConnectionContainer::flushExpiredDeadlines()
+{
+    FlushDeadlines::TimePoint now = std::chrono::steady_clock::now();
+    std::vector<std::int64_t> connectionIds;
+    m_flushDeadlines->takeExpired(now, connectionIds);
+    for (size_t i = 0; i < connectionIds.size(); ++i)
+    {
+        IStreamConnectionPrivatePtr connection;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto it = m_connectionId2Connection.find(connectionIds[i]);
+        if (it != m_connectionId2Connection.end())
+        {
+            connection = it->second;
+        }
+        lock.unlock();
+        if (connection)
+        {
+            connection->flushOnDeadline(now);
+        }
+    }
+}
+
+
+
 bool StreamConnectionContainer::isReconnectTimerExpired()
 {
     bool expired = false;
@@ -534,7 +587,8 @@ void StreamConnectionContainer::pollerLoop()
     m_lastReconnectTime = std::chrono::system_clock::now();
     while (!m_terminatePollerLoop)
     {
-        const PollerResult& result = m_poller->wait(m_cycleTime);
+        int timeout = m_flushDeadlines->getTimeout(std::chrono::steady_clock::now(), m_cycleTime);
+        const PollerResult& result = m_poller->wait(timeout);
 
         if (result.releaseWait)
         {
@@ -616,6 +670,9 @@ void StreamConnectionContainer::pollerLoop()
             }
         }
 
+        flushExpiredDeadlines();
+        runPostedActions();
+
         if (isReconnectTimerExpired())
         {
             doReconnect();
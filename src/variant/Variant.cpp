@@ -1,4 +1,10 @@
 #include "variant/Variant.h"
+#include "variant/VariantValues.h"
+#include "variant/VariantValueView.h"
+#include "variant/VariantValueStruct.h"
+#include "variant/VariantValueList.h"
+
+#include <vector>
 
 
 Variant::Variant()
@@ -13,7 +19,9 @@ Variant::Variant(std::shared_ptr<IVariantValue> value)
 
 
 Variant::Variant(const Variant& rhs)
-    : m_value((rhs.m_value) ? rhs.m_value->clone() : nullptr)
+    : m_value(rhs.m_value)
+    , m_type(rhs.m_type)
+    , m_inline(rhs.m_inline)
 {
 }
 
@@ -23,21 +31,18 @@ const Variant& Variant::operator =(const Variant& rhs)
     {
         return *this;
     }
-    if (rhs.m_value)
-    {
-        m_value = rhs.m_value->clone();
-    }
-    else
-    {
-        m_value = nullptr;
-    }
+    m_value = rhs.m_value;
+    m_type = rhs.m_type;
+    m_inline = rhs.m_inline;
     return *this;
 }
 
 Variant::Variant(Variant&& rhs)
     : m_value(std::move(rhs.m_value))
+    , m_type(rhs.m_type)
+    , m_inline(rhs.m_inline)
 {
-
+    rhs.m_type = VARTYPE_NONE;
 }
 
 Variant& Variant::operator =(Variant&& rhs)
@@ -47,20 +52,34 @@ Variant& Variant::operator =(Variant&& rhs)
         return *this;
     }
     m_value = std::move(rhs.m_value);
+    m_type = rhs.m_type;
+    m_inline = rhs.m_inline;
+    rhs.m_type = VARTYPE_NONE;
     return *this;
 }
 
 
-void Variant::visit(IVariantVisitor& visitor, int index, int level, int size, const std::string& name)
+void Variant::detach()
 {
+    // a clone of a struct or list shares its sub variants, so only this level is copied
+    if (m_value && m_value.use_count() > 1)
+    {
+        m_value = m_value->clone();
+    }
+}
+
 
+void Variant::visit(IVariantVisitor& visitor, int index, int level, int size, const std::string& name)
+{
+    // the visitor gets non const access to all sub variants
+    detach();
     if (m_value)
     {
         m_value->visit(visitor, *this, index, level, size, name);
     }
     else
     {
-       visitor.enterLeaf(*this, VARTYPE_NONE, index, level, size, name);
+       visitor.enterLeaf(*this, m_type, index, level, size, name);
     }
 }
 
@@ -74,11 +93,38 @@ int Variant::getType() const
     }
     else
     {
-        return VARTYPE_NONE;
+        return m_type;
     }
 }
 
 
+void* Variant::getDataIntern()
+{
+    if (m_value)
+    {
+        return m_value->getData();
+    }
+    else if (m_type != VARTYPE_NONE)
+    {
+        return &m_inline;
+    }
+    return nullptr;
+}
+
+const void* Variant::getDataIntern() const
+{
+    if (m_value)
+    {
+        return static_cast<const IVariantValue*>(m_value.get())->getData();
+    }
+    else if (m_type != VARTYPE_NONE)
+    {
+        return &m_inline;
+    }
+    return nullptr;
+}
+
+
 
 
 Variant* Variant::getVariant(const std::string& name)
@@ -92,13 +138,58 @@ Variant* Variant::getVariant(const std::string& name)
         return nullptr;
     }
 
+    detach();
     return m_value->getVariant(name);
 }
 
 
 const Variant* Variant::getVariant(const std::string& name) const
 {
-    return const_cast<Variant*>(this)->getVariant(name);
+    if (name.empty())
+    {
+        return this;
+    }
+    if (m_value == nullptr)
+    {
+        return nullptr;
+    }
+
+    const IVariantValue& value = *m_value;
+    return value.getVariant(name);
+}
+
+
+Variant* Variant::getVariant(const VariantPath& path)
+{
+    const std::vector<VariantPathEntry>& entries = path.getEntries();
+    Variant* variant = this;
+    for (size_t i = 0; i < entries.size() && variant; ++i)
+    {
+        if (variant->m_value == nullptr)
+        {
+            return nullptr;
+        }
+        variant->detach();
+        variant = variant->m_value->getVariant(entries[i]);
+    }
+    return variant;
+}
+
+
+const Variant* Variant::getVariant(const VariantPath& path) const
+{
+    const std::vector<VariantPathEntry>& entries = path.getEntries();
+    const Variant* variant = this;
+    for (size_t i = 0; i < entries.size() && variant; ++i)
+    {
+        if (variant->m_value == nullptr)
+        {
+            return nullptr;
+        }
+        const IVariantValue& value = *variant->m_value;
+        variant = value.getVariant(entries[i]);
+    }
+    return variant;
 }
 
 
@@ -109,17 +200,46 @@ bool Variant::operator ==(const Variant& rhs) const
         return true;
     }
 
-    if (m_value == rhs.m_value)
+    if (m_value && m_value == rhs.m_value)
     {
         return true;
     }
 
-    if (m_value == nullptr || rhs.m_value == nullptr)
+    if (m_value && rhs.m_value)
     {
-        return false;
+        return *m_value == *rhs.m_value;
     }
 
-    return *m_value == *rhs.m_value;
+    // at least one inline scalar or none
+    int type = getType();
+    if (type != rhs.getType())
+    {
+        return false;
+    }
+    const void* data = getDataIntern();
+    const void* rhsData = rhs.getDataIntern();
+    switch (type)
+    {
+    case VARTYPE_NONE:
+        return true;
+    case TYPE_BOOL:
+        return *static_cast<const bool*>(data) == *static_cast<const bool*>(rhsData);
+    case TYPE_INT32:
+        return *static_cast<const std::int32_t*>(data) == *static_cast<const std::int32_t*>(rhsData);
+    case TYPE_UINT32:
+        return *static_cast<const std::uint32_t*>(data) == *static_cast<const std::uint32_t*>(rhsData);
+    case TYPE_INT64:
+        return *static_cast<const std::int64_t*>(data) == *static_cast<const std::int64_t*>(rhsData);
+    case TYPE_UINT64:
+        return *static_cast<const std::uint64_t*>(data) == *static_cast<const std::uint64_t*>(rhsData);
+    case TYPE_FLOAT:
+        return *static_cast<const float*>(data) == *static_cast<const float*>(rhsData);
+    case TYPE_DOUBLE:
+        return *static_cast<const double*>(data) == *static_cast<const double*>(rhsData);
+    default:
+        assert(false);
+        return false;
+    }
 }
 
 
@@ -128,6 +248,7 @@ bool Variant::add(const std::string& name, const Variant& variant)
 {
     if (m_value)
     {
+        detach();
         return m_value->add(name, variant);
     }
     return false;
@@ -136,6 +257,7 @@ bool Variant::add(const std::string& name, Variant&& variant)
 {
     if (m_value)
     {
+        detach();
         return m_value->add(name, std::move(variant));
     }
     return false;
@@ -145,6 +267,7 @@ bool Variant::add(const Variant& variant)
 {
     if (m_value)
     {
+        detach();
         return m_value->add(variant);
     }
     return false;
@@ -153,6 +276,7 @@ bool Variant::add(Variant&& variant)
 {
     if (m_value)
     {
+        detach();
         return m_value->add(std::move(variant));
     }
     return false;
@@ -164,5 +288,82 @@ int Variant::size() const
     {
         return m_value->size();
     }
-    return 0;
+    return (m_type != VARTYPE_NONE) ? 1 : 0;
+}
+
+
+
+// const traversal, a shared tree is not cloned. Collects the path (entry indexes) of every view.
+static void collectViews(const Variant& variant, std::vector<int>& path, std::vector<std::vector<int>>& paths)
+{
+    int type = variant.getType();
+    if (type == VARTYPE_STRING_VIEW || type == VARTYPE_BYTES_VIEW)
+    {
+        paths.push_back(path);
+    }
+    else if (type == VARTYPE_STRUCT)
+    {
+        const VariantStruct* stru = variant;
+        assert(stru);
+        for (size_t i = 0; i < stru->size(); ++i)
+        {
+            path.push_back(static_cast<int>(i));
+            collectViews((*stru)[i].second, path, paths);
+            path.pop_back();
+        }
+    }
+    else if (type == VARTYPE_LIST)
+    {
+        const VariantList* list = variant;
+        assert(list);
+        for (size_t i = 0; i < list->size(); ++i)
+        {
+            path.push_back(static_cast<int>(i));
+            collectViews((*list)[i], path, paths);
+            path.pop_back();
+        }
+    }
+}
+
+
+void Variant::materialize()
+{
+    std::vector<std::vector<int>> paths;
+    std::vector<int> path;
+    collectViews(*this, path, paths);
+
+    // only the levels on the path to a view are detached. The entries are accessed by the const
+    // data pointer, because only their values are replaced, the positions of struct fields stay valid.
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        Variant* variant = this;
+        for (size_t n = 0; n < paths[i].size(); ++n)
+        {
+            variant->detach();
+            int index = paths[i][n];
+            if (variant->getType() == VARTYPE_STRUCT)
+            {
+                const VariantStruct* stru = *static_cast<const Variant*>(variant);
+                variant = const_cast<Variant*>(&(*stru)[index].second);
+            }
+            else
+            {
+                const VariantList* list = *static_cast<const Variant*>(variant);
+                variant = const_cast<Variant*>(&(*list)[index]);
+            }
+        }
+        const Variant& view = *variant;
+        if (view.getType() == VARTYPE_STRING_VIEW)
+        {
+            const StringView* stringView = view;
+            assert(stringView);
+            *variant = std::string(stringView->data, stringView->size);
+        }
+        else
+        {
+            const BytesView* bytesView = view;
+            assert(bytesView);
+            *variant = Bytes(bytesView->data, bytesView->data + bytesView->size);
+        }
+    }
 }
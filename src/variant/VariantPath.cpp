@@ -0,0 +1,62 @@
+#include "variant/VariantPath.h"
+#include "metadata/MetaData.h"
+
+#include <stdlib.h>
+
+
+
+VariantPath::VariantPath(const std::string& path, const MetaStruct* stru)
+{
+    const MetaStruct* struCurrent = stru;
+    bool listNext = false;
+    size_t pos = 0;
+    while (pos < path.size())
+    {
+        size_t posEnd = path.find('.', pos);
+        if (posEnd == std::string::npos)
+        {
+            posEnd = path.size();
+        }
+
+        VariantPathEntry entry;
+        entry.name = path.substr(pos, posEnd - pos);
+        if (!entry.name.empty() && entry.name.find_first_not_of("0123456789") == std::string::npos)
+        {
+            entry.listIndex = atoi(entry.name.c_str());
+        }
+
+        if (listNext)
+        {
+            // entry of an array of structs, the struct stays the same
+            listNext = false;
+        }
+        else
+        {
+            const MetaField* field = struCurrent ? struCurrent->getFieldByName(entry.name) : nullptr;
+            if (field)
+            {
+                entry.metaStruct = struCurrent;
+                entry.fieldIndex = field->index;
+                struCurrent = nullptr;
+                if (field->typeId == MetaTypeId::TYPE_STRUCT || field->typeId == MetaTypeId::TYPE_ARRAY_STRUCT)
+                {
+                    struCurrent = MetaDataGlobal::instance().getStruct(*field);
+                    listNext = (field->typeId == MetaTypeId::TYPE_ARRAY_STRUCT);
+                }
+            }
+            else
+            {
+                struCurrent = nullptr;
+            }
+        }
+
+        m_entries.push_back(std::move(entry));
+        pos = posEnd + 1;
+    }
+}
+
+
+const std::vector<VariantPathEntry>& VariantPath::getEntries() const
+{
+    return m_entries;
+}
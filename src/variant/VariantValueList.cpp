@@ -58,7 +58,7 @@ VariantList::iterator VariantValueList::find(const std::string& name)
 
 
 
-Variant* VariantValueList::getVariant(const std::string& name)
+Variant* VariantValueList::getSubVariant(const std::string& name, std::string& restname) const
 {
     if (name.empty())
     {
@@ -66,7 +66,6 @@ Variant* VariantValueList::getVariant(const std::string& name)
     }
 
     std::string partname;
-    std::string restname;
 
     //sperate first key ansd second key
     size_t cntp = name.find('.');
@@ -82,24 +81,61 @@ Variant* VariantValueList::getVariant(const std::string& name)
     }
 
     // check if next key is in map (if not -> nullptr)
-    auto it = find(partname);   // auto: std::unordered_map<std::string, Variant>::iterator
+    auto it = const_cast<VariantValueList*>(this)->find(partname);   // auto: std::unordered_map<std::string, Variant>::iterator
     if (it == m_value->end())
     {
         return nullptr;
     }
 
+    return &*it;
+}
+
+
+Variant* VariantValueList::getVariant(const std::string& name)
+{
+    std::string restname;
+    Variant* sub = getSubVariant(name, restname);
+    if (sub == nullptr)
+    {
+        return nullptr;
+    }
+
     // m_value[name].getValue( with remaining name )
-    return it->getVariant(restname);
+    return sub->getVariant(restname);
 }
 
 
 const Variant* VariantValueList::getVariant(const std::string& name) const
 {
-    return const_cast<VariantValueList*>(this)->getVariant(name);
+    std::string restname;
+    const Variant* sub = getSubVariant(name, restname);
+    if (sub == nullptr)
+    {
+        return nullptr;
+    }
+
+    // the const access does not clone shared sub variants
+    return sub->getVariant(restname);
 }
 
 
 
+Variant* VariantValueList::getVariant(const VariantPathEntry& entry)
+{
+    if (entry.listIndex >= 0 && entry.listIndex < static_cast<int>(m_value->size()))
+    {
+        return &(*m_value)[entry.listIndex];
+    }
+    return nullptr;
+}
+
+
+const Variant* VariantValueList::getVariant(const VariantPathEntry& entry) const
+{
+    return const_cast<VariantValueList*>(this)->getVariant(entry);
+}
+
+
 std::shared_ptr<IVariantValue> VariantValueList::clone() const
 {
     return std::make_shared<VariantValueList>(*this);
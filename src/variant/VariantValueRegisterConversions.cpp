@@ -3,6 +3,7 @@
 #include "variant/VariantValueRegisterConversions.h"
 
 #include "variant/VariantValues.h"
+#include "variant/VariantValueView.h"
 #include "conversions/Conversions.h"
 
 
@@ -39,6 +40,48 @@ public:
 };
 
 
+template<class TO>
+class FunctionConvertStringViewToNumber
+{
+public:
+    TO operator ()(const Variant& variant)
+    {
+        assert(variant.getType() == VARTYPE_STRING_VIEW);
+        const StringView* data = variant;
+        assert(data);
+        TO number;
+        string2Number(std::string(data->data, data->size), number);
+        return number;
+    }
+};
+
+
+class FunctionConvertStringViewToString
+{
+public:
+    std::string operator ()(const Variant& variant)
+    {
+        assert(variant.getType() == VARTYPE_STRING_VIEW);
+        const StringView* data = variant;
+        assert(data);
+        return std::string(data->data, data->size);
+    }
+};
+
+
+class FunctionConvertBytesViewToBytes
+{
+public:
+    Bytes operator ()(const Variant& variant)
+    {
+        assert(variant.getType() == VARTYPE_BYTES_VIEW);
+        const BytesView* data = variant;
+        assert(data);
+        return Bytes(data->data, data->data + data->size);
+    }
+};
+
+
 template<class FROM>
 class FunctionConvertNumberToString
 {
@@ -104,5 +147,15 @@ VariantValueRegisterConversions::VariantValueRegisterConversions()
     Convert<std::uint64_t>::registerConversion(MetaTypeId::TYPE_STRING, FunctionConvertStringToNumber<std::uint64_t>());
     Convert<float>::registerConversion(MetaTypeId::TYPE_STRING,         FunctionConvertStringToNumber<float>());
     Convert<double>::registerConversion(MetaTypeId::TYPE_STRING,        FunctionConvertStringToNumber<double>());
+
+    Convert<std::string>::registerConversion(VARTYPE_STRING_VIEW,   FunctionConvertStringViewToString());
+    Convert<Bytes>::registerConversion(VARTYPE_BYTES_VIEW,          FunctionConvertBytesViewToBytes());
+    Convert<bool>::registerConversion(VARTYPE_STRING_VIEW,          FunctionConvertStringViewToNumber<bool>());
+    Convert<std::int32_t>::registerConversion(VARTYPE_STRING_VIEW,  FunctionConvertStringViewToNumber<std::int32_t>());
+    Convert<std::uint32_t>::registerConversion(VARTYPE_STRING_VIEW, FunctionConvertStringViewToNumber<std::uint32_t>());
+    Convert<std::int64_t>::registerConversion(VARTYPE_STRING_VIEW,  FunctionConvertStringViewToNumber<std::int64_t>());
+    Convert<std::uint64_t>::registerConversion(VARTYPE_STRING_VIEW, FunctionConvertStringViewToNumber<std::uint64_t>());
+    Convert<float>::registerConversion(VARTYPE_STRING_VIEW,         FunctionConvertStringViewToNumber<float>());
+    Convert<double>::registerConversion(VARTYPE_STRING_VIEW,        FunctionConvertStringViewToNumber<double>());
 }
 
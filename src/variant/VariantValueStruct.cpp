@@ -1,6 +1,7 @@
 #include "variant/VariantValueStruct.h"
 #include "variant/Variant.h"
 #include <utility>
+#include <algorithm>
 #include <assert.h>
 
 
@@ -8,13 +9,26 @@ VariantValueStruct::VariantValueStruct()
 {
 }
 
+VariantValueStruct::VariantValueStruct(const MetaStruct& metaStruct)
+    : m_value(std::make_unique<VariantStruct>())
+    , m_metaStruct(&metaStruct)
+    , m_positions(metaStruct.getFieldsSize(), -1)
+{
+}
+
 VariantValueStruct::VariantValueStruct(const VariantValueStruct& rhs)
     : m_value(std::make_unique<VariantStruct>(*rhs.m_value))
+    , m_metaStruct(rhs.m_metaStruct)
+    , m_positions(rhs.m_positions)
+    , m_positionsDirty(rhs.m_positionsDirty)
 {
 }
 
 VariantValueStruct::VariantValueStruct(VariantValueStruct&& rhs)
     : m_value(std::move(rhs.m_value))
+    , m_metaStruct(rhs.m_metaStruct)
+    , m_positions(std::move(rhs.m_positions))
+    , m_positionsDirty(rhs.m_positionsDirty)
 {
 }
 
@@ -35,16 +49,73 @@ int VariantValueStruct::getType() const
 
 void* VariantValueStruct::getData()
 {
+    // the entries may be changed by the caller, the positions are updated with the next non const access
+    m_positionsDirty = true;
     return m_value.get();
 }
 
 const void* VariantValueStruct::getData() const
 {
-    return const_cast<VariantValueStruct*>(this)->getData();
+    return m_value.get();
 }
 
 
-VariantStruct::iterator VariantValueStruct::find(const std::string& name)
+void VariantValueStruct::updatePositions()
+{
+    if (m_positionsDirty)
+    {
+        std::fill(m_positions.begin(), m_positions.end(), -1);
+        for (size_t i = 0; i < m_value->size(); ++i)
+        {
+            const MetaField* field = m_metaStruct ? m_metaStruct->getFieldByName((*m_value)[i].first) : nullptr;
+            if (field)
+            {
+                m_positions[field->index] = i;
+            }
+        }
+        m_positionsDirty = false;
+    }
+}
+
+
+// the const find does not write, because the struct may be shared by several threads
+VariantStruct::const_iterator VariantValueStruct::findByIndex(int fieldIndex, const std::string& name) const
+{
+    assert(fieldIndex >= 0 && fieldIndex < static_cast<int>(m_positions.size()));
+    if (m_positionsDirty)
+    {
+        return findLinear(name);
+    }
+    int position = m_positions[fieldIndex];
+    if (position < 0)
+    {
+        return m_value->end();
+    }
+    auto it = m_value->begin() + position;
+    if (position < static_cast<int>(m_value->size()) && it->first == name)
+    {
+        return it;
+    }
+    // the entries were changed by a data pointer, which was taken before the last update
+    return findLinear(name);
+}
+
+
+VariantStruct::const_iterator VariantValueStruct::find(const std::string& name) const
+{
+    if (m_metaStruct)
+    {
+        const MetaField* field = m_metaStruct->getFieldByName(name);
+        if (field)
+        {
+            return findByIndex(field->index, name);
+        }
+    }
+    return findLinear(name);
+}
+
+
+VariantStruct::const_iterator VariantValueStruct::findLinear(const std::string& name) const
 {
     for (auto it = m_value->begin(); it != m_value->end(); ++it)
     {
@@ -57,8 +128,18 @@ VariantStruct::iterator VariantValueStruct::find(const std::string& name)
 }
 
 
+Variant* VariantValueStruct::getEntry(VariantStruct::const_iterator it) const
+{
+    if (it == m_value->end())
+    {
+        return nullptr;
+    }
+    return const_cast<Variant*>(&it->second);
+}
 
-Variant* VariantValueStruct::getVariant(const std::string& name)
+
+
+Variant* VariantValueStruct::getSubVariant(const std::string& name, std::string& restname) const
 {
     if (name.empty())
     {
@@ -66,7 +147,6 @@ Variant* VariantValueStruct::getVariant(const std::string& name)
     }
 
     std::string partname;
-    std::string restname;
 
     //sperate first key ansd second key
     size_t cntp = name.find('.');
@@ -82,20 +162,60 @@ Variant* VariantValueStruct::getVariant(const std::string& name)
     }
 
     // check if next key is in map (if not -> nullptr)
-    auto it = find(partname);   // auto: std::unordered_map<std::string, Variant>::iterator
-    if (it == m_value->end())
+    return getEntry(find(partname));
+}
+
+
+Variant* VariantValueStruct::getVariant(const std::string& name)
+{
+    updatePositions();
+    std::string restname;
+    Variant* sub = getSubVariant(name, restname);
+    if (sub == nullptr)
     {
         return nullptr;
     }
 
     // m_value[name].getValue( with remaining name )
-    return it->second.getVariant(restname);
+    return sub->getVariant(restname);
 }
 
 
 const Variant* VariantValueStruct::getVariant(const std::string& name) const
 {
-    return const_cast<VariantValueStruct*>(this)->getVariant(name);
+    std::string restname;
+    const Variant* sub = getSubVariant(name, restname);
+    if (sub == nullptr)
+    {
+        return nullptr;
+    }
+
+    // the const access does not clone shared sub variants
+    return sub->getVariant(restname);
+}
+
+
+Variant* VariantValueStruct::getVariant(const VariantPathEntry& entry)
+{
+    updatePositions();
+    return getEntry(findEntry(entry));
+}
+
+
+const Variant* VariantValueStruct::getVariant(const VariantPathEntry& entry) const
+{
+    return getEntry(findEntry(entry));
+}
+
+
+VariantStruct::const_iterator VariantValueStruct::findEntry(const VariantPathEntry& entry) const
+{
+    if (m_metaStruct && entry.metaStruct == m_metaStruct)
+    {
+        // resolved path
+        return findByIndex(entry.fieldIndex, entry.name);
+    }
+    return find(entry.name);
 }
 
 
@@ -127,11 +247,26 @@ bool VariantValueStruct::operator ==(const IVariantValue& rhs) const
 
 
 
+void VariantValueStruct::addPosition(const std::string& name)
+{
+    if (m_metaStruct)
+    {
+        const MetaField* field = m_metaStruct->getFieldByName(name);
+        if (field)
+        {
+            m_positions[field->index] = m_value->size();
+        }
+    }
+}
+
+
 bool VariantValueStruct::add(const std::string& name, const Variant& variant)
 {
+    updatePositions();
     auto it = find(name);
     if (it == m_value->end())
     {
+        addPosition(name);
         m_value->push_back(std::make_pair(name, variant));
         return true;
     }
@@ -140,9 +275,11 @@ bool VariantValueStruct::add(const std::string& name, const Variant& variant)
 
 bool VariantValueStruct::add(const std::string& name, Variant&& variant)
 {
+    updatePositions();
     auto it = find(name);
     if (it == m_value->end())
     {
+        addPosition(name);
         m_value->push_back(std::make_pair(name, std::move(variant)));
         return true;
     }
@@ -384,6 +384,42 @@ TEST_F(TestEpoll, testAddSocketWritableWait)
 
 
 
+TEST_F(TestEpoll, testDisableReadKeepsWrite)
+{
+    SocketDescriptorPtr socket = std::make_shared<SocketDescriptor>(TESTSOCKET);
+
+    epoll_event evCtl;
+    evCtl.events = EPOLLIN;
+    evCtl.data.fd = socket->getDescriptor();
+    EXPECT_CALL(*m_mockMockOperatingSystem, epoll_ctl(EPOLL_FD, EPOLL_CTL_ADD, socket->getDescriptor(), Event(&evCtl))).Times(1);
+
+    m_select->addSocket(socket);
+
+    epoll_event evCtlDisableRead;
+    evCtlDisableRead.events = 0;
+    evCtlDisableRead.data.fd = socket->getDescriptor();
+    epoll_event evCtlWrite;
+    evCtlWrite.events = EPOLLOUT;
+    evCtlWrite.data.fd = socket->getDescriptor();
+    epoll_event evCtlEnableRead;
+    evCtlEnableRead.events = EPOLLIN | EPOLLOUT;
+    evCtlEnableRead.data.fd = socket->getDescriptor();
+    {
+        InSequence seq;
+        EXPECT_CALL(*m_mockMockOperatingSystem, epoll_ctl(EPOLL_FD, EPOLL_CTL_MOD, socket->getDescriptor(), Event(&evCtlDisableRead))).Times(1);
+        EXPECT_CALL(*m_mockMockOperatingSystem, epoll_ctl(EPOLL_FD, EPOLL_CTL_MOD, socket->getDescriptor(), Event(&evCtlWrite))).Times(1);
+        EXPECT_CALL(*m_mockMockOperatingSystem, epoll_ctl(EPOLL_FD, EPOLL_CTL_MOD, socket->getDescriptor(), Event(&evCtlEnableRead))).Times(1);
+    }
+
+    m_select->disableRead(socket);
+    // a second disableRead does not change anything
+    m_select->disableRead(socket);
+    m_select->enableWrite(socket);
+    m_select->enableRead(socket);
+}
+
+
+
 TEST_F(TestEpoll, testAddSocketDisableWritableWait)
 {
     SocketDescriptorPtr socket = std::make_shared<SocketDescriptor>(TESTSOCKET);
@@ -0,0 +1,37 @@
+#include "gtest/gtest.h"
+
+
+#include "helpers/Executor.h"
+
+#include <future>
+#include <atomic>
+
+
+
+TEST(TestExecutorWorkerPool, testAddActionDoesNotBlock)
+{
+    static const int KEY = 5;
+    std::atomic<int> counter(0);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    {
+        std::shared_ptr<IExecutor> executor = std::make_shared<ExecutorWorkerPool>(1, 2);
+        EXPECT_EQ(executor->addAction(KEY, [&counter, released] () {
+            released.wait();
+            ++counter;
+        }), true);
+        EXPECT_EQ(executor->addAction(KEY, [&counter] () { ++counter; }), true);
+        // the queue of the key is above its bound, but the action is queued without blocking
+        for (int i = 0; i < 10; ++i)
+        {
+            EXPECT_EQ(executor->addAction(KEY, [&counter] () { ++counter; }), false);
+        }
+        // another key has its own bound
+        EXPECT_EQ(executor->addAction(KEY + 1, [&counter] () { ++counter; }), true);
+        EXPECT_EQ(counter, 0);
+        release.set_value();
+        // the destructor executes the queued actions
+    }
+    EXPECT_EQ(counter, 13);
+}
+
@@ -284,3 +284,365 @@ TEST_F(TestIntegrationConnectionHub, testStopForwardingFromSession)
     std::this_thread::sleep_for(std::chrono::milliseconds(20));
 }
 
+
+
+
+TEST_F(TestIntegrationConnectionHub, testTopicRouting)
+{
+    static const std::string MESSAGE_TEMPERATURE = "sensors/room1/temperature:21";
+    static const std::string MESSAGE_HUMIDITY = "sensors/room1/humidity:50";
+    static const std::string MESSAGE_OTHER = "other:1";
+
+    std::shared_ptr<MockIProtocolSessionCallback> mockServerCallback2 = std::make_shared<MockIProtocolSessionCallback>();
+    auto& expectConnectServer = EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectConnectServer2 = EXPECT_CALL(*mockServerCallback2, connected(_)).Times(1);
+    auto& expectConnectClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+
+    m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    m_sessionContainer->bind("tcp://*:3335", mockServerCallback2, m_factoryProtocol);
+    IProtocolSessionPtr sessionTemperature = m_connectionHub->connect("tcp://localhost:3333", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    IProtocolSessionPtr sessionSensors = m_connectionHub->connect("tcp://localhost:3335", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->bind("tcp://*:3334", m_factoryProtocol);
+    IProtocolSessionPtr session = m_sessionContainer->connect("tcp://localhost:3334", m_mockClientCallback, std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+
+    m_connectionHub->setTopicFunction(TopicFromPayloadPrefix(':'));
+    m_connectionHub->subscribe(sessionTemperature->getSessionId(), "sensors/+/temperature");
+    m_connectionHub->subscribe(sessionSensors->getSessionId(), "sensors/#");
+    m_connectionHub->startMessageForwarding();
+
+    waitTillDone(expectConnectServer, 5000);
+    waitTillDone(expectConnectServer2, 5000);
+    waitTillDone(expectConnectClient, 5000);
+
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE_TEMPERATURE))).Times(1);
+    EXPECT_CALL(*mockServerCallback2, received(_, ReceivedMessage(MESSAGE_TEMPERATURE))).Times(1);
+    auto& expectReceive = EXPECT_CALL(*mockServerCallback2, received(_, ReceivedMessage(MESSAGE_HUMIDITY))).Times(1);
+
+    for (const std::string& payload : {MESSAGE_TEMPERATURE, MESSAGE_OTHER, MESSAGE_HUMIDITY})
+    {
+        IMessagePtr message = session->createMessage();
+        message->addSendPayload(payload);
+        session->sendMessage(message);
+    }
+
+    waitTillDone(expectReceive, 5000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+
+
+TEST_F(TestIntegrationConnectionHub, testPrepareMessageOncePerProtocol)
+{
+    // the sessions do not need to be connected to prepare messages
+    IProtocolSessionPtr session1 = m_sessionContainer->connect("tcp://localhost:3336", m_mockClientCallback, std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    IProtocolSessionPtr session2 = m_sessionContainer->connect("tcp://localhost:3336", m_mockClientCallback, std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    IProtocolSessionPtr session3 = m_sessionContainer->connect("tcp://localhost:3336", m_mockClientCallback, std::make_shared<ProtocolStream>(), 1);
+
+    IMessagePtr message = session3->createMessage();
+    message->addSendPayload(MESSAGE_BUFFER);
+    message->setSequenceNumber(7);
+
+    IMessagePtr prepared1 = session1->prepareMessage(message);
+    IMessagePtr prepared2 = session2->prepareMessage(message);
+    ASSERT_NE(prepared1, nullptr);
+    EXPECT_EQ(prepared1, prepared2);
+    EXPECT_EQ(prepared1->wasSent(), true);
+    EXPECT_EQ(prepared1->getTotalSendBufferSize(), static_cast<int>(MESSAGE_BUFFER.size() + DELIMITER.size()));
+    EXPECT_EQ(prepared1->getProtocolId(), session1->getProtocolId());
+    EXPECT_NE(session1->getProtocolId(), session3->getProtocolId());
+    EXPECT_EQ(prepared1->getSequenceNumber(), 7);
+}
+
+
+
+TEST_F(TestIntegrationConnectionHub, testFanOut)
+{
+    std::shared_ptr<MockIProtocolSessionCallback> mockServerCallback2 = std::make_shared<MockIProtocolSessionCallback>();
+    auto& expectConnectServer = EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(2);
+    auto& expectConnectServer2 = EXPECT_CALL(*mockServerCallback2, connected(_)).Times(1);
+    auto& expectConnectClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+
+    m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    m_sessionContainer->bind("tcp://*:3335", mockServerCallback2, std::make_shared<ProtocolStreamFactory>());
+    m_connectionHub->connect("tcp://localhost:3333", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->connect("tcp://localhost:3333", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->connect("tcp://localhost:3335", std::make_shared<ProtocolStream>(), 1);
+    m_connectionHub->bind("tcp://*:3334", m_factoryProtocol);
+    IProtocolSessionPtr session = m_sessionContainer->connect("tcp://localhost:3334", m_mockClientCallback, std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->startMessageForwarding();
+
+    waitTillDone(expectConnectServer, 5000);
+    waitTillDone(expectConnectServer2, 5000);
+    waitTillDone(expectConnectClient, 5000);
+
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE_BUFFER))).Times(2);
+    auto& expectReceive2 = EXPECT_CALL(*mockServerCallback2, received(_, ReceivedMessage(MESSAGE_BUFFER))).Times(1);
+
+    IMessagePtr message = session->createMessage();
+    message->addSendPayload(MESSAGE_BUFFER);
+    session->sendMessage(message);
+
+    waitTillDone(expectReceive, 5000);
+    waitTillDone(expectReceive2, 5000);
+}
+
+
+
+TEST_F(TestIntegrationConnectionHub, testSlowConsumerDrop)
+{
+    auto& expectConnectClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+
+    // the messages are queued, till the server is bound
+    IProtocolSessionPtr sessionForward = m_connectionHub->connect("tcp://localhost:3333", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->setSlowConsumerPolicy(sessionForward->getSessionId(), SLOWCONSUMER_DROP, 2);
+    m_connectionHub->bind("tcp://*:3334", m_factoryProtocol);
+    IProtocolSessionPtr session = m_sessionContainer->connect("tcp://localhost:3334", m_mockClientCallback, std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->startMessageForwarding();
+
+    waitTillDone(expectConnectClient, 5000);
+
+    for (const char* payload : {"1", "2", "3", "4"})
+    {
+        IMessagePtr message = session->createMessage();
+        message->addSendPayload(payload);
+        session->sendMessage(message);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(sessionForward->getPendingMessages(), 2);
+
+    testing::InSequence seq;
+    auto& expectConnectServer = EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("1"))).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("2"))).Times(1);
+    m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+
+    waitTillDone(expectConnectServer, 5000);
+    waitTillDone(expectReceive, 5000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+
+
+TEST_F(TestIntegrationConnectionHub, testSlowConsumerDisconnect)
+{
+    auto& expectConnectClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+
+    IProtocolSessionPtr sessionForward = m_connectionHub->connect("tcp://localhost:3333", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->setSlowConsumerPolicy(sessionForward->getSessionId(), SLOWCONSUMER_DISCONNECT, 2);
+    m_connectionHub->bind("tcp://*:3334", m_factoryProtocol);
+    IProtocolSessionPtr session = m_sessionContainer->connect("tcp://localhost:3334", m_mockClientCallback, std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->startMessageForwarding();
+
+    waitTillDone(expectConnectClient, 5000);
+
+    for (const char* payload : {"1", "2", "3"})
+    {
+        IMessagePtr message = session->createMessage();
+        message->addSendPayload(payload);
+        session->sendMessage(message);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    EXPECT_EQ(m_connectionHub->getSession(sessionForward->getSessionId()), nullptr);
+}
+
+
+
+TEST_F(TestIntegrationConnectionHub, testSlowConsumerConflate)
+{
+    auto& expectConnectClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+
+    IProtocolSessionPtr sessionForward = m_connectionHub->connect("tcp://localhost:3333", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->setSlowConsumerPolicy(sessionForward->getSessionId(), SLOWCONSUMER_CONFLATE, 0, TopicFromPayloadPrefix(':'));
+    m_connectionHub->bind("tcp://*:3334", m_factoryProtocol);
+    IProtocolSessionPtr session = m_sessionContainer->connect("tcp://localhost:3334", m_mockClientCallback, std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->startMessageForwarding();
+
+    waitTillDone(expectConnectClient, 5000);
+
+    for (const char* payload : {"a:1", "b:1", "a:2", "nokey", "a:3"})
+    {
+        IMessagePtr message = session->createMessage();
+        message->addSendPayload(payload);
+        session->sendMessage(message);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(sessionForward->getPendingMessages(), 3);
+
+    testing::InSequence seq;
+    auto& expectConnectServer = EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("a:3"))).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("b:1"))).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("nokey"))).Times(1);
+    m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+
+    waitTillDone(expectConnectServer, 5000);
+    waitTillDone(expectReceive, 5000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+
+
+TEST_F(TestIntegrationConnectionHub, testForwardSpooledMessages)
+{
+    static const int NUMBER_OF_MESSAGES = 1000;
+
+    auto& expectConnectServer = EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectConnectClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+
+    m_connectionHub->setPreForwardingBuffer(100);
+    m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    m_connectionHub->connect("tcp://localhost:3333", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->bind("tcp://*:3334", m_factoryProtocol);
+    IProtocolSessionPtr session = m_sessionContainer->connect("tcp://localhost:3334", m_mockClientCallback, std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+
+    waitTillDone(expectConnectServer, 5000);
+    waitTillDone(expectConnectClient, 5000);
+
+    testing::InSequence seq;
+    for (int i = 0; i < NUMBER_OF_MESSAGES; ++i)
+    {
+        std::string payload = MESSAGE_BUFFER + std::to_string(i);
+        EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(payload))).Times(1);
+        IMessagePtr message = session->createMessage();
+        message->addSendPayload(payload);
+        session->sendMessage(message);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    m_connectionHub->startMessageForwarding();
+
+    IMessagePtr message = session->createMessage();
+    message->addSendPayload(MESSAGE_BUFFER);
+    auto& expectReceiveLast = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE_BUFFER))).Times(1);
+    session->sendMessage(message);
+
+    waitTillDone(expectReceiveLast, 5000);
+}
+
+
+
+TEST_F(TestIntegrationConnectionHub, testReplayFromJournal)
+{
+    char directory[] = "/tmp/finalmq_journal_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+
+    IProtocolSessionPtr sessionForward;
+    auto& expectConnectServer = EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectConnectClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+
+    m_connectionHub->enableJournal(directory);
+    m_connectionHub->startMessageForwarding();
+    m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    sessionForward = m_connectionHub->connect("tcp://localhost:3333", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->bind("tcp://*:3334", m_factoryProtocol);
+    IProtocolSessionPtr session = m_sessionContainer->connect("tcp://localhost:3334", m_mockClientCallback, std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+
+    waitTillDone(expectConnectServer, 5000);
+    waitTillDone(expectConnectClient, 5000);
+
+    {
+        testing::InSequence seq;
+        EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("1"))).Times(1);
+        EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("2"))).Times(1);
+        auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("3"))).Times(1);
+        for (const char* payload : {"1", "2", "3"})
+        {
+            IMessagePtr message = session->createMessage();
+            message->addSendPayload(payload);
+            session->sendMessage(message);
+        }
+        waitTillDone(expectReceive, 5000);
+    }
+    EXPECT_EQ(m_connectionHub->getLastSequenceNumber(), 3);
+
+    // e.g. the subscriber has seen the first message, before it reconnected
+    testing::Mock::VerifyAndClearExpectations(m_mockServerCallback.get());
+    testing::InSequence seq;
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("2"))).Times(1);
+    auto& expectReplay = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("3"))).Times(1);
+    EXPECT_EQ(m_connectionHub->replayFromJournal(sessionForward->getSessionId(), 2), true);
+    waitTillDone(expectReplay, 5000);
+
+    EXPECT_EQ(m_connectionHub->replayFromJournal(sessionForward->getSessionId(), 5), false);
+    EXPECT_EQ(m_connectionHub->replayFromJournal(12345, 1), false);
+
+    std::string command = std::string("rm -rf ") + directory;
+    EXPECT_EQ(system(command.c_str()), 0);
+}
+
+
+TEST_F(TestIntegrationConnectionHub, testReplayFromJournalRoutedAfterReconnect)
+{
+    char directory[] = "/tmp/finalmq_journal_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+
+    std::shared_ptr<MockIProtocolSessionCallback> mockServerCallback2 = std::make_shared<MockIProtocolSessionCallback>();
+    IProtocolSessionPtr sessionSubscriberServer;
+    auto& expectConnectServer = EXPECT_CALL(*m_mockServerCallback, connected(_)).WillOnce(testing::SaveArg<0>(&sessionSubscriberServer));
+    auto& expectConnectClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+
+    m_connectionHub->enableJournal(directory);
+    m_connectionHub->setTopicFunction(TopicFromPayloadPrefix(':'));
+    m_connectionHub->startMessageForwarding();
+    m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    m_sessionContainer->bind("tcp://*:3335", mockServerCallback2, m_factoryProtocol);
+    IProtocolSessionPtr sessionSubscriber = m_connectionHub->connect("tcp://localhost:3333", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->subscribe(sessionSubscriber->getSessionId(), "a/#");
+    m_connectionHub->bind("tcp://*:3334", m_factoryProtocol);
+    IProtocolSessionPtr session = m_sessionContainer->connect("tcp://localhost:3334", m_mockClientCallback, std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+
+    waitTillDone(expectConnectServer, 5000);
+    waitTillDone(expectConnectClient, 5000);
+
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("a/1:x"))).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage("a/2:z"))).Times(1);
+    for (const char* payload : {"a/1:x", "b/1:y", "a/2:z"})
+    {
+        IMessagePtr message = session->createMessage();
+        message->addSendPayload(payload);
+        session->sendMessage(message);
+    }
+    waitTillDone(expectReceive, 5000);
+
+    // the subscriber publishes a message itself, no other session subscribed it
+    IMessagePtr message = sessionSubscriberServer->createMessage();
+    message->addSendPayload("a/3:own");
+    sessionSubscriberServer->sendMessage(message);
+    for (int i = 0; i < 500 && m_connectionHub->getLastSequenceNumber() < 4; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(m_connectionHub->getLastSequenceNumber(), 4);
+
+    // the subscriber reconnects with a new session
+    auto& expectConnectServer2 = EXPECT_CALL(*mockServerCallback2, connected(_)).Times(1);
+    IProtocolSessionPtr sessionSubscriber2 = m_connectionHub->connect("tcp://localhost:3335", std::make_shared<ProtocolDelimiter>(DELIMITER), 1);
+    m_connectionHub->setSourceId(sessionSubscriber2->getSessionId(), sessionSubscriber->getSessionId());
+    m_connectionHub->subscribe(sessionSubscriber2->getSessionId(), "a/#");
+    waitTillDone(expectConnectServer2, 5000);
+
+    // the replayed messages are routed, the own message is not replayed, the live messages follow once
+    static const int LIVE_MESSAGES = 50;
+    EXPECT_CALL(*m_mockServerCallback, received(_, _)).Times(LIVE_MESSAGES);
+    testing::InSequence seq;
+    EXPECT_CALL(*mockServerCallback2, received(_, ReceivedMessage("a/1:x"))).Times(1);
+    EXPECT_CALL(*mockServerCallback2, received(_, ReceivedMessage("a/2:z"))).Times(1);
+    for (int i = 0; i < LIVE_MESSAGES - 1; ++i)
+    {
+        EXPECT_CALL(*mockServerCallback2, received(_, ReceivedMessage("a/live:" + std::to_string(i)))).Times(1);
+    }
+    auto& expectReplay = EXPECT_CALL(*mockServerCallback2, received(_, ReceivedMessage("a/live:" + std::to_string(LIVE_MESSAGES - 1)))).Times(1);
+
+    EXPECT_EQ(m_connectionHub->replayFromJournal(sessionSubscriber2->getSessionId(), 1), true);
+    for (int i = 0; i < LIVE_MESSAGES; ++i)
+    {
+        IMessagePtr message = session->createMessage();
+        message->addSendPayload("a/live:" + std::to_string(i));
+        session->sendMessage(message);
+    }
+    waitTillDone(expectReplay, 5000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::string command = std::string("rm -rf ") + directory;
+    EXPECT_EQ(system(command.c_str()), 0);
+}
@@ -257,3 +257,158 @@ TEST_F(TestIntegrationProtocolHeaderBinarySize, testSendMultipleMessages)
 
     waitTillDone(expectReceive, 10000);
 }
+
+
+TEST_F(TestIntegrationProtocolHeaderBinarySize, testSendMessageWithHighSizeBytes)
+{
+    // 0x0186a0 and 0xc8: header bytes >= 0x80 must not be sign extended
+    static const std::string MESSAGE_LARGE(100000, 'a');
+    static const std::string MESSAGE_SMALL(200, 'b');
+
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    auto& expectConnectedClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceiveLarge = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE_LARGE))).Times(1);
+    auto& expectReceiveSmall = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE_SMALL))).Times(1);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolHeaderBinarySize>());
+    waitTillDone(expectConnectedClient, 5000);
+
+    IMessagePtr messageLarge = connection->createMessage();
+    messageLarge->addSendPayload(MESSAGE_LARGE);
+    connection->sendMessage(messageLarge);
+    IMessagePtr messageSmall = connection->createMessage();
+    messageSmall->addSendPayload(MESSAGE_SMALL);
+    connection->sendMessage(messageSmall);
+
+    waitTillDone(expectReceiveLarge, 10000);
+    waitTillDone(expectReceiveSmall, 10000);
+}
+
+
+TEST_F(TestIntegrationProtocolHeaderBinarySize, testPriority)
+{
+    static const int NUMBER_BULK = 200;
+    static const std::string MESSAGE_CONTROL = "control";
+
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    std::mutex mutex;
+    int counterReceived = 0;
+    int indexControl = -1;
+    auto& expectConnectedClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, _)).Times(NUMBER_BULK + 1)
+            .WillRepeatedly(testing::Invoke([&mutex, &counterReceived, &indexControl] (const IProtocolSessionPtr& session, const IMessagePtr& message) {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (message->getReceivePayload().second == static_cast<int>(MESSAGE_CONTROL.size()))
+                {
+                    indexControl = counterReceived;
+                }
+                ++counterReceived;
+            }));
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolHeaderBinarySize>());
+    waitTillDone(expectConnectedClient, 5000);
+
+    IMessagePtr messageBulk = connection->createMessage();
+    messageBulk->addSendPayload(std::string(100000, 'b'));
+    for (int i = 0; i < NUMBER_BULK; ++i)
+    {
+        connection->sendMessage(messageBulk, MESSAGEPRIORITY_BULK);
+    }
+    IMessagePtr messageControl = connection->createMessage();
+    messageControl->addSendPayload(MESSAGE_CONTROL);
+    connection->sendMessage(messageControl, MESSAGEPRIORITY_CONTROL);
+
+    waitTillDone(expectReceive, 10000);
+
+    // the control message overtakes the pending bulk messages
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_NE(indexControl, -1);
+    EXPECT_LT(indexControl, NUMBER_BULK);
+}
+
+
+
+TEST_F(TestIntegrationProtocolHeaderBinarySize, testCoalescingDeadline)
+{
+    static const int NUMBER_MESSAGES = 10;
+
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    std::mutex mutex;
+    std::vector<std::string> received;
+    auto& expectConnectedClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, _)).Times(NUMBER_MESSAGES)
+            .WillRepeatedly(testing::Invoke([&mutex, &received] (const IProtocolSessionPtr& session, const IMessagePtr& message) {
+                std::unique_lock<std::mutex> lock(mutex);
+                BufferRef payload = message->getReceivePayload();
+                received.emplace_back(payload.first, payload.second);
+            }));
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolHeaderBinarySize>());
+    connection->setCoalescing(65536, 0, 20000);
+    waitTillDone(expectConnectedClient, 5000);
+
+    for (int i = 0; i < NUMBER_MESSAGES; ++i)
+    {
+        IMessagePtr message = connection->createMessage();
+        message->addSendPayload(std::to_string(i));
+        connection->sendMessage(message);
+    }
+
+    // no flush, the deadline sends the batch
+    waitTillDone(expectReceive, 5000);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_EQ(received.size(), NUMBER_MESSAGES);
+    for (int i = 0; i < NUMBER_MESSAGES; ++i)
+    {
+        EXPECT_EQ(received[i], std::to_string(i));
+    }
+}
+
+
+
+TEST_F(TestIntegrationProtocolHeaderBinarySize, testCoalescingFlush)
+{
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    std::mutex mutex;
+    int counterReceived = 0;
+    auto& expectConnectedClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, _)).Times(7)
+            .WillRepeatedly(testing::Invoke([&mutex, &counterReceived] (const IProtocolSessionPtr& session, const IMessagePtr& message) {
+                std::unique_lock<std::mutex> lock(mutex);
+                ++counterReceived;
+            }));
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolHeaderBinarySize>());
+    // no deadline, the batch is sent after 5 messages or with flush
+    connection->setCoalescing(65536, 5, 0);
+    waitTillDone(expectConnectedClient, 5000);
+
+    for (int i = 0; i < 7; ++i)
+    {
+        IMessagePtr message = connection->createMessage();
+        message->addSendPayload(MESSAGE1_BUFFER);
+        connection->sendMessage(message);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        EXPECT_EQ(counterReceived, 5);
+    }
+
+    connection->flush();
+    waitTillDone(expectReceive, 5000);
+}
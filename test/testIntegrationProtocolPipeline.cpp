@@ -0,0 +1,274 @@
+
+#include "gtest/gtest.h"
+
+
+#include "protocolconnection/ProtocolSessionContainer.h"
+#include "MockIProtocolSessionCallback.h"
+#include "protocols/ProtocolHeaderBinarySize.h"
+#include "protocols/ProtocolDelimiter.h"
+#include "protocols/ProtocolPipeline.h"
+#include "protocols/ProtocolStageChecksum.h"
+#include "protocols/ProtocolStageCompression.h"
+#include "testHelper.h"
+
+#include <thread>
+
+
+using ::testing::_;
+using ::testing::Return;
+
+
+static const std::string MESSAGE1_BUFFER = "Hello";
+
+
+
+class TestIntegrationProtocolPipeline : public testing::Test
+{
+public:
+
+protected:
+    virtual void SetUp()
+    {
+        m_factoryProtocol = std::make_shared<ProtocolPipelineFactory>(std::make_shared<ProtocolHeaderBinarySizeFactory>(),
+                                                                      std::vector<IProtocolStageFactoryPtr>{std::make_shared<ProtocolStageChecksumFactory>()});
+        m_mockClientCallback = std::make_shared<MockIProtocolSessionCallback>();
+        m_mockServerCallback = std::make_shared<MockIProtocolSessionCallback>();
+        m_sessionContainer = std::make_unique<ProtocolSessionContainer>();
+        m_sessionContainer->init(1, 1);
+        IProtocolSessionContainer* sessionContainerRaw = m_sessionContainer.get();
+        m_thread = std::make_unique<std::thread>([sessionContainerRaw] () {
+            sessionContainerRaw->threadEntry();
+        });
+    }
+
+    virtual void TearDown()
+    {
+        EXPECT_EQ(m_sessionContainer->terminatePollerLoop(100), true);
+        m_sessionContainer = nullptr;
+        m_thread->join();
+    }
+
+    std::shared_ptr<IProtocolSessionContainer>              m_sessionContainer;
+    std::shared_ptr<MockIProtocolSessionCallback>           m_mockClientCallback;
+    std::shared_ptr<MockIProtocolSessionCallback>           m_mockServerCallback;
+    std::shared_ptr<IProtocolFactory>                       m_factoryProtocol;
+
+    std::unique_ptr<std::thread>                            m_thread;
+
+};
+
+
+MATCHER_P(ReceivedMessage, msg, "")
+{
+    BufferRef buffer = arg->getReceivePayload();
+    std::string str(buffer.first, buffer.second);
+    return str == msg;
+}
+
+
+TEST_F(TestIntegrationProtocolPipeline, testBindConnect)
+{
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    IProtocolSessionPtr connConnect;
+    EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1)
+                                            .WillOnce(testing::SaveArg<0>(&connConnect));
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(1);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, m_factoryProtocol->createProtocol());
+    IMessagePtr message = connection->createMessage();
+    message->addSendPayload(MESSAGE1_BUFFER);
+    connection->sendMessage(message);
+
+    waitTillDone(expectReceive, 5000);
+
+    EXPECT_EQ(connConnect, connection);
+
+    // the payload of the sent message is not touched by the stages
+    const std::list<BufferRef>& payloads = message->getAllSendPayloads();
+    ASSERT_EQ(payloads.size(), 1);
+    EXPECT_EQ(std::string(payloads.begin()->first, payloads.begin()->second), MESSAGE1_BUFFER);
+    EXPECT_EQ(message->getTotalSendBufferSize(), 4 + MESSAGE1_BUFFER.size() + 4);
+}
+
+
+TEST_F(TestIntegrationProtocolPipeline, testDelimiterFraming)
+{
+    m_factoryProtocol = std::make_shared<ProtocolPipelineFactory>(std::make_shared<ProtocolDelimiterFactory>("\n"),
+                                                                  std::vector<IProtocolStageFactoryPtr>{});
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(1);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, m_factoryProtocol->createProtocol());
+    IMessagePtr message = connection->createMessage();
+    message->addSendPayload(MESSAGE1_BUFFER);
+    connection->sendMessage(message);
+
+    waitTillDone(expectReceive, 5000);
+}
+
+
+TEST_F(TestIntegrationProtocolPipeline, testSendMultipleMessages)
+{
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    IProtocolSessionPtr connConnect;
+    auto& expectConnectedClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1)
+                                            .WillOnce(testing::SaveArg<0>(&connConnect));
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(10000);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, m_factoryProtocol->createProtocol());
+    IMessagePtr message = connection->createMessage();
+    message->addSendPayload(MESSAGE1_BUFFER);
+
+    for (int i = 0; i < 10000; ++i)
+    {
+        connection->sendMessage(message);
+    }
+    waitTillDone(expectConnectedClient, 5000);
+    EXPECT_EQ(connConnect, connection);
+
+    waitTillDone(expectReceive, 10000);
+}
+
+
+TEST_F(TestIntegrationProtocolPipeline, testCompression)
+{
+    m_factoryProtocol = std::make_shared<ProtocolPipelineFactory>(std::make_shared<ProtocolHeaderBinarySizeFactory>(),
+                                                                  std::vector<IProtocolStageFactoryPtr>{std::make_shared<ProtocolStageCompressionFactory>(COMPRESSION_ZLIB, 16),
+                                                                                                        std::make_shared<ProtocolStageChecksumFactory>()});
+    std::string messageLarge;
+    for (int i = 0; i < 100; ++i)
+    {
+        messageLarge += "{\"value\":\"Hello\",\"number\":123}";
+    }
+
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceiveSmall = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(1);
+    auto& expectReceiveLarge = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(messageLarge))).Times(1);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, m_factoryProtocol->createProtocol());
+    IMessagePtr message = connection->createMessage();
+    message->addSendPayload(MESSAGE1_BUFFER);
+    connection->sendMessage(message);
+    IMessagePtr messageCompressed = connection->createMessage();
+    messageCompressed->addSendPayload(messageLarge);
+    connection->sendMessage(messageCompressed);
+
+    waitTillDone(expectReceiveSmall, 5000);
+    waitTillDone(expectReceiveLarge, 5000);
+
+    // header + flags + payload + checksum
+    EXPECT_EQ(message->getTotalSendBufferSize(), 4 + 1 + MESSAGE1_BUFFER.size() + 4);
+    EXPECT_LT(messageCompressed->getTotalSendBufferSize(), static_cast<int>(messageLarge.size() / 8));
+}
+
+
+TEST(TestProtocolStageCompression, testThresholdAndDictionary)
+{
+    std::string data;
+    for (int i = 0; i < 20; ++i)
+    {
+        data += "{\"symbol\":\"ABC\",\"price\":" + std::to_string(i) + "}";
+    }
+    std::shared_ptr<const std::string> dictionary = std::make_shared<const std::string>("{\"symbol\":\"ABC\",\"price\":");
+    std::shared_ptr<const std::string> dictionaryOther = std::make_shared<const std::string>("{\"symbol\":\"XYZ\",\"volume\":");
+
+    IProtocolStagePtr stageSmall = std::make_shared<ProtocolStageCompression>(COMPRESSION_ZLIB, 10000);
+    std::string payload = data;
+    stageSmall->encode(payload);
+    EXPECT_EQ(payload.size(), data.size() + 1);
+    EXPECT_EQ(payload[0], 0);
+    EXPECT_EQ(stageSmall->decode(payload), true);
+    EXPECT_EQ(payload, data);
+
+    IProtocolStagePtr stageNoDictionary = std::make_shared<ProtocolStageCompression>(COMPRESSION_ZLIB, 0);
+    std::string payloadNoDictionary = data;
+    stageNoDictionary->encode(payloadNoDictionary);
+
+    IProtocolStagePtr stage = std::make_shared<ProtocolStageCompression>(COMPRESSION_ZLIB, 0, dictionary);
+    payload = data;
+    stage->encode(payload);
+    EXPECT_EQ(payload[0], COMPRESSION_ZLIB | 0x10);
+    EXPECT_LT(payload.size(), payloadNoDictionary.size());
+
+    std::string payloadOtherDictionary = payload;
+    IProtocolStagePtr stageOther = std::make_shared<ProtocolStageCompression>(COMPRESSION_ZLIB, 0, dictionaryOther);
+    EXPECT_EQ(stageOther->decode(payloadOtherDictionary), false);
+
+    IProtocolStagePtr stageReceiver = std::make_shared<ProtocolStageCompression>(COMPRESSION_ZLIB, 0, dictionary);
+    EXPECT_EQ(stageReceiver->decode(payload), true);
+    EXPECT_EQ(payload, data);
+    EXPECT_EQ(stageReceiver->decode(payloadNoDictionary), true);
+    EXPECT_EQ(payloadNoDictionary, data);
+
+    std::string payloadCorrupt = "\x01\x10\x00\x00\x00garbage";
+    EXPECT_EQ(stageReceiver->decode(payloadCorrupt), false);
+}
+
+
+TEST(TestProtocolStageCompression, testDecodedSizeLimits)
+{
+    std::string data(100000, 'a');
+    IProtocolStagePtr stage = std::make_shared<ProtocolStageCompression>(COMPRESSION_ZLIB, 0);
+    std::string payload = data;
+    stage->encode(payload);
+    ASSERT_EQ(payload[0], COMPRESSION_ZLIB);
+
+    std::string payloadOk = payload;
+    EXPECT_EQ(stage->decode(payloadOk), true);
+    EXPECT_EQ(payloadOk, data);
+
+    // the decoded size is larger than the maximum
+    IProtocolStagePtr stageSmall = std::make_shared<ProtocolStageCompression>(COMPRESSION_ZLIB, 0, nullptr, -1, 50000);
+    std::string payloadTooLarge = payload;
+    EXPECT_EQ(stageSmall->decode(payloadTooLarge), false);
+
+    // the ratio of decoded to compressed size is too high
+    IProtocolStagePtr stageRatio = std::make_shared<ProtocolStageCompression>(COMPRESSION_ZLIB, 0, nullptr, -1, ProtocolStageCompression::DEFAULT_MAX_DECODED_SIZE, 10);
+    std::string payloadRatio = payload;
+    EXPECT_EQ(stageRatio->decode(payloadRatio), false);
+
+    // a 9 byte frame that announces 2 GB
+    std::string payloadHuge("\x01\xff\xff\xff\x7f" "abcd", 9);
+    EXPECT_EQ(stage->decode(payloadHuge), false);
+}
+
+
+TEST(TestProtocolStageChecksum, testCorruptPayload)
+{
+    IProtocolStageFactoryPtr factory = std::make_shared<ProtocolStageChecksumFactory>();
+    IProtocolStagePtr stage = factory->createStage();
+    std::string payload = MESSAGE1_BUFFER;
+    stage->encode(payload);
+    EXPECT_EQ(payload.size(), MESSAGE1_BUFFER.size() + 4);
+
+    std::string payloadOk = payload;
+    EXPECT_EQ(stage->decode(payloadOk), true);
+    EXPECT_EQ(payloadOk, MESSAGE1_BUFFER);
+
+    std::string payloadCorrupt = payload;
+    payloadCorrupt[1] ^= 0x10;
+    EXPECT_EQ(stage->decode(payloadCorrupt), false);
+
+    std::string payloadShort = "ab";
+    EXPECT_EQ(stage->decode(payloadShort), false);
+}
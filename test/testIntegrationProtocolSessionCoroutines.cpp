@@ -0,0 +1,182 @@
+
+#include "gtest/gtest.h"
+
+#include "protocolconnection/ProtocolSessionCoroutines.h"
+
+// the coroutine layer is only available with C++20
+#if defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)
+
+#include "protocols/ProtocolHeaderBinarySize.h"
+#include "helpers/CondVar.h"
+
+#include <thread>
+
+
+
+
+class TestIntegrationProtocolSessionCoroutines : public testing::Test
+{
+public:
+
+protected:
+    virtual void SetUp()
+    {
+        m_sessionContainer = std::make_shared<ProtocolSessionContainer>();
+        m_sessionContainer->init(1, 1);
+        IProtocolSessionContainer* sessionContainerRaw = m_sessionContainer.get();
+        m_thread = std::make_unique<std::thread>([sessionContainerRaw] () {
+            sessionContainerRaw->threadEntry();
+        });
+        m_coroutines = std::make_shared<ProtocolSessionCoroutines>(m_sessionContainer);
+    }
+
+    virtual void TearDown()
+    {
+        EXPECT_EQ(m_sessionContainer->terminatePollerLoop(100), true);
+        m_thread->join();
+        m_coroutines = nullptr;
+        m_sessionContainer = nullptr;
+    }
+
+    std::shared_ptr<IProtocolSessionContainer>              m_sessionContainer;
+    std::shared_ptr<ProtocolSessionCoroutines>              m_coroutines;
+    std::unique_ptr<std::thread>                            m_thread;
+};
+
+
+
+static SessionTask echoServer(ProtocolSessionCoroutines& coroutines)
+{
+    IProtocolSessionPtr session = co_await coroutines.accept();
+    while (IMessagePtr request = co_await coroutines.receive(session))
+    {
+        BufferRef payload = request->getReceivePayload();
+        IMessagePtr reply = session->createMessage();
+        reply->addSendPayload(payload.first, payload.second);
+        session->sendMessage(reply);
+    }
+}
+
+static SessionTask client(ProtocolSessionCoroutines& coroutines, int numberOfRequests, std::vector<std::string>& replies, CondVar& done)
+{
+    IProtocolSessionPtr session = co_await coroutines.connect("tcp://localhost:3333", std::make_shared<ProtocolHeaderBinarySize>());
+    if (session)
+    {
+        // pipeline all requests, then collect the replies
+        for (int i = 0; i < numberOfRequests; ++i)
+        {
+            IMessagePtr request = session->createMessage();
+            request->addSendPayload(std::to_string(i));
+            session->sendMessage(request);
+        }
+        for (int i = 0; i < numberOfRequests; ++i)
+        {
+            IMessagePtr reply = co_await coroutines.receive(session);
+            if (!reply)
+            {
+                break;
+            }
+            BufferRef payload = reply->getReceivePayload();
+            replies.emplace_back(payload.first, payload.second);
+        }
+        co_await coroutines.sleepFor(std::chrono::milliseconds(10));
+    }
+    done = true;
+}
+
+
+
+TEST_F(TestIntegrationProtocolSessionCoroutines, testRequestReply)
+{
+    static const int NUMBER_REQUESTS = 20;
+
+    int res = m_sessionContainer->bind("tcp://*:3333", m_coroutines, std::make_shared<ProtocolHeaderBinarySizeFactory>());
+    EXPECT_EQ(res, 0);
+
+    echoServer(*m_coroutines);
+
+    std::vector<std::string> replies;
+    CondVar done;
+    client(*m_coroutines, NUMBER_REQUESTS, replies, done);
+
+    EXPECT_EQ(done.wait(5000), true);
+    ASSERT_EQ(replies.size(), NUMBER_REQUESTS);
+    for (int i = 0; i < NUMBER_REQUESTS; ++i)
+    {
+        EXPECT_EQ(replies[i], std::to_string(i));
+    }
+}
+
+
+
+static SessionTask sender(ProtocolSessionCoroutines& coroutines, int numberOfMessages, int sizeMessage, bool& allSent, CondVar& done)
+{
+    IProtocolSessionPtr session = co_await coroutines.connect("tcp://localhost:3334", std::make_shared<ProtocolHeaderBinarySize>());
+    allSent = (session != nullptr);
+    for (int i = 0; i < numberOfMessages && session; ++i)
+    {
+        IMessagePtr message = session->createMessage();
+        message->addSendPayload(std::string(sizeMessage, 'a' + (i % 26)));
+        // resumes, when the message is written to the socket
+        if (!co_await coroutines.sendMessage(session, message))
+        {
+            allSent = false;
+            break;
+        }
+        if (session->getPendingMessages() != 0)
+        {
+            allSent = false;
+        }
+    }
+    done = true;
+}
+
+static SessionTask slowReceiver(ProtocolSessionCoroutines& coroutines, int numberOfMessages, std::vector<int>& sizes, CondVar& done)
+{
+    IProtocolSessionPtr session = co_await coroutines.accept();
+    // the messages queue up, till the receiver starts
+    co_await coroutines.sleepFor(std::chrono::milliseconds(300));
+    for (int i = 0; i < numberOfMessages; ++i)
+    {
+        IMessagePtr message = co_await coroutines.receive(session);
+        if (!message)
+        {
+            break;
+        }
+        sizes.push_back(message->getReceivePayload().second);
+    }
+    done = true;
+}
+
+
+
+TEST_F(TestIntegrationProtocolSessionCoroutines, testSendMessageAndQueueBound)
+{
+    static const int NUMBER_MESSAGES = 200;
+    static const int SIZE_MESSAGE = 10000;
+
+    // only a few messages are queued for the receiver, then the session stops reading from its socket
+    std::shared_ptr<ProtocolSessionCoroutines> coroutines = std::make_shared<ProtocolSessionCoroutines>(m_sessionContainer, 4);
+    int res = m_sessionContainer->bind("tcp://*:3334", coroutines, std::make_shared<ProtocolHeaderBinarySizeFactory>());
+    EXPECT_EQ(res, 0);
+
+    std::vector<int> sizes;
+    CondVar doneReceive;
+    slowReceiver(*coroutines, NUMBER_MESSAGES, sizes, doneReceive);
+
+    bool allSent = false;
+    CondVar doneSend;
+    sender(*coroutines, NUMBER_MESSAGES, SIZE_MESSAGE, allSent, doneSend);
+
+    EXPECT_EQ(doneReceive.wait(10000), true);
+    EXPECT_EQ(doneSend.wait(10000), true);
+    EXPECT_EQ(allSent, true);
+    ASSERT_EQ(sizes.size(), NUMBER_MESSAGES);
+    for (int i = 0; i < NUMBER_MESSAGES; ++i)
+    {
+        EXPECT_EQ(sizes[i], SIZE_MESSAGE);
+    }
+    m_sessionContainer->unbind("tcp://*:3334");
+}
+
+#endif
@@ -0,0 +1,115 @@
+
+#include "gtest/gtest.h"
+
+
+#include "protocolconnection/ProtocolSessionContainer.h"
+#include "MockIProtocolSessionCallback.h"
+#include "protocols/ProtocolHeaderBinarySize.h"
+#include "helpers/Executor.h"
+#include "testHelper.h"
+
+#include <thread>
+#include <unordered_map>
+
+
+using ::testing::_;
+using ::testing::Return;
+
+
+
+
+class TestIntegrationProtocolSessionExecutor : public testing::Test
+{
+public:
+
+protected:
+    virtual void SetUp()
+    {
+        m_factoryProtocol = std::make_shared<ProtocolHeaderBinarySizeFactory>();
+        m_mockClientCallback = std::make_shared<MockIProtocolSessionCallback>();
+        m_mockServerCallback = std::make_shared<MockIProtocolSessionCallback>();
+        m_sessionContainer = std::make_unique<ProtocolSessionContainer>();
+        m_sessionContainer->init(1, 1, std::make_shared<ExecutorWorkerPool>(4, 10));
+        IProtocolSessionContainer* sessionContainerRaw = m_sessionContainer.get();
+        m_thread = std::make_unique<std::thread>([sessionContainerRaw] () {
+            sessionContainerRaw->threadEntry();
+        });
+    }
+
+    virtual void TearDown()
+    {
+        EXPECT_EQ(m_sessionContainer->terminatePollerLoop(100), true);
+        m_sessionContainer = nullptr;
+        m_thread->join();
+    }
+
+    std::shared_ptr<IProtocolSessionContainer>              m_sessionContainer;
+    std::shared_ptr<MockIProtocolSessionCallback>           m_mockClientCallback;
+    std::shared_ptr<MockIProtocolSessionCallback>           m_mockServerCallback;
+    std::shared_ptr<IProtocolFactory>                       m_factoryProtocol;
+
+    std::unique_ptr<std::thread>                            m_thread;
+};
+
+
+
+
+TEST_F(TestIntegrationProtocolSessionExecutor, testOrderPerSession)
+{
+    static const int NUMBER_CLIENTS = 3;
+    static const int NUMBER_MESSAGES = 100;
+
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    std::mutex mutex;
+    std::unordered_map<std::int64_t, std::vector<int>> received;
+    bool calledByPollerThread = false;
+    std::thread::id pollerThreadId = m_thread->get_id();
+    auto& expectConnectedClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(NUMBER_CLIENTS);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(NUMBER_CLIENTS);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, _)).Times(NUMBER_CLIENTS * NUMBER_MESSAGES)
+            .WillRepeatedly(testing::Invoke([&] (const IProtocolSessionPtr& session, const IMessagePtr& message) {
+                // slow handler, the queues of the workers run full
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                BufferRef payload = message->getReceivePayload();
+                std::unique_lock<std::mutex> lock(mutex);
+                received[session->getSessionId()].push_back(std::stoi(std::string(payload.first, payload.second)));
+                if (std::this_thread::get_id() == pollerThreadId)
+                {
+                    calledByPollerThread = true;
+                }
+            }));
+
+    std::vector<IProtocolSessionPtr> connections;
+    for (int i = 0; i < NUMBER_CLIENTS; ++i)
+    {
+        connections.push_back(m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolHeaderBinarySize>()));
+    }
+    waitTillDone(expectConnectedClient, 5000);
+
+    for (int n = 0; n < NUMBER_MESSAGES; ++n)
+    {
+        for (int i = 0; i < NUMBER_CLIENTS; ++i)
+        {
+            IMessagePtr message = connections[i]->createMessage();
+            message->addSendPayload(std::to_string(n));
+            connections[i]->sendMessage(message);
+        }
+    }
+
+    waitTillDone(expectReceive, 10000);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_EQ(calledByPollerThread, false);
+    ASSERT_EQ(received.size(), NUMBER_CLIENTS);
+    for (auto it = received.begin(); it != received.end(); ++it)
+    {
+        const std::vector<int>& numbers = it->second;
+        ASSERT_EQ(numbers.size(), NUMBER_MESSAGES);
+        for (int n = 0; n < NUMBER_MESSAGES; ++n)
+        {
+            EXPECT_EQ(numbers[n], n);
+        }
+    }
+}
@@ -0,0 +1,267 @@
+
+#include "gtest/gtest.h"
+
+
+#include "protocolconnection/ProtocolSessionContainer.h"
+#include "MockIProtocolSessionCallback.h"
+#include "protocols/ProtocolVarintSize.h"
+#include "protocolconnection/ProtocolMessage.h"
+#include "testHelper.h"
+
+#include <thread>
+
+
+using ::testing::_;
+using ::testing::Return;
+
+
+static const std::string MESSAGE1_BUFFER = "Hello";
+static const std::string MESSAGE2_BUFFER = "World";
+
+
+
+class TestIntegrationProtocolVarintSize : public testing::Test
+{
+public:
+
+protected:
+    virtual void SetUp()
+    {
+        m_factoryProtocol = std::make_shared<ProtocolVarintSizeFactory>();
+        m_mockClientCallback = std::make_shared<MockIProtocolSessionCallback>();
+        m_mockServerCallback = std::make_shared<MockIProtocolSessionCallback>();
+        m_sessionContainer = std::make_unique<ProtocolSessionContainer>();
+        m_sessionContainer->init(1, 1);
+        IProtocolSessionContainer* sessionContainerRaw = m_sessionContainer.get();
+        m_thread = std::make_unique<std::thread>([sessionContainerRaw] () {
+            sessionContainerRaw->threadEntry();
+        });
+    }
+
+    virtual void TearDown()
+    {
+        EXPECT_EQ(m_sessionContainer->terminatePollerLoop(100), true);
+        m_sessionContainer = nullptr;
+        m_thread->join();
+    }
+
+    std::shared_ptr<IProtocolSessionContainer>              m_sessionContainer;
+    std::shared_ptr<MockIProtocolSessionCallback>           m_mockClientCallback;
+    std::shared_ptr<MockIProtocolSessionCallback>           m_mockServerCallback;
+    std::shared_ptr<IProtocolFactory>                       m_factoryProtocol;
+
+    std::unique_ptr<std::thread>                            m_thread;
+
+};
+
+
+MATCHER_P(ReceivedMessage, msg, "")
+{
+    BufferRef buffer = arg->getReceivePayload();
+    std::string str(buffer.first, buffer.second);
+    return str == msg;
+}
+
+
+TEST_F(TestIntegrationProtocolVarintSize, testBindConnect)
+{
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    IProtocolSessionPtr connConnect;
+    EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1)
+                                            .WillOnce(testing::SaveArg<0>(&connConnect));
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(1);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolVarintSize>());
+    IMessagePtr message = connection->createMessage();
+    message->addSendPayload(MESSAGE1_BUFFER);
+    connection->sendMessage(message);
+
+    waitTillDone(expectReceive, 5000);
+
+    EXPECT_EQ(connConnect, connection);
+
+    // one byte header in the same buffer as the payload
+    EXPECT_EQ(message->getAllSendBuffers().size(), 1);
+    EXPECT_EQ(message->getTotalSendBufferSize(), 1 + MESSAGE1_BUFFER.size());
+}
+
+
+TEST_F(TestIntegrationProtocolVarintSize, testLargeMessages)
+{
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    std::string message200(200, 'a');
+    std::string message100000(100000, 'b');
+
+    EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive200 = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(message200))).Times(10);
+    auto& expectReceive100000 = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(message100000))).Times(10);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolVarintSize>());
+    IMessagePtr messageA = connection->createMessage();
+    messageA->addSendPayload(message200);
+    IMessagePtr messageB = connection->createMessage();
+    messageB->addSendPayload(message100000);
+    for (int i = 0; i < 10; ++i)
+    {
+        connection->sendMessage(messageA);
+        connection->sendMessage(messageB);
+    }
+
+    waitTillDone(expectReceive200, 5000);
+    waitTillDone(expectReceive100000, 5000);
+
+    EXPECT_EQ(messageA->getTotalSendBufferSize(), 2 + 200);
+    EXPECT_EQ(messageB->getTotalSendBufferSize(), 3 + 100000);
+}
+
+
+TEST_F(TestIntegrationProtocolVarintSize, testBatch)
+{
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    testing::Sequence sequence;
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(1).InSequence(sequence);
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE2_BUFFER))).Times(1).InSequence(sequence);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(1).InSequence(sequence);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolVarintSize>());
+    IMessagePtr message1 = connection->createMessage();
+    message1->addSendPayload(MESSAGE1_BUFFER);
+    IMessagePtr message2 = connection->createMessage();
+    message2->addSendPayload(MESSAGE2_BUFFER);
+    IMessagePtr batch = ProtocolVarintSize::createBatchMessage({message1, message2});
+    ASSERT_NE(batch, nullptr);
+    // batch marker + size + 2 * (size + payload)
+    EXPECT_EQ(batch->getTotalSendBufferSize(), 2 + 2 * (1 + 5));
+    connection->sendMessage(batch);
+    connection->sendMessage(message1);
+
+    waitTillDone(expectReceive, 5000);
+}
+
+
+TEST_F(TestIntegrationProtocolVarintSize, testEmptyMessage)
+{
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    testing::Sequence sequence;
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(1).InSequence(sequence);
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(""))).Times(1).InSequence(sequence);
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE2_BUFFER))).Times(1).InSequence(sequence);
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(""))).Times(1).InSequence(sequence);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(1).InSequence(sequence);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolVarintSize>());
+    IMessagePtr message1 = connection->createMessage();
+    message1->addSendPayload(MESSAGE1_BUFFER);
+    IMessagePtr messageEmpty = connection->createMessage();
+    IMessagePtr message2 = connection->createMessage();
+    message2->addSendPayload(MESSAGE2_BUFFER);
+    connection->sendMessage(message1);
+    connection->sendMessage(messageEmpty);
+    connection->sendMessage(message2);
+    // an empty message inside of a batch
+    IMessagePtr batch = ProtocolVarintSize::createBatchMessage({connection->createMessage(), message1});
+    ASSERT_NE(batch, nullptr);
+    connection->sendMessage(batch);
+
+    waitTillDone(expectReceive, 5000);
+}
+
+
+TEST_F(TestIntegrationProtocolVarintSize, testPayloadReference)
+{
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(1);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolVarintSize>());
+    std::shared_ptr<std::string> buffer = std::make_shared<std::string>(MESSAGE1_BUFFER);
+    IMessagePtr message = std::make_shared<ProtocolMessage>(0);
+    message->addSendPayloadReference(buffer->data(), buffer->size(), buffer);
+    EXPECT_EQ(std::string(message->getReceivePayload().first, message->getReceivePayload().second), MESSAGE1_BUFFER);
+    connection->sendMessage(message);
+
+    waitTillDone(expectReceive, 5000);
+
+    // the message of the protocol sends the referenced payload, the header is in an own buffer
+    IMessagePtr messageProtocol = message->getMessage(ProtocolVarintSize::PROTOCOL_ID);
+    ASSERT_NE(messageProtocol, nullptr);
+    EXPECT_EQ(messageProtocol->getSendPayloadOwner(), buffer);
+    ASSERT_EQ(messageProtocol->getAllSendBuffers().size(), 2);
+    EXPECT_EQ(messageProtocol->getAllSendBuffers().back().first, buffer->data());
+    EXPECT_EQ(messageProtocol->getTotalSendBufferSize(), 1 + MESSAGE1_BUFFER.size());
+}
+
+
+TEST_F(TestIntegrationProtocolVarintSize, testMaxFrameSize)
+{
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, std::make_shared<ProtocolVarintSizeFactory>(100));
+    EXPECT_EQ(res, 0);
+
+    std::string message200(200, 'a');
+
+    EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(message200))).Times(0);
+    EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE2_BUFFER))).Times(0);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolVarintSize>());
+    IMessagePtr message1 = connection->createMessage();
+    message1->addSendPayload(MESSAGE1_BUFFER);
+    connection->sendMessage(message1);
+    waitTillDone(expectReceive, 5000);
+
+    // the frame is too large, the stream is dropped from there on
+    IMessagePtr messageLarge = connection->createMessage();
+    messageLarge->addSendPayload(message200);
+    IMessagePtr message2 = connection->createMessage();
+    message2->addSendPayload(MESSAGE2_BUFFER);
+    connection->sendMessage(messageLarge);
+    connection->sendMessage(message2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+
+TEST_F(TestIntegrationProtocolVarintSize, testSendMultipleMessages)
+{
+    int res = m_sessionContainer->bind("tcp://*:3333", m_mockServerCallback, m_factoryProtocol);
+    EXPECT_EQ(res, 0);
+
+    IProtocolSessionPtr connConnect;
+    auto& expectConnectedClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1)
+                                            .WillOnce(testing::SaveArg<0>(&connConnect));
+    EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+    auto& expectReceive = EXPECT_CALL(*m_mockServerCallback, received(_, ReceivedMessage(MESSAGE1_BUFFER))).Times(10000);
+
+    IProtocolSessionPtr connection = m_sessionContainer->connect("tcp://localhost:3333", m_mockClientCallback, std::make_shared<ProtocolVarintSize>());
+    IMessagePtr message = connection->createMessage();
+    message->addSendPayload(MESSAGE1_BUFFER);
+
+    for (int i = 0; i < 10000; ++i)
+    {
+        connection->sendMessage(message);
+    }
+    waitTillDone(expectConnectedClient, 5000);
+    EXPECT_EQ(connConnect, connection);
+
+    waitTillDone(expectReceive, 10000);
+}
@@ -0,0 +1,151 @@
+
+#include "gtest/gtest.h"
+
+
+#include "protocolconnection/ProtocolSessionContainer.h"
+#include "protocolconnection/RequestReply.h"
+#include "MockIRequestReplyCallback.h"
+#include "protocols/ProtocolHeaderBinarySize.h"
+#include "helpers/CondVar.h"
+#include "testHelper.h"
+
+#include <thread>
+
+
+using ::testing::_;
+using ::testing::Return;
+
+
+
+
+class TestIntegrationRequestReply : public testing::Test
+{
+public:
+
+protected:
+    virtual void SetUp()
+    {
+        m_mockClientCallback = std::make_shared<MockIRequestReplyCallback>();
+        m_mockServerCallback = std::make_shared<MockIRequestReplyCallback>();
+        m_requestReplyClient = std::make_shared<RequestReply>(m_mockClientCallback);
+        m_requestReplyServer = std::make_shared<RequestReply>(m_mockServerCallback);
+        m_sessionContainer = std::make_unique<ProtocolSessionContainer>();
+        m_sessionContainer->init(1, 1);
+        IProtocolSessionContainer* sessionContainerRaw = m_sessionContainer.get();
+        m_thread = std::make_unique<std::thread>([sessionContainerRaw] () {
+            sessionContainerRaw->threadEntry();
+        });
+    }
+
+    virtual void TearDown()
+    {
+        EXPECT_EQ(m_sessionContainer->terminatePollerLoop(100), true);
+        m_sessionContainer = nullptr;
+        m_thread->join();
+    }
+
+    IProtocolSessionPtr bindConnect()
+    {
+        int res = m_sessionContainer->bind("tcp://*:3333", std::static_pointer_cast<IProtocolSessionCallback>(m_requestReplyServer), std::make_shared<ProtocolHeaderBinarySizeFactory>());
+        EXPECT_EQ(res, 0);
+        auto& expectConnectedClient = EXPECT_CALL(*m_mockClientCallback, connected(_)).Times(1);
+        EXPECT_CALL(*m_mockServerCallback, connected(_)).Times(1);
+        IProtocolSessionPtr session = m_sessionContainer->connect("tcp://localhost:3333", std::static_pointer_cast<IProtocolSessionCallback>(m_requestReplyClient), std::make_shared<ProtocolHeaderBinarySize>());
+        waitTillDone(expectConnectedClient, 5000);
+        return session;
+    }
+
+    std::shared_ptr<IProtocolSessionContainer>              m_sessionContainer;
+    std::shared_ptr<MockIRequestReplyCallback>              m_mockClientCallback;
+    std::shared_ptr<MockIRequestReplyCallback>              m_mockServerCallback;
+    std::shared_ptr<RequestReply>                           m_requestReplyClient;
+    std::shared_ptr<RequestReply>                           m_requestReplyServer;
+
+    std::unique_ptr<std::thread>                            m_thread;
+};
+
+
+
+
+TEST_F(TestIntegrationRequestReply, testPipelinedRequests)
+{
+    static const int NUMBER_REQUESTS = 2000;
+
+    IRequestReply* requestReplyServer = m_requestReplyServer.get();
+    EXPECT_CALL(*m_mockServerCallback, receivedRequest(_, _, _, _)).Times(NUMBER_REQUESTS)
+            .WillRepeatedly(testing::Invoke([requestReplyServer] (const IProtocolSessionPtr& session, std::uint64_t correlationId, const IMessagePtr& message, const BufferRef& payload) {
+                requestReplyServer->sendReply(session, correlationId, payload.first, payload.second);
+            }));
+
+    IProtocolSessionPtr session = bindConnect();
+
+    std::mutex mutex;
+    int counterOk = 0;
+    int counterMismatch = 0;
+    CondVar done;
+    IRequestReply* requestReplyClient = m_requestReplyClient.get();
+    for (int i = 0; i < NUMBER_REQUESTS; ++i)
+    {
+        std::string request = std::to_string(i);
+        bool ok = requestReplyClient->sendRequest(session, request.data(), request.size(), 5000, [&, request] (const Reply& reply) {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (reply.status == REPLYSTATUS_OK && std::string(reply.payload.first, reply.payload.second) == request)
+            {
+                ++counterOk;
+            }
+            else
+            {
+                ++counterMismatch;
+            }
+            if (counterOk + counterMismatch == NUMBER_REQUESTS)
+            {
+                done = true;
+            }
+        });
+        EXPECT_EQ(ok, true);
+    }
+
+    EXPECT_EQ(done.wait(5000), true);
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_EQ(counterOk, NUMBER_REQUESTS);
+    EXPECT_EQ(counterMismatch, 0);
+    EXPECT_EQ(requestReplyClient->getNumberOfPendingRequests(), 0);
+}
+
+
+
+TEST_F(TestIntegrationRequestReply, testTimeout)
+{
+    auto& expectRequest = EXPECT_CALL(*m_mockServerCallback, receivedRequest(_, _, _, _)).Times(1);
+
+    IProtocolSessionPtr session = bindConnect();
+
+    IRequestReply* requestReplyClient = m_requestReplyClient.get();
+    std::future<Reply> future = requestReplyClient->sendRequest(session, "hello", 5, 50);
+    waitTillDone(expectRequest, 5000);
+
+    ASSERT_EQ(future.wait_for(std::chrono::milliseconds(5000)), std::future_status::ready);
+    EXPECT_EQ(future.get().status, REPLYSTATUS_TIMEOUT);
+    EXPECT_EQ(requestReplyClient->getNumberOfPendingRequests(), 0);
+}
+
+
+
+TEST_F(TestIntegrationRequestReply, testDisconnect)
+{
+    auto& expectRequest = EXPECT_CALL(*m_mockServerCallback, receivedRequest(_, _, _, _)).Times(1);
+    auto& expectDisconnected = EXPECT_CALL(*m_mockClientCallback, disconnected(_)).Times(1);
+    EXPECT_CALL(*m_mockServerCallback, disconnected(_)).Times(1);
+
+    IProtocolSessionPtr session = bindConnect();
+
+    IRequestReply* requestReplyClient = m_requestReplyClient.get();
+    std::future<Reply> future = requestReplyClient->sendRequest(session, "hello", 5, -1);
+    waitTillDone(expectRequest, 5000);
+
+    session->disconnect();
+    waitTillDone(expectDisconnected, 5000);
+
+    ASSERT_EQ(future.wait_for(std::chrono::milliseconds(5000)), std::future_status::ready);
+    EXPECT_EQ(future.get().status, REPLYSTATUS_DISCONNECTED);
+}
@@ -0,0 +1,204 @@
+#include "gtest/gtest.h"
+
+#include "connectionhub/MessageJournal.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+
+
+class TestMessageJournal : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        char directory[] = "/tmp/finalmq_journal_XXXXXX";
+        ASSERT_NE(mkdtemp(directory), nullptr);
+        m_directory = directory;
+    }
+
+    virtual void TearDown()
+    {
+        for (const std::string& file : getFiles())
+        {
+            unlink((m_directory + "/" + file).c_str());
+        }
+        rmdir(m_directory.c_str());
+    }
+
+    std::vector<std::string> getFiles() const
+    {
+        std::vector<std::string> files;
+        DIR* dir = opendir(m_directory.c_str());
+        struct dirent* entry = nullptr;
+        while (dir && (entry = readdir(dir)) != nullptr)
+        {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..")
+            {
+                files.push_back(name);
+            }
+        }
+        if (dir)
+        {
+            closedir(dir);
+        }
+        return files;
+    }
+
+    static std::vector<JournalEntry> replay(const MessageJournal& journal, std::uint64_t sequenceNumberFrom, std::vector<std::string>& payloads)
+    {
+        std::vector<JournalEntry> entries;
+        journal.replay(sequenceNumberFrom, [&entries, &payloads] (const JournalEntry& entry) {
+            entries.push_back(entry);
+            payloads.emplace_back(entry.payload.first, entry.payload.second);
+        });
+        return entries;
+    }
+
+    std::string m_directory;
+};
+
+
+
+TEST_F(TestMessageJournal, testAppendReplay)
+{
+    MessageJournal journal(m_directory);
+    EXPECT_EQ(journal.getLastSequenceNumber(), 0);
+    std::string payload1 = "hello";
+    std::string payload2 = "world";
+    EXPECT_EQ(journal.append(3, {&payload1[0], 5}), 1);
+    EXPECT_EQ(journal.append(4, {&payload2[0], 5}), 2);
+    EXPECT_EQ(journal.getLastSequenceNumber(), 2);
+
+    std::vector<std::string> payloads;
+    std::vector<JournalEntry> entries = replay(journal, 1, payloads);
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0].sequenceNumber, 1);
+    EXPECT_EQ(entries[0].sessionId, 3);
+    EXPECT_GT(entries[0].timestamp, 0);
+    EXPECT_EQ(entries[1].sequenceNumber, 2);
+    EXPECT_EQ(entries[1].sessionId, 4);
+    EXPECT_EQ(payloads, std::vector<std::string>({"hello", "world"}));
+
+    payloads.clear();
+    entries = replay(journal, 2, payloads);
+    EXPECT_EQ(payloads, std::vector<std::string>({"world"}));
+
+    EXPECT_EQ(journal.replay(3, [] (const JournalEntry& entry) {}), true);
+    EXPECT_EQ(journal.replay(4, [] (const JournalEntry& entry) {}), false);
+    EXPECT_EQ(journal.replay(0, [] (const JournalEntry& entry) {}), false);
+}
+
+TEST_F(TestMessageJournal, testSegments)
+{
+    MessageJournal journal(m_directory, 100, 3);
+    std::string payload(50, 'a');
+    for (int i = 0; i < 10; ++i)
+    {
+        journal.append(1, {&payload[0], static_cast<int>(payload.size())});
+    }
+    // one entry per segment, only the last 3 segments are kept
+    EXPECT_EQ(getFiles().size(), 3);
+    EXPECT_EQ(journal.getFirstSequenceNumber(), 8);
+    EXPECT_EQ(journal.replay(7, [] (const JournalEntry& entry) {}), false);
+
+    std::vector<std::string> payloads;
+    std::vector<JournalEntry> entries = replay(journal, 9, payloads);
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0].sequenceNumber, 9);
+    EXPECT_EQ(entries[1].sequenceNumber, 10);
+
+    // bigger than a segment
+    std::string payloadBig(1000, 'b');
+    EXPECT_EQ(journal.append(1, {&payloadBig[0], static_cast<int>(payloadBig.size())}), 11);
+    payloads.clear();
+    replay(journal, 11, payloads);
+    EXPECT_EQ(payloads, std::vector<std::string>({payloadBig}));
+}
+
+TEST_F(TestMessageJournal, testContinueExistingJournal)
+{
+    std::string payload = "hello";
+    {
+        MessageJournal journal(m_directory, 100, 3);
+        for (int i = 0; i < 5; ++i)
+        {
+            journal.append(i, {&payload[0], 5});
+        }
+    }
+    MessageJournal journal(m_directory, 100, 3);
+    EXPECT_EQ(journal.getLastSequenceNumber(), 5);
+    EXPECT_EQ(journal.append(5, {&payload[0], 5}), 6);
+
+    std::vector<std::string> payloads;
+    std::vector<JournalEntry> entries = replay(journal, journal.getFirstSequenceNumber(), payloads);
+    ASSERT_EQ(entries.empty(), false);
+    EXPECT_EQ(entries.back().sequenceNumber, 6);
+    EXPECT_EQ(entries.back().sessionId, 5);
+    for (size_t i = 1; i < entries.size(); ++i)
+    {
+        EXPECT_EQ(entries[i].sequenceNumber, entries[i - 1].sequenceNumber + 1);
+    }
+}
+
+TEST_F(TestMessageJournal, testRemoveSegmentsOnReopen)
+{
+    std::string payload(50, 'a');
+    {
+        MessageJournal journal(m_directory, 100, 5);
+        for (int i = 0; i < 10; ++i)
+        {
+            journal.append(1, {&payload[0], static_cast<int>(payload.size())});
+        }
+    }
+    EXPECT_EQ(getFiles().size(), 5);
+    MessageJournal journal(m_directory, 100, 3);
+    EXPECT_EQ(getFiles().size(), 3);
+    EXPECT_EQ(journal.getFirstSequenceNumber(), 8);
+    EXPECT_EQ(journal.getLastSequenceNumber(), 10);
+}
+
+TEST_F(TestMessageJournal, testReplayMaxEntries)
+{
+    MessageJournal journal(m_directory);
+    for (int i = 1; i <= 1000; ++i)
+    {
+        std::string payload = std::to_string(i);
+        journal.append(1, {&payload[0], static_cast<int>(payload.size())});
+    }
+    std::vector<std::string> payloads;
+    std::vector<JournalEntry> entries;
+    journal.replay(600, [&entries, &payloads] (const JournalEntry& entry) {
+        entries.push_back(entry);
+        payloads.emplace_back(entry.payload.first, entry.payload.second);
+    }, 3);
+    ASSERT_EQ(entries.size(), 3);
+    EXPECT_EQ(entries[0].sequenceNumber, 600);
+    EXPECT_EQ(payloads, std::vector<std::string>({"600", "601", "602"}));
+
+    // after a reopen the index is built again
+    MessageJournal journalReopened(m_directory);
+    payloads.clear();
+    journalReopened.replay(999, [&payloads] (const JournalEntry& entry) {
+        payloads.emplace_back(entry.payload.first, entry.payload.second);
+    });
+    EXPECT_EQ(payloads, std::vector<std::string>({"999", "1000"}));
+}
+
+
+TEST_F(TestMessageJournal, testEntryKeepsSegmentMapped)
+{
+    JournalEntry entry;
+    {
+        MessageJournal journal(m_directory);
+        std::string payload = "hello";
+        EXPECT_EQ(journal.append(3, {&payload[0], 5}), 1);
+        journal.replay(1, [&entry] (const JournalEntry& entryReplayed) {
+            entry = entryReplayed;
+        });
+    }
+    // the journal is closed, the entry still references the mapped segment
+    ASSERT_NE(entry.segment, nullptr);
+    EXPECT_EQ(std::string(entry.payload.first, entry.payload.second), "hello");
+}
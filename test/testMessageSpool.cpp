@@ -0,0 +1,178 @@
+#include "gtest/gtest.h"
+
+#include "connectionhub/MessageSpool.h"
+#include "protocolconnection/ProtocolMessage.h"
+
+#include <sys/resource.h>
+#include <signal.h>
+
+
+
+static IMessagePtr createMessage(const std::string& payload)
+{
+    IMessagePtr message = std::make_shared<ProtocolMessage>(0);
+    char* buffer = message->resizeReceivePayload(static_cast<int>(payload.size()));
+    memcpy(buffer, payload.data(), payload.size());
+    return message;
+}
+
+static std::string getPayload(const IMessagePtr& message)
+{
+    BufferRef payload = message->getReceivePayload();
+    return std::string(payload.first, payload.second);
+}
+
+
+
+TEST(TestMessageSpool, testInMemory)
+{
+    MessageSpool spool(100);
+    EXPECT_EQ(spool.empty(), true);
+    spool.push(1, createMessage("hello"));
+    spool.push(2, createMessage("world"));
+    EXPECT_EQ(spool.getMemoryBytes(), 10);
+    EXPECT_EQ(spool.getFileBytes(), 0);
+
+    std::vector<std::pair<std::int64_t, IMessagePtr>> entries;
+    EXPECT_EQ(spool.pop(10, entries), true);
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0].first, 1);
+    EXPECT_EQ(getPayload(entries[0].second), "hello");
+    EXPECT_EQ(entries[1].first, 2);
+    EXPECT_EQ(getPayload(entries[1].second), "world");
+    EXPECT_EQ(spool.empty(), true);
+    EXPECT_EQ(spool.pop(10, entries), false);
+}
+
+TEST(TestMessageSpool, testSpillToFile)
+{
+    MessageSpool spool(10);
+    for (int i = 0; i < 100; ++i)
+    {
+        spool.push(i, createMessage("message" + std::to_string(i)));
+    }
+    EXPECT_EQ(spool.getMemoryBytes(), 8);
+    EXPECT_GT(spool.getFileBytes(), 0);
+
+    // the order is kept, also for messages which are pushed while the file is read
+    std::vector<std::pair<std::int64_t, IMessagePtr>> entries;
+    EXPECT_EQ(spool.pop(30, entries), true);
+    spool.push(100, createMessage("message100"));
+    while (spool.pop(30, entries))
+    {
+    }
+    ASSERT_EQ(entries.size(), 101);
+    for (int i = 0; i < 101; ++i)
+    {
+        EXPECT_EQ(entries[i].first, i);
+        EXPECT_EQ(getPayload(entries[i].second), "message" + std::to_string(i));
+    }
+    EXPECT_EQ(spool.getMemoryBytes(), 0);
+    EXPECT_EQ(spool.getFileBytes(), 0);
+
+    // the drained file is released, the memory is used again
+    spool.push(1, createMessage("hello"));
+    EXPECT_EQ(spool.getMemoryBytes(), 5);
+    EXPECT_EQ(spool.getFileBytes(), 0);
+}
+
+TEST(TestMessageSpool, testGrowFile)
+{
+    MessageSpool spool(0);
+    std::string payload(300 * 1024, 'a');
+    for (int i = 0; i < 10; ++i)
+    {
+        spool.push(i, createMessage(payload));
+    }
+    EXPECT_EQ(spool.getMemoryBytes(), 0);
+    EXPECT_EQ(spool.getFileBytes(), 10 * (12 + 300 * 1024));
+
+    std::vector<std::pair<std::int64_t, IMessagePtr>> entries;
+    EXPECT_EQ(spool.pop(100, entries), true);
+    ASSERT_EQ(entries.size(), 10);
+    EXPECT_EQ(entries[9].first, 9);
+    EXPECT_EQ(getPayload(entries[9].second), payload);
+}
+
+TEST(TestMessageSpool, testNoSpoolDirectory)
+{
+    MessageSpool spool(0, "/nonexistingdirectory");
+    spool.push(1, createMessage("hello"));
+    EXPECT_EQ(spool.getMemoryBytes(), 5);
+    EXPECT_EQ(spool.getFileBytes(), 0);
+    std::vector<std::pair<std::int64_t, IMessagePtr>> entries;
+    EXPECT_EQ(spool.pop(10, entries), true);
+    ASSERT_EQ(entries.size(), 1);
+    EXPECT_EQ(getPayload(entries[0].second), "hello");
+}
+
+TEST(TestMessageSpool, testReuseReadSpace)
+{
+    MessageSpool spool(0);
+    std::string payload(100 * 1024, 'a');
+    std::vector<std::pair<std::int64_t, IMessagePtr>> entries;
+    int pushed = 0;
+    int popped = 0;
+    // the reader is always a few messages behind, the space of the read messages is reused
+    for (int i = 0; i < 200; ++i)
+    {
+        for (int j = 0; j < 5; ++j)
+        {
+            spool.push(pushed, createMessage(payload + std::to_string(pushed)));
+            ++pushed;
+        }
+        entries.clear();
+        spool.pop(4, entries);
+        for (size_t j = 0; j < entries.size(); ++j)
+        {
+            EXPECT_EQ(entries[j].first, popped);
+            EXPECT_EQ(getPayload(entries[j].second), payload + std::to_string(popped));
+            ++popped;
+        }
+    }
+    entries.clear();
+    while (spool.pop(100, entries))
+    {
+    }
+    for (size_t j = 0; j < entries.size(); ++j)
+    {
+        EXPECT_EQ(entries[j].first, popped);
+        ++popped;
+    }
+    EXPECT_EQ(popped, pushed);
+    EXPECT_EQ(spool.getDroppedMessages(), 0);
+}
+
+TEST(TestMessageSpool, testDropIfFileCannotGrow)
+{
+    // the file cannot grow beyond 2MB
+    struct rlimit limitBefore;
+    getrlimit(RLIMIT_FSIZE, &limitBefore);
+    struct rlimit limit = limitBefore;
+    limit.rlim_cur = 2 * 1024 * 1024;
+    sighandler_t handlerBefore = signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limit);
+
+    MessageSpool spool(0);
+    std::string payload(600 * 1024, 'a');
+    EXPECT_EQ(spool.push(1, createMessage(payload)), true);
+    EXPECT_EQ(spool.push(2, createMessage(payload)), true);
+    EXPECT_EQ(spool.push(3, createMessage(payload)), true);
+    EXPECT_EQ(spool.push(4, createMessage(payload)), false);
+    EXPECT_EQ(spool.push(5, createMessage("hello")), true);
+
+    setrlimit(RLIMIT_FSIZE, &limitBefore);
+    signal(SIGXFSZ, handlerBefore);
+
+    EXPECT_EQ(spool.getDroppedMessages(), 1);
+    EXPECT_EQ(spool.getMemoryBytes(), 0);
+    std::vector<std::pair<std::int64_t, IMessagePtr>> entries;
+    while (spool.pop(10, entries))
+    {
+    }
+    ASSERT_EQ(entries.size(), 4);
+    EXPECT_EQ(entries[0].first, 1);
+    EXPECT_EQ(entries[1].first, 2);
+    EXPECT_EQ(entries[2].first, 3);
+    EXPECT_EQ(entries[3].first, 5);
+}
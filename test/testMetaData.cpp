@@ -0,0 +1,205 @@
+#include "gtest/gtest.h"
+
+
+#include "metadata/MetaData.h"
+
+#include <thread>
+#include <atomic>
+
+
+
+class TestMetaData : public testing::Test
+{
+public:
+
+protected:
+    virtual void SetUp()
+    {
+        m_metaData = std::make_unique<MetaData>();
+
+        MetaStruct structInt32;
+        structInt32.setTypeName("test.TestMessageInt32");
+        structInt32.addField({MetaTypeId::TYPE_INT32, "", "value", "description"});
+        m_metaData->addStruct(structInt32);
+
+        MetaStruct structTest;
+        structTest.setTypeName("test.TestMessageStruct");
+        structTest.addField({MetaTypeId::TYPE_STRUCT, "test.TestMessageInt32", "struct_int32", "description"});
+        structTest.addField({MetaTypeId::TYPE_ARRAY_STRUCT, "test.TestMessageInt32", "array_int32", "description"});
+        structTest.addField({MetaTypeId::TYPE_ARRAY_ENUM, "test.Foo", "array_enum", "description"});
+        m_metaData->addStruct(structTest);
+
+        MetaEnum metaEnum;
+        metaEnum.setTypeName("test.Foo");
+        metaEnum.addEntry({"FOO_WORLD", 0 ,""});
+        metaEnum.addEntry({"FOO_HELLO", -2 ,""});
+        metaEnum.addEntry({"FOO_WORLD2", 1 ,""});
+        m_metaData->addEnum(std::move(metaEnum));
+    }
+
+    std::unique_ptr<IMetaData> m_metaData;
+};
+
+
+
+TEST_F(TestMetaData, testTypeIds)
+{
+    const MetaStruct* structInt32 = m_metaData->getStruct("test.TestMessageInt32");
+    const MetaStruct* structTest = m_metaData->getStruct("test.TestMessageStruct");
+    const MetaEnum* metaEnum = m_metaData->getEnum("test.Foo");
+    ASSERT_NE(structInt32, nullptr);
+    ASSERT_NE(structTest, nullptr);
+    ASSERT_NE(metaEnum, nullptr);
+    EXPECT_EQ(structInt32->getTypeId(), 0);
+    EXPECT_EQ(structTest->getTypeId(), 1);
+    EXPECT_EQ(metaEnum->getTypeId(), 0);
+    EXPECT_EQ(m_metaData->getStructById(1), structTest);
+    EXPECT_EQ(m_metaData->getStructById(2), nullptr);
+    EXPECT_EQ(m_metaData->getEnumById(0), metaEnum);
+    EXPECT_EQ(m_metaData->getEnumById(-1), nullptr);
+}
+
+TEST_F(TestMetaData, testFreezeResolvesFields)
+{
+    m_metaData->freeze();
+    EXPECT_EQ(m_metaData->isFrozen(), true);
+
+    const MetaStruct* structTest = m_metaData->getStruct("test.TestMessageStruct");
+    ASSERT_NE(structTest, nullptr);
+    const MetaStruct* structInt32 = m_metaData->getStruct("test.TestMessageInt32");
+
+    EXPECT_EQ(structTest->getFieldByIndex(0)->metaStruct, structInt32);
+    const MetaField* arrayStruct = structTest->getFieldByIndex(1);
+    EXPECT_EQ(arrayStruct->metaStruct, structInt32);
+    ASSERT_NE(arrayStruct->fieldWithoutArray, nullptr);
+    EXPECT_EQ(arrayStruct->fieldWithoutArray->typeId, MetaTypeId::TYPE_STRUCT);
+    EXPECT_EQ(arrayStruct->fieldWithoutArray->metaStruct, structInt32);
+    const MetaField* arrayEnum = structTest->getFieldByIndex(2);
+    EXPECT_EQ(arrayEnum->metaEnum, m_metaData->getEnum("test.Foo"));
+    EXPECT_EQ(arrayEnum->fieldWithoutArray->metaEnum, m_metaData->getEnum("test.Foo"));
+}
+
+TEST_F(TestMetaData, testAddAfterFreeze)
+{
+    m_metaData->freeze();
+
+    MetaStruct structNew;
+    structNew.setTypeName("test.New");
+    m_metaData->addStruct(structNew);
+    EXPECT_EQ(m_metaData->getStruct("test.New"), nullptr);
+
+    MetaEnum enumNew;
+    enumNew.setTypeName("test.NewEnum");
+    m_metaData->addEnum(enumNew);
+    EXPECT_EQ(m_metaData->getEnum("test.NewEnum"), nullptr);
+}
+
+TEST_F(TestMetaData, testEnumIds)
+{
+    const MetaEnum* metaEnum = m_metaData->getEnum("test.Foo");
+    ASSERT_NE(metaEnum, nullptr);
+    EXPECT_EQ(metaEnum->getNameByValue(-2), "FOO_HELLO");
+    EXPECT_EQ(metaEnum->getNameByValue(1), "FOO_WORLD2");
+    EXPECT_EQ(metaEnum->getNameByValue(5), "FOO_WORLD");
+    EXPECT_EQ(metaEnum->isId(-1), false);
+
+    MetaEnum sparseEnum;
+    sparseEnum.addEntry({"A", 0 ,""});
+    sparseEnum.addEntry({"B", 1000000 ,""});
+    sparseEnum.addEntry({"C", -1000000 ,""});
+    EXPECT_EQ(sparseEnum.getNameByValue(1000000), "B");
+    EXPECT_EQ(sparseEnum.getNameByValue(-1000000), "C");
+    EXPECT_EQ(sparseEnum.isId(1), false);
+}
+
+TEST_F(TestMetaData, testConcurrentLookupsAfterFreeze)
+{
+    m_metaData->freeze();
+
+    const MetaStruct* structInt32 = m_metaData->getStruct("test.TestMessageInt32");
+    std::atomic<int> errors{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([this, structInt32, &errors] () {
+            for (int i = 0; i < 10000; ++i)
+            {
+                const MetaStruct* structTest = m_metaData->getStruct("test.TestMessageStruct");
+                const MetaField* field = structTest->getFieldByIndex(1);
+                if (m_metaData->getStruct(*m_metaData->getArrayField(*field)) != structInt32)
+                {
+                    ++errors;
+                }
+            }
+        });
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+    EXPECT_EQ(errors, 0);
+}
+
+TEST_F(TestMetaData, testConcurrentLookupsWhileAdding)
+{
+    const MetaStruct* structInt32 = m_metaData->getStruct("test.TestMessageInt32");
+    std::atomic<bool> adding{true};
+    std::atomic<int> errors{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([this, structInt32, &adding, &errors] () {
+            while (adding)
+            {
+                const MetaStruct* structTest = m_metaData->getStruct("test.TestMessageStruct");
+                const MetaField* field = structTest->getFieldByIndex(1);
+                if (m_metaData->getStruct(*m_metaData->getArrayField(*field)) != structInt32 ||
+                    m_metaData->getStructById(0) != structInt32)
+                {
+                    ++errors;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 1000; ++i)
+    {
+        MetaStruct stru;
+        stru.setTypeName("test.Added" + std::to_string(i));
+        m_metaData->addStruct(stru);
+    }
+    adding = false;
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+    EXPECT_EQ(errors, 0);
+    const MetaStruct* structAdded = m_metaData->getStruct("test.Added999");
+    ASSERT_NE(structAdded, nullptr);
+    EXPECT_EQ(m_metaData->getStructById(structAdded->getTypeId()), structAdded);
+}
+
+TEST_F(TestMetaData, testFieldCacheBeforeFreeze)
+{
+    const MetaStruct* structTest = m_metaData->getStruct("test.TestMessageStruct");
+    ASSERT_NE(structTest, nullptr);
+    const MetaField* field = structTest->getFieldByIndex(0);
+    EXPECT_EQ(static_cast<const MetaStruct*>(field->metaStruct), nullptr);
+
+    const MetaStruct* structInt32 = m_metaData->getStruct(*field);
+    EXPECT_EQ(structInt32, m_metaData->getStruct("test.TestMessageInt32"));
+    EXPECT_EQ(static_cast<const MetaStruct*>(field->metaStruct), structInt32);
+
+    const MetaField* arrayEnum = structTest->getFieldByIndex(2);
+    const MetaEnum* metaEnum = m_metaData->getEnum(*m_metaData->getArrayField(*arrayEnum));
+    EXPECT_EQ(metaEnum, m_metaData->getEnum("test.Foo"));
+    EXPECT_EQ(static_cast<const MetaEnum*>(arrayEnum->fieldWithoutArray->metaEnum), metaEnum);
+
+    // a struct, which is not registered yet, is not cached
+    MetaField fieldAdded = {MetaTypeId::TYPE_STRUCT, "test.Added"};
+    EXPECT_EQ(m_metaData->getStruct(fieldAdded), nullptr);
+    MetaStruct stru;
+    stru.setTypeName("test.Added");
+    m_metaData->addStruct(stru);
+    EXPECT_EQ(m_metaData->getStruct(fieldAdded), m_metaData->getStruct("test.Added"));
+    EXPECT_EQ(static_cast<const MetaStruct*>(fieldAdded.metaStruct), m_metaData->getStruct("test.Added"));
+}
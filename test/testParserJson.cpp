@@ -415,6 +415,60 @@ TEST_F(TestParserJson, testStruct)
 
 
 
+TEST_F(TestParserJson, testFieldMask)
+{
+    static const std::string VALUE_STRING = "Hello World";
+    static const std::uint32_t VALUE_LAST = 12;
+    MetaStruct structInt32;
+    MetaStruct structString;
+    structInt32.setTypeName("test.StructInt32");
+    structString.setTypeName("test.StructString");
+    MetaField fieldInt32 = {MetaTypeId::TYPE_INT32, "", "value", "description"};
+    structInt32.addField(fieldInt32);
+    MetaField fieldString = {MetaTypeId::TYPE_STRING, "", "value", "description"};
+    structString.addField(fieldString);
+
+    MetaStruct structTest;
+    structTest.setTypeName("test.TestStructMask");
+    MetaField fieldStructInt32 = {MetaTypeId::TYPE_STRUCT, "test.StructInt32", "structInt32", "description"};
+    structTest.addField(fieldStructInt32);
+    MetaField fieldStructString = {MetaTypeId::TYPE_STRUCT, "test.StructString", "structString", "description"};
+    structTest.addField(fieldStructString);
+    MetaField fieldLastValue = {MetaTypeId::TYPE_UINT32, "", "lastValue", "description"};
+    structTest.addField(fieldLastValue);
+
+    MetaDataGlobal::instance().addStruct(structInt32);
+    MetaDataGlobal::instance().addStruct(structString);
+    MetaDataGlobal::instance().addStruct(structTest);
+
+    FieldMask mask("test.TestStructMask", {"structString.value", "lastValue"});
+    EXPECT_EQ(mask.isValid(), true);
+    EXPECT_EQ(FieldMask("test.TestStructMask", {"structString.unknown"}).isValid(), false);
+
+    std::string data = "{\"structInt32\":{\"value\":-2},\"structString\":{\"value\":\"Hello World\"},\"lastValue\":12}";
+
+    MockIParserVisitor mockVisitor;
+    MetaField rootStruct = {MetaTypeId::TYPE_STRUCT, "test.TestStructMask", ""};
+
+    EXPECT_CALL(mockVisitor, enterInt32(_, _)).Times(0);
+    {
+        testing::InSequence seq;
+        EXPECT_CALL(mockVisitor, enterStruct(MatcherMetaField(rootStruct))).Times(1);
+        EXPECT_CALL(mockVisitor, enterStruct(MatcherMetaField(fieldStructString))).Times(1);
+        EXPECT_CALL(mockVisitor, enterString(MatcherMetaField(fieldString), ArrayEq(VALUE_STRING.data(), VALUE_STRING.size()), VALUE_STRING.size())).Times(1);
+        EXPECT_CALL(mockVisitor, exitStruct(MatcherMetaField(fieldStructString))).Times(1);
+        EXPECT_CALL(mockVisitor, enterUInt32(MatcherMetaField(fieldLastValue), VALUE_LAST)).Times(1);
+        EXPECT_CALL(mockVisitor, exitStruct(MatcherMetaField(rootStruct))).Times(1);
+        EXPECT_CALL(mockVisitor, finished()).Times(1);
+    }
+
+    ParserJson parser(mockVisitor, data.data(), data.size());
+    bool res = parser.parseStruct("test.TestStructMask", &mask);
+    EXPECT_EQ(res, true);
+}
+
+
+
 
 TEST_F(TestParserJson, testUndefinedStructs)
 {
@@ -425,6 +425,66 @@ TEST_F(TestParserProto, testStruct)
 
 
 
+TEST_F(TestParserProto, testFieldMask)
+{
+    static const std::string VALUE_STRING = "Hello World";
+    static const std::uint32_t VALUE_LAST = 12;
+    MetaStruct structInt32;
+    MetaStruct structString;
+    structInt32.setTypeName("test.StructInt32");
+    structString.setTypeName("test.StructString");
+    MetaField fieldInt32 = {MetaTypeId::TYPE_INT32, "", "value", "description"};
+    structInt32.addField(fieldInt32);
+    MetaField fieldString = {MetaTypeId::TYPE_STRING, "", "value", "description"};
+    structString.addField(fieldString);
+
+    MetaStruct structTest;
+    structTest.setTypeName("test.TestStructMask");
+    MetaField fieldStructInt32 = {MetaTypeId::TYPE_STRUCT, "test.StructInt32", "structInt32", "description"};
+    structTest.addField(fieldStructInt32);
+    MetaField fieldStructString = {MetaTypeId::TYPE_STRUCT, "test.StructString", "structString", "description"};
+    structTest.addField(fieldStructString);
+    MetaField fieldLastValue = {MetaTypeId::TYPE_UINT32, "", "lastValue", "description"};
+    structTest.addField(fieldLastValue);
+
+    MetaDataGlobal::instance().addStruct(structInt32);
+    MetaDataGlobal::instance().addStruct(structString);
+    MetaDataGlobal::instance().addStruct(structTest);
+
+    FieldMask mask("test.TestStructMask", {"structString.value", "lastValue"});
+    EXPECT_EQ(mask.isValid(), true);
+    EXPECT_EQ(FieldMask("test.TestStructMask", {"structString.unknown"}).isValid(), false);
+
+    std::string data;
+
+    test::TestMessageStruct message;
+    message.mutable_struct_int32()->set_value(-2);
+    message.mutable_struct_string()->set_value(VALUE_STRING);
+    message.set_last_value(VALUE_LAST);
+    message.SerializeToString(&data);
+
+    MockIParserVisitor mockVisitor;
+    MetaField rootStruct = {MetaTypeId::TYPE_STRUCT, "test.TestStructMask", ""};
+
+    EXPECT_CALL(mockVisitor, enterInt32(_, _)).Times(0);
+    {
+        testing::InSequence seq;
+        EXPECT_CALL(mockVisitor, enterStruct(MatcherMetaField(rootStruct))).Times(1);
+        EXPECT_CALL(mockVisitor, enterStruct(MatcherMetaField(fieldStructString))).Times(1);
+        EXPECT_CALL(mockVisitor, enterString(MatcherMetaField(fieldString), ArrayEq(VALUE_STRING.data(), VALUE_STRING.size()), VALUE_STRING.size())).Times(1);
+        EXPECT_CALL(mockVisitor, exitStruct(MatcherMetaField(fieldStructString))).Times(1);
+        EXPECT_CALL(mockVisitor, enterUInt32(MatcherMetaField(fieldLastValue), VALUE_LAST)).Times(1);
+        EXPECT_CALL(mockVisitor, exitStruct(MatcherMetaField(rootStruct))).Times(1);
+        EXPECT_CALL(mockVisitor, finished()).Times(1);
+    }
+
+    ParserProto parser(mockVisitor, data.data(), data.size());
+    bool res = parser.parseStruct("test.TestStructMask", &mask);
+    EXPECT_EQ(res, true);
+}
+
+
+
 TEST_F(TestParserProto, testEnum)
 {
     static const test::Foo VALUE = test::Foo::FOO_HELLO;
@@ -1004,3 +1064,141 @@ TEST_F(TestParserProto, testArrayEnum)
     bool res = parser.parseStruct("test.TestArrayEnum");
     EXPECT_EQ(res, true);
 }
+
+
+TEST_F(TestParserProto, testArrayVarintPacked)
+{
+    static const std::vector<std::int64_t> VALUE_INT64 = {0, 1, -1, 1234567890123LL};
+    static const std::vector<std::int32_t> VALUE_SINT32 = {0, -1, 64, -65};
+    static const std::vector<std::uint64_t> VALUE_UINT64 = {127, 128, 0xffffffffffffffffULL};
+    static const std::uint32_t VALUE_LAST = 123;
+
+    MetaStruct structTest;
+    structTest.setTypeName("test.TestMessageArrayVarint");
+    MetaField fieldInt64 = {MetaTypeId::TYPE_ARRAY_INT64, "", "value_int64", "", 0, METAFLAG_PROTO_VARINT};
+    MetaField fieldSInt32 = {MetaTypeId::TYPE_ARRAY_INT32, "", "value_sint32", "", 0, METAFLAG_PROTO_ZIGZAG};
+    MetaField fieldUInt64 = {MetaTypeId::TYPE_ARRAY_UINT64, "", "value_uint64", "", 0, METAFLAG_PROTO_VARINT};
+    MetaField fieldLast = {MetaTypeId::TYPE_UINT32, "", "last_value", ""};
+    structTest.addField(fieldInt64);
+    structTest.addField(fieldSInt32);
+    structTest.addField(fieldUInt64);
+    structTest.addField(fieldLast);
+
+    MetaDataGlobal::instance().addStruct(structTest);
+
+    test::TestMessageArrayVarint message;
+    for (auto value : VALUE_INT64)
+    {
+        message.add_value_int64(value);
+    }
+    for (auto value : VALUE_SINT32)
+    {
+        message.add_value_sint32(value);
+    }
+    for (auto value : VALUE_UINT64)
+    {
+        message.add_value_uint64(value);
+    }
+    message.set_last_value(VALUE_LAST);
+    std::string data = message.SerializeAsString();
+
+    MockIParserVisitor mockVisitor;
+    MetaField rootStruct = {MetaTypeId::TYPE_STRUCT, "test.TestMessageArrayVarint", ""};
+
+    {
+        testing::InSequence seq;
+        EXPECT_CALL(mockVisitor, enterStruct(MatcherMetaField(rootStruct))).Times(1);
+        EXPECT_CALL(mockVisitor, enterArrayInt64(MatcherMetaField(fieldInt64), std::vector<std::int64_t>(VALUE_INT64))).Times(1);
+        EXPECT_CALL(mockVisitor, enterArrayInt32(MatcherMetaField(fieldSInt32), std::vector<std::int32_t>(VALUE_SINT32))).Times(1);
+        EXPECT_CALL(mockVisitor, enterArrayUInt64(MatcherMetaField(fieldUInt64), std::vector<std::uint64_t>(VALUE_UINT64))).Times(1);
+        EXPECT_CALL(mockVisitor, enterUInt32(MatcherMetaField(fieldLast), VALUE_LAST)).Times(1);
+        EXPECT_CALL(mockVisitor, exitStruct(MatcherMetaField(rootStruct))).Times(1);
+        EXPECT_CALL(mockVisitor, finished()).Times(1);
+    }
+
+    ParserProto parser(mockVisitor, data.data(), data.size());
+    bool res = parser.parseStruct("test.TestMessageArrayVarint");
+    EXPECT_EQ(res, true);
+}
+
+TEST_F(TestParserProto, testArrayVarintPackedIncomplete)
+{
+    MetaStruct structTest;
+    structTest.setTypeName("test.TestMessageArrayVarint");
+    MetaField fieldInt64 = {MetaTypeId::TYPE_ARRAY_INT64, "", "value_int64", "", 0, METAFLAG_PROTO_VARINT};
+    structTest.addField(fieldInt64);
+
+    MetaDataGlobal::instance().addStruct(structTest);
+
+    // field 1, length delimited, 2 bytes, the last varint has the continuation bit
+    std::string data = {0x0a, 0x02, 0x01, static_cast<char>(0x80)};
+
+    MockIParserVisitor mockVisitor;
+    EXPECT_CALL(mockVisitor, enterStruct(_)).Times(1);
+    EXPECT_CALL(mockVisitor, enterArrayInt64(_, testing::An<std::vector<std::int64_t>&&>())).Times(0);
+    EXPECT_CALL(mockVisitor, exitStruct(_)).Times(1);
+    EXPECT_CALL(mockVisitor, finished()).Times(1);
+
+    ParserProto parser(mockVisitor, data.data(), data.size());
+    bool res = parser.parseStruct("test.TestMessageArrayVarint");
+    EXPECT_EQ(res, false);
+}
+
+TEST_F(TestParserProto, testVarintAllLengths)
+{
+    // values with 1 to 10 bytes as varint
+    std::vector<std::uint64_t> values;
+    for (int i = 1; i < 64; i += 7)
+    {
+        values.push_back((1ULL << i) - 1);
+        values.push_back(1ULL << i);
+    }
+    values.push_back(0xffffffffffffffffULL);
+
+    MetaStruct structTest;
+    structTest.setTypeName("test.TestMessageArrayVarint");
+    MetaField fieldInt64 = {MetaTypeId::TYPE_ARRAY_INT64, "", "value_int64", "", 0, METAFLAG_PROTO_VARINT};
+    MetaField fieldSInt32 = {MetaTypeId::TYPE_ARRAY_INT32, "", "value_sint32", "", 0, METAFLAG_PROTO_ZIGZAG};
+    MetaField fieldUInt64 = {MetaTypeId::TYPE_ARRAY_UINT64, "", "value_uint64", "", 0, METAFLAG_PROTO_VARINT};
+    structTest.addField(fieldInt64);
+    structTest.addField(fieldSInt32);
+    structTest.addField(fieldUInt64);
+
+    MetaDataGlobal::instance().addStruct(structTest);
+
+    test::TestMessageArrayVarint message;
+    for (auto value : values)
+    {
+        message.add_value_uint64(value);
+    }
+    std::string dataPacked = message.SerializeAsString();
+
+    // the same values not packed, every value has its own tag
+    std::string dataNotPacked;
+    for (auto value : values)
+    {
+        dataNotPacked += static_cast<char>((3 << 3) | WIRETYPE_VARINT);
+        while (value >= 0x80)
+        {
+            dataNotPacked += static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        dataNotPacked += static_cast<char>(value);
+    }
+
+    for (const std::string& data : {dataPacked, dataNotPacked})
+    {
+        MockIParserVisitor mockVisitor;
+        {
+            testing::InSequence seq;
+            EXPECT_CALL(mockVisitor, enterStruct(_)).Times(1);
+            EXPECT_CALL(mockVisitor, enterArrayUInt64(MatcherMetaField(fieldUInt64), std::vector<std::uint64_t>(values))).Times(1);
+            EXPECT_CALL(mockVisitor, exitStruct(_)).Times(1);
+            EXPECT_CALL(mockVisitor, finished()).Times(1);
+        }
+
+        ParserProto parser(mockVisitor, data.data(), data.size());
+        bool res = parser.parseStruct("test.TestMessageArrayVarint");
+        EXPECT_EQ(res, true);
+    }
+}
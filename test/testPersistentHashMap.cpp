@@ -0,0 +1,99 @@
+#include "gtest/gtest.h"
+
+#include "helpers/PersistentHashMap.h"
+
+#include <algorithm>
+
+
+
+struct HashCollision
+{
+    std::size_t operator ()(int key) const
+    {
+        return key % 3;
+    }
+};
+
+template<class MAP>
+static std::vector<int> getKeys(const MAP& map)
+{
+    std::vector<int> keys;
+    map.forEach([&keys] (int key, int) {
+        keys.push_back(key);
+    });
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+
+
+TEST(TestPersistentHashMap, testInsertFindErase)
+{
+    PersistentHashMap<int, int> map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_EQ(map.insert(i, i * 2), true);
+    }
+    EXPECT_EQ(map.insert(5, 0), false);
+    EXPECT_EQ(map.size(), 1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_NE(map.find(i), nullptr);
+        EXPECT_EQ(*map.find(i), i * 2);
+    }
+    EXPECT_EQ(map.find(1000), nullptr);
+    map.set(5, 7);
+    EXPECT_EQ(*map.find(5), 7);
+    for (int i = 0; i < 1000; i += 2)
+    {
+        EXPECT_EQ(map.erase(i), true);
+    }
+    EXPECT_EQ(map.erase(0), false);
+    EXPECT_EQ(map.size(), 500);
+    EXPECT_EQ(map.find(0), nullptr);
+    EXPECT_EQ(*map.find(1), 2);
+    for (int i = 1; i < 1000; i += 2)
+    {
+        EXPECT_EQ(map.erase(i), true);
+    }
+    EXPECT_EQ(map.empty(), true);
+    EXPECT_EQ(getKeys(map), std::vector<int>());
+}
+
+TEST(TestPersistentHashMap, testCopyIsNotChanged)
+{
+    PersistentHashMap<int, int> map;
+    map.insert(1, 1);
+    map.insert(2, 2);
+    PersistentHashMap<int, int> copy = map;
+    map.set(1, 10);
+    map.insert(3, 3);
+    map.erase(2);
+    EXPECT_EQ(getKeys(copy), std::vector<int>({1, 2}));
+    EXPECT_EQ(*copy.find(1), 1);
+    EXPECT_EQ(getKeys(map), std::vector<int>({1, 3}));
+    EXPECT_EQ(*map.find(1), 10);
+}
+
+TEST(TestPersistentHashMap, testHashCollisions)
+{
+    PersistentHashMap<int, int, HashCollision> map;
+    for (int i = 0; i < 30; ++i)
+    {
+        EXPECT_EQ(map.insert(i, i), true);
+    }
+    for (int i = 0; i < 30; ++i)
+    {
+        ASSERT_NE(map.find(i), nullptr);
+        EXPECT_EQ(*map.find(i), i);
+    }
+    for (int i = 0; i < 30; i += 3)
+    {
+        EXPECT_EQ(map.erase(i), true);
+    }
+    EXPECT_EQ(map.find(3), nullptr);
+    EXPECT_EQ(*map.find(4), 4);
+    EXPECT_EQ(map.size(), 20);
+    EXPECT_EQ(map.insert(3, 3), true);
+    EXPECT_EQ(*map.find(3), 3);
+}
@@ -0,0 +1,267 @@
+#include "gtest/gtest.h"
+
+
+#include "test.codec.h"
+#include "serializeproto/SerializerProto.h"
+#include "protocolconnection/ProtocolMessage.h"
+#include "test.pb.h"
+
+#include <chrono>
+#include <iostream>
+
+
+
+template<class T>
+static std::string encode(const T& value)
+{
+    std::string data;
+    protoEncode(value, data);
+    return data;
+}
+
+
+
+TEST(TestProtoCodec, testScalars)
+{
+    test_codec::TestMessageInt32 int32;
+    int32.value = -2;
+    test::TestMessageInt32 messageInt32;
+    messageInt32.set_value(-2);
+    EXPECT_EQ(encode(int32), messageInt32.SerializeAsString());
+
+    test_codec::TestMessageDouble dbl;
+    dbl.value = 1.5;
+    test::TestMessageDouble messageDouble;
+    messageDouble.set_value(1.5);
+    EXPECT_EQ(encode(dbl), messageDouble.SerializeAsString());
+
+    test_codec::TestMessageBool bl;
+    bl.value = true;
+    test::TestMessageBool messageBool;
+    messageBool.set_value(true);
+    EXPECT_EQ(encode(bl), messageBool.SerializeAsString());
+
+    test_codec::TestMessageEnum en;
+    en.value = test_codec::FOO_HELLO;
+    test::TestMessageEnum messageEnum;
+    messageEnum.set_value(test::FOO_HELLO);
+    EXPECT_EQ(encode(en), messageEnum.SerializeAsString());
+
+    test_codec::TestMessageEnum enDecoded;
+    std::string data = messageEnum.SerializeAsString();
+    EXPECT_EQ(protoDecode(data.data(), data.size(), enDecoded), true);
+    EXPECT_EQ(enDecoded.value, test_codec::FOO_HELLO);
+}
+
+TEST(TestProtoCodec, testDefaultValuesAreNotSerialized)
+{
+    test_codec::TestMessageStruct value;
+    EXPECT_EQ(encode(value), "");
+    test_codec::TestMessageString str;
+    EXPECT_EQ(encode(str), "");
+    test_codec::TestMessageArrayDouble arr;
+    EXPECT_EQ(encode(arr), "");
+}
+
+TEST(TestProtoCodec, testStruct)
+{
+    test_codec::TestMessageStruct value;
+    value.struct_int32.value = -5;
+    value.struct_string.value = "Hello";
+    value.last_value = 123;
+
+    test::TestMessageStruct message;
+    message.mutable_struct_int32()->set_value(-5);
+    message.mutable_struct_string()->set_value("Hello");
+    message.set_last_value(123);
+    EXPECT_EQ(encode(value), message.SerializeAsString());
+
+    std::string data = message.SerializeAsString();
+    test_codec::TestMessageStruct decoded;
+    EXPECT_EQ(protoDecode(data.data(), data.size(), decoded), true);
+    EXPECT_EQ(decoded.struct_int32.value, -5);
+    EXPECT_EQ(decoded.struct_string.value, "Hello");
+    EXPECT_EQ(decoded.last_value, 123);
+}
+
+TEST(TestProtoCodec, testArrays)
+{
+    test_codec::TestMessageArrayInt32 int32;
+    int32.value = {1, -2, 3};
+    test::TestMessageArrayInt32 messageInt32;
+    messageInt32.add_value(1);
+    messageInt32.add_value(-2);
+    messageInt32.add_value(3);
+    EXPECT_EQ(encode(int32), messageInt32.SerializeAsString());
+
+    test_codec::TestMessageArrayBool bl;
+    bl.value = {true, false, true};
+    test::TestMessageArrayBool messageBool;
+    messageBool.add_value(true);
+    messageBool.add_value(false);
+    messageBool.add_value(true);
+    EXPECT_EQ(encode(bl), messageBool.SerializeAsString());
+
+    test_codec::TestMessageArrayString str;
+    str.value = {"Hello", "", "World"};
+    test::TestMessageArrayString messageString;
+    messageString.add_value("Hello");
+    messageString.add_value("");
+    messageString.add_value("World");
+    EXPECT_EQ(encode(str), messageString.SerializeAsString());
+
+    test_codec::TestMessageArrayEnum en;
+    en.value = {test_codec::FOO_HELLO, test_codec::FOO_WORLD2};
+    test::TestMessageArrayEnum messageEnum;
+    messageEnum.add_value(test::FOO_HELLO);
+    messageEnum.add_value(test::FOO_WORLD2);
+    EXPECT_EQ(encode(en), messageEnum.SerializeAsString());
+
+    test_codec::TestMessageArrayStruct stru;
+    stru.value.resize(2);
+    stru.value[0].last_value = 1;
+    stru.value[1].struct_string.value = "Hello";
+    test::TestMessageArrayStruct messageStruct;
+    messageStruct.add_value()->set_last_value(1);
+    messageStruct.add_value()->mutable_struct_string()->set_value("Hello");
+    std::string data = messageStruct.SerializeAsString();
+    EXPECT_EQ(encode(stru), data);
+
+    test_codec::TestMessageArrayStruct decoded;
+    EXPECT_EQ(protoDecode(data.data(), data.size(), decoded), true);
+    ASSERT_EQ(decoded.value.size(), 2);
+    EXPECT_EQ(decoded.value[0].last_value, 1);
+    EXPECT_EQ(decoded.value[1].struct_string.value, "Hello");
+}
+
+TEST(TestProtoCodec, testArrayStructWithEmptyElements)
+{
+    // the sizes of the size pass are taken in the same order by the write pass
+    test_codec::TestMessageArrayStruct stru;
+    stru.value.resize(4);
+    stru.value[1].struct_int32.value = 5;
+    stru.value[1].struct_string.value = "Hello";
+    stru.value[3].struct_string.value = "World";
+    test::TestMessageArrayStruct messageStruct;
+    messageStruct.add_value();
+    test::TestMessageStruct* message = messageStruct.add_value();
+    message->mutable_struct_int32()->set_value(5);
+    message->mutable_struct_string()->set_value("Hello");
+    messageStruct.add_value();
+    messageStruct.add_value()->mutable_struct_string()->set_value("World");
+    EXPECT_EQ(encode(stru), messageStruct.SerializeAsString());
+    EXPECT_EQ(ProtoCodec<test_codec::TestMessageArrayStruct>::size(stru), messageStruct.ByteSizeLong());
+}
+
+TEST(TestProtoCodec, testDecodeRepeatedMessageWithWrongWireType)
+{
+    // field 1, wire type varint, is skipped and not appended
+    std::string data = {0x08, 0x05, 0x0a, 0x00};
+    test_codec::TestMessageArrayStruct decoded;
+    EXPECT_EQ(protoDecode(data.data(), data.size(), decoded), true);
+    EXPECT_EQ(decoded.value.size(), 1);
+}
+
+TEST(TestProtoCodec, testDecodeNotPackedArray)
+{
+    // field 1, wire type fixed32, not packed
+    std::string data = {0x0d, 0x01, 0x00, 0x00, 0x00, 0x0d, 0x02, 0x00, 0x00, 0x00};
+    test_codec::TestMessageArrayUInt32 decoded;
+    EXPECT_EQ(protoDecode(data.data(), data.size(), decoded), true);
+    EXPECT_EQ(decoded.value, std::vector<std::uint32_t>({1, 2}));
+}
+
+TEST(TestProtoCodec, testDecodeSkipsUnknownFields)
+{
+    test::TestMessageStruct message;
+    message.mutable_struct_string()->set_value("Hello");
+    message.set_last_value(7);
+    std::string data = message.SerializeAsString();
+
+    // field 1 of TestMessageUInt32 is fixed32, the struct is skipped by its wire type, field 3 is unknown
+    test_codec::TestMessageUInt32 decoded;
+    EXPECT_EQ(protoDecode(data.data(), data.size(), decoded), true);
+    EXPECT_EQ(decoded.value, 0);
+}
+
+TEST(TestProtoCodec, testDecodeInvalid)
+{
+    std::string data = {0x0a, 0x05, 'H', 'e'};
+    test_codec::TestMessageString decoded;
+    EXPECT_EQ(protoDecode(data.data(), data.size(), decoded), false);
+}
+
+
+
+// compares the generated codec with protobuf and the visitor based SerializerProto, enable it for measurements.
+TEST(TestProtoCodec, DISABLED_testPerformance)
+{
+    static const int LOOPS = 1000000;
+
+    test_codec::TestMessageStruct value;
+    value.struct_int32.value = -5;
+    value.struct_string.value = "Hello World";
+    value.last_value = 123;
+
+    test::TestMessageStruct message;
+    message.mutable_struct_int32()->set_value(-5);
+    message.mutable_struct_string()->set_value("Hello World");
+    message.set_last_value(123);
+
+    std::string data;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOOPS; ++i)
+    {
+        protoEncode(value, data);
+    }
+    auto durationCodecEncode = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOOPS; ++i)
+    {
+        message.SerializeToString(&data);
+    }
+    auto durationProtobufEncode = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOOPS; ++i)
+    {
+        ProtocolMessage buffer(0);
+        SerializerProto serializer(buffer);
+        IParserVisitor& visitor = serializer;
+        visitor.enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStruct", ""});
+        visitor.enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageInt32", "struct_int32", "", 0});
+        visitor.enterInt32({MetaTypeId::TYPE_INT32, "", "value", "", 0}, -5);
+        visitor.exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageInt32", "struct_int32", "", 0});
+        visitor.enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageString", "struct_string", "", 1});
+        visitor.enterString({MetaTypeId::TYPE_STRING, "", "value", "", 0}, "Hello World", 11);
+        visitor.exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageString", "struct_string", "", 1});
+        visitor.enterUInt32({MetaTypeId::TYPE_UINT32, "", "last_value", "", 2}, 123);
+        visitor.exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStruct", ""});
+        visitor.finished();
+    }
+    auto durationVisitorEncode = std::chrono::steady_clock::now() - start;
+
+    message.SerializeToString(&data);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOOPS; ++i)
+    {
+        test_codec::TestMessageStruct decoded;
+        protoDecode(data.data(), data.size(), decoded);
+    }
+    auto durationCodecDecode = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOOPS; ++i)
+    {
+        test::TestMessageStruct decoded;
+        decoded.ParseFromString(data);
+    }
+    auto durationProtobufDecode = std::chrono::steady_clock::now() - start;
+
+    auto ms = [] (std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    };
+    std::cout << "encode codec: " << ms(durationCodecEncode) << "ms, protobuf: " << ms(durationProtobufEncode) << "ms, SerializerProto: " << ms(durationVisitorEncode) << "ms" << std::endl;
+    std::cout << "decode codec: " << ms(durationCodecDecode) << "ms, protobuf: " << ms(durationProtobufDecode) << "ms" << std::endl;
+}
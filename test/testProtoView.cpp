@@ -0,0 +1,134 @@
+#include "gtest/gtest.h"
+
+
+#include "serializeproto/ProtoView.h"
+#include "metadata/MetaData.h"
+#include "test.pb.h"
+
+
+
+class TestProtoView : public testing::Test
+{
+public:
+
+protected:
+    virtual void SetUp()
+    {
+        MetaStruct structInt32;
+        structInt32.setTypeName("test.TestMessageInt32");
+        structInt32.addField({MetaTypeId::TYPE_INT32, "", "value", "description"});
+        MetaDataGlobal::instance().addStruct(structInt32);
+
+        MetaStruct structString;
+        structString.setTypeName("test.TestMessageString");
+        structString.addField({MetaTypeId::TYPE_STRING, "", "value", "description"});
+        MetaDataGlobal::instance().addStruct(structString);
+
+        MetaStruct structTest;
+        structTest.setTypeName("test.TestMessageStruct");
+        structTest.addField({MetaTypeId::TYPE_STRUCT, "test.TestMessageInt32", "struct_int32", "description"});
+        structTest.addField({MetaTypeId::TYPE_STRUCT, "test.TestMessageString", "struct_string", "description"});
+        structTest.addField({MetaTypeId::TYPE_UINT32, "", "last_value", "description"});
+        MetaDataGlobal::instance().addStruct(structTest);
+
+        MetaStruct structArray;
+        structArray.setTypeName("test.TestMessageArrayStruct");
+        structArray.addField({MetaTypeId::TYPE_ARRAY_STRUCT, "test.TestMessageStruct", "value", "description"});
+        MetaDataGlobal::instance().addStruct(structArray);
+
+        MetaStruct structArrayVarint;
+        structArrayVarint.setTypeName("test.TestMessageArrayVarint");
+        structArrayVarint.addField({MetaTypeId::TYPE_ARRAY_INT64, "", "value_int64", "", 0, METAFLAG_PROTO_VARINT});
+        structArrayVarint.addField({MetaTypeId::TYPE_ARRAY_INT32, "", "value_sint32", "", 0, METAFLAG_PROTO_ZIGZAG});
+        structArrayVarint.addField({MetaTypeId::TYPE_ARRAY_UINT64, "", "value_uint64", "", 0, METAFLAG_PROTO_VARINT});
+        structArrayVarint.addField({MetaTypeId::TYPE_UINT32, "", "last_value", ""});
+        MetaDataGlobal::instance().addStruct(structArrayVarint);
+    }
+
+    virtual void TearDown()
+    {
+        MetaDataGlobal::setInstance(nullptr);
+    }
+};
+
+
+
+TEST_F(TestProtoView, testStruct)
+{
+    test::TestMessageStruct message;
+    message.mutable_struct_int32()->set_value(-2);
+    message.mutable_struct_string()->set_value("Hello World");
+    message.set_last_value(123);
+    std::string data = message.SerializeAsString();
+
+    ProtoView view("test.TestMessageStruct", data.data(), data.size());
+    EXPECT_EQ(view.isValid(), true);
+    EXPECT_EQ(view.getUInt32(view.getFieldIndex("last_value")), 123);
+    EXPECT_EQ(view.getStruct(0).getInt32(0), -2);
+    EXPECT_EQ(view.getStruct(1).getString(0), "Hello World");
+
+    const char* buffer = nullptr;
+    int size = 0;
+    EXPECT_EQ(view.getStruct(1).getString(0, buffer, size), true);
+    EXPECT_EQ(std::string(buffer, size), "Hello World");
+    // the string points into the message
+    EXPECT_GE(buffer, data.data());
+    EXPECT_LT(buffer, data.data() + data.size());
+}
+
+TEST_F(TestProtoView, testMissingAndWrongFields)
+{
+    test::TestMessageStruct message;
+    message.set_last_value(123);
+    std::string data = message.SerializeAsString();
+
+    ProtoView view("test.TestMessageStruct", data.data(), data.size());
+    EXPECT_EQ(view.hasField(0), false);
+    EXPECT_EQ(view.hasField(2), true);
+    EXPECT_EQ(view.getStruct(0).isValid(), false);
+    EXPECT_EQ(view.getStruct(0).getInt32(0), 0);
+    EXPECT_EQ(view.getInt32(2), 0);         // the field is an uint32
+    EXPECT_EQ(view.getUInt32(5), 0);        // no such field
+    EXPECT_EQ(view.getFieldIndex("foo"), -1);
+
+    ProtoView viewUnknown("test.Unknown", data.data(), data.size());
+    EXPECT_EQ(viewUnknown.isValid(), false);
+}
+
+TEST_F(TestProtoView, testInvalidData)
+{
+    std::string data = {0x12, 0x05, 'H', 'e'};
+    ProtoView view("test.TestMessageStruct", data.data(), data.size());
+    EXPECT_EQ(view.isValid(), false);
+    EXPECT_EQ(view.hasField(1), false);
+}
+
+TEST_F(TestProtoView, testArrayStruct)
+{
+    test::TestMessageArrayStruct message;
+    message.add_value()->set_last_value(1);
+    message.add_value();
+    message.add_value()->mutable_struct_string()->set_value("Hello");
+    std::string data = message.SerializeAsString();
+
+    ProtoView view("test.TestMessageArrayStruct", data.data(), data.size());
+    std::vector<ProtoView> entries = view.getArrayStruct(0);
+    ASSERT_EQ(entries.size(), 3);
+    EXPECT_EQ(entries[0].getUInt32(2), 1);
+    EXPECT_EQ(entries[1].isValid(), true);
+    EXPECT_EQ(entries[1].hasField(2), false);
+    EXPECT_EQ(entries[2].getStruct(1).getString(0), "Hello");
+}
+
+TEST_F(TestProtoView, testVarint)
+{
+    test::TestMessageArrayVarint message;
+    message.add_value_int64(5);
+    message.set_last_value(7);
+    std::string data = message.SerializeAsString();
+
+    ProtoView view("test.TestMessageArrayVarint", data.data(), data.size());
+    EXPECT_EQ(view.hasField(0), true);
+    EXPECT_EQ(view.hasField(1), false);
+    EXPECT_EQ(view.getUInt32(3), 7);
+}
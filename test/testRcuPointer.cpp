@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+
+#include "helpers/RcuPointer.h"
+
+#include <thread>
+
+
+
+struct RcuValue
+{
+    RcuValue(int v, std::atomic<int>& d)
+        : value(v)
+        , deleted(d)
+    {
+    }
+    ~RcuValue()
+    {
+        ++deleted;
+    }
+    int                 value;
+    std::atomic<int>&   deleted;
+};
+
+
+
+TEST(TestRcuPointer, testPublishWithoutReaders)
+{
+    std::atomic<int> deleted{0};
+    {
+        RcuPointer<RcuValue> rcu(std::make_unique<RcuValue>(1, deleted));
+        rcu.publish(std::make_unique<RcuValue>(2, deleted));
+        EXPECT_EQ(deleted, 1);
+        RcuPointer<RcuValue>::Reader reader(rcu);
+        EXPECT_EQ(reader->value, 2);
+    }
+    EXPECT_EQ(deleted, 2);
+}
+
+TEST(TestRcuPointer, testReaderKeepsObject)
+{
+    std::atomic<int> deleted{0};
+    RcuPointer<RcuValue> rcu(std::make_unique<RcuValue>(1, deleted));
+    {
+        RcuPointer<RcuValue>::Reader reader(rcu);
+        for (int i = 2; i < 10; ++i)
+        {
+            rcu.publish(std::make_unique<RcuValue>(i, deleted));
+        }
+        EXPECT_EQ(reader->value, 1);
+        // only the object of the reader's epoch and the objects retired after it are kept
+        EXPECT_LT(deleted, 8);
+        RcuPointer<RcuValue>::Reader readerNew(rcu);
+        EXPECT_EQ(readerNew->value, 9);
+    }
+    rcu.publish(std::make_unique<RcuValue>(10, deleted));
+    EXPECT_EQ(deleted, 9);
+    EXPECT_EQ(rcu.get().value, 10);
+}
+
+TEST(TestRcuPointer, testConcurrentReaders)
+{
+    std::atomic<int> deleted{0};
+    RcuPointer<RcuValue> rcu(std::make_unique<RcuValue>(0, deleted));
+    std::atomic<bool> running{true};
+    std::atomic<int> errors{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&rcu, &running, &errors] () {
+            int valueLast = 0;
+            while (running)
+            {
+                RcuPointer<RcuValue>::Reader reader(rcu);
+                int value = reader->value;
+                if (value < valueLast)
+                {
+                    ++errors;
+                }
+                valueLast = value;
+            }
+        });
+    }
+    for (int i = 1; i <= 10000; ++i)
+    {
+        rcu.publish(std::make_unique<RcuValue>(i, deleted));
+    }
+    running = false;
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+    EXPECT_EQ(errors, 0);
+    rcu.publish(std::make_unique<RcuValue>(0, deleted));
+    EXPECT_EQ(deleted, 10001);
+}
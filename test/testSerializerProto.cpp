@@ -474,3 +474,34 @@ TEST_F(TestSerializerProto, testArrayEnum)
     EXPECT_EQ(std::vector<std::int32_t>(message.value().begin(), message.value().end()), VALUE);
 }
 
+
+TEST_F(TestSerializerProto, testArrayVarintPacked)
+{
+    static const std::vector<std::int64_t> VALUE_INT64 = {0, 1, -1, 1234567890123LL};
+    static const std::vector<std::int32_t> VALUE_SINT32 = {0, -1, 64, -65};
+    static const std::vector<std::uint64_t> VALUE_UINT64 = {127, 128, 0xffffffffffffffffULL};
+    static const std::uint32_t VALUE_LAST = 123;
+
+    m_serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageArrayVarint", ""});
+    m_serializer->enterArrayInt64({MetaTypeId::TYPE_ARRAY_INT64, "", "value_int64", "", 0, METAFLAG_PROTO_VARINT}, VALUE_INT64.data(), VALUE_INT64.size());
+    m_serializer->enterArrayInt32({MetaTypeId::TYPE_ARRAY_INT32, "", "value_sint32", "", 1, METAFLAG_PROTO_ZIGZAG}, VALUE_SINT32.data(), VALUE_SINT32.size());
+    m_serializer->enterArrayUInt64({MetaTypeId::TYPE_ARRAY_UINT64, "", "value_uint64", "", 2, METAFLAG_PROTO_VARINT}, VALUE_UINT64.data(), VALUE_UINT64.size());
+    m_serializer->enterUInt32({MetaTypeId::TYPE_UINT32, "", "last_value", "", 3}, VALUE_LAST);
+    m_serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageArrayVarint", ""});
+
+    test::TestMessageArrayVarint message;
+    for (auto value : VALUE_INT64)
+    {
+        message.add_value_int64(value);
+    }
+    for (auto value : VALUE_SINT32)
+    {
+        message.add_value_sint32(value);
+    }
+    for (auto value : VALUE_UINT64)
+    {
+        message.add_value_uint64(value);
+    }
+    message.set_last_value(VALUE_LAST);
+    EXPECT_EQ(m_data, message.SerializeAsString());
+}
@@ -409,3 +409,92 @@ TEST(TestSerializerProtoStruct, test122DataBlockSize1)
     EXPECT_EQ(message.last_value(), VALUE3);
 }
 
+
+
+
+
+void helperTestStructSizeExact(int size)
+{
+    const std::int32_t VALUE1 = 0;
+    const std::string VALUE2 = std::string(size, 'a');
+    const std::uint32_t VALUE3 = 123;
+
+    String data;
+    MockIZeroCopyBuffer mockBuffer;
+    EXPECT_CALL(mockBuffer, addBuffer(_)).Times(1).WillOnce(Invoke([&data] (int size) {
+        data.resize(size);
+        return (char*)data.data();
+    }));
+    EXPECT_CALL(mockBuffer, downsizeLastBuffer(_)).Times(1).WillOnce(Invoke(&data, &String::resize));
+
+    std::unique_ptr<IParserVisitor> serializer = std::make_unique<SerializerProto>(mockBuffer, 100, true);
+
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStruct", ""});
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageInt32", "struct_int32", "", 0});
+    serializer->enterInt32({MetaTypeId::TYPE_INT32, "", "value", "", 0}, VALUE1);
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageInt32", "struct_int32", "", 0});
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageString", "struct_string", "", 1});
+    serializer->enterString({MetaTypeId::TYPE_STRING, "", "value", "", 0}, VALUE2.data(), VALUE2.size());
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageString", "struct_string", "", 1});
+    serializer->enterUInt32({MetaTypeId::TYPE_UINT32, "", "value", "", 2}, VALUE3);
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStruct", ""});
+
+    // empty structs are not serialized
+    test::TestMessageStruct message;
+    if (size > 0)
+    {
+        message.mutable_struct_string()->set_value(VALUE2);
+    }
+    message.set_last_value(VALUE3);
+    EXPECT_EQ(data, message.SerializeAsString());
+}
+
+TEST(TestSerializerProtoStruct, testExactSize)
+{
+    helperTestStructSizeExact(0);
+    helperTestStructSizeExact(32);
+    helperTestStructSizeExact(125);
+    helperTestStructSizeExact(126);
+    helperTestStructSizeExact(16380);
+    helperTestStructSizeExact(16381);
+    helperTestStructSizeExact(2097152);
+}
+
+
+TEST(TestSerializerProtoStruct, testExactSizeArrayStruct)
+{
+    String data;
+    MockIZeroCopyBuffer mockBuffer;
+    EXPECT_CALL(mockBuffer, addBuffer(_)).Times(1).WillOnce(Invoke([&data] (int size) {
+        data.resize(size);
+        return (char*)data.data();
+    }));
+    EXPECT_CALL(mockBuffer, downsizeLastBuffer(_)).Times(1).WillOnce(Invoke(&data, &String::resize));
+
+    std::unique_ptr<IParserVisitor> serializer = std::make_unique<SerializerProto>(mockBuffer, 1, true);
+
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageArrayStruct", ""});
+    serializer->enterArrayStruct({MetaTypeId::TYPE_ARRAY_STRUCT, "test.TestMessageStruct", "value", "", 0});
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStruct", "", "", 0});
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageInt32", "struct_int32", "", 0});
+    serializer->enterInt32({MetaTypeId::TYPE_INT32, "", "value", "", 0}, -2);
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageInt32", "struct_int32", "", 0});
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageString", "struct_string", "", 1});
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageString", "struct_string", "", 1});
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStruct", "", "", 0});
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStruct", "", "", 0});
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStruct", "", "", 0});
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStruct", "", "", 0});
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageString", "struct_string", "", 1});
+    serializer->enterString({MetaTypeId::TYPE_STRING, "", "value", "", 0}, std::string(200, 'a'));
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageString", "struct_string", "", 1});
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStruct", "", "", 0});
+    serializer->exitArrayStruct({MetaTypeId::TYPE_ARRAY_STRUCT, "test.TestMessageStruct", "value", "", 0});
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageArrayStruct", ""});
+
+    test::TestMessageArrayStruct message;
+    message.add_value()->mutable_struct_int32()->set_value(-2);
+    message.add_value();
+    message.add_value()->mutable_struct_string()->set_value(std::string(200, 'a'));
+    EXPECT_EQ(data, message.SerializeAsString());
+}
@@ -3,9 +3,11 @@
 
 
 #include "serializevariant/SerializerVariant.h"
+#include "serializejson/ParserJson.h"
 #include "variant/VariantValues.h"
 #include "variant/VariantValueList.h"
 #include "variant/VariantValueStruct.h"
+#include "variant/VariantValueView.h"
 #include "metadata/MetaData.h"
 
 
@@ -170,6 +172,71 @@ TEST_F(TestSerializerVariant, testBytes)
     ASSERT_EQ(m_root == cmp, true);
 }
 
+TEST_F(TestSerializerVariant, testStringAndBytesView)
+{
+    std::shared_ptr<std::string> buffer = std::make_shared<std::string>("Hello World");
+    std::unique_ptr<IParserVisitor> serializer = std::make_unique<SerializerVariant>(m_root, true, true, buffer, buffer->data(), buffer->size());
+
+    serializer->enterStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStringBytes", ""});
+    serializer->enterString({MetaTypeId::TYPE_STRING, "", "value", "", 0}, buffer->data(), 5);
+    serializer->enterBytes({MetaTypeId::TYPE_BYTES, "", "data", "", 1}, buffer->data() + 6, 5);
+    serializer->exitStruct({MetaTypeId::TYPE_STRUCT, "test.TestMessageStringBytes", ""});
+    serializer->finished();
+    serializer = nullptr;
+
+    const Variant* value = m_root.getVariant("value");
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(value->getType(), VARTYPE_STRING_VIEW);
+    const StringView* view = *value;
+    EXPECT_EQ(view->data, buffer->data());
+    EXPECT_EQ(m_root.getDataValue<std::string>("value"), "Hello");
+    EXPECT_EQ(m_root.getDataValue<Bytes>("data"), Bytes({'W','o','r','l','d'}));
+
+    // the views keep the buffer alive
+    std::weak_ptr<std::string> weakBuffer = buffer;
+    buffer = nullptr;
+    EXPECT_EQ(weakBuffer.expired(), false);
+
+    m_root.materialize();
+    EXPECT_EQ(weakBuffer.expired(), true);
+
+    Variant cmp = VariantStruct({{"value", std::string("Hello")}, {"data", Bytes({'W','o','r','l','d'})}});
+    ASSERT_EQ(m_root == cmp, true);
+}
+
+TEST_F(TestSerializerVariant, testViewsFromParserJson)
+{
+    MetaStruct structTest;
+    structTest.setTypeName("test.TestStringBytesView");
+    structTest.addField({MetaTypeId::TYPE_STRING, "", "value", "description"});
+    structTest.addField({MetaTypeId::TYPE_BYTES, "", "data", "description"});
+    MetaDataGlobal::instance().addStruct(structTest);
+
+    // the escaped bytes are unescaped by the parser into a temporary string, they must be copied
+    std::shared_ptr<std::string> buffer = std::make_shared<std::string>("{\"value\":\"Hello\",\"data\":\"Wo\\u0000ld\"}");
+    {
+        SerializerVariant serializer(m_root, true, true, buffer, buffer->data(), buffer->size());
+        ParserJson parser(serializer, buffer->data(), buffer->size());
+        bool res = parser.parseStruct("test.TestStringBytesView");
+        EXPECT_EQ(res, true);
+    }
+
+    const Variant* value = m_root.getVariant("value");
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(value->getType(), VARTYPE_STRING_VIEW);
+    const StringView* view = *value;
+    EXPECT_GE(view->data, buffer->data());
+    EXPECT_LE(view->data + view->size, buffer->data() + buffer->size());
+
+    const Variant* data = m_root.getVariant("data");
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(data->getType(), MetaTypeId::TYPE_BYTES);
+
+    Variant cmp = VariantStruct({{"value", std::string("Hello")}, {"data", Bytes({'W','o','\0','l','d'})}});
+    m_root.materialize();
+    ASSERT_EQ(m_root == cmp, true);
+}
+
 
 TEST_F(TestSerializerVariant, testStruct)
 {
@@ -0,0 +1,180 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+
+#include "streamconnection/StreamConnection.h"
+#include "protocolconnection/ProtocolMessage.h"
+#include "helpers/OperatingSystem.h"
+
+
+#include "MockIOperatingSystem.h"
+#include "MockIPoller.h"
+
+
+using ::testing::_;
+using ::testing::Return;
+using ::testing::InSequence;
+
+
+static const int TESTSOCKET = 7;
+
+
+class TestStreamConnection: public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        m_mockMockOperatingSystem = new MockIOperatingSystem;
+        std::unique_ptr<IOperatingSystem> iOperatingSystem(m_mockMockOperatingSystem);
+        OperatingSystem::setInstance(iOperatingSystem);
+        EXPECT_CALL(*m_mockMockOperatingSystem, setNonBlocking(TESTSOCKET, true)).WillRepeatedly(Return(0));
+        EXPECT_CALL(*m_mockMockOperatingSystem, setLinger(TESTSOCKET, true, 0)).WillRepeatedly(Return(0));
+        EXPECT_CALL(*m_mockMockOperatingSystem, setNoDelay(TESTSOCKET, true)).WillRepeatedly(Return(0));
+
+        m_mockPoller = std::make_shared<MockIPoller>();
+
+        SocketPtr socket = std::make_shared<Socket>();
+        socket->attach(TESTSOCKET);
+        ConnectionData connectionData;
+        connectionData.connectionState = CONNECTIONSTATE_CONNECTED;
+        m_connection = std::make_shared<StreamConnection>(connectionData, socket, m_mockPoller, std::make_shared<FlushDeadlines>(), nullptr);
+    }
+
+    virtual void TearDown()
+    {
+        EXPECT_CALL(*m_mockMockOperatingSystem, closeSocket(TESTSOCKET)).WillRepeatedly(Return(0));
+        m_connection = nullptr;
+        m_mockPoller = nullptr;
+        std::unique_ptr<IOperatingSystem> resetOperatingSystem;
+        OperatingSystem::setInstance(resetOperatingSystem);
+    }
+
+    MockIOperatingSystem*                   m_mockMockOperatingSystem = nullptr;
+    std::shared_ptr<MockIPoller>            m_mockPoller;
+    IStreamConnectionPrivatePtr             m_connection;
+};
+
+
+
+TEST_F(TestStreamConnection, testFirstSendFails)
+{
+    IMessagePtr message = std::make_shared<ProtocolMessage>(0);
+    message->addSendPayload(std::string(100, 'a'));
+    const BufferRef& payload = message->getAllSendBuffers().front();
+
+    {
+        InSequence seq;
+        // the first send fails, the message stays pending
+        EXPECT_CALL(*m_mockMockOperatingSystem, send(TESTSOCKET, payload.first, payload.second, 0)).Times(1)
+                    .WillOnce(Return(-1));
+        EXPECT_CALL(*m_mockPoller, enableWrite(_)).Times(1);
+        // the pending message is sent from its beginning, not from offset -1
+        EXPECT_CALL(*m_mockMockOperatingSystem, send(TESTSOCKET, payload.first, payload.second, 0)).Times(1)
+                    .WillOnce(Return(payload.second));
+        EXPECT_CALL(*m_mockPoller, disableWrite(_)).Times(1);
+    }
+    EXPECT_CALL(*m_mockMockOperatingSystem, getLastError()).WillRepeatedly(Return(ECONNRESET));
+
+    EXPECT_EQ(m_connection->sendMessage(message), true);
+    EXPECT_EQ(m_connection->getPendingMessages(), 1);
+
+    EXPECT_EQ(m_connection->sendPendingMessages(), false);
+    EXPECT_EQ(m_connection->getPendingMessages(), 0);
+}
+
+
+TEST_F(TestStreamConnection, testPartialSendOfFirstBuffer)
+{
+    IMessagePtr message = std::make_shared<ProtocolMessage>(0);
+    message->addSendPayload(std::string(100, 'a'));
+    message->addSendPayload(std::string(200, 'b'));
+    const BufferRef& payload1 = message->getAllSendBuffers().front();
+    const BufferRef& payload2 = message->getAllSendBuffers().back();
+
+    {
+        InSequence seq;
+        // only 40 bytes of the first buffer are sent, then the socket would block
+        EXPECT_CALL(*m_mockMockOperatingSystem, send(TESTSOCKET, payload1.first, payload1.second, MSG_MORE)).Times(1)
+                    .WillOnce(Return(40));
+        EXPECT_CALL(*m_mockMockOperatingSystem, send(TESTSOCKET, payload1.first + 40, payload1.second - 40, MSG_MORE)).Times(1)
+                    .WillOnce(Return(-1));
+        EXPECT_CALL(*m_mockPoller, enableWrite(_)).Times(1);
+        // the rest of the first buffer
+        EXPECT_CALL(*m_mockMockOperatingSystem, send(TESTSOCKET, payload1.first + 40, payload1.second - 40, MSG_MORE)).Times(1)
+                    .WillOnce(Return(payload1.second - 40));
+        // the second buffer starts at offset 0
+        EXPECT_CALL(*m_mockMockOperatingSystem, send(TESTSOCKET, payload2.first, payload2.second, 0)).Times(1)
+                    .WillOnce(Return(payload2.second));
+        EXPECT_CALL(*m_mockPoller, disableWrite(_)).Times(1);
+    }
+    EXPECT_CALL(*m_mockMockOperatingSystem, getLastError()).WillRepeatedly(Return(EWOULDBLOCK));
+
+    EXPECT_EQ(m_connection->sendMessage(message), true);
+    EXPECT_EQ(m_connection->getPendingMessages(), 1);
+
+    EXPECT_EQ(m_connection->sendPendingMessages(), false);
+    EXPECT_EQ(m_connection->getPendingMessages(), 0);
+}
+
+
+TEST_F(TestStreamConnection, testCoalescingBufferGrows)
+{
+    m_connection->setCoalescing(1024 * 1024, 0, 0);
+
+    std::string expected;
+    std::string sent;
+    std::vector<int> sizesSent;
+    EXPECT_CALL(*m_mockMockOperatingSystem, send(TESTSOCKET, _, _, _))
+                .WillRepeatedly(testing::Invoke([&sent, &sizesSent] (int fd, const void* buffer, size_t len, int flags) {
+                    sent.append(static_cast<const char*>(buffer), len);
+                    sizesSent.push_back(static_cast<int>(len));
+                    return static_cast<int>(len);
+                }));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        IMessagePtr message = std::make_shared<ProtocolMessage>(0);
+        std::string payload(3000, static_cast<char>('a' + i));
+        message->addSendPayload(payload);
+        expected += payload;
+        EXPECT_EQ(m_connection->sendMessage(message), true);
+    }
+    EXPECT_EQ(sent.empty(), true);
+    m_connection->flush();
+
+    // the first buffer (4096 bytes) holds one message, the second one (8192 bytes) the next two
+    ASSERT_EQ(sizesSent.size(), 2);
+    EXPECT_EQ(sizesSent[0], 3000);
+    EXPECT_EQ(sizesSent[1], 6000);
+    EXPECT_EQ(sent, expected);
+}
+
+
+TEST_F(TestStreamConnection, testNotifyWhenSent)
+{
+    int notified = 0;
+    m_connection->notifyWhenSent([&notified] () { ++notified; });
+    // nothing is pending
+    EXPECT_EQ(notified, 1);
+
+    IMessagePtr message = std::make_shared<ProtocolMessage>(0);
+    message->addSendPayload(std::string(100, 'a'));
+    const BufferRef& payload = message->getAllSendBuffers().front();
+    {
+        InSequence seq;
+        EXPECT_CALL(*m_mockMockOperatingSystem, send(TESTSOCKET, payload.first, payload.second, 0)).Times(1)
+                    .WillOnce(Return(-1));
+        EXPECT_CALL(*m_mockPoller, enableWrite(_)).Times(1);
+        EXPECT_CALL(*m_mockMockOperatingSystem, send(TESTSOCKET, payload.first, payload.second, 0)).Times(1)
+                    .WillOnce(Return(payload.second));
+        EXPECT_CALL(*m_mockPoller, disableWrite(_)).Times(1);
+    }
+    EXPECT_CALL(*m_mockMockOperatingSystem, getLastError()).WillRepeatedly(Return(EWOULDBLOCK));
+
+    EXPECT_EQ(m_connection->sendMessage(message), true);
+    m_connection->notifyWhenSent([&notified] () { ++notified; });
+    EXPECT_EQ(notified, 1);
+
+    EXPECT_EQ(m_connection->sendPendingMessages(), false);
+    EXPECT_EQ(notified, 2);
+}
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+
+#include "connectionhub/TopicRouter.h"
+
+
+
+static std::vector<std::int64_t> getSubscribers(const TopicRouter& router, const std::string& topic)
+{
+    std::vector<std::int64_t> sessionIds;
+    router.getSubscribers(topic, sessionIds);
+    return sessionIds;
+}
+
+
+
+TEST(TestTopicRouter, testExact)
+{
+    TopicRouter router;
+    router.subscribe(1, "a/b");
+    router.subscribe(2, "a/b/c");
+    EXPECT_EQ(getSubscribers(router, "a/b"), std::vector<std::int64_t>({1}));
+    EXPECT_EQ(getSubscribers(router, "a/b/c"), std::vector<std::int64_t>({2}));
+    EXPECT_EQ(getSubscribers(router, "a"), std::vector<std::int64_t>());
+    EXPECT_EQ(getSubscribers(router, "a/b/c/d"), std::vector<std::int64_t>());
+}
+
+TEST(TestTopicRouter, testWildcards)
+{
+    TopicRouter router;
+    router.subscribe(1, "a/+/c");
+    router.subscribe(2, "a/#");
+    router.subscribe(3, "#");
+    router.subscribe(4, "+/b/+");
+    EXPECT_EQ(getSubscribers(router, "a/b/c"), std::vector<std::int64_t>({1, 2, 3, 4}));
+    EXPECT_EQ(getSubscribers(router, "a/x/c"), std::vector<std::int64_t>({1, 2, 3}));
+    EXPECT_EQ(getSubscribers(router, "a"), std::vector<std::int64_t>({2, 3}));
+    EXPECT_EQ(getSubscribers(router, "x/b/y"), std::vector<std::int64_t>({3, 4}));
+    EXPECT_EQ(getSubscribers(router, "x/b"), std::vector<std::int64_t>({3}));
+}
+
+TEST(TestTopicRouter, testSessionOnlyOnce)
+{
+    TopicRouter router;
+    router.subscribe(1, "a/+");
+    router.subscribe(1, "a/b");
+    router.subscribe(1, "a/#");
+    EXPECT_EQ(getSubscribers(router, "a/b"), std::vector<std::int64_t>({1}));
+}
+
+TEST(TestTopicRouter, testUnsubscribe)
+{
+    TopicRouter router;
+    router.subscribe(1, "a/+");
+    router.subscribe(1, "a/b");
+    router.subscribe(2, "a/b");
+    router.unsubscribe(1, "a/b");
+    EXPECT_EQ(getSubscribers(router, "a/b"), std::vector<std::int64_t>({1, 2}));
+    router.unsubscribe(1, "a/+");
+    EXPECT_EQ(getSubscribers(router, "a/b"), std::vector<std::int64_t>({2}));
+    router.subscribe(1, "a/#");
+    router.unsubscribeAll(2);
+    router.unsubscribeAll(1);
+    EXPECT_EQ(getSubscribers(router, "a/b"), std::vector<std::int64_t>());
+}
+
+TEST(TestTopicRouter, testInvalidPattern)
+{
+    TopicRouter router;
+    EXPECT_EQ(router.subscribe(1, "a/#/b"), false);
+    EXPECT_EQ(router.subscribe(1, "a/b#"), false);
+    EXPECT_EQ(router.subscribe(1, "a+/b"), false);
+    EXPECT_EQ(router.hasSubscriptions(1), false);
+    EXPECT_EQ(getSubscribers(router, "a/x/b"), std::vector<std::int64_t>());
+    EXPECT_EQ(router.subscribe(1, "+/#"), true);
+    EXPECT_EQ(getSubscribers(router, "a/x/b"), std::vector<std::int64_t>({1}));
+}
+
+TEST(TestTopicRouter, testRoutesKeepTheirVersion)
+{
+    TopicRouter router;
+    router.subscribe(1, "a/b");
+    router.subscribe(2, "x/#");
+    TopicRoutes routes = router.getRoutes();
+    router.subscribe(3, "a/b");
+    router.unsubscribe(2, "x/#");
+    std::vector<std::int64_t> sessionIds;
+    routes.getSubscribers("a/b", sessionIds);
+    EXPECT_EQ(sessionIds, std::vector<std::int64_t>({1}));
+    sessionIds.clear();
+    routes.getSubscribers("x/y", sessionIds);
+    EXPECT_EQ(sessionIds, std::vector<std::int64_t>({2}));
+    EXPECT_EQ(getSubscribers(router, "a/b"), std::vector<std::int64_t>({1, 3}));
+    EXPECT_EQ(getSubscribers(router, "x/y"), std::vector<std::int64_t>());
+}
@@ -5,9 +5,14 @@
 #include "variant/VariantValueStruct.h"
 #include "variant/VariantValueList.h"
 #include "variant/VariantValues.h"
+#include "variant/VariantValueView.h"
 #include "variant/Variant.h"
+#include "variant/VariantPath.h"
+#include "metadata/MetaData.h"
 #include "conversions/Conversions.h"
 
+#include <thread>
+
 
 //using ::testing::_;
 //using ::testing::Return;
@@ -542,3 +547,226 @@ TEST_F(TestVariant, testListSub)
     ASSERT_EQ(var, nullptr);
 }
 
+
+
+TEST_F(TestVariant, testCopyOnWrite)
+{
+    Variant variant = VariantStruct({{"hello", std::string("world")}, {"sub", VariantStruct({{"a", 100}, {"b", std::string("200")}})}});
+    Variant copy = variant;
+
+    // the copy shares the data until it is modified
+    const Variant& constVariant = variant;
+    const Variant& constCopy = copy;
+    ASSERT_EQ(constCopy.getData<VariantStruct>(""), constVariant.getData<VariantStruct>(""));
+    ASSERT_EQ(constCopy.getData<std::string>("sub.b"), constVariant.getData<std::string>("sub.b"));
+
+    Variant* sub = copy.getVariant("sub");
+    ASSERT_NE(sub, nullptr);
+    sub->add("c", 300);
+    ASSERT_NE(constCopy.getData<VariantStruct>(""), constVariant.getData<VariantStruct>(""));
+    // unmodified sub variants stay shared
+    ASSERT_EQ(constCopy.getData<std::string>("hello"), constVariant.getData<std::string>("hello"));
+    ASSERT_EQ(constCopy.getData<std::string>("sub.b"), constVariant.getData<std::string>("sub.b"));
+
+    std::string* b = copy.getData<std::string>("sub.b");
+    ASSERT_NE(b, nullptr);
+    *b = "changed";
+
+    VariantStruct s = {{"hello", std::string("world")}, {"sub", VariantStruct({{"a", 100}, {"b", std::string("200")}})}};
+    ASSERT_EQ(variant == s, true);
+    VariantStruct c = {{"hello", std::string("world")}, {"sub", VariantStruct({{"a", 100}, {"b", std::string("changed")}, {"c", 300}})}};
+    ASSERT_EQ(copy == c, true);
+}
+
+
+TEST_F(TestVariant, testMaterializeDetachesOnlyPathsToViews)
+{
+    std::shared_ptr<std::string> buffer = std::make_shared<std::string>("view");
+    std::shared_ptr<IVariantValue> view = std::make_shared<VariantValueStringView>(StringView{buffer->data(), 4}, buffer);
+    Variant variant = VariantStruct({{"hello", std::string("world")},
+                                     {"sub", VariantStruct({{"a", 100}, {"b", std::string("200")}})},
+                                     {"list", VariantList({VariantStruct({{"v", Variant(view)}})})}});
+    Variant copy = variant;
+    const Variant& constVariant = variant;
+    const Variant& constCopy = copy;
+
+    copy.materialize();
+    // the sub tree without views stays shared, the view is replaced only in the copy
+    ASSERT_NE(constCopy.getData<VariantStruct>(""), constVariant.getData<VariantStruct>(""));
+    ASSERT_EQ(constCopy.getData<VariantStruct>("sub"), constVariant.getData<VariantStruct>("sub"));
+    ASSERT_EQ(constCopy.getData<std::string>("hello"), constVariant.getData<std::string>("hello"));
+    ASSERT_EQ(constVariant.getVariant("list.0.v")->getType(), VARTYPE_STRING_VIEW);
+    ASSERT_EQ(constCopy.getVariant("list.0.v")->getType(), TYPE_STRING);
+    ASSERT_EQ(copy.getDataValue<std::string>("list.0.v"), "view");
+
+    // without views nothing is detached
+    Variant copy2 = copy;
+    copy2.materialize();
+    ASSERT_EQ(static_cast<const Variant&>(copy2).getData<VariantStruct>(""), constCopy.getData<VariantStruct>(""));
+}
+
+
+TEST_F(TestVariant, testInlineScalars)
+{
+    Variant variant = std::int64_t(-123);
+    ASSERT_EQ(variant.getType(), TYPE_INT64);
+    ASSERT_EQ(variant.size(), 1);
+
+    // the scalar is stored in the variant itself
+    std::int64_t* pval = variant;
+    ASSERT_NE(pval, nullptr);
+    ASSERT_GE(reinterpret_cast<char*>(pval), reinterpret_cast<char*>(&variant));
+    ASSERT_LT(reinterpret_cast<char*>(pval), reinterpret_cast<char*>(&variant) + sizeof(Variant));
+    double* pdval = variant;
+    ASSERT_EQ(pdval, nullptr);
+
+    Variant copy = variant;
+    *pval = 10;
+    ASSERT_EQ(static_cast<std::int64_t>(copy), -123);
+    ASSERT_EQ(static_cast<std::int64_t>(variant), 10);
+    ASSERT_EQ(variant.getDataValue<std::string>(""), "10");
+
+    Variant moved = std::move(variant);
+    ASSERT_EQ(moved.getType(), TYPE_INT64);
+    ASSERT_EQ(variant.getType(), VARTYPE_NONE);
+
+    ASSERT_EQ(moved == Variant(std::int64_t(10)), true);
+    ASSERT_EQ(moved == Variant(std::int32_t(10)), false);
+    std::shared_ptr<IVariantValue> heapValue = std::make_shared<VariantValueInt64>(10);
+    ASSERT_EQ(moved == Variant(heapValue), true);
+    ASSERT_EQ(Variant() == Variant(), true);
+}
+
+
+
+TEST_F(TestVariant, testVariantPath)
+{
+    Variant variant = VariantStruct({{"hello", -123}, {"list", VariantList({VariantStruct({{"a", 100}}), VariantStruct({{"a", 200}})})}});
+
+    VariantPath path("list.1.a");
+    ASSERT_EQ(path.getEntries().size(), 3);
+    ASSERT_EQ(path.getEntries()[1].listIndex, 1);
+    ASSERT_EQ(variant.getDataValue<std::int32_t>(path), 200);
+    ASSERT_EQ(variant.getDataValue<std::int32_t>(VariantPath("hello")), -123);
+    ASSERT_EQ(variant.getVariant(VariantPath("list.2.a")), nullptr);
+    ASSERT_EQ(variant.getVariant(VariantPath("hello.a")), nullptr);
+    ASSERT_EQ(variant.getVariant(VariantPath("")), &variant);
+}
+
+
+TEST_F(TestVariant, testStructBoundToMetaStruct)
+{
+    MetaStruct structSub;
+    structSub.setTypeName("test.VariantPathSub");
+    structSub.addField({MetaTypeId::TYPE_INT32, "", "a", "description", 0});
+    structSub.addField({MetaTypeId::TYPE_STRING, "", "b", "description", 1});
+    MetaStruct structRoot;
+    structRoot.setTypeName("test.VariantPathRoot");
+    structRoot.addField({MetaTypeId::TYPE_INT32, "", "hello", "description", 0});
+    structRoot.addField({MetaTypeId::TYPE_STRUCT, "test.VariantPathSub", "sub", "description", 1});
+    structRoot.addField({MetaTypeId::TYPE_ARRAY_STRUCT, "test.VariantPathSub", "list", "description", 2});
+    MetaDataGlobal::instance().addStruct(structSub);
+    MetaDataGlobal::instance().addStruct(structRoot);
+    const MetaStruct* metaRoot = MetaDataGlobal::instance().getStruct("test.VariantPathRoot");
+    const MetaStruct* metaSub = MetaDataGlobal::instance().getStruct("test.VariantPathSub");
+    ASSERT_NE(metaRoot, nullptr);
+    ASSERT_NE(metaSub, nullptr);
+
+    std::shared_ptr<IVariantValue> valueRoot = std::make_shared<VariantValueStruct>(*metaRoot);
+    std::shared_ptr<IVariantValue> valueSub = std::make_shared<VariantValueStruct>(*metaSub);
+    std::shared_ptr<IVariantValue> valueEntry = std::make_shared<VariantValueStruct>(*metaSub);
+    Variant variant = valueRoot;
+    Variant entry = valueEntry;
+    entry.add("a", 300);
+    variant.add("list", VariantList({entry}));
+    variant.add("extra", std::string("not in meta data"));
+    variant.add("sub", Variant(valueSub));
+    variant.getVariant("sub")->add("b", std::string("world"));
+    variant.getVariant("sub")->add("a", 100);
+    variant.add("hello", -123);
+    ASSERT_EQ(variant.add("hello", 5), false);
+
+    VariantPath path("sub.b", metaRoot);
+    ASSERT_EQ(path.getEntries()[0].fieldIndex, 1);
+    ASSERT_EQ(path.getEntries()[1].metaStruct, metaSub);
+    ASSERT_EQ(path.getEntries()[1].fieldIndex, 1);
+    ASSERT_EQ(variant.getDataValue<std::string>(path), "world");
+    ASSERT_EQ(variant.getDataValue<std::int32_t>(VariantPath("list.0.a", metaRoot)), 300);
+    ASSERT_EQ(variant.getDataValue<std::int32_t>(VariantPath("sub.a")), 100);
+    ASSERT_EQ(variant.getDataValue<std::int32_t>("hello"), -123);
+    ASSERT_EQ(variant.getDataValue<std::string>("extra"), "not in meta data");
+    ASSERT_EQ(variant.getVariant(VariantPath("sub.c", metaRoot)), nullptr);
+
+    VariantStruct s = {{"list", VariantList({VariantStruct({{"a", 300}})})}, {"extra", std::string("not in meta data")},
+                       {"sub", VariantStruct({{"b", std::string("world")}, {"a", 100}})}, {"hello", -123}};
+    ASSERT_EQ(variant == s, true);
+
+    // a copy keeps the binding
+    Variant copy = variant;
+    copy.getVariant("sub")->add("x", 1);
+    ASSERT_EQ(copy.getDataValue<std::string>(path), "world");
+}
+
+TEST_F(TestVariant, testStructBoundToMetaStructChangedDirectly)
+{
+    MetaStruct structTest;
+    structTest.setTypeName("test.VariantStructChanged");
+    structTest.addField({MetaTypeId::TYPE_INT32, "", "a", "description", 0});
+    structTest.addField({MetaTypeId::TYPE_INT32, "", "b", "description", 1});
+    structTest.addField({MetaTypeId::TYPE_INT32, "", "c", "description", 2});
+    MetaDataGlobal::instance().addStruct(structTest);
+    const MetaStruct* metaTest = MetaDataGlobal::instance().getStruct("test.VariantStructChanged");
+    ASSERT_NE(metaTest, nullptr);
+
+    Variant variant = std::shared_ptr<IVariantValue>(std::make_shared<VariantValueStruct>(*metaTest));
+    variant.add("a", 1);
+    variant.add("b", 2);
+
+    // the entries are changed without the variant, the positions of the fields are stale
+    VariantStruct* stru = variant;
+    ASSERT_NE(stru, nullptr);
+    stru->erase(stru->begin());
+    stru->push_back(std::make_pair(std::string("c"), Variant(3)));
+
+    ASSERT_EQ(variant.getDataValue<std::int32_t>(VariantPath("b", metaTest)), 2);
+    ASSERT_EQ(variant.getDataValue<std::int32_t>(VariantPath("c", metaTest)), 3);
+    ASSERT_EQ(variant.getDataValue<std::int32_t>("b"), 2);
+    ASSERT_EQ(variant.getVariant(VariantPath("a", metaTest)), nullptr);
+    ASSERT_EQ(variant.add("c", 4), false);
+    ASSERT_EQ(variant.add("a", 5), true);
+    ASSERT_EQ(variant.getDataValue<std::int32_t>("a"), 5);
+}
+
+TEST_F(TestVariant, testStructBoundToMetaStructConstReads)
+{
+    MetaStruct structTest;
+    structTest.setTypeName("test.VariantStructConstReads");
+    structTest.addField({MetaTypeId::TYPE_INT32, "", "a", "description", 0});
+    structTest.addField({MetaTypeId::TYPE_INT32, "", "b", "description", 1});
+    MetaDataGlobal::instance().addStruct(structTest);
+    const MetaStruct* metaTest = MetaDataGlobal::instance().getStruct("test.VariantStructConstReads");
+    ASSERT_NE(metaTest, nullptr);
+
+    Variant variant = std::shared_ptr<IVariantValue>(std::make_shared<VariantValueStruct>(*metaTest));
+    variant.add("a", 1);
+    const Variant shared = variant;
+
+    // the const reads of a shared struct do not write, also not for an absent field
+    const VariantPath pathA("a", metaTest);
+    const VariantPath pathB("b", metaTest);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&shared, &pathA, &pathB] () {
+            for (int i = 0; i < 1000; ++i)
+            {
+                ASSERT_EQ(shared.getDataValue<std::int32_t>(pathA), 1);
+                ASSERT_EQ(shared.getVariant(pathB), nullptr);
+            }
+        });
+    }
+    for (size_t t = 0; t < threads.size(); ++t)
+    {
+        threads[t].join();
+    }
+}
@@ -0,0 +1,649 @@
+// Generates plain structs and ProtoCodec<T> specializations (see serializeproto/ProtoCodec.h)
+// from a proto3 file. Supported are packages, enums, messages (also nested), repeated fields
+// and the scalar types of proto3. Not supported are maps, oneofs, imports and groups.
+//
+// usage: protocodecgen [--namespace <namespace>] <input.proto> <output.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cctype>
+#include <cstdlib>
+
+
+
+struct ProtoField
+{
+    bool            repeated = false;
+    std::string     type;
+    std::string     name;
+    int             id = 0;
+};
+
+struct ProtoEnum
+{
+    std::string                                 name;       // flat name, e.g. Outer_Inner
+    std::vector<std::pair<std::string, int>>    values;
+};
+
+struct ProtoMessage
+{
+    std::string                 name;       // flat name
+    std::string                 scope;      // dotted full name, e.g. Outer.Inner
+    std::vector<ProtoField>     fields;
+};
+
+
+struct ScalarType
+{
+    const char* protoType;
+    const char* cppType;
+    const char* kind;
+};
+
+static const ScalarType SCALAR_TYPES[] = {
+    {"bool",        "bool",             "PROTOKIND_BOOL"},
+    {"int32",       "std::int32_t",     "PROTOKIND_INT32"},
+    {"sint32",      "std::int32_t",     "PROTOKIND_SINT32"},
+    {"uint32",      "std::uint32_t",    "PROTOKIND_UINT32"},
+    {"fixed32",     "std::uint32_t",    "PROTOKIND_FIXED32"},
+    {"sfixed32",    "std::int32_t",     "PROTOKIND_SFIXED32"},
+    {"int64",       "std::int64_t",     "PROTOKIND_INT64"},
+    {"sint64",      "std::int64_t",     "PROTOKIND_SINT64"},
+    {"uint64",      "std::uint64_t",    "PROTOKIND_UINT64"},
+    {"fixed64",     "std::uint64_t",    "PROTOKIND_FIXED64"},
+    {"sfixed64",    "std::int64_t",     "PROTOKIND_SFIXED64"},
+    {"float",       "float",            "PROTOKIND_FLOAT"},
+    {"double",      "double",           "PROTOKIND_DOUBLE"},
+    {"string",      "std::string",      "PROTOKIND_STRING"},
+    {"bytes",       "Bytes",            "PROTOKIND_BYTES"},
+};
+
+static const ScalarType* findScalarType(const std::string& type)
+{
+    for (const ScalarType& scalarType : SCALAR_TYPES)
+    {
+        if (type == scalarType.protoType)
+        {
+            return &scalarType;
+        }
+    }
+    return nullptr;
+}
+
+
+
+class ProtoFile
+{
+public:
+    bool parse(const std::string& text)
+    {
+        tokenize(text);
+        while (m_pos < m_tokens.size())
+        {
+            const std::string& token = next();
+            if (token == "syntax" || token == "option")
+            {
+                skipStatement();
+            }
+            else if (token == "package")
+            {
+                m_package = next();
+                expect(";");
+            }
+            else if (token == "enum")
+            {
+                parseEnum("");
+            }
+            else if (token == "message")
+            {
+                parseMessage("");
+            }
+            else if (token == ";")
+            {
+            }
+            else
+            {
+                error("unsupported statement '" + token + "'");
+            }
+            if (!m_error.empty())
+            {
+                return false;
+            }
+        }
+        return m_error.empty();
+    }
+
+    const std::string& getError() const
+    {
+        return m_error;
+    }
+
+    const std::string& getPackage() const
+    {
+        return m_package;
+    }
+
+    const std::vector<ProtoEnum>& getEnums() const
+    {
+        return m_enums;
+    }
+
+    const std::vector<ProtoMessage>& getMessages() const
+    {
+        return m_messages;
+    }
+
+    // resolves a type name of a field to the flat name of an enum or message
+    std::string resolve(const std::string& scope, std::string type, bool& isEnum) const
+    {
+        if (!type.empty() && type[0] == '.')
+        {
+            type = type.substr(1);
+        }
+        if (!m_package.empty() && type.compare(0, m_package.size() + 1, m_package + ".") == 0)
+        {
+            type = type.substr(m_package.size() + 1);
+        }
+        std::string currentScope = scope;
+        while (true)
+        {
+            std::string fullName = currentScope.empty() ? type : (currentScope + "." + type);
+            auto it = m_fullNames.find(fullName);
+            if (it != m_fullNames.end())
+            {
+                isEnum = it->second.second;
+                return it->second.first;
+            }
+            if (currentScope.empty())
+            {
+                return "";
+            }
+            size_t pos = currentScope.rfind('.');
+            currentScope = (pos == std::string::npos) ? "" : currentScope.substr(0, pos);
+        }
+    }
+
+private:
+    void tokenize(const std::string& text)
+    {
+        size_t i = 0;
+        while (i < text.size())
+        {
+            char c = text[i];
+            if (isspace(static_cast<unsigned char>(c)))
+            {
+                ++i;
+            }
+            else if (c == '/' && i + 1 < text.size() && text[i + 1] == '/')
+            {
+                while (i < text.size() && text[i] != '\n')
+                {
+                    ++i;
+                }
+            }
+            else if (c == '/' && i + 1 < text.size() && text[i + 1] == '*')
+            {
+                size_t end = text.find("*/", i + 2);
+                i = (end == std::string::npos) ? text.size() : end + 2;
+            }
+            else if (c == '"' || c == '\'')
+            {
+                size_t end = text.find(c, i + 1);
+                end = (end == std::string::npos) ? text.size() : end + 1;
+                m_tokens.push_back(text.substr(i, end - i));
+                i = end;
+            }
+            else if (isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '-')
+            {
+                size_t begin = i;
+                while (i < text.size() && (isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_' || text[i] == '.' || (i == begin && text[i] == '-')))
+                {
+                    ++i;
+                }
+                m_tokens.push_back(text.substr(begin, i - begin));
+            }
+            else
+            {
+                m_tokens.push_back(std::string(1, c));
+                ++i;
+            }
+        }
+    }
+
+    const std::string& next()
+    {
+        static const std::string END;
+        if (m_pos >= m_tokens.size())
+        {
+            error("unexpected end of file");
+            return END;
+        }
+        return m_tokens[m_pos++];
+    }
+
+    const std::string& peek() const
+    {
+        static const std::string END;
+        return (m_pos < m_tokens.size()) ? m_tokens[m_pos] : END;
+    }
+
+    void expect(const std::string& token)
+    {
+        if (next() != token)
+        {
+            error("expected '" + token + "'");
+        }
+    }
+
+    void skipStatement()
+    {
+        while (m_error.empty() && next() != ";")
+        {
+        }
+    }
+
+    void error(const std::string& message)
+    {
+        if (m_error.empty())
+        {
+            m_error = message;
+        }
+    }
+
+    int parseNumber(const std::string& token)
+    {
+        char* end = nullptr;
+        long value = strtol(token.c_str(), &end, 0);
+        if (token.empty() || *end != 0)
+        {
+            error("expected number instead of '" + token + "'");
+        }
+        return static_cast<int>(value);
+    }
+
+    static std::string flatName(const std::string& scope)
+    {
+        std::string name = scope;
+        for (char& c : name)
+        {
+            if (c == '.')
+            {
+                c = '_';
+            }
+        }
+        return name;
+    }
+
+    void parseEnum(const std::string& scope)
+    {
+        ProtoEnum protoEnum;
+        std::string fullName = scope.empty() ? next() : (scope + "." + next());
+        protoEnum.name = flatName(fullName);
+        expect("{");
+        while (m_error.empty() && peek() != "}")
+        {
+            const std::string& token = next();
+            if (token == "option" || token == "reserved")
+            {
+                skipStatement();
+                continue;
+            }
+            std::string name = token;
+            expect("=");
+            int value = parseNumber(next());
+            if (peek() == "[")
+            {
+                while (m_error.empty() && next() != "]")
+                {
+                }
+            }
+            expect(";");
+            if (!scope.empty())
+            {
+                // like protobuf, the values of nested enums are prefixed by the message
+                name = flatName(scope) + "_" + name;
+            }
+            protoEnum.values.emplace_back(name, value);
+        }
+        expect("}");
+        m_fullNames[fullName] = {protoEnum.name, true};
+        m_enums.push_back(protoEnum);
+    }
+
+    void parseMessage(const std::string& scope)
+    {
+        ProtoMessage message;
+        message.scope = scope.empty() ? next() : (scope + "." + next());
+        message.name = flatName(message.scope);
+        m_fullNames[message.scope] = {message.name, false};
+        expect("{");
+        while (m_error.empty() && peek() != "}")
+        {
+            std::string token = next();
+            if (token == "message")
+            {
+                parseMessage(message.scope);
+            }
+            else if (token == "enum")
+            {
+                parseEnum(message.scope);
+            }
+            else if (token == "option" || token == "reserved")
+            {
+                skipStatement();
+            }
+            else if (token == "map" || token == "oneof" || token == "group" || token == "extensions")
+            {
+                error("'" + token + "' is not supported");
+            }
+            else
+            {
+                ProtoField field;
+                if (token == "repeated")
+                {
+                    field.repeated = true;
+                    token = next();
+                }
+                field.type = token;
+                field.name = next();
+                expect("=");
+                field.id = parseNumber(next());
+                if (peek() == "[")
+                {
+                    // e.g. [packed = true], the arrays are packed anyway
+                    while (m_error.empty() && next() != "]")
+                    {
+                    }
+                }
+                expect(";");
+                message.fields.push_back(field);
+            }
+        }
+        expect("}");
+        m_messages.push_back(message);
+    }
+
+    std::vector<std::string>                                        m_tokens;
+    size_t                                                          m_pos = 0;
+    std::string                                                     m_error;
+    std::string                                                     m_package;
+    std::vector<ProtoEnum>                                          m_enums;
+    std::vector<ProtoMessage>                                       m_messages;
+    std::map<std::string, std::pair<std::string, bool>>             m_fullNames;
+};
+
+
+
+class CodeGenerator
+{
+public:
+    CodeGenerator(const ProtoFile& protoFile, const std::string& cppNamespace)
+        : m_protoFile(protoFile)
+        , m_namespace(cppNamespace)
+    {
+        if (m_namespace.empty())
+        {
+            m_namespace = protoFile.getPackage();
+        }
+        size_t pos = 0;
+        while ((pos = m_namespace.find('.', pos)) != std::string::npos)
+        {
+            m_namespace.replace(pos, 1, "::");
+        }
+    }
+
+    bool generate(const std::string& inputFileName, std::ostream& out)
+    {
+        std::vector<const ProtoMessage*> messages;
+        if (!sortMessages(messages))
+        {
+            return false;
+        }
+
+        out << "// generated by protocodecgen from " << inputFileName << ", do not edit\n";
+        out << "#pragma once\n\n";
+        out << "#include \"serializeproto/ProtoCodec.h\"\n\n\n";
+
+        std::string prefix = m_namespace.empty() ? "" : (m_namespace + "::");
+        if (!m_namespace.empty())
+        {
+            out << "namespace " << m_namespace << " {\n\n";
+        }
+        for (const ProtoEnum& protoEnum : m_protoFile.getEnums())
+        {
+            out << "enum " << protoEnum.name << " : std::int32_t\n{\n";
+            for (const auto& value : protoEnum.values)
+            {
+                out << "    " << value.first << " = " << value.second << ",\n";
+            }
+            out << "};\n\n";
+        }
+        for (const ProtoMessage* message : messages)
+        {
+            out << "struct " << message->name << "\n{\n";
+            for (const ProtoField& field : message->fields)
+            {
+                std::string cppType = getCppType(*message, field);
+                if (field.repeated)
+                {
+                    cppType = "std::vector<" + cppType + ">";
+                }
+                out << "    " << cppType << " " << field.name << "{};\n";
+            }
+            out << "};\n\n";
+        }
+        if (!m_namespace.empty())
+        {
+            out << "} // namespace " << m_namespace << "\n\n";
+        }
+
+        for (const ProtoMessage* message : messages)
+        {
+            generateCodec(*message, prefix + message->name, out);
+        }
+        return m_error.empty();
+    }
+
+    const std::string& getError() const
+    {
+        return m_error;
+    }
+
+private:
+    // the messages are sorted, so that a message is defined before it is used as field type
+    bool sortMessages(std::vector<const ProtoMessage*>& messages)
+    {
+        std::set<std::string> done;
+        std::set<std::string> visiting;
+        for (const ProtoMessage& message : m_protoFile.getMessages())
+        {
+            if (!visit(message, done, visiting, messages))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool visit(const ProtoMessage& message, std::set<std::string>& done, std::set<std::string>& visiting, std::vector<const ProtoMessage*>& messages)
+    {
+        if (done.find(message.name) != done.end())
+        {
+            return true;
+        }
+        if (visiting.find(message.name) != visiting.end())
+        {
+            m_error = "recursive message " + message.name + " is not supported";
+            return false;
+        }
+        visiting.insert(message.name);
+        for (const ProtoField& field : message.fields)
+        {
+            if (findScalarType(field.type))
+            {
+                continue;
+            }
+            bool isEnum = false;
+            std::string name = m_protoFile.resolve(message.scope, field.type, isEnum);
+            if (name.empty())
+            {
+                m_error = "unknown type " + field.type + " in " + message.name;
+                return false;
+            }
+            if (!isEnum)
+            {
+                for (const ProtoMessage& m : m_protoFile.getMessages())
+                {
+                    if (m.name == name && !visit(m, done, visiting, messages))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        visiting.erase(message.name);
+        done.insert(message.name);
+        messages.push_back(&message);
+        return true;
+    }
+
+    std::string getCppType(const ProtoMessage& message, const ProtoField& field) const
+    {
+        const ScalarType* scalarType = findScalarType(field.type);
+        if (scalarType)
+        {
+            return scalarType->cppType;
+        }
+        bool isEnum = false;
+        return m_protoFile.resolve(message.scope, field.type, isEnum);
+    }
+
+    void generateCodec(const ProtoMessage& message, const std::string& cppName, std::ostream& out)
+    {
+        std::ostringstream size;
+        std::ostringstream write;
+        std::ostringstream read;
+        for (const ProtoField& field : message.fields)
+        {
+            std::string id = std::to_string(field.id);
+            std::string value = "value." + field.name;
+            const ScalarType* scalarType = findScalarType(field.type);
+            bool isEnum = false;
+            if (!scalarType)
+            {
+                m_protoFile.resolve(message.scope, field.type, isEnum);
+            }
+            if (scalarType || isEnum)
+            {
+                std::string kind = scalarType ? scalarType->kind : "PROTOKIND_ENUM";
+                std::string suffix = field.repeated ? "Repeated<" : "Field<";
+                size << "        protoSize" << suffix << kind << ">(size, " << id << ", " << value << ");\n";
+                write << "        protoWrite" << suffix << kind << ">(writer, " << id << ", " << value << ");\n";
+                read << "            case " << id << ":\n";
+                read << "                ok = protoRead" << suffix << kind << ">(reader, wireType, " << value << ");\n";
+                read << "                break;\n";
+            }
+            else
+            {
+                std::string suffix = field.repeated ? "RepeatedMessage" : "Message";
+                size << "        protoSize" << suffix << "(size, " << id << ", " << value << ", sizes);\n";
+                write << "        protoWrite" << suffix << "(writer, " << id << ", " << value << ");\n";
+                read << "            case " << id << ":\n";
+                read << "                ok = protoRead" << suffix << "(reader, wireType, " << value << ");\n";
+                read << "                break;\n";
+            }
+        }
+
+        out << "template<>\n";
+        out << "struct ProtoCodec<" << cppName << ">\n{\n";
+        out << "    static size_t size(const " << cppName << "& value, ProtoSizes* sizes = nullptr)\n    {\n";
+        out << "        size_t size = 0;\n";
+        out << size.str();
+        out << "        return size;\n    }\n\n";
+        out << "    static void write(ProtoWriter& writer, const " << cppName << "& value)\n    {\n";
+        out << write.str();
+        out << "    }\n\n";
+        out << "    static bool read(ProtoReader& reader, " << cppName << "& value)\n    {\n";
+        out << "        int id = 0;\n";
+        out << "        int wireType = 0;\n";
+        out << "        while (reader.readTag(id, wireType))\n        {\n";
+        out << "            bool ok = true;\n";
+        out << "            switch (id)\n            {\n";
+        out << read.str();
+        out << "            default:\n";
+        out << "                ok = reader.skip(wireType);\n";
+        out << "                break;\n";
+        out << "            }\n";
+        out << "            if (!ok)\n            {\n                return false;\n            }\n";
+        out << "        }\n";
+        out << "        return reader.isValid();\n    }\n";
+        out << "};\n\n";
+    }
+
+    const ProtoFile&    m_protoFile;
+    std::string         m_namespace;
+    std::string         m_error;
+};
+
+
+
+int main(int argc, char* argv[])
+{
+    std::string cppNamespace;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--namespace" && i + 1 < argc)
+        {
+            cppNamespace = argv[++i];
+        }
+        else
+        {
+            files.push_back(arg);
+        }
+    }
+    if (files.size() != 2)
+    {
+        std::cerr << "usage: protocodecgen [--namespace <namespace>] <input.proto> <output.h>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(files[0]);
+    if (!input)
+    {
+        std::cerr << "protocodecgen: cannot open " << files[0] << std::endl;
+        return 1;
+    }
+    std::stringstream text;
+    text << input.rdbuf();
+
+    ProtoFile protoFile;
+    if (!protoFile.parse(text.str()))
+    {
+        std::cerr << files[0] << ": " << protoFile.getError() << std::endl;
+        return 1;
+    }
+
+    std::ostringstream out;
+    CodeGenerator generator(protoFile, cppNamespace);
+    if (!generator.generate(files[0], out))
+    {
+        std::cerr << files[0] << ": " << generator.getError() << std::endl;
+        return 1;
+    }
+
+    std::ofstream output(files[1]);
+    output << out.str();
+    if (!output)
+    {
+        std::cerr << "protocodecgen: cannot write " << files[1] << std::endl;
+        return 1;
+    }
+    return 0;
+}